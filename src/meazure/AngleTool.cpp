@@ -435,14 +435,30 @@ const POINT& MeaAngleTool::GetPosition() const
 
 
 void MeaAngleTool::GetPosition(MeaPositionLogMgr::Position& position) const
+{
+    RecordPosition(m_point1, m_point2, m_vertex, position);
+}
+
+
+void MeaAngleTool::GetPosition(const PointMap& points, MeaPositionLogMgr::Position& position) const
+{
+    RecordPosition(FindPoint(points, _T("1"), m_point1),
+                   FindPoint(points, _T("2"), m_point2),
+                   FindPoint(points, _T("v"), m_vertex),
+                   position);
+}
+
+
+void MeaAngleTool::RecordPosition(const POINT& point1, const POINT& point2, const POINT& vertex,
+                                  MeaPositionLogMgr::Position& position)
 {
     MeaUnitsMgr& units = MeaUnitsMgr::Instance();
     
     // Convert the pixel locations to the current units.
     //
-    FPOINT p1 = units.ConvertCoord(m_point1);
-    FPOINT p2 = units.ConvertCoord(m_point2);
-    FPOINT v = units.ConvertCoord(m_vertex);
+    FPOINT p1 = units.ConvertCoord(point1);
+    FPOINT p2 = units.ConvertCoord(point2);
+    FPOINT v = units.ConvertCoord(vertex);
 
     // Save the positions in the position object.
     //
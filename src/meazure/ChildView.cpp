@@ -99,6 +99,10 @@ BEGIN_MESSAGE_MAP(CChildView,CWnd )
     ON_COMMAND(ID_MEA_DELETE_POSITIONS, OnDeletePositions)
     ON_UPDATE_COMMAND_UI(ID_MEA_DELETE_POSITIONS, OnUpdateDeletePositions)
     ON_COMMAND(ID_MEA_LOAD_POSITIONS, OnLoadPositions)
+    ON_COMMAND(ID_MEA_MERGE_POSITIONS, OnMergePositions)
+    ON_COMMAND(ID_MEA_IMPORT_POSITIONS, OnImportPositions)
+    ON_COMMAND(ID_MEA_EXPORT_POSITIONS, OnExportPositions)
+    ON_UPDATE_COMMAND_UI(ID_MEA_EXPORT_POSITIONS, OnUpdateSavePositions)
     ON_COMMAND(ID_MEA_SAVE_POSITIONS, OnSavePositions)
     ON_COMMAND(ID_MEA_SAVE_POSITIONS_AS, OnSavePositionsAs)
     ON_UPDATE_COMMAND_UI(ID_MEA_SAVE_POSITIONS, OnUpdateSavePositions)
@@ -738,15 +742,37 @@ void CChildView::OnLoadPositions()
 }
 
 
+void CChildView::OnMergePositions()
+{
+    if (MeaPositionLogMgr::Instance().Merge()) {
+        MeaPositionLogMgr::Instance().ManagePositions();
+    }
+}
+
+
+void CChildView::OnImportPositions()
+{
+    if (MeaPositionLogMgr::Instance().Import()) {
+        MeaPositionLogMgr::Instance().ManagePositions();
+    }
+}
+
+
+void CChildView::OnExportPositions()
+{
+    MeaPositionLogMgr::Instance().Export();
+}
+
+
 void CChildView::OnSavePositions() 
 {
-    MeaPositionLogMgr::Instance().Save(false);
+    MeaPositionLogMgr::Instance().SaveInBackground(false);
 }
 
 
 void CChildView::OnSavePositionsAs() 
 {
-    MeaPositionLogMgr::Instance().Save(true);
+    MeaPositionLogMgr::Instance().SaveInBackground(true);
 }
 
 
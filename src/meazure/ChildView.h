@@ -218,6 +218,9 @@ protected:
     afx_msg void OnDeletePositions();
     afx_msg void OnUpdateDeletePositions(CCmdUI* pCmdUI);
     afx_msg void OnLoadPositions();
+    afx_msg void OnMergePositions();
+    afx_msg void OnImportPositions();
+    afx_msg void OnExportPositions();
     afx_msg void OnSavePositions();
     afx_msg void OnSavePositionsAs();
     afx_msg void OnUpdateSavePositions(CCmdUI* pCmdUI);
@@ -440,6 +443,15 @@ protected:
     /// @fn OnLoadPositions()
     /// Called to load a position log file.
 
+    /// @fn OnMergePositions()
+    /// Called to merge position log files into the recorded positions.
+
+    /// @fn OnImportPositions()
+    /// Called to add the positions from a CSV or JSON Lines file.
+
+    /// @fn OnExportPositions()
+    /// Called to write the positions to a CSV or JSON Lines file.
+
     /// @fn OnSavePositions()
     /// Called to save a position log file.
 
@@ -408,17 +408,32 @@ const POINT& MeaCircleTool::GetPosition() const
 
 
 void MeaCircleTool::GetPosition(MeaPositionLogMgr::Position& position) const
+{
+    RecordPosition(m_center, m_perimeter, position);
+}
+
+
+void MeaCircleTool::GetPosition(const PointMap& points, MeaPositionLogMgr::Position& position) const
+{
+    RecordPosition(FindPoint(points, _T("v"), m_center),
+                   FindPoint(points, _T("1"), m_perimeter),
+                   position);
+}
+
+
+void MeaCircleTool::RecordPosition(const POINT& center, const POINT& perimeter,
+                                   MeaPositionLogMgr::Position& position)
 {
     MeaUnitsMgr& units = MeaUnitsMgr::Instance();
     
     // Convert the pixel locations to the current units.
     //
-    FPOINT p1 = units.ConvertCoord(m_center);
-    FPOINT p2 = units.ConvertCoord(m_perimeter);
+    FPOINT p1 = units.ConvertCoord(center);
+    FPOINT p2 = units.ConvertCoord(perimeter);
 
-    int radius = m_circle.GetRadius();
-    CPoint topLeft(m_center.x - radius, m_center.y - radius);
-    CPoint bottomRight(m_center.x + radius, m_center.y + radius);
+    int radius = static_cast<int>(MeaLayout::CalcLength(center, perimeter));
+    CPoint topLeft(center.x - radius, center.y - radius);
+    CPoint bottomRight(center.x + radius, center.y + radius);
     FSIZE wh = units.GetWidthHeight(topLeft, bottomRight);
 
     double r = wh.cx / 2.0;
@@ -163,6 +163,18 @@ public:
     ///
     virtual void    GetPosition(MeaPositionLogMgr::Position& position) const;
 
+    /// Records the position the tool would have if its crosshairs were
+    /// at the specified points, without moving the tool. This method is
+    /// called by the position log manager to record a batch of positions.
+    ///
+    /// @param points       [in] Map of positions for the tool's crosshairs.
+    ///                     Crosshairs missing from the map are taken at
+    ///                     their current location.
+    /// @param position     [in] Position object into which the position
+    ///                     is recorded.
+    ///
+    virtual void    GetPosition(const PointMap& points, MeaPositionLogMgr::Position& position) const;
+
     /// Returns the name of the tool. Each tool has a unique name
     /// which is used to identify the tool in profiles and position
     /// logs.
@@ -227,6 +239,16 @@ private:
     ///
     bool    Create();
 
+    /// Records the position of the tool with its crosshairs at the
+    /// specified locations.
+    ///
+    /// @param center         [in] Location of the center of the circle.
+    /// @param perimeter      [in] Location of a point on the circle.
+    /// @param position       [in] Position object into which the position
+    ///                       is recorded.
+    ///
+    static void RecordPosition(const POINT& center, const POINT& perimeter, MeaPositionLogMgr::Position& position);
+
     /// Sets the position of the tool's crosshairs based on the current
     /// values of #m_center, and #m_perimeter.
     ///
@@ -187,6 +187,12 @@ void MeaCursorTool::GetPosition(MeaPositionLogMgr::Position& position) const
 }
 
 
+void MeaCursorTool::GetPosition(const PointMap& points, MeaPositionLogMgr::Position& position) const
+{
+    position.RecordXY1(MeaUnitsMgr::Instance().ConvertCoord(FindPoint(points, _T("1"), m_cursorPos)));
+}
+
+
 CString MeaCursorTool::GetToolName() const
 {
     return kToolName;
@@ -26,6 +26,7 @@
 MeaFileProfile::MeaFileProfile(LPCTSTR pathname, Mode mode) : 
     MeaProfile(),
     MeaXMLParserHandler(),
+    m_writer(NULL),
     m_mode(mode),
     m_readVersion(1)
 {
@@ -40,6 +41,7 @@ MeaFileProfile::MeaFileProfile(LPCTSTR pathname, Mode mode) :
     m_title.Format(_T("%s Profile File"), static_cast<LPCTSTR>(AfxGetAppName()));
 
     if (m_mode == ProfWrite) {
+        m_writer = new MeaXMLWriter(m_stdioFile);
         WriteFileStart();
     } else {
         ParseFile();
@@ -52,6 +54,7 @@ MeaFileProfile::~MeaFileProfile()
     try {
         if (m_mode == ProfWrite) {
             WriteFileEnd();
+            delete m_writer;
         }
 
         m_stdioFile.Close();
@@ -64,46 +67,40 @@ MeaFileProfile::~MeaFileProfile()
 
 bool MeaFileProfile::WriteBool(LPCTSTR key, bool value)
 {
-    Write(2, _T("<%s value=\"%s\"/>\n"), key, (value ? _T("true") : _T("false")));
+    m_writer->StartElement(key);
+    m_writer->Attribute(_T("value"), value);
+    m_writer->EndElement();
     return true;
 }
 
 
 bool MeaFileProfile::WriteInt(LPCTSTR key, int value)
 {
-    Write(2, _T("<%s value=\"%d\"/>\n"), key, value);
+    m_writer->StartElement(key);
+    m_writer->Attribute(_T("value"), value);
+    m_writer->EndElement();
     return true;
 }
 
 
 bool MeaFileProfile::WriteDbl(LPCTSTR key, double value)
 {
-    Write(2, _T("<%s value=\"%f\"/>\n"), key, value);
+    m_writer->StartElement(key);
+    m_writer->Attribute(_T("value"), value);
+    m_writer->EndElement();
     return true;
 }
 
 
 bool MeaFileProfile::WriteStr(LPCTSTR key, LPCTSTR value)
 {
-    Write(2, _T("<%s value=\"%s\"/>\n"), key, value);
+    m_writer->StartElement(key);
+    m_writer->Attribute(_T("value"), value);
+    m_writer->EndElement();
     return true;
 }
 
 
-void MeaFileProfile::Write(int indentLevel, LPCTSTR format, ...)
-{
-    CString indent(_T(' '), indentLevel * 4);
-    CString str;
-    va_list args;
-    
-    va_start(args, format);
-    str.FormatV(format, args);
-    va_end(args);
-
-    m_stdioFile.WriteString(indent + MeaXMLParser::ToUTF8(str));
-}
-
-
 bool MeaFileProfile::ReadBool(LPCTSTR key, bool defaultValue)
 {
     std::map<CString, CString>::const_iterator iter;
@@ -168,30 +165,39 @@ int MeaFileProfile::GetVersion()
 
 void MeaFileProfile::WriteFileStart()
 {
-    Write(0, _T("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"));
-    Write(0, _T("<profile version=\"%d\">\n"), g_versionInfo.GetProfileFileMajor());
+    m_writer->Declaration(true);
+    m_writer->StartElement(_T("profile"));
+    m_writer->Attribute(_T("version"), g_versionInfo.GetProfileFileMajor());
 
     TCHAR nameBuffer[MAX_COMPUTERNAME_LENGTH + 1];
     DWORD size = MAX_COMPUTERNAME_LENGTH + 1;
     GetComputerName(nameBuffer, &size);
 
-    Write(1, _T("<info>\n"));
-        Write(2, _T("<title>%s</title>\n"), static_cast<LPCTSTR>(MeaXMLParser::Encode(m_title)));
-        Write(2, _T("<created date=\"%s\"/>\n"), static_cast<LPCTSTR>(MeaMakeTimeStamp(time(NULL))));
-        Write(2, _T("<generator name=\"%s\" version=\"%s\" build=\"%d\"/>\n"),
-                static_cast<LPCTSTR>(AfxGetAppName()),
-                static_cast<LPCTSTR>(g_versionInfo.GetProductVersion()),
-                g_versionInfo.GetProductBuild());
-        Write(2, _T("<machine name=\"%s\"/>\n"), nameBuffer);
-    Write(1, _T("</info>\n"));
-    Write(1, _T("<data>\n"));
+    m_writer->StartElement(_T("info"));
+        m_writer->StartElement(_T("title"));
+        m_writer->Text(m_title);
+        m_writer->EndElement();
+        m_writer->StartElement(_T("created"));
+        m_writer->Attribute(_T("date"), MeaMakeTimeStamp(time(NULL)));
+        m_writer->EndElement();
+        m_writer->StartElement(_T("generator"));
+        m_writer->Attribute(_T("name"), AfxGetAppName());
+        m_writer->Attribute(_T("version"), g_versionInfo.GetProductVersion());
+        m_writer->Attribute(_T("build"), g_versionInfo.GetProductBuild());
+        m_writer->EndElement();
+        m_writer->StartElement(_T("machine"));
+        m_writer->Attribute(_T("name"), nameBuffer);
+        m_writer->EndElement();
+    m_writer->EndElement();
+    m_writer->StartElement(_T("data"));
 }
 
 
 void MeaFileProfile::WriteFileEnd()
 {
-    Write(1, _T("</data>\n"));
-    Write(0, _T("</profile>\n"));
+    m_writer->EndElement();     // data
+    m_writer->EndElement();     // profile
+    m_writer->Flush();
 }
 
 
@@ -24,6 +24,7 @@
 
 #include "Profile.h"
 #include "XMLParser.h"
+#include "XMLWriter.h"
 #include <map>
 
 
@@ -156,15 +157,6 @@ public:
     virtual CString GetFilePathname();
 
 private:
-    /// Printf style method that writes the specified values using the
-    /// specified format and indentation level.
-    ///
-    /// @param indentLevel      [in] Indentation level for the output.
-    /// @param format           [in] Printf-style format string for the output.
-    /// @param ...              [in] Items to write to the file.
-    ///
-    void    Write(int indentLevel, LPCTSTR format, ...);
-
     /// Writes the XML boilerplate at the start of the XML profile file.
     ///
     void    WriteFileStart();
@@ -178,6 +170,7 @@ private:
     void    ParseFile();
 
     CStdioFile  m_stdioFile;        ///< File object representing the profile.
+    MeaXMLWriter    *m_writer;      ///< Writes the profile file when opened for writing.
     Mode        m_mode;             ///< Opening mode for the profile file.
     int         m_readVersion;      ///< Profile format version number read from the profile file.
     CString     m_title;            ///< Title for the profile file.
@@ -60,12 +60,35 @@ MeaGUID& MeaGUID::Assign(LPCTSTR guidStr)
 }
 
 
+size_t MeaGUID::GetHash() const
+{
+    // FNV-1a over the raw bytes of the GUID.
+    //
+    const BYTE* bytes = reinterpret_cast<const BYTE*>(&m_guid);
+    size_t hash = 2166136261U;
+
+    for (size_t i = 0; i < sizeof(m_guid); i++) {
+        hash ^= bytes[i];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+
 CString MeaGUID::ToString() const
 {
-    m_buffer.Format(
+    TCHAR buffer[kBufferSize];
+    return CString(Format(buffer));
+}
+
+
+LPCTSTR MeaGUID::Format(TCHAR* buffer) const
+{
+    _stprintf_s(buffer, kBufferSize,
                 _T("%08lX-%04hX-%04hX-%02hX%02hX-%02hX%02hX%02hX%02hX%02hX%02hX"),
                 m_guid.Data1, m_guid.Data2, m_guid.Data3,
                 m_guid.Data4[0], m_guid.Data4[1], m_guid.Data4[2], m_guid.Data4[3],
                 m_guid.Data4[4], m_guid.Data4[5], m_guid.Data4[6], m_guid.Data4[7]);
-    return m_buffer;
+    return buffer;
 }
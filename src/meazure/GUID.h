@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <functional>
+
 
 /// Represents a globally unique identifier (GUID) and common operations
 /// on a GUID.
@@ -99,12 +101,12 @@ public:
     /// @return Operating system defined GUID structure.
     operator GUID() const { return m_guid; }
 
-    /// Casts to a string.
-    /// @return String representation of the GUID.
-    operator LPCTSTR() const { return static_cast<LPCTSTR>(ToString()); }
-
 
     /// Used by the STL to perform ordering of MeaGUID objects in collections.
+    /// The GUID fields are compared directly rather than formatting the
+    /// GUIDs as strings. Because the string representation uses fixed
+    /// width hexadecimal fields in the same order, the resulting order is
+    /// identical to a lexical comparison of the strings.
     ///
     struct less {
         /// Compares two MeaGUID objects.
@@ -116,7 +118,7 @@ public:
         ///
         bool operator()(const MeaGUID& lhs, const MeaGUID& rhs) const
         {
-            return lhs.ToString() < rhs.ToString();
+            return lhs.Compare(rhs) < 0;
         }
     };
 
@@ -168,16 +170,71 @@ public:
     }
 
 
-    /// Returns a string representation of the GUID. Note that the
-    /// string returned is not preserved across calls to this method.
-    /// Copy the returned string to preserve it.
+    /// Compares the specified MeaGUID object with this in the same order
+    /// as a lexical comparison of their string representations.
+    ///
+    /// @param guid     [in] MeaGUID object to compare with this.
+    ///
+    /// @return Negative if this is less than the specified object, zero if
+    ///         they are equal and positive if this is greater.
+    ///
+    int     Compare(const MeaGUID& guid) const {
+        if (m_guid.Data1 != guid.m_guid.Data1) {
+            return (m_guid.Data1 < guid.m_guid.Data1) ? -1 : 1;
+        }
+        if (m_guid.Data2 != guid.m_guid.Data2) {
+            return (m_guid.Data2 < guid.m_guid.Data2) ? -1 : 1;
+        }
+        if (m_guid.Data3 != guid.m_guid.Data3) {
+            return (m_guid.Data3 < guid.m_guid.Data3) ? -1 : 1;
+        }
+        return memcmp(m_guid.Data4, guid.m_guid.Data4, sizeof(m_guid.Data4));
+    }
+
+    /// Computes a hash value from the 16 bytes of the GUID.
+    ///
+    /// @return Hash value for the GUID.
+    ///
+    size_t  GetHash() const;
+
+
+    /// Returns a string representation of the GUID. The string is
+    /// formatted into the returned object, so this method may be called
+    /// on a MeaGUID that is read by several threads.
     ///
     /// @return String representation of the GUID.
     ///
     CString ToString() const;
 
 private:
-    GUID    m_guid;             ///< Underlying GUID for the object.
+    static const int kBufferSize = 37;  ///< Length of a GUID string plus the terminating null.
 
-    mutable CString m_buffer;   ///< Buffer holding the string representation of the GUID.
+    /// Formats the GUID into the specified buffer.
+    ///
+    /// @param buffer   [out] Buffer of kBufferSize characters to receive
+    ///                 the string representation of the GUID.
+    ///
+    /// @return The buffer.
+    ///
+    LPCTSTR Format(TCHAR* buffer) const;
+
+    GUID    m_guid;             ///< Underlying GUID for the object.
 };
+
+
+namespace std
+{
+    /// Allows MeaGUID objects to be used as keys in unordered STL collections.
+    ///
+    template<>
+    struct hash<MeaGUID> : public unary_function<MeaGUID, size_t>
+    {
+        /// Hashes the specified MeaGUID object.
+        ///
+        /// @param guid     [in] MeaGUID object to hash.
+        ///
+        /// @return Hash value for the GUID.
+        ///
+        size_t operator()(const MeaGUID& guid) const { return guid.GetHash(); }
+    };
+}
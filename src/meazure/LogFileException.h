@@ -0,0 +1,39 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Header file for the position log file exception.
+
+#pragma once
+
+
+/// Exception thrown if a problem occurs while reading or writing
+/// the position log file.
+///
+class MeaLogFileException
+{
+public:
+    /// Constructor for the exception.
+    ///
+    MeaLogFileException() { }
+    
+    /// Destroys the exception.
+    ///
+    virtual ~MeaLogFileException() { }
+};
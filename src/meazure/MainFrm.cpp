@@ -24,6 +24,7 @@
 #include "Preferences.h"
 #include "Layout.h"
 #include "ScreenMgr.h"
+#include "PositionLogMgr.h"
 
 
 #ifdef _DEBUG
@@ -64,6 +65,7 @@ BEGIN_MESSAGE_MAP(CMainFrame, CFrameWnd)
     ON_MESSAGE(MeaShowCalPrefsMsg, OnShowCalPrefs)
     ON_MESSAGE(WM_COPYDATA, OnCopyData)
     ON_MESSAGE(MeaMasterResetMsg, OnMasterReset)
+    ON_MESSAGE(MeaPositionLogSavedMsg, OnPositionLogSaved)
 END_MESSAGE_MAP()
 
 
@@ -259,6 +261,14 @@ LRESULT CMainFrame::OnMasterReset(WPARAM, LPARAM)
 }
 
 
+LRESULT CMainFrame::OnPositionLogSaved(WPARAM wParam, LPARAM)
+{
+    MeaPositionLogMgr::Instance().SaveCompleted(static_cast<UINT>(wParam));
+
+    return TRUE;
+}
+
+
 void CMainFrame::InitView()
 {
     if (!m_profileToolbarVisible) {
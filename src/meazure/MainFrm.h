@@ -250,6 +250,12 @@ protected:
     /// @return Always returns TRUE.
     afx_msg LRESULT OnMasterReset(WPARAM wParam, LPARAM lParam);
 
+    /// Called when a background save of the position log has completed.
+    /// @param wParam   [in] Identifies the save.
+    /// @param lParam   [in] Not used.
+    /// @return Always returns TRUE.
+    afx_msg LRESULT OnPositionLogSaved(WPARAM wParam, LPARAM lParam);
+
     DECLARE_MESSAGE_MAP()
 
 private:
@@ -35,5 +35,6 @@ enum MeaMessages {
     MeaGetPositionMsg       = (WM_USER + 0x106),    ///< Request for the current radio tool's position.
     MeaCaliperPositionMsg   = (WM_USER + 0x107),    ///< Calibration calipers have been moved.
     MeaHPTimerMsg           = (WM_USER + 0x108),    ///< High priority timer has expired.
-    MeaMasterResetMsg       = (WM_USER + 0x109)     ///< Master reset has been requested.
+    MeaMasterResetMsg       = (WM_USER + 0x109),    ///< Master reset has been requested.
+    MeaPositionLogSavedMsg  = (WM_USER + 0x10A)     ///< A background save of the position log has completed.
 };
@@ -272,6 +272,12 @@ void MeaPointTool::GetPosition(MeaPositionLogMgr::Position& position) const
 }
 
 
+void MeaPointTool::GetPosition(const PointMap& points, MeaPositionLogMgr::Position& position) const
+{
+    position.RecordXY1(MeaUnitsMgr::Instance().ConvertCoord(FindPoint(points, _T("1"), m_center)));
+}
+
+
 void MeaPointTool::ColorsChanged()
 {
     // Redraw the crosshair in the new colors.
@@ -140,6 +140,18 @@ public:
     ///
     virtual void    GetPosition(MeaPositionLogMgr::Position& position) const;
 
+    /// Records the position the tool would have if its crosshairs were
+    /// at the specified points, without moving the tool. This method is
+    /// called by the position log manager to record a batch of positions.
+    ///
+    /// @param points       [in] Map of positions for the tool's crosshairs.
+    ///                     Crosshairs missing from the map are taken at
+    ///                     their current location.
+    /// @param position     [in] Position object into which the position
+    ///                     is recorded.
+    ///
+    virtual void    GetPosition(const PointMap& points, MeaPositionLogMgr::Position& position) const;
+
 
     /// Returns the name of the tool. Each tool has a unique name
     /// which is used to identify the tool in profiles and position
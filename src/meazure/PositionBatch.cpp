@@ -0,0 +1,336 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include "PositionBatch.h"
+#include "DataDisplay.h"
+#include "MeaAssert.h"
+#include <math.h>
+#include <emmintrin.h>
+
+
+namespace
+{
+    /// Multiplies each value by a factor.
+    ///
+    /// @param values   [in, out] Values to scale.
+    /// @param count    [in] Number of values.
+    /// @param factor   [in] Scale factor.
+    ///
+    void ScaleValues(double* values, int count, double factor)
+    {
+        __m128d f = _mm_set1_pd(factor);
+        int i = 0;
+
+        for (; (i + 2) <= count; i += 2) {
+            _mm_storeu_pd(values + i, _mm_mul_pd(_mm_loadu_pd(values + i), f));
+        }
+        for (; i < count; i++) {
+            values[i] *= factor;
+        }
+    }
+
+    /// Multiplies each value by its own factor.
+    ///
+    /// @param values   [in, out] Values to scale.
+    /// @param factors  [in] Scale factor for each value.
+    /// @param count    [in] Number of values.
+    ///
+    void ScaleValues(double* values, const double* factors, int count)
+    {
+        int i = 0;
+
+        for (; (i + 2) <= count; i += 2) {
+            _mm_storeu_pd(values + i, _mm_mul_pd(_mm_loadu_pd(values + i), _mm_loadu_pd(factors + i)));
+        }
+        for (; i < count; i++) {
+            values[i] *= factors[i];
+        }
+    }
+
+    /// Multiplies each value by the product of its own two factors.
+    ///
+    /// @param values   [in, out] Values to scale.
+    /// @param factors1 [in] First scale factor for each value.
+    /// @param factors2 [in] Second scale factor for each value.
+    /// @param count    [in] Number of values.
+    ///
+    void ScaleValues(double* values, const double* factors1, const double* factors2, int count)
+    {
+        int i = 0;
+
+        for (; (i + 2) <= count; i += 2) {
+            __m128d f = _mm_mul_pd(_mm_loadu_pd(factors1 + i), _mm_loadu_pd(factors2 + i));
+            _mm_storeu_pd(values + i, _mm_mul_pd(_mm_loadu_pd(values + i), f));
+        }
+        for (; i < count; i++) {
+            values[i] *= factors1[i] * factors2[i];
+        }
+    }
+
+    /// Returns the factor for a distance. When the X and Y factors differ,
+    /// the distance is scaled according to its direction, which is given
+    /// by the width and height of the position if it has them.
+    ///
+    /// @param fx       [in] X factor.
+    /// @param fy       [in] Y factor.
+    /// @param width    [in] Width of the position.
+    /// @param height   [in] Height of the position.
+    /// @param haveSize [in] Does the position have a width and height.
+    ///
+    /// @return Distance factor.
+    ///
+    double DistanceFactor(double fx, double fy, double width, double height, bool haveSize)
+    {
+        if (fx == fy) {
+            return fx;
+        }
+
+        double size2 = width * width + height * height;
+        if (haveSize && size2 > 0.0) {
+            return sqrt((fx * fx * width * width + fy * fy * height * height) / size2);
+        }
+        return sqrt(fx * fy);
+    }
+
+    /// Returns the address of the first value of a field array.
+    ///
+    /// @param column   [in] Field array, which must not be empty.
+    ///
+    /// @return First value.
+    ///
+    inline double* Values(std::vector<double>& column)
+    {
+        return &column[0];
+    }
+}
+
+
+MeaPositionBatch::MeaPositionBatch()
+{
+}
+
+
+MeaPositionBatch::~MeaPositionBatch()
+{
+}
+
+
+void MeaPositionBatch::Reserve(int count)
+{
+    m_fieldMask.reserve(count);
+    m_pointMask.reserve(count);
+    for (int id = 0; id < MeaPositionPoints::kNumPointIds; id++) {
+        m_x[id].reserve(count);
+        m_y[id].reserve(count);
+    }
+    m_width.reserve(count);
+    m_height.reserve(count);
+    m_distance.reserve(count);
+    m_area.reserve(count);
+    m_angle.reserve(count);
+}
+
+
+void MeaPositionBatch::Clear()
+{
+    m_fieldMask.clear();
+    m_pointMask.clear();
+    for (int id = 0; id < MeaPositionPoints::kNumPointIds; id++) {
+        m_x[id].clear();
+        m_y[id].clear();
+    }
+    m_width.clear();
+    m_height.clear();
+    m_distance.clear();
+    m_area.clear();
+    m_angle.clear();
+}
+
+
+int MeaPositionBatch::Add(UINT fieldMask, const MeaPositionPoints& points, double width, double height,
+                          double distance, double area, double angle)
+{
+    unsigned char pointMask = 0;
+
+    // Missing points are stored as zero so that every point array can be
+    // converted without checking for them.
+    //
+    for (int i = 0; i < MeaPositionPoints::kNumPointIds; i++) {
+        MeaPositionPoints::PointId id = static_cast<MeaPositionPoints::PointId>(i);
+
+        if (points.HasPoint(id)) {
+            const FPOINT& pt = points.GetPoint(id);
+            m_x[id].push_back(pt.x);
+            m_y[id].push_back(pt.y);
+            pointMask |= static_cast<unsigned char>(1 << id);
+        } else {
+            m_x[id].push_back(0.0);
+            m_y[id].push_back(0.0);
+        }
+    }
+
+    m_fieldMask.push_back(fieldMask);
+    m_pointMask.push_back(pointMask);
+    m_width.push_back(width);
+    m_height.push_back(height);
+    m_distance.push_back(distance);
+    m_area.push_back(area);
+    m_angle.push_back(angle);
+
+    return GetCount() - 1;
+}
+
+
+bool MeaPositionBatch::GetPoint(int index, MeaPositionPoints::PointId id, FPOINT& pt) const
+{
+    MeaAssert(id < MeaPositionPoints::kNumPointIds);
+
+    if ((m_pointMask[index] & (1 << id)) == 0) {
+        return false;
+    }
+
+    pt.x = m_x[id][index];
+    pt.y = m_y[id][index];
+    return true;
+}
+
+
+void MeaPositionBatch::Convert(const ScaleList& scales, double angleFactor)
+{
+    MeaAssert(!scales.empty());
+
+    int count = GetCount();
+    if (count == 0) {
+        return;
+    }
+
+    bool uniform = true;
+    for (ScaleList::const_iterator iter = scales.begin() + 1; iter != scales.end(); ++iter) {
+        if ((*iter).factor.cx != scales[0].factor.cx || (*iter).factor.cy != scales[0].factor.cy) {
+            uniform = false;
+            break;
+        }
+    }
+
+    if (uniform) {
+        // All screens have the same factors (e.g. there is only one screen,
+        // or the units do not depend on the screen resolution), so each
+        // field is scaled by a constant.
+        //
+        double fx = scales[0].factor.cx;
+        double fy = scales[0].factor.cy;
+
+        if (fx == fy) {
+            ScaleValues(Values(m_distance), count, fx);
+        } else {
+            for (int i = 0; i < count; i++) {
+                bool haveSize = (m_fieldMask[i] & (MeaWidthField | MeaHeightField)) == (MeaWidthField | MeaHeightField);
+                m_distance[i] *= DistanceFactor(fx, fy, m_width[i], m_height[i], haveSize);
+            }
+        }
+
+        for (int id = 0; id < MeaPositionPoints::kNumPointIds; id++) {
+            ScaleValues(Values(m_x[id]), count, fx);
+            ScaleValues(Values(m_y[id]), count, fy);
+        }
+
+        ScaleValues(Values(m_width), count, fx);
+        ScaleValues(Values(m_height), count, fy);
+        ScaleValues(Values(m_area), count, fx * fy);
+    } else {
+        FindFactors(scales);
+
+        // The distance factor depends on the width and height before they
+        // are converted.
+        //
+        for (int i = 0; i < count; i++) {
+            bool haveSize = (m_fieldMask[i] & (MeaWidthField | MeaHeightField)) == (MeaWidthField | MeaHeightField);
+            m_distance[i] *= DistanceFactor(m_sizeFactorX[i], m_sizeFactorY[i], m_width[i], m_height[i], haveSize);
+        }
+
+        for (int id = 0; id < MeaPositionPoints::kNumPointIds; id++) {
+            ScaleValues(Values(m_x[id]), Values(m_pointFactorX[id]), count);
+            ScaleValues(Values(m_y[id]), Values(m_pointFactorY[id]), count);
+        }
+
+        ScaleValues(Values(m_width), Values(m_sizeFactorX), count);
+        ScaleValues(Values(m_height), Values(m_sizeFactorY), count);
+        ScaleValues(Values(m_area), Values(m_sizeFactorX), Values(m_sizeFactorY), count);
+    }
+
+    ScaleValues(Values(m_angle), count, angleFactor);
+}
+
+
+void MeaPositionBatch::FindFactors(const ScaleList& scales)
+{
+    int count = GetCount();
+
+    m_sizeFactorX.resize(count);
+    m_sizeFactorY.resize(count);
+
+    for (int id = 0; id < MeaPositionPoints::kNumPointIds; id++) {
+        m_pointFactorX[id].resize(count);
+        m_pointFactorY[id].resize(count);
+
+        const double* xs = Values(m_x[id]);
+        const double* ys = Values(m_y[id]);
+        double* fxs = Values(m_pointFactorX[id]);
+        double* fys = Values(m_pointFactorY[id]);
+
+        for (int i = 0; i < count; i++) {
+            const Scale* found = &scales[0];
+
+            // The screen rectangles are in the units being converted from,
+            // where the y-axis may be inverted, so the edges are compared
+            // without assuming their order.
+            //
+            for (ScaleList::const_iterator iter = scales.begin(); iter != scales.end(); ++iter) {
+                const FRECT& rect = (*iter).rect;
+                double x = xs[i];
+                double y = ys[i];
+
+                if (x >= min(rect.left, rect.right) && x <= max(rect.left, rect.right) &&
+                        y >= min(rect.top, rect.bottom) && y <= max(rect.top, rect.bottom)) {
+                    found = &(*iter);
+                    break;
+                }
+            }
+
+            fxs[i] = found->factor.cx;
+            fys[i] = found->factor.cy;
+        }
+    }
+
+    // The sizes of a position use the factors of its first point.
+    //
+    for (int i = 0; i < count; i++) {
+        m_sizeFactorX[i] = scales[0].factor.cx;
+        m_sizeFactorY[i] = scales[0].factor.cy;
+
+        for (int id = 0; id < MeaPositionPoints::kNumPointIds; id++) {
+            if ((m_pointMask[i] & (1 << id)) != 0) {
+                m_sizeFactorX[i] = m_pointFactorX[id][i];
+                m_sizeFactorY[i] = m_pointFactorY[id][i];
+                break;
+            }
+        }
+    }
+}
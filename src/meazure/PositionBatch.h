@@ -0,0 +1,187 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Header file for converting batches of positions between units.
+
+#pragma once
+
+#include <vector>
+#include "Utils.h"
+#include "PositionPoints.h"
+
+
+/// Holds the measurement values of a batch of positions so that they can
+/// be converted from one set of units to another in a single pass. The
+/// values are stored by field rather than by position (i.e. one array of
+/// all the x1 coordinates, one array of all the widths, and so on), so
+/// that each field is converted by a loop over a contiguous array of
+/// doubles. The loops are written with SSE2 instructions that convert two
+/// values at a time.
+///
+/// Positions are stored relative to an origin, with the y-axis possibly
+/// inverted. Both the origin and the y-axis orientation are defined in
+/// pixels, so converting a position to other units while keeping the same
+/// origin and orientation only scales its values. The scale factors depend
+/// on the resolution of the screen on which a position is located, so the
+/// conversion is described by a list of screens and their factors. A point
+/// is scaled by the factors of the screen that contains it. The width,
+/// height, distance and area of a position are scaled by the factors of the
+/// screen containing the first point of the position.
+///
+class MeaPositionBatch
+{
+public:
+    /// Conversion factors for the positions located on one screen.
+    ///
+    struct Scale
+    {
+        FRECT   rect;       ///< Screen rectangle, in the units being converted from.
+        FSIZE   factor;     ///< X and Y factors from the units being converted from to the units being converted to.
+    };
+
+    typedef std::vector<Scale> ScaleList;       ///< Conversion factors for each screen.
+
+
+    /// Constructs an empty batch.
+    ///
+    MeaPositionBatch();
+
+    /// Destroys the batch.
+    ///
+    ~MeaPositionBatch();
+
+
+    /// Allocates space for the specified number of positions so that
+    /// adding them does not reallocate the field arrays.
+    ///
+    /// @param count    [in] Number of positions.
+    ///
+    void Reserve(int count);
+
+    /// Removes all positions from the batch.
+    ///
+    void Clear();
+
+    /// Returns the number of positions in the batch.
+    ///
+    /// @return Number of positions.
+    ///
+    int GetCount() const { return static_cast<int>(m_fieldMask.size()); }
+
+
+    /// Adds a position to the batch.
+    ///
+    /// @param fieldMask    [in] Data fields defined for the position (see MeaFields).
+    /// @param points       [in] Points of the position. Only the points with
+    ///                     point IDs are held by the batch.
+    /// @param width        [in] Width.
+    /// @param height       [in] Height.
+    /// @param distance     [in] Distance.
+    /// @param area         [in] Area.
+    /// @param angle        [in] Angle.
+    ///
+    /// @return Index of the position in the batch.
+    ///
+    int Add(UINT fieldMask, const MeaPositionPoints& points, double width, double height,
+            double distance, double area, double angle);
+
+
+    /// Returns the data fields defined for a position.
+    ///
+    /// @param index    [in] Position index in the batch.
+    ///
+    /// @return Data fields (see MeaFields).
+    ///
+    UINT GetFieldMask(int index) const { return m_fieldMask[index]; }
+
+    /// Returns a point of a position.
+    ///
+    /// @param index    [in] Position index in the batch.
+    /// @param id       [in] Point ID.
+    /// @param pt       [out] Point coordinates.
+    ///
+    /// @return <b>true</b> if the position has the point.
+    ///
+    bool GetPoint(int index, MeaPositionPoints::PointId id, FPOINT& pt) const;
+
+    /// Returns the width of a position.
+    /// @param index    [in] Position index in the batch.
+    /// @return Width.
+    double GetWidth(int index) const { return m_width[index]; }
+
+    /// Returns the height of a position.
+    /// @param index    [in] Position index in the batch.
+    /// @return Height.
+    double GetHeight(int index) const { return m_height[index]; }
+
+    /// Returns the distance of a position.
+    /// @param index    [in] Position index in the batch.
+    /// @return Distance.
+    double GetDistance(int index) const { return m_distance[index]; }
+
+    /// Returns the area of a position.
+    /// @param index    [in] Position index in the batch.
+    /// @return Area.
+    double GetArea(int index) const { return m_area[index]; }
+
+    /// Returns the angle of a position.
+    /// @param index    [in] Position index in the batch.
+    /// @return Angle.
+    double GetAngle(int index) const { return m_angle[index]; }
+
+
+    /// Converts all positions in the batch to other units.
+    ///
+    /// @param scales       [in] Linear conversion factors for each screen.
+    ///                     Must contain at least one screen. A position that
+    ///                     is not on any screen is converted using the factors
+    ///                     of the first screen.
+    /// @param angleFactor  [in] Factor from the angular units being converted
+    ///                     from to the angular units being converted to.
+    ///
+    void Convert(const ScaleList& scales, double angleFactor);
+
+private:
+    typedef std::vector<double> Column;     ///< Values of one field for all positions.
+
+
+    /// Determines the screen factors of each point of each position.
+    /// Fills in m_pointFactorX/Y for each point ID and m_sizeFactorX/Y.
+    ///
+    /// @param scales       [in] Linear conversion factors for each screen.
+    ///
+    void FindFactors(const ScaleList& scales);
+
+
+    std::vector<UINT>           m_fieldMask;                    ///< Data fields of each position.
+    std::vector<unsigned char>  m_pointMask;                    ///< Bit per point ID for each position, indicating whether the point is present.
+    Column                      m_x[MeaPositionPoints::kNumPointIds];   ///< X coordinate of each point.
+    Column                      m_y[MeaPositionPoints::kNumPointIds];   ///< Y coordinate of each point.
+    Column                      m_width;                        ///< Width of each position.
+    Column                      m_height;                       ///< Height of each position.
+    Column                      m_distance;                     ///< Distance of each position.
+    Column                      m_area;                         ///< Area of each position.
+    Column                      m_angle;                        ///< Angle of each position.
+
+    Column                      m_pointFactorX[MeaPositionPoints::kNumPointIds];    ///< X factor for each point, when there are several screens.
+    Column                      m_pointFactorY[MeaPositionPoints::kNumPointIds];    ///< Y factor for each point, when there are several screens.
+    Column                      m_sizeFactorX;                  ///< X factor for the sizes of each position, when there are several screens.
+    Column                      m_sizeFactorY;                  ///< Y factor for the sizes of each position, when there are several screens.
+};
@@ -0,0 +1,407 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include "PositionIndex.h"
+#include "MeaAssert.h"
+#include <algorithm>
+#include <limits.h>
+
+
+const double MeaPositionIndex::kDefaultCellSize = 64.0;
+
+
+MeaPositionIndex::MeaPositionIndex(double cellSize) :
+    m_cellSize(cellSize),
+    m_liveCount(0)
+{
+    MeaAssert(cellSize > 0.0);
+
+    m_liveTree.push_back(0);
+}
+
+
+MeaPositionIndex::~MeaPositionIndex()
+{
+}
+
+
+void MeaPositionIndex::Add(const CString& toolName, const CString& timestamp, const MeaPositionPoints& points)
+{
+    unsigned int id = static_cast<unsigned int>(m_entries.size());
+
+    m_entries.push_back(Entry());
+    m_entries.back().live = true;
+
+    // Extend the binary indexed tree. The new node covers the entries
+    // from i - lowbit(i) + 1 through i, which are all live entries
+    // counted by prefix sums of the existing nodes plus the new entry.
+    //
+    int i = static_cast<int>(id) + 1;
+    int low = i - (i & -i);
+    int count = 1;
+    int j;
+
+    for (j = i - 1; j > 0; j -= (j & -j)) {
+        count += m_liveTree[j];
+    }
+    for (j = low; j > 0; j -= (j & -j)) {
+        count -= m_liveTree[j];
+    }
+    m_liveTree.push_back(count);
+    m_liveCount++;
+
+    Link(id, toolName, timestamp, points);
+}
+
+
+void MeaPositionIndex::Replace(unsigned int posIndex, const CString& toolName, const CString& timestamp,
+                               const MeaPositionPoints& points) throw(std::out_of_range)
+{
+    if (posIndex >= m_liveCount) {
+        throw new std::out_of_range("MeaPositionIndex::Replace posIndex out of range");
+    }
+
+    unsigned int id = GetId(posIndex);
+
+    Unlink(id);
+    Link(id, toolName, timestamp, points);
+}
+
+
+void MeaPositionIndex::Delete(unsigned int posIndex, unsigned int count) throw(std::out_of_range)
+{
+    if ((posIndex > m_liveCount) || (count > m_liveCount - posIndex)) {
+        throw new std::out_of_range("MeaPositionIndex::Delete posIndex out of range");
+    }
+
+    // Look up all the IDs before any are deleted, because deleting a
+    // position changes the index of the positions after it.
+    //
+    IdList ids;
+    unsigned int i;
+
+    ids.reserve(count);
+    for (i = 0; i < count; i++) {
+        ids.push_back(GetId(posIndex + i));
+    }
+
+    for (IdList::const_iterator iter = ids.begin(); iter != ids.end(); ++iter) {
+        unsigned int id = *iter;
+
+        Unlink(id);
+
+        Entry& entry = m_entries[id];
+        entry.live = false;
+        entry.points = NULL;
+
+        for (int j = static_cast<int>(id) + 1; j < static_cast<int>(m_liveTree.size()); j += (j & -j)) {
+            m_liveTree[j]--;
+        }
+        m_liveCount--;
+    }
+
+    if (m_entries.size() - m_liveCount > m_liveCount) {
+        Compact();
+    }
+}
+
+
+void MeaPositionIndex::Clear()
+{
+    m_entries.clear();
+    m_liveTree.clear();
+    m_liveTree.push_back(0);
+    m_liveCount = 0;
+    m_toolIndex.clear();
+    m_timeIndex.clear();
+    m_gridIndex.clear();
+}
+
+
+void MeaPositionIndex::FindTool(const CString& toolName, IndexList& result) const
+{
+    result.clear();
+
+    ToolIndex::const_iterator iter = m_toolIndex.find(toolName);
+    if (iter != m_toolIndex.end()) {
+        const IdSet& ids = (*iter).second;
+
+        result.reserve(ids.size());
+        for (IdSet::const_iterator idIter = ids.begin(); idIter != ids.end(); ++idIter) {
+            result.push_back(GetIndex(*idIter));
+        }
+    }
+}
+
+
+void MeaPositionIndex::FindTimeRange(const CString& start, const CString& end, IndexList& result) const
+{
+    IdList ids;
+
+    TimeIndex::const_iterator last = m_timeIndex.upper_bound(end);
+    for (TimeIndex::const_iterator iter = m_timeIndex.lower_bound(start); iter != last; ++iter) {
+        ids.push_back((*iter).second);
+    }
+
+    ToIndices(ids, result);
+}
+
+
+void MeaPositionIndex::FindInRect(const FRECT& rect, IndexList& result) const
+{
+    double minX = (rect.left < rect.right) ? rect.left : rect.right;
+    double maxX = (rect.left < rect.right) ? rect.right : rect.left;
+    double minY = (rect.top < rect.bottom) ? rect.top : rect.bottom;
+    double maxY = (rect.top < rect.bottom) ? rect.bottom : rect.top;
+
+    int cellMinX = CellCoord(minX);
+    int cellMaxX = CellCoord(maxX);
+    int cellMinY = CellCoord(minY);
+    int cellMaxY = CellCoord(maxY);
+
+    // Gather the positions in the cells overlapped by the rectangle. If
+    // the rectangle covers more cells than are occupied, it is quicker
+    // to test each occupied cell.
+    //
+    IdList candidates;
+    double numCells = (static_cast<double>(cellMaxX) - cellMinX + 1.0) *
+                      (static_cast<double>(cellMaxY) - cellMinY + 1.0);
+
+    if (numCells > static_cast<double>(m_gridIndex.size())) {
+        for (GridIndex::const_iterator iter = m_gridIndex.begin(); iter != m_gridIndex.end(); ++iter) {
+            int x = static_cast<int>(static_cast<unsigned int>((*iter).first >> 32));
+            int y = static_cast<int>(static_cast<unsigned int>((*iter).first));
+
+            if ((x >= cellMinX) && (x <= cellMaxX) && (y >= cellMinY) && (y <= cellMaxY)) {
+                candidates.insert(candidates.end(), (*iter).second.begin(), (*iter).second.end());
+            }
+        }
+    } else {
+        for (int x = cellMinX; x <= cellMaxX; x++) {
+            for (int y = cellMinY; y <= cellMaxY; y++) {
+                GridIndex::const_iterator iter = m_gridIndex.find(CellKey(x, y));
+                if (iter != m_gridIndex.end()) {
+                    candidates.insert(candidates.end(), (*iter).second.begin(), (*iter).second.end());
+                }
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    // A position in an overlapped cell need not have a point within the
+    // rectangle itself.
+    //
+    IdList ids;
+
+    for (IdList::const_iterator iter = candidates.begin(); iter != candidates.end(); ++iter) {
+        const MeaPositionPoints& points = *m_entries[*iter].points;
+        int count = points.GetCount();
+
+        for (int i = 0; i < count; i++) {
+            const FPOINT& pt = points.GetPointAt(i);
+
+            if ((pt.x >= minX) && (pt.x <= maxX) && (pt.y >= minY) && (pt.y <= maxY)) {
+                ids.push_back(*iter);
+                break;
+            }
+        }
+    }
+
+    ToIndices(ids, result);
+}
+
+
+void MeaPositionIndex::Link(unsigned int id, const CString& toolName, const CString& timestamp,
+                            const MeaPositionPoints& points)
+{
+    Entry& entry = m_entries[id];
+
+    entry.tool = m_toolIndex.insert(ToolIndex::value_type(toolName, IdSet())).first;
+    (*entry.tool).second.insert((*entry.tool).second.end(), id);
+
+    entry.time = m_timeIndex.insert(m_timeIndex.end(), TimeIndex::value_type(timestamp, id));
+
+    entry.points = &points;
+
+    int count = points.GetCount();
+    for (int i = 0; i < count; i++) {
+        const FPOINT& pt = points.GetPointAt(i);
+        InsertId(m_gridIndex[CellKey(CellCoord(pt.x), CellCoord(pt.y))], id);
+    }
+}
+
+
+void MeaPositionIndex::Unlink(unsigned int id)
+{
+    const Entry& entry = m_entries[id];
+
+    (*entry.tool).second.erase(id);
+    if ((*entry.tool).second.empty()) {
+        m_toolIndex.erase(entry.tool);
+    }
+
+    m_timeIndex.erase(entry.time);
+
+    int count = entry.points->GetCount();
+    for (int i = 0; i < count; i++) {
+        const FPOINT& pt = entry.points->GetPointAt(i);
+        GridIndex::iterator cellIter = m_gridIndex.find(CellKey(CellCoord(pt.x), CellCoord(pt.y)));
+        if (cellIter != m_gridIndex.end()) {
+            EraseId((*cellIter).second, id);
+            if ((*cellIter).second.empty()) {
+                m_gridIndex.erase(cellIter);
+            }
+        }
+    }
+}
+
+
+void MeaPositionIndex::Compact()
+{
+    // The tool names and timestamps are held by the indexes being
+    // rebuilt, so they are copied out first. CString copies share the
+    // string data rather than duplicating it.
+    //
+    std::vector<CString> toolNames;
+    std::vector<CString> timestamps;
+    std::vector<const MeaPositionPoints*> points;
+
+    toolNames.reserve(m_liveCount);
+    timestamps.reserve(m_liveCount);
+    points.reserve(m_liveCount);
+
+    for (EntryList::const_iterator iter = m_entries.begin(); iter != m_entries.end(); ++iter) {
+        if ((*iter).live) {
+            toolNames.push_back((*(*iter).tool).first);
+            timestamps.push_back((*(*iter).time).first);
+            points.push_back((*iter).points);
+        }
+    }
+
+    Clear();
+
+    // Release the storage of the deleted entries.
+    //
+    EntryList entries;
+    entries.reserve(points.size());
+    m_entries.swap(entries);
+
+    std::vector<int> liveTree;
+    liveTree.reserve(points.size() + 1);
+    liveTree.push_back(0);
+    m_liveTree.swap(liveTree);
+
+    for (size_t i = 0; i < points.size(); i++) {
+        Add(toolNames[i], timestamps[i], *points[i]);
+    }
+}
+
+
+unsigned int MeaPositionIndex::GetId(unsigned int posIndex) const
+{
+    MeaAssert(posIndex < m_liveCount);
+
+    // Descend the binary indexed tree to find the smallest ID whose
+    // live prefix count is posIndex + 1.
+    //
+    int size = static_cast<int>(m_liveTree.size()) - 1;
+    int step = 1;
+    int pos = 0;
+    int remaining = static_cast<int>(posIndex) + 1;
+
+    while ((step << 1) <= size) {
+        step <<= 1;
+    }
+
+    for (; step > 0; step >>= 1) {
+        if ((pos + step <= size) && (m_liveTree[pos + step] < remaining)) {
+            pos += step;
+            remaining -= m_liveTree[pos];
+        }
+    }
+
+    return static_cast<unsigned int>(pos);
+}
+
+
+unsigned int MeaPositionIndex::GetIndex(unsigned int id) const
+{
+    int count = 0;
+
+    for (int i = static_cast<int>(id); i > 0; i -= (i & -i)) {
+        count += m_liveTree[i];
+    }
+
+    return static_cast<unsigned int>(count);
+}
+
+
+void MeaPositionIndex::ToIndices(IdList& ids, IndexList& result) const
+{
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    result.clear();
+    result.reserve(ids.size());
+    for (IdList::const_iterator iter = ids.begin(); iter != ids.end(); ++iter) {
+        result.push_back(GetIndex(*iter));
+    }
+}
+
+
+int MeaPositionIndex::CellCoord(double coord) const
+{
+    double cell = floor(coord / m_cellSize);
+
+    if (!(cell > static_cast<double>(INT_MIN / 2))) {      // Also catches NaN
+        return INT_MIN / 2;
+    }
+    if (cell > static_cast<double>(INT_MAX / 2)) {
+        return INT_MAX / 2;
+    }
+    return static_cast<int>(cell);
+}
+
+
+void MeaPositionIndex::InsertId(IdList& ids, unsigned int id)
+{
+    // IDs are usually added in ascending order.
+    //
+    if (ids.empty() || (ids.back() < id)) {
+        ids.push_back(id);
+        return;
+    }
+
+    IdList::iterator iter = std::lower_bound(ids.begin(), ids.end(), id);
+    if ((iter == ids.end()) || (*iter != id)) {
+        ids.insert(iter, id);
+    }
+}
+
+
+void MeaPositionIndex::EraseId(IdList& ids, unsigned int id)
+{
+    IdList::iterator iter = std::lower_bound(ids.begin(), ids.end(), id);
+    if ((iter != ids.end()) && (*iter == id)) {
+        ids.erase(iter);
+    }
+}
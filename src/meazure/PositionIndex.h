@@ -0,0 +1,259 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Header file for the secondary indexes over recorded positions.
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "Utils.h"
+#include "PositionPoints.h"
+
+
+/// Secondary indexes over a list of recorded positions, used to find the
+/// positions recorded by a given tool, recorded within a range of times,
+/// or having a point within a rectangle. The indexes mirror the position
+/// list: positions are added at the end and replaced or deleted by their
+/// zero based index, just as in the list, and queries return indices into
+/// the list.
+///
+/// Internally each position is given an ID in the order in which it was
+/// added. Because positions are only ever added at the end of the list,
+/// the ID order is also the list order, and the list index of an ID is
+/// the number of IDs before it that have not been deleted. That count is
+/// kept in a binary indexed tree so that deleting a position does not
+/// require renumbering the entries in every index. Once more positions
+/// have been deleted than remain, the IDs are reassigned so that the
+/// entries of deleted positions do not accumulate.
+///
+/// The index does not copy the points of a position. It refers to the
+/// position's points object, which must not be changed or destroyed until
+/// the position has been replaced or deleted in the index.
+///
+class MeaPositionIndex
+{
+public:
+    typedef std::vector<unsigned int> IndexList;    ///< Position indices in ascending order.
+
+
+    /// Constructs an empty index.
+    ///
+    /// @param cellSize     [in] Width and height of a spatial grid cell, in
+    ///                     the units of the recorded points.
+    ///
+    explicit MeaPositionIndex(double cellSize = kDefaultCellSize);
+
+    /// Destroys the index.
+    ///
+    ~MeaPositionIndex();
+
+
+    /// Returns the number of positions in the index.
+    ///
+    /// @return Number of positions.
+    ///
+    unsigned int Size() const { return m_liveCount; }
+
+
+    /// Indexes a position added to the end of the position list.
+    ///
+    /// @param toolName     [in] Name of the tool that recorded the position.
+    /// @param timestamp    [in] ISO 8601 timestamp of the position.
+    /// @param points       [in] Points of the position. Referenced, not copied.
+    ///
+    void Add(const CString& toolName, const CString& timestamp, const MeaPositionPoints& points);
+
+    /// Reindexes a position that has been replaced in the position list.
+    /// The points of the position being replaced must still be valid.
+    ///
+    /// @param posIndex     [in] Zero based index of the replaced position.
+    /// @param toolName     [in] Name of the tool that recorded the position.
+    /// @param timestamp    [in] ISO 8601 timestamp of the position.
+    /// @param points       [in] Points of the position. Referenced, not copied.
+    ///
+    void Replace(unsigned int posIndex, const CString& toolName, const CString& timestamp,
+                 const MeaPositionPoints& points) throw(std::out_of_range);
+
+    /// Removes a contiguous range of positions deleted from the position list.
+    /// The points of the deleted positions must still be valid.
+    ///
+    /// @param posIndex     [in] Zero based index of the first deleted position.
+    /// @param count        [in] Number of positions deleted.
+    ///
+    void Delete(unsigned int posIndex, unsigned int count) throw(std::out_of_range);
+
+    /// Removes all positions from the index.
+    ///
+    void Clear();
+
+
+    /// Finds the positions recorded by the specified tool.
+    ///
+    /// @param toolName     [in] Name of the tool.
+    /// @param result       [out] Indices of the matching positions.
+    ///
+    void FindTool(const CString& toolName, IndexList& result) const;
+
+    /// Finds the positions recorded within the specified range of times.
+    /// Because ISO 8601 timestamps sort in time order, the range is
+    /// expressed using timestamps.
+    ///
+    /// @param start        [in] Earliest timestamp, inclusive.
+    /// @param end          [in] Latest timestamp, inclusive.
+    /// @param result       [out] Indices of the matching positions.
+    ///
+    void FindTimeRange(const CString& start, const CString& end, IndexList& result) const;
+
+    /// Finds the positions having at least one point within the specified
+    /// rectangle. The rectangle is expressed in the units of the recorded
+    /// points and its edges are inclusive.
+    ///
+    /// @param rect         [in] Rectangle to search.
+    /// @param result       [out] Indices of the matching positions.
+    ///
+    void FindInRect(const FRECT& rect, IndexList& result) const;
+
+
+    static const double kDefaultCellSize;   ///< Default spatial grid cell size.
+
+private:
+    typedef std::vector<unsigned int> IdList;                       ///< Position IDs in ascending order.
+    typedef std::set<unsigned int> IdSet;                           ///< Position IDs in ascending order.
+    typedef std::map<CString, IdSet> ToolIndex;                     ///< Maps a tool name to the IDs of its positions.
+    typedef std::multimap<CString, unsigned int> TimeIndex;         ///< Maps a timestamp to the IDs of positions recorded at that time.
+    typedef std::unordered_map<unsigned __int64, IdList> GridIndex; ///< Maps a grid cell to the IDs of positions having a point in the cell.
+
+    /// Indexed information for a position. The tool name and timestamp
+    /// are held only once, as keys of the tool and time indexes, and the
+    /// entry refers to its place in those indexes so that it can be
+    /// removed without searching. A tool has many positions, so its IDs
+    /// are kept in a set. The positions in a grid cell are few enough for
+    /// a sorted list.
+    ///
+    struct Entry
+    {
+        ToolIndex::iterator         tool;       ///< Tool index entry of the tool that recorded the position.
+        TimeIndex::iterator         time;       ///< Time index entry of the position.
+        const MeaPositionPoints*    points;     ///< Points of the position.
+        bool                        live;       ///< Has the position not been deleted.
+    };
+
+    typedef std::vector<Entry> EntryList;       ///< Entries indexed by position ID.
+
+
+    /// Purposely undefined.
+    MeaPositionIndex(const MeaPositionIndex&);
+
+    /// Purposely undefined.
+    MeaPositionIndex& operator=(const MeaPositionIndex&);
+
+
+    /// Adds the entry with the specified ID to the tool, time and grid indexes.
+    ///
+    /// @param id           [in] ID of the entry.
+    /// @param toolName     [in] Name of the tool that recorded the position.
+    /// @param timestamp    [in] Timestamp of the position.
+    /// @param points       [in] Points of the position.
+    ///
+    void    Link(unsigned int id, const CString& toolName, const CString& timestamp,
+                 const MeaPositionPoints& points);
+
+    /// Removes the entry with the specified ID from the tool, time and grid
+    /// indexes.
+    ///
+    /// @param id           [in] ID of the entry.
+    ///
+    void    Unlink(unsigned int id);
+
+    /// Reassigns the IDs of the positions that have not been deleted and
+    /// rebuilds the indexes, discarding the entries of deleted positions.
+    ///
+    void    Compact();
+
+    /// Returns the ID of the position at the specified list index.
+    ///
+    /// @param posIndex     [in] Zero based position index.
+    ///
+    /// @return ID of the position.
+    ///
+    unsigned int    GetId(unsigned int posIndex) const;
+
+    /// Returns the list index of the position with the specified ID.
+    ///
+    /// @param id           [in] ID of a position that has not been deleted.
+    ///
+    /// @return Zero based position index.
+    ///
+    unsigned int    GetIndex(unsigned int id) const;
+
+    /// Converts a list of IDs, which need not be sorted or unique, to a
+    /// sorted list of position indices.
+    ///
+    /// @param ids          [in] IDs of positions that have not been deleted.
+    /// @param result       [out] Position indices.
+    ///
+    void    ToIndices(IdList& ids, IndexList& result) const;
+
+    /// Returns the key of the grid cell containing the specified point.
+    ///
+    /// @param x            [in] Grid column.
+    /// @param y            [in] Grid row.
+    ///
+    /// @return Cell key.
+    ///
+    static unsigned __int64 CellKey(int x, int y) {
+        return (static_cast<unsigned __int64>(static_cast<unsigned int>(x)) << 32) | static_cast<unsigned int>(y);
+    }
+
+    /// Returns the grid column or row containing the specified coordinate.
+    ///
+    /// @param coord        [in] X or y coordinate.
+    ///
+    /// @return Grid column or row.
+    ///
+    int     CellCoord(double coord) const;
+
+    /// Inserts an ID into an ascending ID list.
+    ///
+    /// @param ids          [in] List to insert into.
+    /// @param id           [in] ID to insert.
+    ///
+    static void InsertId(IdList& ids, unsigned int id);
+
+    /// Removes an ID from an ascending ID list.
+    ///
+    /// @param ids          [in] List to remove from.
+    /// @param id           [in] ID to remove.
+    ///
+    static void EraseId(IdList& ids, unsigned int id);
+
+
+    double              m_cellSize;     ///< Width and height of a grid cell.
+    EntryList           m_entries;      ///< Entries indexed by position ID.
+    std::vector<int>    m_liveTree;     ///< Binary indexed tree counting the live entries, indexed by ID + 1.
+    unsigned int        m_liveCount;    ///< Number of live entries.
+    ToolIndex           m_toolIndex;    ///< Positions by tool name.
+    TimeIndex           m_timeIndex;    ///< Positions by timestamp.
+    GridIndex           m_gridIndex;    ///< Positions by grid cell.
+};
@@ -0,0 +1,703 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include "PositionLogBinary.h"
+#include "LogFileException.h"
+#include "MeaAssert.h"
+
+
+const char      MeaBinaryLogReader::kMagic[8] = { 'M', 'E', 'A', 'P', 'L', 'O', 'G', '\0' };
+const UINT32    MeaBinaryLogReader::kFormatVersion = 1;
+
+
+//*************************************************************************
+// MeaBinaryLogWriter
+//*************************************************************************
+
+
+MeaBinaryLogWriter::MeaBinaryLogWriter() :
+    m_screenMark(0),
+    m_precisionMark(0),
+    m_pointMark(0)
+{
+    memset(&m_header, 0, sizeof(m_header));
+    memcpy(m_header.magic, MeaBinaryLogReader::kMagic, sizeof(m_header.magic));
+    m_header.formatVersion = MeaBinaryLogReader::kFormatVersion;
+
+    // Offset zero of the string table is always the empty string.
+    //
+    AddString(_T(""));
+}
+
+
+MeaBinaryLogWriter::~MeaBinaryLogWriter()
+{
+}
+
+
+void MeaBinaryLogWriter::SetInfo(const CString& title, const CString& desc)
+{
+    m_header.titleStr = AddString(title);
+    m_header.descStr = AddString(desc);
+}
+
+
+UINT32 MeaBinaryLogWriter::AddString(const CString& str)
+{
+    StringMap::const_iterator iter = m_stringMap.find(str);
+    if (iter != m_stringMap.end()) {
+        return (*iter).second;
+    }
+
+    CStringW wideStr(str);
+    UINT32 count = wideStr.GetLength();
+    UINT32 offset = static_cast<UINT32>(m_strings.size());
+
+    m_strings.resize(offset + sizeof(UINT32) + count * sizeof(WCHAR));
+    memcpy(&m_strings[offset], &count, sizeof(UINT32));
+    if (count > 0) {
+        memcpy(&m_strings[offset + sizeof(UINT32)], static_cast<LPCWSTR>(wideStr), count * sizeof(WCHAR));
+    }
+
+    m_stringMap[str] = offset;
+    return offset;
+}
+
+
+void MeaBinaryLogWriter::AddDesktop(const MeaBinaryLogDesktop& desktop)
+{
+    MeaBinaryLogDesktop record(desktop);
+
+    record.firstScreen = m_screenMark;
+    record.screenCount = static_cast<UINT32>(m_screens.size()) - m_screenMark;
+    record.firstPrecision = m_precisionMark;
+    record.precisionCount = static_cast<UINT32>(m_precisions.size()) - m_precisionMark;
+
+    m_screenMark = static_cast<UINT32>(m_screens.size());
+    m_precisionMark = static_cast<UINT32>(m_precisions.size());
+
+    m_desktopIndexMap[MeaGUID(record.id)] = static_cast<UINT32>(m_desktops.size());
+    m_desktops.push_back(record);
+}
+
+
+void MeaBinaryLogWriter::AddPoint(const CString& name, double x, double y)
+{
+    MeaBinaryLogPoint point;
+
+    point.nameStr = AddString(name);
+    point.x = x;
+    point.y = y;
+
+    m_points.push_back(point);
+}
+
+
+void MeaBinaryLogWriter::AddPosition(const MeaGUID& desktopId, const MeaBinaryLogPosition& position)
+{
+    DesktopIndexMap::const_iterator iter = m_desktopIndexMap.find(desktopId);
+    MeaAssert(iter != m_desktopIndexMap.end());
+
+    MeaBinaryLogPosition record(position);
+
+    record.desktop = (*iter).second;
+    record.firstPoint = m_pointMark;
+    record.pointCount = static_cast<UINT32>(m_points.size()) - m_pointMark;
+
+    m_pointMark = static_cast<UINT32>(m_points.size());
+
+    m_positions.push_back(record);
+}
+
+
+void MeaBinaryLogWriter::Write(CFile& file) const throw(CFileException)
+{
+    MeaBinaryLogHeader header(m_header);
+    UINT32 offset = sizeof(header);
+
+    header.desktopOffset = offset;
+    header.desktopCount = static_cast<UINT32>(m_desktops.size());
+    offset += header.desktopCount * sizeof(MeaBinaryLogDesktop);
+
+    header.screenOffset = offset;
+    header.screenCount = static_cast<UINT32>(m_screens.size());
+    offset += header.screenCount * sizeof(MeaBinaryLogScreen);
+
+    header.precisionOffset = offset;
+    header.precisionCount = static_cast<UINT32>(m_precisions.size());
+    offset += header.precisionCount * sizeof(INT32);
+
+    header.positionOffset = offset;
+    header.positionCount = static_cast<UINT32>(m_positions.size());
+    offset += header.positionCount * sizeof(MeaBinaryLogPosition);
+
+    header.pointOffset = offset;
+    header.pointCount = static_cast<UINT32>(m_points.size());
+    offset += header.pointCount * sizeof(MeaBinaryLogPoint);
+
+    header.stringOffset = offset;
+    header.stringSize = static_cast<UINT32>(m_strings.size());
+
+    file.Write(&header, sizeof(header));
+    if (!m_desktops.empty()) {
+        file.Write(&m_desktops[0], header.desktopCount * sizeof(MeaBinaryLogDesktop));
+    }
+    if (!m_screens.empty()) {
+        file.Write(&m_screens[0], header.screenCount * sizeof(MeaBinaryLogScreen));
+    }
+    if (!m_precisions.empty()) {
+        file.Write(&m_precisions[0], header.precisionCount * sizeof(INT32));
+    }
+    if (!m_positions.empty()) {
+        file.Write(&m_positions[0], header.positionCount * sizeof(MeaBinaryLogPosition));
+    }
+    if (!m_points.empty()) {
+        file.Write(&m_points[0], header.pointCount * sizeof(MeaBinaryLogPoint));
+    }
+    file.Write(&m_strings[0], header.stringSize);
+}
+
+
+//*************************************************************************
+// MeaBinaryLogReader
+//*************************************************************************
+
+
+MeaBinaryLogReader::MeaBinaryLogReader() :
+    m_file(INVALID_HANDLE_VALUE),
+    m_mapping(NULL),
+    m_view(NULL),
+    m_size(0),
+    m_header(NULL),
+    m_desktops(NULL),
+    m_screens(NULL),
+    m_precisions(NULL),
+    m_positions(NULL),
+    m_points(NULL),
+    m_strings(NULL)
+{
+}
+
+
+MeaBinaryLogReader::~MeaBinaryLogReader()
+{
+    try {
+        Close();
+    }
+    catch(...) {
+        MeaAssert(false);
+    }
+}
+
+
+void MeaBinaryLogReader::Open(LPCTSTR pathname)
+{
+    Close();
+
+    m_file = CreateFile(pathname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        CFileException::ThrowOsError(static_cast<LONG>(GetLastError()), pathname);
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size)) {
+        LONG err = static_cast<LONG>(GetLastError());
+        Close();
+        CFileException::ThrowOsError(err, pathname);
+    }
+    m_size = static_cast<UINT64>(size.QuadPart);
+
+    if (m_size < sizeof(MeaBinaryLogHeader)) {
+        Close();
+        throw MeaLogFileException();
+    }
+
+    m_mapping = CreateFileMapping(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping != NULL) {
+        m_view = static_cast<const BYTE*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (m_view == NULL) {
+        LONG err = static_cast<LONG>(GetLastError());
+        Close();
+        CFileException::ThrowOsError(err, pathname);
+    }
+
+    Attach();
+}
+
+
+void MeaBinaryLogReader::Open(const BYTE* data, UINT64 size)
+{
+    Close();
+
+    if (size < sizeof(MeaBinaryLogHeader)) {
+        throw MeaLogFileException();
+    }
+
+    m_view = data;
+    m_size = size;
+
+    Attach();
+}
+
+
+void MeaBinaryLogReader::Attach()
+{
+    try {
+        m_header = reinterpret_cast<const MeaBinaryLogHeader*>(m_view);
+
+        if ((memcmp(m_header->magic, kMagic, sizeof(kMagic)) != 0) ||
+                (m_header->formatVersion != kFormatVersion)) {
+            throw MeaLogFileException();
+        }
+
+        ValidateTable(m_header->desktopOffset, m_header->desktopCount, sizeof(MeaBinaryLogDesktop));
+        ValidateTable(m_header->screenOffset, m_header->screenCount, sizeof(MeaBinaryLogScreen));
+        ValidateTable(m_header->precisionOffset, m_header->precisionCount, sizeof(INT32));
+        ValidateTable(m_header->positionOffset, m_header->positionCount, sizeof(MeaBinaryLogPosition));
+        ValidateTable(m_header->pointOffset, m_header->pointCount, sizeof(MeaBinaryLogPoint));
+        ValidateTable(m_header->stringOffset, m_header->stringSize, 1);
+
+        m_desktops = reinterpret_cast<const MeaBinaryLogDesktop*>(m_view + m_header->desktopOffset);
+        m_screens = reinterpret_cast<const MeaBinaryLogScreen*>(m_view + m_header->screenOffset);
+        m_precisions = reinterpret_cast<const INT32*>(m_view + m_header->precisionOffset);
+        m_positions = reinterpret_cast<const MeaBinaryLogPosition*>(m_view + m_header->positionOffset);
+        m_points = reinterpret_cast<const MeaBinaryLogPoint*>(m_view + m_header->pointOffset);
+        m_strings = m_view + m_header->stringOffset;
+
+        ValidateReferences();
+    }
+    catch (MeaLogFileException&) {
+        Close();
+        throw;
+    }
+}
+
+
+void MeaBinaryLogReader::Close()
+{
+    m_stringCache.clear();
+
+    m_header = NULL;
+    m_desktops = NULL;
+    m_screens = NULL;
+    m_precisions = NULL;
+    m_positions = NULL;
+    m_points = NULL;
+    m_strings = NULL;
+
+    if ((m_view != NULL) && (m_mapping != NULL)) {
+        UnmapViewOfFile(m_view);
+    }
+    m_view = NULL;
+    if (m_mapping != NULL) {
+        CloseHandle(m_mapping);
+        m_mapping = NULL;
+    }
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+    m_size = 0;
+}
+
+
+const CString& MeaBinaryLogReader::GetString(UINT32 offset) const
+{
+    StringCache::const_iterator iter = m_stringCache.find(offset);
+    if (iter != m_stringCache.end()) {
+        return (*iter).second;
+    }
+
+    UINT32 count;
+    memcpy(&count, m_strings + offset, sizeof(UINT32));
+
+    CString& str = m_stringCache[offset];
+    if (count > 0) {
+        str = CString(reinterpret_cast<LPCWSTR>(m_strings + offset + sizeof(UINT32)), count);
+    }
+    return str;
+}
+
+
+bool MeaBinaryLogReader::IsBinaryLog(LPCTSTR pathname)
+{
+    CFile file;
+    char magic[sizeof(kMagic)];
+
+    if (!file.Open(pathname, CFile::modeRead | CFile::shareDenyWrite)) {
+        return false;
+    }
+
+    bool isBinary = false;
+    try {
+        isBinary = (file.Read(magic, sizeof(magic)) == sizeof(magic)) &&
+                   (memcmp(magic, kMagic, sizeof(kMagic)) == 0);
+    }
+    catch (CFileException* ex) {
+        ex->Delete();
+    }
+
+    file.Close();
+    return isBinary;
+}
+
+
+void MeaBinaryLogReader::ValidateTable(UINT32 offset, UINT32 count, size_t recordSize) const
+{
+    UINT64 end = static_cast<UINT64>(offset) + static_cast<UINT64>(count) * recordSize;
+    if ((offset < sizeof(MeaBinaryLogHeader)) || (end > m_size)) {
+        throw MeaLogFileException();
+    }
+}
+
+
+void MeaBinaryLogReader::ValidateString(UINT32 offset) const
+{
+    UINT64 size = m_header->stringSize;
+
+    if (static_cast<UINT64>(offset) + sizeof(UINT32) > size) {
+        throw MeaLogFileException();
+    }
+
+    UINT32 count;
+    memcpy(&count, m_strings + offset, sizeof(UINT32));
+    if (static_cast<UINT64>(offset) + sizeof(UINT32) + static_cast<UINT64>(count) * sizeof(WCHAR) > size) {
+        throw MeaLogFileException();
+    }
+}
+
+
+void MeaBinaryLogReader::ValidateReferences() const
+{
+    UINT32 i;
+
+    ValidateString(m_header->titleStr);
+    ValidateString(m_header->descStr);
+
+    for (i = 0; i < m_header->desktopCount; i++) {
+        const MeaBinaryLogDesktop& desktop = m_desktops[i];
+
+        ValidateString(desktop.linearUnitsStr);
+        ValidateString(desktop.angularUnitsStr);
+        ValidateString(desktop.customNameStr);
+        ValidateString(desktop.customAbbrevStr);
+        ValidateString(desktop.customBasisStr);
+
+        if ((static_cast<UINT64>(desktop.firstScreen) + desktop.screenCount > m_header->screenCount) ||
+            (static_cast<UINT64>(desktop.firstPrecision) + desktop.precisionCount > m_header->precisionCount)) {
+            throw MeaLogFileException();
+        }
+    }
+
+    for (i = 0; i < m_header->screenCount; i++) {
+        ValidateString(m_screens[i].descStr);
+    }
+
+    for (i = 0; i < m_header->positionCount; i++) {
+        const MeaBinaryLogPosition& position = m_positions[i];
+
+        ValidateString(position.toolStr);
+        ValidateString(position.timestampStr);
+        ValidateString(position.descStr);
+
+        if ((position.desktop >= m_header->desktopCount) ||
+            (static_cast<UINT64>(position.firstPoint) + position.pointCount > m_header->pointCount)) {
+            throw MeaLogFileException();
+        }
+    }
+
+    for (i = 0; i < m_header->pointCount; i++) {
+        ValidateString(m_points[i].nameStr);
+    }
+}
+
+
+//*************************************************************************
+// MeaBinaryLogJournal
+//*************************************************************************
+
+
+const char      MeaBinaryLogJournal::kMagic[8] = { 'M', 'E', 'A', 'P', 'J', 'N', 'L', '\0' };
+LPCTSTR         MeaBinaryLogJournal::kSuffix = _T(".jnl");
+
+
+MeaBinaryLogJournal::MeaBinaryLogJournal()
+{
+}
+
+
+MeaBinaryLogJournal::~MeaBinaryLogJournal()
+{
+}
+
+
+void MeaBinaryLogJournal::Attach(const CString& logPathname)
+{
+    m_logPathname = logPathname;
+    m_pathname = logPathname + kSuffix;
+    m_contents.clear();
+}
+
+
+void MeaBinaryLogJournal::Detach()
+{
+    m_logPathname.Empty();
+    m_pathname.Empty();
+    m_contents.clear();
+}
+
+
+void MeaBinaryLogJournal::Append(Operation op, int posIndex, const MeaBinaryLogWriter* writer)
+    throw(CFileException)
+{
+    MeaAssert(IsAttached());
+
+    CMemFile data;
+    if (writer != NULL) {
+        writer->Write(data);
+    }
+
+    MeaBinaryLogJournalEntry entry;
+    entry.op = op;
+    entry.posIndex = posIndex;
+    entry.size = static_cast<UINT32>(data.GetLength());
+
+    CFile file(m_pathname, CFile::modeCreate | CFile::modeNoTruncate | CFile::modeWrite | CFile::shareDenyWrite);
+
+    if (file.GetLength() == 0) {
+        MeaBinaryLogJournalHeader header;
+
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, kMagic, sizeof(header.magic));
+        header.formatVersion = MeaBinaryLogReader::kFormatVersion;
+        GetLogStamp(header.baseSize, header.baseTime);
+
+        file.Write(&header, sizeof(header));
+    } else {
+        file.SeekToEnd();
+    }
+
+    file.Write(&entry, sizeof(entry));
+    if (entry.size > 0) {
+        BYTE* buffer = data.Detach();
+        try {
+            file.Write(buffer, entry.size);
+        }
+        catch (CFileException*) {
+            free(buffer);
+            throw;
+        }
+        free(buffer);
+    }
+
+    file.Close();
+}
+
+
+void MeaBinaryLogJournal::AppendPositions(int firstIndex, const MeaBinaryLogWriter& writer)
+    throw(CFileException)
+{
+    Append(AddBatchOp, firstIndex, &writer);
+}
+
+
+ULONGLONG MeaBinaryLogJournal::GetSize() const
+{
+    CFileStatus status;
+
+    if (!IsAttached() || !CFile::GetStatus(m_pathname, status)) {
+        return 0;
+    }
+    return status.m_size;
+}
+
+
+size_t MeaBinaryLogJournal::GetEndOffset() const
+{
+    ULONGLONG size = GetSize();
+
+    if (size <= sizeof(MeaBinaryLogJournalHeader)) {
+        return 0;
+    }
+    return static_cast<size_t>(size - sizeof(MeaBinaryLogJournalHeader));
+}
+
+
+void MeaBinaryLogJournal::Rebase(const CString& logPathname, size_t offset)
+    throw(CFileException)
+{
+    std::vector<BYTE> entries;
+
+    if (IsAttached()) {
+        CFile file;
+        if (file.Open(m_pathname, CFile::modeRead | CFile::shareDenyWrite)) {
+            ULONGLONG start = sizeof(MeaBinaryLogJournalHeader) + offset;
+            ULONGLONG length = file.GetLength();
+
+            if (length > start) {
+                entries.resize(static_cast<size_t>(length - start));
+                file.Seek(start, CFile::begin);
+                if (file.Read(&entries[0], static_cast<UINT>(entries.size())) != entries.size()) {
+                    file.Close();
+                    AfxThrowFileException(CFileException::endOfFile, -1, m_pathname);
+                }
+            }
+            file.Close();
+        }
+    }
+
+    Discard();
+    Attach(logPathname);
+
+    if (entries.empty()) {
+        return;
+    }
+
+    MeaBinaryLogJournalHeader header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(header.magic));
+    header.formatVersion = MeaBinaryLogReader::kFormatVersion;
+    GetLogStamp(header.baseSize, header.baseTime);
+
+    CFile file(m_pathname, CFile::modeCreate | CFile::modeWrite | CFile::shareDenyWrite);
+    file.Write(&header, sizeof(header));
+    file.Write(&entries[0], static_cast<UINT>(entries.size()));
+    file.Close();
+}
+
+
+void MeaBinaryLogJournal::Discard()
+{
+    m_contents.clear();
+
+    if (IsAttached()) {
+        DeleteFile(m_pathname);
+    }
+}
+
+
+bool MeaBinaryLogJournal::Read()
+{
+    m_contents.clear();
+
+    if (!IsAttached()) {
+        return false;
+    }
+
+    CFile file;
+    if (!file.Open(m_pathname, CFile::modeRead | CFile::shareDenyWrite)) {
+        return false;
+    }
+
+    MeaBinaryLogJournalHeader header;
+    bool valid = false;
+
+    try {
+        if (file.Read(&header, sizeof(header)) == sizeof(header)) {
+            UINT64 size;
+            UINT64 time;
+
+            valid = (memcmp(header.magic, kMagic, sizeof(kMagic)) == 0) &&
+                    (header.formatVersion == MeaBinaryLogReader::kFormatVersion) &&
+                    GetLogStamp(size, time) &&
+                    (header.baseSize == size) && (header.baseTime == time);
+        }
+
+        if (valid) {
+            ULONGLONG length = file.GetLength() - sizeof(header);
+            m_contents.resize(static_cast<size_t>(length));
+            if (length > 0) {
+                valid = (file.Read(&m_contents[0], static_cast<UINT>(length)) == length);
+            }
+        }
+    }
+    catch (CFileException* ex) {
+        ex->Delete();
+        valid = false;
+    }
+
+    file.Close();
+
+    if (!valid) {
+        // The journal does not apply to this version of the log.
+        //
+        Discard();
+        return false;
+    }
+
+    return !m_contents.empty();
+}
+
+
+bool MeaBinaryLogJournal::GetEntry(size_t& offset, MeaBinaryLogJournalEntry& entry, const BYTE*& data) const
+{
+    if ((offset >= m_contents.size()) || (m_contents.size() - offset < sizeof(entry))) {
+        return false;
+    }
+
+    MeaBinaryLogJournalEntry header;
+    memcpy(&header, &m_contents[offset], sizeof(header));
+
+    if (m_contents.size() - offset - sizeof(header) < header.size) {
+        return false;
+    }
+
+    entry = header;
+    offset += sizeof(header);
+
+    data = (entry.size > 0) ? &m_contents[offset] : NULL;
+    offset += entry.size;
+
+    return true;
+}
+
+
+void MeaBinaryLogJournal::Truncate(size_t offset) throw(CFileException)
+{
+    if (!IsAttached() || (offset >= m_contents.size())) {
+        return;
+    }
+
+    CFile file(m_pathname, CFile::modeWrite | CFile::modeNoTruncate | CFile::shareDenyWrite);
+    file.SetLength(sizeof(MeaBinaryLogJournalHeader) + offset);
+    file.Close();
+
+    m_contents.resize(offset);
+}
+
+
+bool MeaBinaryLogJournal::GetLogStamp(UINT64& size, UINT64& time) const
+{
+    WIN32_FILE_ATTRIBUTE_DATA attrs;
+
+    if (!GetFileAttributesEx(m_logPathname, GetFileExInfoStandard, &attrs)) {
+        size = 0;
+        time = 0;
+        return false;
+    }
+
+    size = (static_cast<UINT64>(attrs.nFileSizeHigh) << 32) | attrs.nFileSizeLow;
+    time = (static_cast<UINT64>(attrs.ftLastWriteTime.dwHighDateTime) << 32) |
+            attrs.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
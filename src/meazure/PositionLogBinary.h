@@ -0,0 +1,580 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Header file for reading and writing the binary position log file format.
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include "GUID.h"
+
+
+/// @page binlog Binary Position Log Format
+///
+/// A binary position log holds the same information as the XML position
+/// log but is laid out so that it can be memory mapped and read in place.
+/// All values are little endian. The file consists of:
+///
+/// - A MeaBinaryLogHeader at offset zero.
+/// - A table of MeaBinaryLogDesktop records.
+/// - A table of MeaBinaryLogScreen records, referenced by the desktops.
+/// - A table of 32 bit display precisions, referenced by the desktops.
+/// - A table of MeaBinaryLogPosition records.
+/// - A table of MeaBinaryLogPoint records, referenced by the positions.
+/// - A string table. Strings are referenced by their offset into the
+///   table and are stored as a 32 bit character count followed by that
+///   many UTF-16 characters. Identical strings are stored once.
+///
+/// Each table is located by an offset and count in the header.
+///
+/// A journal file records changes made to a position log since it was
+/// last saved. It consists of a MeaBinaryLogJournalHeader followed by
+/// any number of entries. Each entry is a MeaBinaryLogJournalEntry
+/// followed by the number of bytes it specifies. For added and replaced
+/// positions, those bytes are a complete binary position log holding the
+/// position and the desktop it references. For a batch of added
+/// positions, they are a binary position log holding all of the positions
+/// and each desktop they reference, once.
+
+#pragma pack(push, 1)
+
+/// Header at the start of a binary position log file.
+///
+struct MeaBinaryLogHeader
+{
+    char    magic[8];           ///< File identifier, kMagic.
+    UINT32  formatVersion;      ///< Version of the binary layout.
+    UINT32  logVersion;         ///< Position log file major version.
+    UINT32  titleStr;           ///< Log title, string table offset.
+    UINT32  descStr;            ///< Log description, string table offset.
+    UINT32  desktopOffset;      ///< File offset of the desktop table.
+    UINT32  desktopCount;       ///< Number of desktop records.
+    UINT32  screenOffset;       ///< File offset of the screen table.
+    UINT32  screenCount;        ///< Number of screen records.
+    UINT32  precisionOffset;    ///< File offset of the display precision table.
+    UINT32  precisionCount;     ///< Number of display precisions.
+    UINT32  positionOffset;     ///< File offset of the position table.
+    UINT32  positionCount;      ///< Number of position records.
+    UINT32  pointOffset;        ///< File offset of the point table.
+    UINT32  pointCount;         ///< Number of point records.
+    UINT32  stringOffset;       ///< File offset of the string table.
+    UINT32  stringSize;         ///< Size of the string table, in bytes.
+};
+
+/// Desktop information record.
+///
+struct MeaBinaryLogDesktop
+{
+    GUID    id;                 ///< Desktop information ID.
+    double  originX;            ///< Origin x offset.
+    double  originY;            ///< Origin y offset.
+    double  sizeX;              ///< Desktop width.
+    double  sizeY;              ///< Desktop height.
+    UINT32  invertY;            ///< Non-zero if the y-axis is inverted.
+    UINT32  linearUnitsStr;     ///< Linear units name, string table offset.
+    UINT32  angularUnitsStr;    ///< Angular units name, string table offset.
+    UINT32  customNameStr;      ///< Custom units name, string table offset.
+    UINT32  customAbbrevStr;    ///< Custom units abbreviation, string table offset.
+    UINT32  customBasisStr;     ///< Custom units scale basis, string table offset.
+    double  customFactor;       ///< Custom units scale factor.
+    UINT32  firstScreen;        ///< Index of the desktop's first screen record.
+    UINT32  screenCount;        ///< Number of screens.
+    UINT32  firstPrecision;     ///< Index of the desktop's first display precision.
+    UINT32  precisionCount;     ///< Number of display precisions.
+};
+
+/// Display screen record.
+///
+struct MeaBinaryLogScreen
+{
+    double  top;                ///< Top of the screen rectangle.
+    double  bottom;             ///< Bottom of the screen rectangle.
+    double  left;               ///< Left of the screen rectangle.
+    double  right;              ///< Right of the screen rectangle.
+    double  resX;               ///< Horizontal resolution.
+    double  resY;               ///< Vertical resolution.
+    UINT32  primary;            ///< Non-zero if this is the primary screen.
+    UINT32  manualRes;          ///< Non-zero if the resolution was calibrated manually.
+    UINT32  descStr;            ///< Screen description, string table offset.
+};
+
+/// Tool position record.
+///
+struct MeaBinaryLogPosition
+{
+    UINT32  desktop;            ///< Index of the referenced desktop record.
+    UINT32  toolStr;            ///< Tool name, string table offset.
+    UINT32  timestampStr;       ///< Recording timestamp, string table offset.
+    UINT32  descStr;            ///< Position description, string table offset.
+    UINT32  fieldMask;          ///< Data fields defined for the position.
+    double  width;              ///< Width property.
+    double  height;             ///< Height property.
+    double  distance;           ///< Distance property.
+    double  area;               ///< Area property.
+    double  angle;              ///< Angle property.
+    UINT32  firstPoint;         ///< Index of the position's first point record.
+    UINT32  pointCount;         ///< Number of points.
+};
+
+/// Named point record.
+///
+struct MeaBinaryLogPoint
+{
+    UINT32  nameStr;            ///< Point name, string table offset.
+    double  x;                  ///< X coordinate.
+    double  y;                  ///< Y coordinate.
+};
+
+/// Header at the start of a position log journal file.
+///
+struct MeaBinaryLogJournalHeader
+{
+    char    magic[8];           ///< File identifier, MeaBinaryLogJournal::kMagic.
+    UINT32  formatVersion;      ///< Version of the binary layout.
+    UINT64  baseSize;           ///< Size of the position log the journal applies to.
+    UINT64  baseTime;           ///< Last write time of the position log the journal applies to.
+};
+
+/// Journal entry header.
+///
+struct MeaBinaryLogJournalEntry
+{
+    UINT32  op;                 ///< Operation, a MeaBinaryLogJournal::Operation.
+    INT32   posIndex;           ///< Index of the affected position.
+    UINT32  size;               ///< Number of bytes of entry data that follow.
+};
+
+#pragma pack(pop)
+
+
+/// Builds a binary position log in memory and writes it to a file. Records
+/// are appended in order. A record that references screens, precisions or
+/// points must be added immediately after those items are added.
+///
+class MeaBinaryLogWriter
+{
+public:
+    /// Constructs a writer for an empty log.
+    ///
+    MeaBinaryLogWriter();
+
+    /// Destroys the writer.
+    ///
+    ~MeaBinaryLogWriter();
+
+
+    /// Sets the title and description of the log.
+    ///
+    /// @param title    [in] Log title.
+    /// @param desc     [in] Log description.
+    ///
+    void    SetInfo(const CString& title, const CString& desc);
+
+    /// Adds a string to the string table. Identical strings are stored once.
+    ///
+    /// @param str      [in] String to add.
+    ///
+    /// @return Offset of the string in the string table.
+    ///
+    UINT32  AddString(const CString& str);
+
+    /// Adds a screen record for the next desktop.
+    ///
+    /// @param screen   [in] Screen record.
+    ///
+    void    AddScreen(const MeaBinaryLogScreen& screen) { m_screens.push_back(screen); }
+
+    /// Adds a display precision for the next desktop.
+    ///
+    /// @param precision    [in] Number of decimal places.
+    ///
+    void    AddPrecision(int precision) { m_precisions.push_back(precision); }
+
+    /// Adds a desktop record. The screens and precisions added since the
+    /// previous desktop are assigned to this desktop.
+    ///
+    /// @param desktop  [in] Desktop record. The screen and precision
+    ///                 ranges are filled in by the writer.
+    ///
+    void    AddDesktop(const MeaBinaryLogDesktop& desktop);
+
+    /// Indicates whether a desktop record with the specified ID has been
+    /// added.
+    ///
+    /// @param desktopId    [in] ID of the desktop.
+    ///
+    /// @return <b>true</b> if the desktop has been added.
+    ///
+    bool    HasDesktop(const MeaGUID& desktopId) const {
+        return m_desktopIndexMap.find(desktopId) != m_desktopIndexMap.end();
+    }
+
+    /// Adds a point for the next position.
+    ///
+    /// @param name     [in] Point name.
+    /// @param x        [in] X coordinate.
+    /// @param y        [in] Y coordinate.
+    ///
+    void    AddPoint(const CString& name, double x, double y);
+
+    /// Adds a position record. The points added since the previous
+    /// position are assigned to this position.
+    ///
+    /// @param desktopId    [in] ID of the desktop referenced by the
+    ///                     position. The desktop must already have been added.
+    /// @param position     [in] Position record. The desktop index and point
+    ///                     range are filled in by the writer.
+    ///
+    void    AddPosition(const MeaGUID& desktopId, const MeaBinaryLogPosition& position);
+
+
+    /// Writes the log to the specified file. To build the log in memory,
+    /// pass a CMemFile.
+    ///
+    /// @param file     [in] File open for writing.
+    ///
+    void    Write(CFile& file) const throw(CFileException);
+
+private:
+    typedef std::map<CString, UINT32> StringMap;                        ///< Maps a string to its string table offset.
+    typedef std::map<MeaGUID, UINT32, MeaGUID::less> DesktopIndexMap;   ///< Maps a desktop ID to its record index.
+
+    /// Purposely undefined.
+    MeaBinaryLogWriter(const MeaBinaryLogWriter&);
+
+    /// Purposely undefined.
+    MeaBinaryLogWriter& operator=(const MeaBinaryLogWriter&);
+
+
+    MeaBinaryLogHeader                  m_header;           ///< File header.
+    std::vector<MeaBinaryLogDesktop>    m_desktops;         ///< Desktop table.
+    std::vector<MeaBinaryLogScreen>     m_screens;          ///< Screen table.
+    std::vector<INT32>                  m_precisions;       ///< Display precision table.
+    std::vector<MeaBinaryLogPosition>   m_positions;        ///< Position table.
+    std::vector<MeaBinaryLogPoint>      m_points;           ///< Point table.
+    std::vector<BYTE>                   m_strings;          ///< String table.
+    StringMap                           m_stringMap;        ///< Strings already in the string table.
+    DesktopIndexMap                     m_desktopIndexMap;  ///< Desktop records by ID.
+    UINT32                              m_screenMark;       ///< First screen not yet assigned to a desktop.
+    UINT32                              m_precisionMark;    ///< First precision not yet assigned to a desktop.
+    UINT32                              m_pointMark;        ///< First point not yet assigned to a position.
+};
+
+
+/// Provides read access to a binary position log by memory mapping the
+/// file. The records are accessed in place. The tables and string
+/// references are validated when the file is opened so that a corrupt
+/// file cannot cause reads outside of the mapping.
+///
+class MeaBinaryLogReader
+{
+public:
+    /// Constructs a reader. Call Open to map a file.
+    ///
+    MeaBinaryLogReader();
+
+    /// Unmaps the file, if one is mapped, and destroys the reader.
+    ///
+    ~MeaBinaryLogReader();
+
+
+    /// Maps the specified binary position log file into memory and
+    /// validates its structure.
+    ///
+    /// @param pathname     [in] Pathname of the binary log file.
+    ///
+    /// @throw CFileException* if the file cannot be opened or mapped.
+    /// @throw MeaLogFileException if the file is not a valid binary log.
+    ///
+    void    Open(LPCTSTR pathname);
+
+    /// Reads a binary position log held in memory and validates its
+    /// structure. The memory must remain valid until the reader is
+    /// closed.
+    ///
+    /// @param data         [in] Start of the log.
+    /// @param size         [in] Size of the log, in bytes.
+    ///
+    /// @throw MeaLogFileException if the data is not a valid binary log.
+    ///
+    void    Open(const BYTE* data, UINT64 size);
+
+    /// Unmaps the file.
+    ///
+    void    Close();
+
+
+    /// Returns the file header.
+    /// @return File header.
+    const MeaBinaryLogHeader&   GetHeader() const { return *m_header; }
+
+    /// Returns the desktop record at the specified index.
+    /// @param index    [in] Zero based desktop index.
+    /// @return Desktop record.
+    const MeaBinaryLogDesktop&  GetDesktop(UINT32 index) const { return m_desktops[index]; }
+
+    /// Returns the screen record at the specified index.
+    /// @param index    [in] Zero based screen index.
+    /// @return Screen record.
+    const MeaBinaryLogScreen&   GetScreen(UINT32 index) const { return m_screens[index]; }
+
+    /// Returns the display precision at the specified index.
+    /// @param index    [in] Zero based precision index.
+    /// @return Number of decimal places.
+    int                         GetPrecision(UINT32 index) const { return m_precisions[index]; }
+
+    /// Returns the position record at the specified index.
+    /// @param index    [in] Zero based position index.
+    /// @return Position record.
+    const MeaBinaryLogPosition& GetPosition(UINT32 index) const { return m_positions[index]; }
+
+    /// Returns the point record at the specified index.
+    /// @param index    [in] Zero based point index.
+    /// @return Point record.
+    const MeaBinaryLogPoint&    GetPoint(UINT32 index) const { return m_points[index]; }
+
+    /// Returns the string at the specified string table offset. Each
+    /// distinct string is converted once and cached.
+    ///
+    /// @param offset   [in] String table offset.
+    ///
+    /// @return String at the offset.
+    ///
+    const CString&  GetString(UINT32 offset) const;
+
+
+    /// Tests whether the specified file starts with the binary position
+    /// log identifier.
+    ///
+    /// @param pathname     [in] Pathname of the file to test.
+    ///
+    /// @return <b>true</b> if the file is a binary position log.
+    ///
+    static bool IsBinaryLog(LPCTSTR pathname);
+
+    static const char   kMagic[8];          ///< Binary position log file identifier.
+    static const UINT32 kFormatVersion;     ///< Current version of the binary layout.
+
+private:
+    typedef std::map<UINT32, CString> StringCache;     ///< Maps a string table offset to the converted string.
+
+    /// Purposely undefined.
+    MeaBinaryLogReader(const MeaBinaryLogReader&);
+
+    /// Purposely undefined.
+    MeaBinaryLogReader& operator=(const MeaBinaryLogReader&);
+
+    /// Locates the tables in the log at m_view and validates them.
+    ///
+    /// @throw MeaLogFileException if the data is not a valid binary log.
+    ///
+    void    Attach();
+
+    /// Verifies that a table lies within the mapped file.
+    ///
+    /// @param offset       [in] File offset of the table.
+    /// @param count        [in] Number of records in the table.
+    /// @param recordSize   [in] Size of each record, in bytes.
+    ///
+    /// @throw MeaLogFileException if the table extends past the end of the file.
+    ///
+    void    ValidateTable(UINT32 offset, UINT32 count, size_t recordSize) const;
+
+    /// Verifies that a string reference lies within the string table.
+    ///
+    /// @param offset   [in] String table offset.
+    ///
+    /// @throw MeaLogFileException if the string extends past the table.
+    ///
+    void    ValidateString(UINT32 offset) const;
+
+    /// Verifies that all records reference valid strings and table entries.
+    ///
+    /// @throw MeaLogFileException if a reference is invalid.
+    ///
+    void    ValidateReferences() const;
+
+
+    HANDLE                      m_file;         ///< Handle of the open log file.
+    HANDLE                      m_mapping;      ///< Handle of the file mapping.
+    const BYTE*                 m_view;         ///< Start of the mapped view or in memory log.
+    UINT64                      m_size;         ///< Size of the log, in bytes.
+    const MeaBinaryLogHeader*   m_header;       ///< File header.
+    const MeaBinaryLogDesktop*  m_desktops;     ///< Desktop table.
+    const MeaBinaryLogScreen*   m_screens;      ///< Screen table.
+    const INT32*                m_precisions;   ///< Display precision table.
+    const MeaBinaryLogPosition* m_positions;    ///< Position table.
+    const MeaBinaryLogPoint*    m_points;       ///< Point table.
+    const BYTE*                 m_strings;      ///< String table.
+    mutable StringCache         m_stringCache;  ///< Strings already converted.
+};
+
+
+/// Maintains the journal file for a position log. Changes to the
+/// positions are appended to the journal as they are made, rather than
+/// rewriting the entire log. The journal is named after the log with a
+/// ".jnl" suffix and records the size and modification time of the log
+/// it applies to, so that a journal left over from a different version
+/// of the log is never replayed.
+///
+class MeaBinaryLogJournal
+{
+public:
+    /// Journaled operations.
+    ///
+    enum Operation {
+        AddOp = 1,          ///< A position was added at the end of the log.
+        ReplaceOp = 2,      ///< The position at an index was replaced.
+        DeleteOp = 3,       ///< The position at an index was deleted.
+        AddBatchOp = 4      ///< Positions were added at the end of the log.
+    };
+
+    /// Constructs a journal that is not associated with a log.
+    ///
+    MeaBinaryLogJournal();
+
+    /// Destroys the journal object. The journal file is not affected.
+    ///
+    ~MeaBinaryLogJournal();
+
+
+    /// Associates the journal with the specified position log.
+    ///
+    /// @param logPathname  [in] Pathname of the position log.
+    ///
+    void    Attach(const CString& logPathname);
+
+    /// Dissociates the journal from its position log.
+    ///
+    void    Detach();
+
+    /// Indicates whether the journal is associated with a position log.
+    ///
+    /// @return <b>true</b> if the journal is attached.
+    ///
+    bool    IsAttached() const { return !m_pathname.IsEmpty(); }
+
+
+    /// Appends an entry to the journal file, creating the file if needed.
+    ///
+    /// @param op       [in] Operation performed.
+    /// @param posIndex [in] Index of the affected position.
+    /// @param writer   [in] Log holding the added or replaced position, or
+    ///                 NULL if the operation has no data.
+    ///
+    void    Append(Operation op, int posIndex, const MeaBinaryLogWriter* writer) throw(CFileException);
+
+    /// Appends a single entry for a batch of positions added at the end
+    /// of the log, creating the journal file if needed. The journal file
+    /// is opened and written once for the entire batch.
+    ///
+    /// @param firstIndex   [in] Index of the first added position.
+    /// @param writer       [in] Log holding the added positions and the
+    ///                     desktops they reference.
+    ///
+    void    AppendPositions(int firstIndex, const MeaBinaryLogWriter& writer) throw(CFileException);
+
+    /// Returns the size of the journal file.
+    ///
+    /// @return Size of the journal file, in bytes, or 0 if there is none.
+    ///
+    ULONGLONG   GetSize() const;
+
+    /// Returns the offset at which the next entry will be appended. Used
+    /// with Rebase to identify the entries appended after a point in time.
+    ///
+    /// @return Offset of the end of the journal entries.
+    ///
+    size_t  GetEndOffset() const;
+
+    /// Deletes the journal file.
+    ///
+    void    Discard();
+
+    /// Replaces the journal with a journal for the specified position log
+    /// holding only the entries at and after the specified offset. Used
+    /// once a log is saved, when the log holds the changes journaled
+    /// before the offset but not those journaled while it was being
+    /// written.
+    ///
+    /// @param logPathname  [in] Pathname of the position log.
+    /// @param offset       [in] Offset, as returned by GetEndOffset, of
+    ///                     the first entry to keep.
+    ///
+    void    Rebase(const CString& logPathname, size_t offset) throw(CFileException);
+
+
+    /// Reads the journal file so that its entries can be replayed. A
+    /// journal that does not apply to the current version of the log is
+    /// discarded.
+    ///
+    /// @return <b>true</b> if there are entries to replay.
+    ///
+    bool    Read();
+
+    /// Returns the next journal entry read by Read. An entry that was only
+    /// partly written, for example because Meazure exited while appending
+    /// it, is treated as the end of the journal.
+    ///
+    /// @param offset   [in, out] Offset of the entry to return. Start at 0.
+    ///                 Advanced past the entry on return.
+    /// @param entry    [out] Entry header.
+    /// @param data     [out] Entry data.
+    ///
+    /// @return <b>true</b> if an entry was returned, <b>false</b> at the
+    ///         end of the journal.
+    ///
+    bool    GetEntry(size_t& offset, MeaBinaryLogJournalEntry& entry, const BYTE*& data) const;
+
+    /// Removes the entries at and after the specified offset from the
+    /// journal file, so that entries appended later follow the last
+    /// complete entry. Does nothing if there are no such entries.
+    ///
+    /// @param offset   [in] Offset, as returned by GetEntry, of the first
+    ///                 entry to remove.
+    ///
+    void    Truncate(size_t offset) throw(CFileException);
+
+
+    static const char   kMagic[8];      ///< Journal file identifier.
+    static LPCTSTR      kSuffix;        ///< Suffix appended to the log pathname.
+
+private:
+    /// Purposely undefined.
+    MeaBinaryLogJournal(const MeaBinaryLogJournal&);
+
+    /// Purposely undefined.
+    MeaBinaryLogJournal& operator=(const MeaBinaryLogJournal&);
+
+    /// Obtains the size and last write time of the position log.
+    ///
+    /// @param size     [out] Size of the log, in bytes.
+    /// @param time     [out] Last write time of the log.
+    ///
+    /// @return <b>true</b> if the log exists.
+    ///
+    bool    GetLogStamp(UINT64& size, UINT64& time) const;
+
+
+    CString             m_logPathname;  ///< Pathname of the position log.
+    CString             m_pathname;     ///< Pathname of the journal file.
+    std::vector<BYTE>   m_contents;     ///< Entries read from the journal file.
+};
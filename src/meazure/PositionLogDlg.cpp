@@ -42,11 +42,14 @@ BEGIN_MESSAGE_MAP(MeaPositionLogDlg, CDialog)
     ON_BN_CLICKED(IDC_MEA_LOAD_POSITIONS, OnLoadPositions)
     ON_BN_CLICKED(IDC_MEA_SAVE_POSITIONS, OnSavePositions)
     ON_BN_CLICKED(IDC_MEA_SAVE_POSITIONS_AS, OnSavePositionsAs)
+    ON_NOTIFY(LVN_GETDISPINFO, IDC_MEA_POSITION_LIST, OnGetPositionText)
+    ON_NOTIFY(LVN_ITEMCHANGED, IDC_MEA_POSITION_LIST, OnPositionListChanged)
     //}}AFX_MSG_MAP
 END_MESSAGE_MAP()
 
 
-MeaPositionLogDlg::MeaPositionLogDlg() : CDialog(), MeaPositionLogObserver()
+MeaPositionLogDlg::MeaPositionLogDlg() : CDialog(), MeaPositionLogObserver(),
+    m_rowCache(kRowCacheSize)
 {
 }
 
@@ -65,8 +68,11 @@ BOOL MeaPositionLogDlg::OnInitDialog()
 
     SetDlgTitle();
     
+    InitPositionList();
+    UpdatePositionList(true);
     SetScrollRange();
     SetScrollPos(0);
+    SelectPosition(0);
 
     mgr.ShowPosition(0);
 
@@ -118,12 +124,12 @@ void MeaPositionLogDlg::OnLoadPositions()
 
 void MeaPositionLogDlg::OnSavePositions() 
 {
-    MeaPositionLogMgr::Instance().Save(false);
+    MeaPositionLogMgr::Instance().SaveInBackground(false);
 }
 
 void MeaPositionLogDlg::OnSavePositionsAs() 
 {
-    MeaPositionLogMgr::Instance().Save(true);
+    MeaPositionLogMgr::Instance().SaveInBackground(true);
 }
 
 
@@ -177,8 +183,10 @@ void MeaPositionLogDlg::LogLoaded()
 {
     SetDlgTitle();
 
+    UpdatePositionList(true);
     SetScrollRange();
     SetScrollPos(0);
+    SelectPosition(0);
     
     MeaPositionLogMgr::Instance().ShowPosition(0);
 
@@ -193,25 +201,46 @@ void MeaPositionLogDlg::LogSaved()
 }
 
 
+void MeaPositionLogDlg::LogSaveFailed()
+{
+    SetDlgTitle();
+}
+
+
 void MeaPositionLogDlg::PositionAdded(int /* posIndex */)
 {
+    int lastIndex = MeaPositionLogMgr::Instance().NumPositions() - 1;
+
+    UpdatePositionList(false);
     SetScrollRange();
-    SetScrollPos(MeaPositionLogMgr::Instance().NumPositions() - 1);
+    SetScrollPos(lastIndex);
+    SelectPosition(lastIndex);
 
     UpdatePositionInfo();
     UpdateEnable();
 }
 
 
-void MeaPositionLogDlg::PositionReplaced(int /* posIndex */)
+void MeaPositionLogDlg::PositionsAdded(int firstIndex, int count)
 {
+    PositionAdded(firstIndex + count - 1);
+}
+
+
+void MeaPositionLogDlg::PositionReplaced(int posIndex)
+{
+    m_rowCache.Invalidate(posIndex);
+    static_cast<CListCtrl*>(GetDlgItem(IDC_MEA_POSITION_LIST))->Update(posIndex);
+
     UpdatePositionInfo();
 }
 
 
 void MeaPositionLogDlg::PositionDeleted(int /* posIndex */)
 {
+    UpdatePositionList(true);
     SetScrollRange();
+    SelectPosition(GetScrollPos());
 
     UpdatePositionInfo();
     UpdateEnable();
@@ -220,12 +249,150 @@ void MeaPositionLogDlg::PositionDeleted(int /* posIndex */)
 
 void MeaPositionLogDlg::PositionsDeleted()
 {
+    UpdatePositionList(true);
     SetScrollRange();
     
     UpdateEnable();
 }
 
 
+void MeaPositionLogDlg::InitPositionList()
+{
+    static const int columnWidths[kNumColumns] = { 40, 70, 120, 160 };
+    static const UINT columnLabels[kNumColumns] = {
+        IDS_MEA_POSLIST_NUM, IDS_MEA_POSLIST_TOOL, IDS_MEA_POSLIST_DATE, IDS_MEA_POSLIST_DESC
+    };
+
+    CListCtrl* list = static_cast<CListCtrl*>(GetDlgItem(IDC_MEA_POSITION_LIST));
+
+    list->SetExtendedStyle(list->GetExtendedStyle() | LVS_EX_FULLROWSELECT);
+
+    CRect rect;
+    list->GetClientRect(rect);
+    int width = rect.Width() - ::GetSystemMetrics(SM_CXVSCROLL);
+
+    // The column widths are proportions of the list width.
+    //
+    int totalWidth = 0;
+    for (int i = 0; i < kNumColumns; i++) {
+        totalWidth += columnWidths[i];
+    }
+
+    for (int i = 0; i < kNumColumns; i++) {
+        CString label;
+        label.LoadString(columnLabels[i]);
+        list->InsertColumn(i, label, (i == NumColumn) ? LVCFMT_RIGHT : LVCFMT_LEFT,
+                           width * columnWidths[i] / totalWidth);
+    }
+}
+
+
+void MeaPositionLogDlg::UpdatePositionList(bool reset)
+{
+    CListCtrl* list = static_cast<CListCtrl*>(GetDlgItem(IDC_MEA_POSITION_LIST));
+
+    DWORD flags = LVSICF_NOSCROLL;
+    if (reset) {
+        m_rowCache.Clear();
+    } else {
+        flags |= LVSICF_NOINVALIDATEALL;
+    }
+
+    list->SetItemCountEx(MeaPositionLogMgr::Instance().NumPositions(), flags);
+
+    if (reset) {
+        list->Invalidate();
+    }
+}
+
+
+void MeaPositionLogDlg::SelectPosition(int posIndex) const
+{
+    CListCtrl* list = static_cast<CListCtrl*>(GetDlgItem(IDC_MEA_POSITION_LIST));
+
+    if (posIndex < 0 || posIndex >= list->GetItemCount()) {
+        return;
+    }
+
+    // An owner data list is asked about selection changes through the
+    // change notification, so setting the state here has the same effect
+    // as the user clicking the row.
+    //
+    list->SetItemState(-1, 0, LVIS_SELECTED);
+    list->SetItemState(posIndex, LVIS_SELECTED | LVIS_FOCUSED, LVIS_SELECTED | LVIS_FOCUSED);
+    list->EnsureVisible(posIndex, FALSE);
+}
+
+
+void MeaPositionLogDlg::FormatRow(int posIndex, RowCache::Row& row) const
+{
+    const MeaPositionLogMgr::Position& position = MeaPositionLogMgr::Instance().GetPosition(posIndex);
+
+    row.text[NumColumn].Format(_T("%d"), posIndex + 1);
+    row.text[ToolColumn] = position.GetToolName();
+
+    CTime ts(MeaParseTimeStamp(position.GetTimeStamp()));
+    row.text[DateColumn] = ts.Format(_T("%c"));
+
+    // A list row is a single line, so line breaks in the description
+    // are shown as spaces.
+    //
+    CString desc = position.GetDesc();
+    desc.Replace(_T("\r\n"), _T(" "));
+    desc.Replace(_T('\r'), _T(' '));
+    desc.Replace(_T('\n'), _T(' '));
+    row.text[DescColumn] = desc;
+}
+
+
+void MeaPositionLogDlg::OnGetPositionText(NMHDR* pNMHDR, LRESULT* pResult)
+{
+    LVITEM& item = reinterpret_cast<NMLVDISPINFO*>(pNMHDR)->item;
+
+    *pResult = 0;
+
+    if ((item.mask & LVIF_TEXT) == 0 || item.iItem < 0 ||
+            item.iItem >= MeaPositionLogMgr::Instance().NumPositions() ||
+            item.iSubItem < 0 || item.iSubItem >= kNumColumns) {
+        return;
+    }
+
+    const RowCache::Row* row = m_rowCache.Find(item.iItem);
+    if (row == NULL) {
+        RowCache::Row& newRow = m_rowCache.Add(item.iItem);
+        FormatRow(item.iItem, newRow);
+        row = &newRow;
+    }
+
+    _tcsncpy_s(item.pszText, item.cchTextMax, row->text[item.iSubItem], _TRUNCATE);
+}
+
+
+void MeaPositionLogDlg::OnPositionListChanged(NMHDR* pNMHDR, LRESULT* pResult)
+{
+    NMLISTVIEW* info = reinterpret_cast<NMLISTVIEW*>(pNMHDR);
+
+    *pResult = 0;
+
+    // An index of -1 indicates a change to all items (e.g. clearing the
+    // selection), which does not select a position.
+    //
+    if (info->iItem < 0 || (info->uChanged & LVIF_STATE) == 0) {
+        return;
+    }
+
+    bool selected = (info->uNewState & LVIS_SELECTED) != 0 && (info->uOldState & LVIS_SELECTED) == 0;
+    if (!selected || info->iItem == GetScrollPos()) {
+        return;
+    }
+
+    SetScrollPos(info->iItem);
+    UpdatePositionInfo(info->iItem);
+
+    MeaPositionLogMgr::Instance().ShowPosition(info->iItem);
+}
+
+
 void MeaPositionLogDlg::UpdatePositionInfo(int posIndex) const
 {
     CStatic* numField       = static_cast<CStatic*>(GetDlgItem(IDC_MEA_POSITION_NUM));
@@ -273,6 +440,7 @@ void MeaPositionLogDlg::UpdateEnable() const
     CWnd* numField          = GetDlgItem(IDC_MEA_POSITION_NUM);
 
     CWnd* scrollbar         = GetDlgItem(IDC_MEA_POSITION_SCROLLBAR);
+    CWnd* list              = GetDlgItem(IDC_MEA_POSITION_LIST);
 
     bool havePositions = MeaPositionLogMgr::Instance().HavePositions();
 
@@ -292,6 +460,7 @@ void MeaPositionLogDlg::UpdateEnable() const
     numField->ShowWindow(havePositions ? SW_SHOW : SW_HIDE);
 
     scrollbar->EnableWindow(havePositions);
+    list->EnableWindow(havePositions);
 }
 
 
@@ -393,6 +562,7 @@ void MeaPositionLogDlg::OnHScroll(UINT nSBCode, UINT nPos, CScrollBar* pScrollBa
     //
     SetScrollPos(curpos);
     UpdatePositionInfo(curpos);
+    SelectPosition(curpos);
 
     // Set the tool and its position.
     //
@@ -409,15 +579,69 @@ void MeaPositionLogDlg::OnKillfocusPositionDesc()
     if (mgr.HavePositions()) {
         int posIndex = GetScrollPos();
 
-        MeaPositionLogMgr::Position& position = mgr.GetPosition(posIndex);
-        CString origStr = position.GetDesc();
+        CString origStr = mgr.GetPosition(posIndex).GetDesc();
 
         CString newStr;
         CEdit* descField = static_cast<CEdit*>(GetDlgItem(IDC_MEA_POSITION_DESC));
         descField->GetWindowText(newStr);
 
         if (origStr != newStr) {
-            position.SetDesc(newStr);
+            mgr.SetPositionDesc(posIndex, newStr);
+
+            m_rowCache.Invalidate(posIndex);
+            static_cast<CListCtrl*>(GetDlgItem(IDC_MEA_POSITION_LIST))->Update(posIndex);
         }
     }   
 }
+
+
+//*************************************************************************
+// RowCache
+//*************************************************************************
+
+
+MeaPositionLogDlg::RowCache::RowCache(size_t capacity) : m_capacity(capacity)
+{
+}
+
+
+const MeaPositionLogDlg::RowCache::Row* MeaPositionLogDlg::RowCache::Find(int posIndex)
+{
+    RowMap::iterator iter = m_rowMap.find(posIndex);
+    if (iter == m_rowMap.end()) {
+        return NULL;
+    }
+
+    m_rows.splice(m_rows.begin(), m_rows, iter->second);
+    return &iter->second->second;
+}
+
+
+MeaPositionLogDlg::RowCache::Row& MeaPositionLogDlg::RowCache::Add(int posIndex)
+{
+    if (m_rows.size() >= m_capacity && !m_rows.empty()) {
+        m_rowMap.erase(m_rows.back().first);
+        m_rows.pop_back();
+    }
+
+    m_rows.push_front(std::make_pair(posIndex, Row()));
+    m_rowMap[posIndex] = m_rows.begin();
+    return m_rows.front().second;
+}
+
+
+void MeaPositionLogDlg::RowCache::Invalidate(int posIndex)
+{
+    RowMap::iterator iter = m_rowMap.find(posIndex);
+    if (iter != m_rowMap.end()) {
+        m_rows.erase(iter->second);
+        m_rowMap.erase(iter);
+    }
+}
+
+
+void MeaPositionLogDlg::RowCache::Clear()
+{
+    m_rows.clear();
+    m_rowMap.clear();
+}
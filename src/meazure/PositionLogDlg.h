@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <list>
+#include <unordered_map>
 #include "PositionLogObserver.h"
 
 
@@ -34,6 +36,13 @@
 /// the dialog to be called when positions are recorded, deleted,
 /// loaded or saved.
 ///
+/// The positions are listed in a virtual (owner data) list control. The
+/// list holds no text of its own; the text of a row is formatted from the
+/// position when the row is displayed and kept in a small cache of the
+/// most recently displayed rows. Opening the dialog and scrolling the list
+/// therefore take the same time and resources regardless of the number
+/// of positions.
+///
 class MeaPositionLogDlg : public CDialog, public MeaPositionLogObserver
 {
 public:
@@ -69,10 +78,19 @@ public:
     /// Called when a position log file is saved.
     ///
     virtual void LogSaved();
+
+    /// Called when a background save of the position log file fails.
+    ///
+    virtual void LogSaveFailed();
     
     /// Called when a new position is recorded.
     /// @param posIndex     [in] Index of the new position.
     virtual void PositionAdded(int posIndex);
+
+    /// Called when a batch of new positions is recorded.
+    /// @param firstIndex   [in] Index of the first new position.
+    /// @param count        [in] Number of new positions.
+    virtual void PositionsAdded(int firstIndex, int count);
     
     /// Called when an existing position is replaced with a new position.
     /// @param posIndex     [in] Index of the replaced position.
@@ -118,6 +136,8 @@ protected:
     afx_msg void OnLoadPositions();
     afx_msg void OnSavePositions();
     afx_msg void OnSavePositionsAs();
+    afx_msg void OnGetPositionText(NMHDR* pNMHDR, LRESULT* pResult);
+    afx_msg void OnPositionListChanged(NMHDR* pNMHDR, LRESULT* pResult);
     //}}AFX_MSG
 
     /// @fn OnAddPosition()
@@ -160,9 +180,91 @@ protected:
     /// Called when the Save As button is pressed. Queries for a
     /// pathname and saves the position log file to that pathname.
 
+    /// @fn OnGetPositionText(NMHDR* pNMHDR, LRESULT* pResult)
+    /// Called when the position list needs the text of a row.
+    /// @param pNMHDR       [in] List view display information.
+    /// @param pResult      [out] Always 0.
+
+    /// @fn OnPositionListChanged(NMHDR* pNMHDR, LRESULT* pResult)
+    /// Called when the state of a position list item changes. When a
+    /// position is selected in the list, it becomes the current position.
+    /// @param pNMHDR       [in] List view change information.
+    /// @param pResult      [out] Always 0.
+
     DECLARE_MESSAGE_MAP()
 
 
+    /// Columns of the position list.
+    ///
+    enum Column {
+        NumColumn,          ///< Position number.
+        ToolColumn,         ///< Name of the tool.
+        DateColumn,         ///< When the position was recorded.
+        DescColumn,         ///< Position description.
+        kNumColumns         ///< Number of columns.
+    };
+
+    /// Holds the formatted text of the most recently displayed rows of
+    /// the position list. When the cache is full, the least recently
+    /// used row is discarded.
+    ///
+    class RowCache
+    {
+    public:
+        /// Text of a row, by column.
+        ///
+        struct Row
+        {
+            CString text[kNumColumns];      ///< Text of each column.
+        };
+
+        /// Constructs an empty cache.
+        ///
+        /// @param capacity     [in] Maximum number of rows to hold.
+        ///
+        explicit RowCache(size_t capacity);
+
+        /// Looks up a row and marks it as the most recently used.
+        ///
+        /// @param posIndex     [in] Index of the row's position.
+        ///
+        /// @return Row, or NULL if the row is not in the cache.
+        ///
+        const Row*  Find(int posIndex);
+
+        /// Adds an empty row as the most recently used, discarding the
+        /// least recently used row if the cache is full.
+        ///
+        /// @param posIndex     [in] Index of the row's position. The row
+        ///                     must not already be in the cache.
+        ///
+        /// @return Row to be filled in.
+        ///
+        Row&        Add(int posIndex);
+
+        /// Discards a row.
+        ///
+        /// @param posIndex     [in] Index of the row's position.
+        ///
+        void        Invalidate(int posIndex);
+
+        /// Discards all rows.
+        ///
+        void        Clear();
+
+    private:
+        typedef std::list<std::pair<int, Row> > RowList;            ///< Rows from most to least recently used.
+        typedef std::unordered_map<int, RowList::iterator> RowMap;  ///< Maps a position index to its row.
+
+        size_t  m_capacity;     ///< Maximum number of rows.
+        RowList m_rows;         ///< Cached rows.
+        RowMap  m_rowMap;       ///< Cached rows by position index.
+    };
+
+
+    static const size_t kRowCacheSize = 256;    ///< Number of formatted position list rows kept.
+
+
     /// Called when the dialog Close button is pressed. This method
     /// destroys the dialog's window.
     ///
@@ -191,6 +293,35 @@ protected:
     void    SetScrollRange() const;
 
 
+    /// Adds the columns to the position list.
+    ///
+    void    InitPositionList();
+
+    /// Sets the number of rows in the position list to the number of
+    /// positions.
+    ///
+    /// @param reset    [in] <b>true</b> if existing positions may have
+    ///                 changed or moved, so that all rows must be
+    ///                 formatted again. <b>false</b> if positions have only
+    ///                 been added.
+    ///
+    void    UpdatePositionList(bool reset);
+
+    /// Selects the specified row of the position list and scrolls it
+    /// into view.
+    ///
+    /// @param posIndex     [in] Position index.
+    ///
+    void    SelectPosition(int posIndex) const;
+
+    /// Formats the text of a row of the position list.
+    ///
+    /// @param posIndex     [in] Position index.
+    /// @param row          [out] Text of the row.
+    ///
+    void    FormatRow(int posIndex, RowCache::Row& row) const;
+
+
     /// Update the position number field, the recorded date field
     /// and the description field.
     ///
@@ -203,6 +334,9 @@ protected:
     /// state of the position manager.
     ///
     void UpdateEnable() const;
+
+
+    RowCache    m_rowCache;     ///< Formatted text of recently displayed position list rows.
 };
 
 
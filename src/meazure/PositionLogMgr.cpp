@@ -18,9 +18,11 @@
  */
 
 #include "StdAfx.h"
+#include <boost/functional/hash.hpp>
 #include "Resource.h"
 #include "MeaAssert.h"
 #include "PositionLogMgr.h"
+#include "PositionLogBinary.h"
 #include "PositionLogDlg.h"
 #include "PositionSaveDlg.h"
 #include "ToolMgr.h"
@@ -30,25 +32,38 @@
 #include "ChildView.h"
 #include "MainFrm.h"
 #include "Utils.h"
+#include "Messages.h"
 
 
 MEA_SINGLETON_DEF(MeaPositionLogMgr);   ///< Managers are singletons.
 
 const int   MeaPositionLogMgr::kChunkSize = 1024;
 LPCTSTR     MeaPositionLogMgr::kExt = _T("mpl");
-LPCTSTR     MeaPositionLogMgr::kFilter = _T("Meazure Position Log Files (*.mpl)|*.mpl|All Files (*.*)|*.*||");
+LPCTSTR     MeaPositionLogMgr::kBinaryExt = _T("mpb");
+const ULONGLONG MeaPositionLogMgr::kJournalCompactSize = 256 * 1024;
+LPCTSTR     MeaPositionLogMgr::kFilter = _T("Meazure Position Log Files (*.mpl)|*.mpl|Meazure Binary Position Log Files (*.mpb)|*.mpb|All Files (*.*)|*.*||");
+const DWORD MeaPositionLogMgr::kMergeBufferSize = 64 * 1024;
+LPCTSTR     MeaPositionLogMgr::kCSVExt = _T("csv");
+LPCTSTR     MeaPositionLogMgr::kJSONLinesExt = _T("jsonl");
+LPCTSTR     MeaPositionLogMgr::kTextFilter = _T("CSV Files (*.csv)|*.csv|JSON Lines Files (*.jsonl)|*.jsonl|All Files (*.*)|*.*||");
 
 
-MeaPositionLogMgr::MeaPositionLogMgr() : MeaXMLParserHandler(),
-    MeaSingleton_T<MeaPositionLogMgr>(),
+MeaPositionLogMgr::MeaPositionLogMgr() : MeaSingleton_T<MeaPositionLogMgr>(),
     m_observer(NULL),
     m_saveDialog(NULL),
     m_loadDialog(NULL),
     m_saveDlgTitle(reinterpret_cast<LPCSTR>(IDS_MEA_SAVE_LOG_DLG)),
     m_loadDlgTitle(reinterpret_cast<LPCSTR>(IDS_MEA_LOAD_LOG_DLG)),
-    m_stdioOpen(false),
+    m_mergeDlgTitle(reinterpret_cast<LPCSTR>(IDS_MEA_MERGE_LOG_DLG)),
+    m_exportDlgTitle(reinterpret_cast<LPCSTR>(IDS_MEA_EXPORT_LOG_DLG)),
+    m_importDlgTitle(reinterpret_cast<LPCSTR>(IDS_MEA_IMPORT_LOG_DLG)),
     m_modified(false),
-    m_manageDialog(NULL)
+    m_manageDialog(NULL),
+    m_journaling(false),
+    m_changeCount(0),
+    m_saveCount(0),
+    m_saveSnapshot(NULL),
+    m_saveThread(NULL)
 {
     m_title.Format(_T("%s Position Log File"), static_cast<LPCTSTR>(AfxGetAppName()));
 }
@@ -57,6 +72,16 @@ MeaPositionLogMgr::MeaPositionLogMgr() : MeaXMLParserHandler(),
 MeaPositionLogMgr::~MeaPositionLogMgr()
 {
     try {
+        // Do not leave the save thread writing a snapshot of positions
+        // that are about to be destroyed.
+        //
+        if (m_saveThread != NULL) {
+            ::WaitForSingleObject(m_saveThread->m_hThread, INFINITE);
+            delete m_saveThread;
+            delete m_saveSnapshot;
+            m_positions.ReleaseSnapshot();
+        }
+
         delete m_saveDialog;
         delete m_loadDialog;
 
@@ -74,6 +99,7 @@ void MeaPositionLogMgr::SaveProfile(MeaProfile& profile) const
     if (!profile.UserInitiated()) {
         profile.WriteStr(_T("LastLogDir"), static_cast<LPCTSTR>(m_initialDir));
     }
+    profile.WriteBool(_T("JournalPositions"), m_journaling);
 }
 
 
@@ -82,12 +108,29 @@ void MeaPositionLogMgr::LoadProfile(MeaProfile& profile)
     if (!profile.UserInitiated()) {
         m_initialDir = profile.ReadStr(_T("LastLogDir"), static_cast<LPCTSTR>(m_initialDir));
     }
+    SetJournaling(profile.ReadBool(_T("JournalPositions"), m_journaling));
+}
+
+
+void MeaPositionLogMgr::SetJournaling(bool journaling)
+{
+    m_journaling = journaling;
+
+    // The journal is deleted rather than left behind. Once journaling
+    // is off the journal would miss later changes, and a stale journal
+    // would be replayed the next time the log is opened.
+    //
+    if (!m_journaling) {
+        m_journal.Discard();
+        m_journal.Detach();
+    }
 }
 
 
 void MeaPositionLogMgr::MasterReset()
 {
     m_initialDir.Empty();
+    m_journaling = false;
 }
 
 
@@ -135,6 +178,9 @@ void MeaPositionLogMgr::RecordPosition()
     MeaToolMgr::Instance().StrobeTool();
 
     m_modified = true;
+    m_changeCount++;
+
+    JournalPosition(MeaBinaryLogJournal::AddOp, m_positions.Size() - 1);
 
     if (m_observer != NULL) {
         m_observer->PositionAdded(m_positions.Size() - 1);
@@ -142,6 +188,41 @@ void MeaPositionLogMgr::RecordPosition()
 }
 
 
+void MeaPositionLogMgr::RecordPositions(const ToolPointMap* points, int count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    MeaToolMgr& toolMgr = MeaToolMgr::Instance();
+
+    // The desktop, tool and time are the same for the entire batch so
+    // they are captured once rather than per position.
+    //
+    MeaGUID desktopInfoId = RecordDesktopInfo();
+    CString toolName(toolMgr.GetToolName());
+    CString timestamp(MeaMakeTimeStamp(time(NULL)));
+
+    int firstIndex = m_positions.Size();
+    m_positions.Reserve(firstIndex + count);
+
+    for (int i = 0; i < count; i++) {
+        Position* position = new Position(this, desktopInfoId, toolName, timestamp);
+        toolMgr.GetPosition(points[i], *position);
+        m_positions.Add(position);
+    }
+
+    m_modified = true;
+    m_changeCount++;
+
+    JournalPositions(firstIndex, count);
+
+    if (m_observer != NULL) {
+        m_observer->PositionsAdded(firstIndex, count);
+    }
+}
+
+
 void MeaPositionLogMgr::ReplacePosition(int posIndex)
 {
     m_positions.Set(posIndex, new Position(this, RecordDesktopInfo()));
@@ -149,6 +230,9 @@ void MeaPositionLogMgr::ReplacePosition(int posIndex)
     MeaToolMgr::Instance().StrobeTool();
 
     m_modified = true;
+    m_changeCount++;
+
+    JournalPosition(MeaBinaryLogJournal::ReplaceOp, posIndex);
 
     if (m_observer != NULL) {
         m_observer->PositionReplaced(posIndex);
@@ -161,6 +245,9 @@ void MeaPositionLogMgr::DeletePosition(int posIndex)
     m_positions.Delete(posIndex);
 
     m_modified = HavePositions();
+    m_changeCount++;
+
+    JournalPosition(MeaBinaryLogJournal::DeleteOp, posIndex);
 
     if (m_observer != NULL) {
         m_observer->PositionDeleted(posIndex);
@@ -170,10 +257,20 @@ void MeaPositionLogMgr::DeletePosition(int posIndex)
 
 void MeaPositionLogMgr::DeletePositions()
 {
+    WaitForSave();
+
     ClearPositions();
     ::MessageBeep(MB_OK);
 
     m_modified = false;
+    m_changeCount++;
+
+    // Deleting all positions leaves the log file untouched, so the
+    // changes journaled for it are dropped and journaling stops until
+    // a log is next loaded or saved.
+    //
+    m_journal.Discard();
+    m_journal.Detach();
 
     if (m_observer != NULL) {
         m_observer->PositionsDeleted();
@@ -185,10 +282,69 @@ void MeaPositionLogMgr::ClearPositions()
 {
     m_positions.DeleteAll();
     m_desktopInfoMap.clear();
+    m_desktopHashIndex.clear();
     m_refCountMap.clear();
 }
 
 
+void MeaPositionLogMgr::SetPositionDesc(int posIndex, const CString& desc)
+{
+    if (m_positions.IsShared()) {
+        // The position is being saved so change a copy of it.
+        //
+        Position* position = new Position(m_positions.Get(posIndex));
+        position->SetDesc(desc);
+        m_positions.Set(posIndex, position);
+    } else {
+        m_positions.Get(posIndex).SetDesc(desc);
+    }
+
+    // A save in progress holds the old description, so the log must
+    // remain modified once it completes.
+    //
+    m_modified = true;
+    m_changeCount++;
+
+    JournalPosition(MeaBinaryLogJournal::ReplaceOp, posIndex);
+}
+
+
+void MeaPositionLogMgr::ConvertPositions(const MeaGUID& desktopInfoId, const MeaLinearUnits& linearUnits,
+                                         const MeaAngularUnits& angularUnits, MeaPositionBatch& batch,
+                                         std::vector<int>& posIndices)
+{
+    batch.Clear();
+    posIndices.clear();
+
+    int count = NumPositions();
+    for (int i = 0; i < count; i++) {
+        const Position& position = m_positions.Get(i);
+
+        if (position.GetDesktopInfoId() == desktopInfoId) {
+            position.Save(batch);
+            posIndices.push_back(i);
+        }
+    }
+
+    if (batch.GetCount() == 0) {
+        return;
+    }
+
+    const DesktopInfo& desktopInfo = GetDesktopInfo(desktopInfoId);
+    MeaPositionBatch::ScaleList scales;
+
+    desktopInfo.GetUnitsScales(linearUnits, scales);
+    batch.Convert(scales, desktopInfo.GetAngleFactor(angularUnits));
+}
+
+
+void MeaPositionLogMgr::FindPositionsByTime(time_t start, time_t end,
+                                            MeaPositionIndex::IndexList& result) const
+{
+    m_positions.GetIndex().FindTimeRange(MeaMakeTimeStamp(start), MeaMakeTimeStamp(end), result);
+}
+
+
 void MeaPositionLogMgr::ShowPosition(unsigned int posIndex)
 {
     if (posIndex < m_positions.Size()) {
@@ -198,20 +354,66 @@ void MeaPositionLogMgr::ShowPosition(unsigned int posIndex)
 }
 
 
+void MeaPositionLogMgr::AddDesktopInfo(const DesktopInfo& desktopInfo)
+{
+    const MeaGUID& guid = desktopInfo.GetId();
+    m_desktopInfoMap[guid] = desktopInfo;
+    m_desktopHashIndex.insert(DesktopHashIndex::value_type(desktopInfo.GetHash(), guid));
+}
+
+
+const MeaGUID* MeaPositionLogMgr::FindDesktopInfo(const DesktopInfo& desktopInfo) const
+{
+    // Only the desktops having the same fingerprint need to be
+    // compared in full.
+    //
+    std::pair<DesktopHashIndex::const_iterator, DesktopHashIndex::const_iterator> range =
+                    m_desktopHashIndex.equal_range(desktopInfo.GetHash());
+
+    for (DesktopHashIndex::const_iterator iter = range.first; iter != range.second; ++iter) {
+        DesktopInfoMap::const_iterator infoIter = m_desktopInfoMap.find((*iter).second);
+        if ((infoIter != m_desktopInfoMap.end()) && (desktopInfo == (*infoIter).second)) {
+            return &(*infoIter).first;
+        }
+    }
+
+    return NULL;
+}
+
+
 MeaGUID MeaPositionLogMgr::RecordDesktopInfo()
 {
     DesktopInfo desktopInfo;
-    DesktopInfoMap::const_iterator iter;
 
-    for (iter = m_desktopInfoMap.begin(); iter != m_desktopInfoMap.end(); ++iter) {
-        if (desktopInfo == (*iter).second) {
-            return (*iter).first;
-        }
+    const MeaGUID* id = FindDesktopInfo(desktopInfo);
+    if (id != NULL) {
+        return *id;
     }
 
-    const MeaGUID& guid = desktopInfo.GetId();
-    m_desktopInfoMap[guid] = desktopInfo;
-    return guid;
+    AddDesktopInfo(desktopInfo);
+    return desktopInfo.GetId();
+}
+
+
+MeaGUID MeaPositionLogMgr::MergeDesktopInfo(const DesktopInfo& desktopInfo)
+{
+    const MeaGUID* id = FindDesktopInfo(desktopInfo);
+    if (id != NULL) {
+        return *id;
+    }
+
+    // A different desktop may already be using the ID, for example
+    // when merging log files that were edited from a common original.
+    //
+    if (m_desktopInfoMap.find(desktopInfo.GetId()) == m_desktopInfoMap.end()) {
+        AddDesktopInfo(desktopInfo);
+        return desktopInfo.GetId();
+    }
+
+    DesktopInfo remapped(desktopInfo);
+    remapped.SetId(MeaGUID());
+    AddDesktopInfo(remapped);
+    return remapped.GetId();
 }
 
 
@@ -254,7 +456,39 @@ bool MeaPositionLogMgr::IsPositionFile(LPCTSTR filename)
     if (ext[i] == _T('.')) {
         i++;
     }
-    return (_tcsicmp(&ext[i], kExt) == 0);
+    if ((_tcsicmp(&ext[i], kExt) == 0) || (_tcsicmp(&ext[i], kBinaryExt) == 0)) {
+        return true;
+    }
+
+    // A binary log is recognized by its content regardless of its name.
+    //
+    return MeaBinaryLogReader::IsBinaryLog(filename);
+}
+
+
+bool MeaPositionLogMgr::IsBinaryPathname(LPCTSTR pathname)
+{
+    TCHAR ext[_MAX_EXT];
+    int i = 0;
+
+    _tsplitpath_s(pathname, NULL, 0, NULL, 0, NULL, 0, ext, _MAX_EXT);
+    if (ext[i] == _T('.')) {
+        i++;
+    }
+    return (_tcsicmp(&ext[i], kBinaryExt) == 0);
+}
+
+
+MeaTextLogFormat MeaPositionLogMgr::GetTextFormat(LPCTSTR pathname)
+{
+    TCHAR ext[_MAX_EXT];
+    int i = 0;
+
+    _tsplitpath_s(pathname, NULL, 0, NULL, 0, NULL, 0, ext, _MAX_EXT);
+    if (ext[i] == _T('.')) {
+        i++;
+    }
+    return (_tcsicmp(&ext[i], kJSONLinesExt) == 0) ? MeaJSONLinesFormat : MeaCSVFormat;
 }
 
 
@@ -262,6 +496,8 @@ bool MeaPositionLogMgr::SaveIfModified()
 {
     bool result = true;
 
+    WaitForSave();
+
     if (IsModified()) {
         switch(AfxMessageBox(IDS_MEA_ASK_SAVE, MB_YESNOCANCEL)) {
         case IDCANCEL:
@@ -273,6 +509,7 @@ bool MeaPositionLogMgr::SaveIfModified()
             }
             break;
         default:
+            m_journal.Discard();    // The unsaved changes are abandoned
             break;
         }
     }
@@ -282,6 +519,89 @@ bool MeaPositionLogMgr::SaveIfModified()
 
 
 bool MeaPositionLogMgr::Save(bool askPathname)
+{
+    WaitForSave();
+
+    if (!GetSavePathname(askPathname)) {
+        return false;
+    }
+
+    SaveSnapshot snapshot;
+
+    TakeSnapshot(snapshot);
+    WriteSnapshot(snapshot);
+
+    return FinishSave(snapshot);
+}
+
+
+bool MeaPositionLogMgr::SaveInBackground(bool askPathname)
+{
+    // Only one save at a time.
+    //
+    WaitForSave();
+
+    if (!GetSavePathname(askPathname)) {
+        return false;
+    }
+
+    m_saveSnapshot = new SaveSnapshot;
+    TakeSnapshot(*m_saveSnapshot);
+    m_saveSnapshot->saveId = ++m_saveCount;
+    m_saveSnapshot->notifyWnd = AfxGetMainWnd()->GetSafeHwnd();
+
+    // The thread object is kept after the thread exits so that it can
+    // be waited on.
+    //
+    m_saveThread = AfxBeginThread(MeaPositionLogMgr::SaveProc, m_saveSnapshot,
+                                  THREAD_PRIORITY_BELOW_NORMAL, 0, CREATE_SUSPENDED);
+    if (m_saveThread == NULL) {
+        SaveSnapshot* snapshot = m_saveSnapshot;
+        m_saveSnapshot = NULL;
+
+        WriteSnapshot(*snapshot);
+        FinishSave(*snapshot);
+        delete snapshot;
+        return true;
+    }
+
+    m_saveThread->m_bAutoDelete = FALSE;
+    m_saveThread->ResumeThread();
+
+    return true;
+}
+
+
+void MeaPositionLogMgr::WaitForSave()
+{
+    if (m_saveThread == NULL) {
+        return;
+    }
+
+    ::WaitForSingleObject(m_saveThread->m_hThread, INFINITE);
+
+    delete m_saveThread;
+    m_saveThread = NULL;
+
+    SaveSnapshot* snapshot = m_saveSnapshot;
+    m_saveSnapshot = NULL;
+
+    FinishSave(*snapshot);
+    delete snapshot;
+}
+
+
+void MeaPositionLogMgr::SaveCompleted(UINT saveId)
+{
+    // The save may already have been completed by WaitForSave.
+    //
+    if ((m_saveSnapshot != NULL) && (m_saveSnapshot->saveId == saveId)) {
+        WaitForSave();
+    }
+}
+
+
+bool MeaPositionLogMgr::GetSavePathname(bool askPathname)
 {
     bool needPathname = (m_pathname.IsEmpty() || askPathname);
 
@@ -310,28 +630,146 @@ bool MeaPositionLogMgr::Save(bool askPathname)
         }
     }
 
+    return true;
+}
+
+
+void MeaPositionLogMgr::TakeSnapshot(SaveSnapshot& snapshot)
+{
+    snapshot.saveId         = 0;
+    snapshot.pathname       = m_pathname;
+    snapshot.binary         = IsBinaryPathname(m_pathname);
+    snapshot.title          = m_title;
+    snapshot.desc           = m_desc;
+    snapshot.changeCount    = m_changeCount;
+    snapshot.journaled      = m_journal.IsAttached();
+    snapshot.journalOffset  = m_journal.GetEndOffset();
+    snapshot.notifyWnd      = NULL;
+    snapshot.succeeded      = false;
+
+    snapshot.desktops.reserve(m_refCountMap.size());
+
+    RefCountMap::const_iterator iter;
+    for (iter = m_refCountMap.begin(); iter != m_refCountMap.end(); ++iter) {
+        snapshot.desktops.push_back(GetDesktopInfo((*iter).first));
+    }
+
+    m_positions.TakeSnapshot(snapshot.positions);
+}
+
+
+void MeaPositionLogMgr::WriteSnapshot(SaveSnapshot& snapshot)
+{
+    CStdioFile file;
+    CFileException fe;
+    TCHAR errStr[256];
+    UINT flags = CFile::modeWrite | CFile::modeCreate | (snapshot.binary ? CFile::typeBinary : CFile::typeText);
+
+    snapshot.succeeded = false;
+
+    if (!file.Open(snapshot.pathname, flags, &fe)) {
+        fe.GetErrorMessage(errStr, 256);
+        snapshot.error = errStr;
+        return;
+    }
+
+    try {
+        if (snapshot.binary) {
+            WriteBinary(snapshot, file);
+        } else {
+            WriteXML(snapshot, file);
+        }
+        file.Close();
+    } catch (CException* ex) {
+        ex->GetErrorMessage(errStr, 256);
+        ex->Delete();
+        file.Abort();
+        snapshot.error = errStr;
+        return;
+    }
+
+    snapshot.succeeded = true;
+}
+
+
+void MeaPositionLogMgr::WriteXML(const SaveSnapshot& snapshot, CFile& file) throw(CFileException)
+{
+    MeaXMLWriter writer(file);
+
+    writer.Declaration();
+    writer.Doctype(_T("positionLog"), _T("http://www.cthing.com/dtd/PositionLog1.dtd"));
+    writer.StartElement(_T("positionLog"));
+    writer.Attribute(_T("version"), g_versionInfo.GetLogFileMajor());
+        WriteInfoSection(writer, snapshot);
+        WriteDesktopsSection(writer, snapshot);
+        WritePositionsSection(writer, snapshot);
+    writer.EndElement();
+    writer.Flush();
+}
+
+
+void MeaPositionLogMgr::WriteBinary(const SaveSnapshot& snapshot, CFile& file) throw(CFileException)
+{
+    MeaBinaryLogWriter writer;
+
+    writer.SetInfo(snapshot.title, snapshot.desc);
+
+    DesktopInfoList::const_iterator desktopIter;
+    for (desktopIter = snapshot.desktops.begin(); desktopIter != snapshot.desktops.end(); ++desktopIter) {
+        (*desktopIter).Save(writer);
+    }
+
+    Positions::Snapshot::const_iterator posIter;
+    for (posIter = snapshot.positions.begin(); posIter != snapshot.positions.end(); ++posIter) {
+        (*posIter)->Save(writer);
+    }
+
+    writer.Write(file);
+}
+
+
+bool MeaPositionLogMgr::FinishSave(const SaveSnapshot& snapshot)
+{
+    // Positions removed while the snapshot was being written can now
+    // be destroyed.
     //
-    // Save the positions
-    //
-    int indent = 0;
+    m_positions.ReleaseSnapshot();
 
-    if (!Open(m_pathname, CFile::modeWrite | CFile::modeCreate)) {
+    if (!snapshot.succeeded) {
+        CString msg;
+        msg.Format(IDS_MEA_NO_SAVE_LOG, static_cast<LPCTSTR>(snapshot.error));
+        MessageBox(*AfxGetMainWnd(), msg, NULL, MB_OK | MB_ICONERROR);
+
+        if (m_observer != NULL) {
+            m_observer->LogSaveFailed();
+        }
         return false;
     }
 
-    Write(indent, _T("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"));
-    Write(indent, _T("<!DOCTYPE positionLog SYSTEM \"http://www.cthing.com/dtd/PositionLog1.dtd\">\n"));
-    Write(indent, _T("<positionLog version=\"%d\">\n"), g_versionInfo.GetLogFileMajor());
-    indent++;
-        WriteInfoSection(indent);
-        WriteDesktopsSection(indent);
-        WritePositionsSection(indent);
-    indent--;
-    Write(indent, _T("</positionLog>\n"));
+    // The log now holds every change in the snapshot. Changes made while
+    // a background save was in progress are not in the log, so the
+    // positions remain modified and the entries journaled for those
+    // changes are carried over into the journal for the saved log. If
+    // any of those changes were not journaled, there is no journal
+    // until the log is next saved.
+    //
+    m_modified = (m_changeCount != snapshot.changeCount);
 
-    Close();
+    bool complete = !m_modified || (snapshot.journaled && m_journal.IsAttached());
 
-    m_modified = false;
+    if (m_journaling && complete) {
+        try {
+            m_journal.Rebase(snapshot.pathname, snapshot.journalOffset);
+        }
+        catch (CFileException* ex) {
+            ex->Delete();
+            m_journal.Discard();
+            m_journal.Detach();
+        }
+    } else {
+        m_journal.Discard();
+        m_journal.Detach();
+    }
 
     if (m_observer != NULL) {
         m_observer->LogSaved();
@@ -341,6 +779,21 @@ bool MeaPositionLogMgr::Save(bool askPathname)
 }
 
 
+UINT MeaPositionLogMgr::SaveProc(LPVOID pParam)
+{
+    SaveSnapshot* snapshot = static_cast<SaveSnapshot*>(pParam);
+
+    WriteSnapshot(*snapshot);
+
+    // The snapshot must not be touched once the message is posted
+    // because the main thread may delete it.
+    //
+    ::PostMessage(snapshot->notifyWnd, MeaPositionLogSavedMsg, snapshot->saveId, 0);
+
+    return 0;
+}
+
+
 bool MeaPositionLogMgr::Load(LPCTSTR pathname)
 {
     // If there is a modified set of positions, ask the user if
@@ -350,306 +803,696 @@ bool MeaPositionLogMgr::Load(LPCTSTR pathname)
         return false;
     }
 
+    CString loadPathname;
+
     if (pathname != NULL) {
-        m_pathname = pathname;
+        loadPathname = pathname;
     } else {
         CFileDialog *dlg = CreateLoadDialog();
 
         if (dlg->DoModal() != IDOK) {
             return false;
         }
-        m_pathname = dlg->GetPathName();
+        loadPathname = dlg->GetPathName();
     }
 
-    bool status = false;
     TCHAR drive[_MAX_DRIVE];
     TCHAR dir[_MAX_DIR];
 
     //
     // Remember the directory for persisting.
     //
-    _tsplitpath_s(m_pathname, drive, _MAX_DRIVE, dir, _MAX_DIR, NULL, 0, NULL, 0);
+    _tsplitpath_s(loadPathname, drive, _MAX_DRIVE, dir, _MAX_DIR, NULL, 0, NULL, 0);
     m_initialDir = drive;
     m_initialDir += dir;
 
     //
-    // Load the positions
+    // Load the positions. The current positions are only replaced
+    // if the file is loaded successfully.
     //
-    if (Open(m_pathname, CFile::modeRead)) {
-        //
-        // Delete old positions.
-        //
+    LogLoader loader(loadPathname);
+    bool status = loader.Load();
+
+    const LogLoader::ErrorList& errors = loader.GetErrors();
+    for (LogLoader::ErrorList::const_iterator iter = errors.begin(); iter != errors.end(); ++iter) {
+        MessageBox(*AfxGetMainWnd(), (*iter).msg,
+                   (*iter).title.IsEmpty() ? NULL : static_cast<LPCTSTR>((*iter).title),
+                   MB_OK | MB_ICONERROR);
+    }
+
+    if (status) {
         ClearPositions();
-    
-        //
-        // Parse the contents of the log file
+
+        // The journal belongs to the previous log file so it must not
+        // record the loaded positions.
         //
-        MeaXMLParser parser(this, true);
+        m_journal.Detach();
 
-        try {
-            UINT numBytes;
+        m_pathname = loadPathname;
+        m_title = loader.GetTitle();
+        m_desc = loader.GetDesc();
+        MergeLog(loader);
 
-            do {
-                void *buf = parser.GetBuffer(kChunkSize);
-                numBytes = m_stdioFile.Read(buf, kChunkSize);
-                parser.ParseBuffer(numBytes, numBytes == 0);
-            } while (numBytes > 0);
+        m_modified = false;
 
-            status = true;
-        } catch (MeaXMLParserException&) {
-            // Handled by the parser.
-        } catch (MeaLogFileException&) {
-            CString msg(reinterpret_cast<LPCSTR>(IDS_MEA_INVALID_LOGFILE));
-            MessageBox(*AfxGetMainWnd(), msg, NULL, MB_OK | MB_ICONERROR);
-        } catch (...) {
-            CString msg(reinterpret_cast<LPCSTR>(IDS_MEA_NO_POSITIONS));
-            MessageBox(*AfxGetMainWnd(), msg, NULL, MB_OK | MB_ICONERROR);
+        if (m_journaling) {
+            m_journal.Attach(m_pathname);
+            ReplayJournal();
         }
 
-        Close();
-
-        if (status) {
-            //
-            // Process the log file DOM
-            //
-            ProcessDOM(parser.GetDOM());
-
-            m_modified = false;
-
-            if (m_observer != NULL) {
-                m_observer->LogLoaded();
-            }
+        if (m_observer != NULL) {
+            m_observer->LogLoaded();
         }
-    } else {
-        m_pathname.Empty();
     }
 
     return status;
 }
 
 
-bool MeaPositionLogMgr::Open(const CString &pathname, UINT mode)
+bool MeaPositionLogMgr::Merge()
 {
-    CFileException fe;
+    std::vector<TCHAR> pathnames(kMergeBufferSize, _T('\0'));
+    CFileDialog dlg(TRUE, kExt, NULL,
+                    OFN_HIDEREADONLY | OFN_FILEMUSTEXIST | OFN_ALLOWMULTISELECT, kFilter);
 
-    m_stdioOpen = false;
+    dlg.m_ofn.lpstrTitle = m_mergeDlgTitle;
+    dlg.m_ofn.lpstrInitialDir = m_initialDir;
+    dlg.m_ofn.lpstrFile = &pathnames[0];
+    dlg.m_ofn.nMaxFile = kMergeBufferSize;
 
-    if (m_stdioFile.Open(pathname, mode, &fe) == FALSE) {
-        TCHAR errStr[256];
-        CString msg;
-        fe.GetErrorMessage(errStr, 256);
-        msg.Format(((mode & CFile::modeRead) ? IDS_MEA_NO_LOAD_LOG : IDS_MEA_NO_SAVE_LOG), errStr);
-        MessageBox(*AfxGetMainWnd(), msg, NULL, MB_OK | MB_ICONERROR);
+    if (dlg.DoModal() != IDOK) {
         return false;
     }
 
-    m_stdioOpen = true;
+    PathnameList selected;
+    POSITION pos = dlg.GetStartPosition();
+    while (pos != NULL) {
+        selected.push_back(dlg.GetNextPathName(pos));
+    }
 
-    return true;
+    return Merge(selected);
 }
 
 
-void MeaPositionLogMgr::ProcessDOM(const MeaXMLNode* dom)
+bool MeaPositionLogMgr::Merge(const PathnameList& pathnames)
 {
-    for (MeaXMLNode::NodeIter_c iter = dom->GetChildIter(); !dom->AtEnd(iter); ++iter) {
-        MeaXMLNode* node = *iter;
-        
-        if (node->GetType() == MeaXMLNode::Element) {
-            if (node->GetData() == _T("info")) {
-                ProcessInfoNode(node);
-            } else if (node->GetData() == _T("desktops")) {
-                for (MeaXMLNode::NodeIter_c desktopIter = node->GetChildIter();
-                                            !node->AtEnd(desktopIter); ++desktopIter) {
-                    ProcessDesktopNode(*desktopIter);
-                }
-            } else if (node->GetData() == _T("positions")) {
-                for (MeaXMLNode::NodeIter_c posIter = node->GetChildIter();
-                                            !node->AtEnd(posIter); ++posIter) {
-                    ProcessPositionNode(*posIter);
-                }
-            }
-        }
+    if (pathnames.empty()) {
+        return false;
     }
-}
 
-    
-void MeaPositionLogMgr::ProcessInfoNode(const MeaXMLNode* infoNode)
-{
-    for (MeaXMLNode::NodeIter_c iter = infoNode->GetChildIter(); !infoNode->AtEnd(iter); ++iter) {
-        MeaXMLNode* node = *iter;
-        
-        if (node->GetType() == MeaXMLNode::Element) {
-            if (node->GetData() == _T("title")) {
-                m_title = ProcessDataNodes(node);
-            } else if (node->GetData() == _T("desc")) {
-                m_desc = ProcessDataNodes(node);
+    LogLoaderList loaders;
+    loaders.reserve(pathnames.size());
+
+    for (PathnameList::const_iterator iter = pathnames.begin(); iter != pathnames.end(); ++iter) {
+        loaders.push_back(new LogLoader(*iter));
+    }
+
+    {
+        CWaitCursor wait;
+        LoadLogs(loaders);
+    }
+
+    //
+    // Merge the loaded files in the order they were specified, so that
+    // the result does not depend on which thread finished first.
+    //
+    int firstIndex = m_positions.Size();
+    int count = 0;
+    bool merged = false;
+    CString errorMsg;
+
+    for (LogLoaderList::iterator iter = loaders.begin(); iter != loaders.end(); ++iter) {
+        LogLoader* loader = *iter;
+
+        const LogLoader::ErrorList& errors = loader->GetErrors();
+        if (!errors.empty()) {
+            errorMsg += loader->GetPathname() + _T("\n");
+            for (LogLoader::ErrorList::const_iterator errIter = errors.begin(); errIter != errors.end(); ++errIter) {
+                errorMsg += (*errIter).msg + _T("\n");
             }
+            errorMsg += _T("\n");
         }
+
+        if (loader->IsLoaded()) {
+            count += MergeLog(*loader);
+            merged = true;
+        }
+
+        delete loader;
     }
+
+    if (!errorMsg.IsEmpty()) {
+        CString msg;
+        msg.Format(IDS_MEA_NO_MERGE_LOG, static_cast<LPCTSTR>(errorMsg));
+        MessageBox(*AfxGetMainWnd(), msg, NULL, MB_OK | MB_ICONERROR);
+    }
+
+    if (count > 0) {
+        m_modified = true;
+        m_changeCount++;
+
+        JournalPositions(firstIndex, count);
+
+        if (m_observer != NULL) {
+            m_observer->PositionsAdded(firstIndex, count);
+        }
+    }
+
+    return merged;
 }
 
 
-void MeaPositionLogMgr::ProcessDesktopNode(const MeaXMLNode* desktopNode)
+bool MeaPositionLogMgr::Export(LPCTSTR pathname)
 {
-    CString valueStr;
-    bool def;
+    CString exportPathname;
 
-    desktopNode->GetAttributes().GetValueStr(_T("id"), valueStr, def);
+    if (pathname != NULL) {
+        exportPathname = pathname;
+    } else {
+        CFileDialog dlg(FALSE, kCSVExt, NULL, OFN_OVERWRITEPROMPT | OFN_HIDEREADONLY, kTextFilter);
 
-    try {
-        DesktopInfo desktopInfo(valueStr);
-        
-        desktopInfo.Load(desktopNode);
+        dlg.m_ofn.lpstrTitle = m_exportDlgTitle;
+        dlg.m_ofn.lpstrInitialDir = m_initialDir;
 
-        const MeaGUID& guid = desktopInfo.GetId();
-        m_desktopInfoMap[guid] = desktopInfo;
+        if (dlg.DoModal() != IDOK) {
+            return false;
+        }
+        exportPathname = dlg.GetPathName();
     }
-    catch (COleException* ex) {
-        ex->Delete();
 
-        CString msg;
-        msg.Format(IDS_MEA_INVALID_DESKTOPID, static_cast<LPCTSTR>(valueStr));
+    CFile file;
+    CFileException fe;
+    TCHAR errStr[256];
+    CString msg;
+
+    if (!file.Open(exportPathname, CFile::modeWrite | CFile::modeCreate | CFile::typeBinary, &fe)) {
+        fe.GetErrorMessage(errStr, 256);
+        msg.Format(IDS_MEA_NO_EXPORT_LOG, errStr);
         MessageBox(*AfxGetMainWnd(), msg, NULL, MB_OK | MB_ICONERROR);
+        return false;
+    }
+
+    CWaitCursor wait;
+
+    try {
+        MeaTextLogWriter writer(file, GetTextFormat(exportPathname));
+        MeaTextLogRecord record;
+        const DesktopInfo* desktopInfo = NULL;
+        int count = static_cast<int>(m_positions.Size());
+
+        for (int i = 0; i < count; i++) {
+            const Position& position = m_positions.Get(i);
+
+            // Consecutive positions usually share a desktop, so the
+            // desktop is only looked up when it changes.
+            //
+            if ((desktopInfo == NULL) || (desktopInfo->GetId() != position.GetDesktopInfoId())) {
+                desktopInfo = &GetDesktopInfo(position.GetDesktopInfoId());
+            }
+
+            position.Save(record);
+            record.linearUnits = desktopInfo->GetLinearUnits()->GetUnitsStr();
+            record.angularUnits = desktopInfo->GetAngularUnits()->GetUnitsStr();
+            writer.Write(record);
+        }
+
+        writer.Flush();
+        file.Close();
+    } catch (CException* ex) {
+        ex->GetErrorMessage(errStr, 256);
+        ex->Delete();
+        file.Abort();
+        msg.Format(IDS_MEA_NO_EXPORT_LOG, errStr);
+        MessageBox(*AfxGetMainWnd(), msg, NULL, MB_OK | MB_ICONERROR);
+        return false;
     }
+
+    return true;
 }
 
 
-void MeaPositionLogMgr::ProcessPositionNode(const MeaXMLNode* positionNode)
+bool MeaPositionLogMgr::Import(LPCTSTR pathname)
 {
-    CString idStr;
-    CString toolStr;
-    CString dateStr;
-    bool def;
+    CString importPathname;
 
-    positionNode->GetAttributes().GetValueStr(_T("desktopRef"), idStr, def);
-    positionNode->GetAttributes().GetValueStr(_T("tool"), toolStr, def);
-    positionNode->GetAttributes().GetValueStr(_T("date"), dateStr, def);
+    if (pathname != NULL) {
+        importPathname = pathname;
+    } else {
+        CFileDialog dlg(TRUE, kCSVExt, NULL, OFN_HIDEREADONLY | OFN_FILEMUSTEXIST, kTextFilter);
 
-    try {
-        Position* position = new Position(this, idStr, toolStr, dateStr);
+        dlg.m_ofn.lpstrTitle = m_importDlgTitle;
+        dlg.m_ofn.lpstrInitialDir = m_initialDir;
+
+        if (dlg.DoModal() != IDOK) {
+            return false;
+        }
+        importPathname = dlg.GetPathName();
+    }
 
-        position->Load(positionNode);
+    CFile file;
+    CFileException fe;
+    TCHAR errStr[256];
+    CString msg;
 
-        m_positions.Add(position);
+    if (!file.Open(importPathname, CFile::modeRead | CFile::typeBinary | CFile::shareDenyWrite, &fe)) {
+        fe.GetErrorMessage(errStr, 256);
+        msg.Format(IDS_MEA_NO_IMPORT_LOG, errStr);
+        MessageBox(*AfxGetMainWnd(), msg, NULL, MB_OK | MB_ICONERROR);
+        return false;
     }
-    catch (COleException* ex) {
-        ex->Delete();
 
-        CString msg;
-        msg.Format(IDS_MEA_INVALID_DESKTOPREF, static_cast<LPCTSTR>(idStr));
+    typedef std::map<CString, MeaGUID> UnitsDesktopMap;
+
+    // Positions recorded in the same units share a desktop. The map is
+    // keyed by the linear and angular units identifiers.
+    //
+    UnitsDesktopMap unitsDesktops;
+    MeaUnitsMgr& unitsMgr = MeaUnitsMgr::Instance();
+    MeaTextLogReader reader(file, GetTextFormat(importPathname));
+    MeaTextLogRecord record;
+    int firstIndex = m_positions.Size();
+    int count = 0;
+    CString errorMsg;
+
+    // Positions without a date are given the time of the import.
+    //
+    CString importTimestamp(MeaMakeTimeStamp(time(NULL)));
+
+    {
+        CWaitCursor wait;
+
+        try {
+            while (reader.Read(record)) {
+                if (record.tool.IsEmpty() ||
+                        (!record.linearUnits.IsEmpty() && (unitsMgr.GetLinearUnits(record.linearUnits) == NULL)) ||
+                        (!record.angularUnits.IsEmpty() && (unitsMgr.GetAngularUnits(record.angularUnits) == NULL))) {
+                    errorMsg.Format(IDS_MEA_BAD_IMPORT_LINE, reader.GetLineNumber());
+                    break;
+                }
+
+                CString unitsKey(record.linearUnits + _T('\t') + record.angularUnits);
+                UnitsDesktopMap::const_iterator iter = unitsDesktops.find(unitsKey);
+                if (iter == unitsDesktops.end()) {
+                    DesktopInfo desktopInfo;
+                    if (!record.linearUnits.IsEmpty()) {
+                        desktopInfo.SetLinearUnits(record.linearUnits);
+                    }
+                    if (!record.angularUnits.IsEmpty()) {
+                        desktopInfo.SetAngularUnits(record.angularUnits);
+                    }
+                    iter = unitsDesktops.insert(UnitsDesktopMap::value_type(unitsKey, MergeDesktopInfo(desktopInfo))).first;
+                }
+
+                Position* position = new Position(this, (*iter).second, record.tool,
+                                                  record.timestamp.IsEmpty() ? importTimestamp : record.timestamp);
+                position->Load(record);
+
+                m_positions.Add(position);
+                count++;
+            }
+        } catch (MeaLogFileException&) {
+            errorMsg.Format(IDS_MEA_BAD_IMPORT_LINE, reader.GetLineNumber());
+        } catch (CException* ex) {
+            ex->GetErrorMessage(errStr, 256);
+            ex->Delete();
+            errorMsg = errStr;
+        }
+    }
+
+    file.Abort();
+
+    if (!errorMsg.IsEmpty()) {
+        msg.Format(IDS_MEA_NO_IMPORT_LOG, static_cast<LPCTSTR>(errorMsg));
         MessageBox(*AfxGetMainWnd(), msg, NULL, MB_OK | MB_ICONERROR);
     }
+
+    if (count > 0) {
+        m_modified = true;
+        m_changeCount++;
+
+        JournalPositions(firstIndex, count);
+
+        if (m_observer != NULL) {
+            m_observer->PositionsAdded(firstIndex, count);
+        }
+    }
+
+    return (count > 0);
 }
 
 
-CString MeaPositionLogMgr::ProcessDataNodes(const MeaXMLNode* elementNode)
+void MeaPositionLogMgr::LoadLogs(LogLoaderList& loaders)
 {
-    CString data;
+    LoadQueue queue;
+    queue.loaders = &loaders;
+    queue.next = 0;
 
-    for (MeaXMLNode::NodeIter_c iter = elementNode->GetChildIter(); !elementNode->AtEnd(iter); ++iter) {
-        MeaXMLNode* node = *iter;
-        
-        if (node->GetType() == MeaXMLNode::Data) {
-            data += node->GetData();
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+
+    // The calling thread is one of the loading threads, so one less
+    // worker than the number of processors is started.
+    //
+    size_t workerCount = min(loaders.size(), static_cast<size_t>(sysInfo.dwNumberOfProcessors));
+    workerCount = min(workerCount, static_cast<size_t>(MAXIMUM_WAIT_OBJECTS)) - 1;
+
+    std::vector<CWinThread*> workers;
+    std::vector<HANDLE> handles;
+
+    for (size_t i = 0; i < workerCount; i++) {
+        CWinThread* worker = AfxBeginThread(MeaPositionLogMgr::LoadProc, &queue,
+                                            THREAD_PRIORITY_NORMAL, 0, CREATE_SUSPENDED);
+        if (worker == NULL) {
+            break;
         }
+
+        worker->m_bAutoDelete = FALSE;
+        worker->ResumeThread();
+
+        workers.push_back(worker);
+        handles.push_back(worker->m_hThread);
     }
 
-    return MeaUtils::LFtoCRLF(data);
+    LoadProc(&queue);
+
+    if (!handles.empty()) {
+        ::WaitForMultipleObjects(static_cast<DWORD>(handles.size()), &handles[0], TRUE, INFINITE);
+    }
+
+    for (std::vector<CWinThread*>::iterator iter = workers.begin(); iter != workers.end(); ++iter) {
+        delete *iter;
+    }
+}
+
+
+UINT MeaPositionLogMgr::LoadProc(LPVOID pParam)
+{
+    LoadQueue* queue = static_cast<LoadQueue*>(pParam);
+    LONG count = static_cast<LONG>(queue->loaders->size());
+    LONG index;
+
+    while ((index = InterlockedExchangeAdd(&queue->next, 1)) < count) {
+        (*queue->loaders)[index]->Load();
+    }
+
+    return 0;
+}
+
+
+int MeaPositionLogMgr::MergeLog(LogLoader& loader)
+{
+    typedef std::map<MeaGUID, MeaGUID, MeaGUID::less> IdMap;
+
+    // Map the desktop IDs used in the file to those used by the manager.
+    //
+    IdMap desktopIds;
+    const DesktopInfoList& desktops = loader.GetDesktops();
+    for (DesktopInfoList::const_iterator iter = desktops.begin(); iter != desktops.end(); ++iter) {
+        desktopIds.insert(IdMap::value_type((*iter).GetId(), MergeDesktopInfo(*iter)));
+    }
+
+    const PositionList& positions = loader.GetPositions();
+    int firstIndex = m_positions.Size();
+    int count = static_cast<int>(positions.size());
+
+    m_positions.Reserve(firstIndex + count);
+
+    for (int i = 0; i < count; i++) {
+        Position* position = positions[i];
+
+        IdMap::const_iterator idIter = desktopIds.find(position->GetDesktopInfoId());
+        MeaAssert(idIter != desktopIds.end());      // Validator ensures this
+        position->SetDesktopInfoId(this, (*idIter).second);
+
+        m_positions.Add(position);
+    }
+
+    loader.ReleasePositions();
+
+    return count;
 }
 
 
-void MeaPositionLogMgr::WriteInfoSection(int indent) throw(CFileException)
+void MeaPositionLogMgr::WriteInfoSection(MeaXMLWriter& writer, const SaveSnapshot& snapshot)
+        throw(CFileException)
 {
     TCHAR nameBuffer[MAX_COMPUTERNAME_LENGTH + 1];
     DWORD size = MAX_COMPUTERNAME_LENGTH + 1;
 
     GetComputerName(nameBuffer, &size);
 
-    Write(indent, _T("<info>\n"));
-    indent++;
-        Write(indent, _T("<title>%s</title>\n"), MeaXMLParser::Encode(MeaUtils::CRLFtoLF(m_title)));
-        Write(indent, _T("<created date=\"%s\"/>\n"), static_cast<LPCTSTR>(MeaMakeTimeStamp(time(NULL))));
-        Write(indent, _T("<generator name=\"%s\" version=\"%s\" build=\"%d\"/>\n"),
-                static_cast<LPCTSTR>(AfxGetAppName()),
-                static_cast<LPCTSTR>(g_versionInfo.GetProductVersion()),
-                g_versionInfo.GetProductBuild());
-        Write(indent, _T("<machine name=\"%s\"/>\n"), nameBuffer);
-        if (!m_desc.IsEmpty()) {
-            Write(indent, _T("<desc>%s</desc>\n"), MeaXMLParser::Encode(MeaUtils::CRLFtoLF(m_desc)));
+    writer.StartElement(_T("info"));
+        writer.StartElement(_T("title"));
+        writer.Text(MeaUtils::CRLFtoLF(snapshot.title));
+        writer.EndElement();
+        writer.StartElement(_T("created"));
+        writer.Attribute(_T("date"), MeaMakeTimeStamp(time(NULL)));
+        writer.EndElement();
+        writer.StartElement(_T("generator"));
+        writer.Attribute(_T("name"), AfxGetAppName());
+        writer.Attribute(_T("version"), g_versionInfo.GetProductVersion());
+        writer.Attribute(_T("build"), g_versionInfo.GetProductBuild());
+        writer.EndElement();
+        writer.StartElement(_T("machine"));
+        writer.Attribute(_T("name"), nameBuffer);
+        writer.EndElement();
+        if (!snapshot.desc.IsEmpty()) {
+            writer.StartElement(_T("desc"));
+            writer.Text(MeaUtils::CRLFtoLF(snapshot.desc));
+            writer.EndElement();
         }
-    indent--;
-    Write(indent, _T("</info>\n"));
+    writer.EndElement();
 }
 
 
-void MeaPositionLogMgr::WriteDesktopsSection(int indent) throw(CFileException)
+void MeaPositionLogMgr::WriteDesktopsSection(MeaXMLWriter& writer, const SaveSnapshot& snapshot)
+        throw(CFileException)
 {
-    Write(indent, _T("<desktops>\n"));
-    indent++;
+    writer.StartElement(_T("desktops"));
 
-    RefCountMap::const_iterator iter;
-    for (iter = m_refCountMap.begin(); iter != m_refCountMap.end(); ++iter) {
-        GetDesktopInfo((*iter).first).Save(*this, indent);
+    DesktopInfoList::const_iterator iter;
+    for (iter = snapshot.desktops.begin(); iter != snapshot.desktops.end(); ++iter) {
+        (*iter).Save(writer);
+    }
+
+    writer.EndElement();
+}
+
+
+void MeaPositionLogMgr::WritePositionsSection(MeaXMLWriter& writer, const SaveSnapshot& snapshot)
+        throw(CFileException)
+{
+    writer.StartElement(_T("positions"));
+
+    Positions::Snapshot::const_iterator iter;
+    for (iter = snapshot.positions.begin(); iter != snapshot.positions.end(); ++iter) {
+        (*iter)->Save(writer);
     }
 
-    indent--;
-    Write(indent, _T("</desktops>\n"));
+    writer.EndElement();
 }
 
 
-void MeaPositionLogMgr::WritePositionsSection(int indent) throw(CFileException)
+void MeaPositionLogMgr::JournalPosition(MeaBinaryLogJournal::Operation op, int posIndex)
 {
-    Write(indent, _T("<positions>\n"));
-    indent++;
-        m_positions.Save(indent);
-    indent--;
-    Write(indent, _T("</positions>\n"));
+    if (!m_journal.IsAttached()) {
+        return;
+    }
+
+    try {
+        if (op == MeaBinaryLogJournal::DeleteOp) {
+            m_journal.Append(op, posIndex, NULL);
+        } else {
+            MeaBinaryLogWriter writer;
+            const Position& position = m_positions.Get(posIndex);
+
+            GetDesktopInfo(position.GetDesktopInfoId()).Save(writer);
+            position.Save(writer);
+
+            m_journal.Append(op, posIndex, &writer);
+        }
+    }
+    catch (CFileException* ex) {
+        // A journal missing a change must never be replayed, so drop it.
+        // The positions remain modified and will be saved in full.
+        //
+        ex->Delete();
+        m_journal.Discard();
+        m_journal.Detach();
+        return;
+    }
+
+    CompactJournal();
 }
 
 
-void MeaPositionLogMgr::Write(int indentLevel, LPCTSTR format, ...) throw(CFileException)
+void MeaPositionLogMgr::JournalPositions(int firstIndex, int count)
 {
-    CString indent(_T(' '), indentLevel * 4);
-    CString str;
-    va_list args;
-    
-    va_start(args, format);
-    str.FormatV(format, args);
-    va_end(args);
+    if (!m_journal.IsAttached() || (count <= 0)) {
+        return;
+    }
+
+    try {
+        MeaBinaryLogWriter writer;
+
+        for (int i = 0; i < count; i++) {
+            const Position& position = m_positions.Get(firstIndex + i);
+            const MeaGUID& desktopInfoId = position.GetDesktopInfoId();
+
+            if (!writer.HasDesktop(desktopInfoId)) {
+                GetDesktopInfo(desktopInfoId).Save(writer);
+            }
+            position.Save(writer);
+        }
+
+        m_journal.AppendPositions(firstIndex, writer);
+    }
+    catch (CFileException* ex) {
+        // A journal missing a change must never be replayed, so drop it.
+        // The positions remain modified and will be saved in full.
+        //
+        ex->Delete();
+        m_journal.Discard();
+        m_journal.Detach();
+        return;
+    }
 
-    m_stdioFile.WriteString(indent + MeaXMLParser::ToUTF8(str));
+    CompactJournal();
 }
 
 
-void MeaPositionLogMgr::ParseEntity(MeaXMLParser& parser,
-                            const CString& pathname)
+void MeaPositionLogMgr::CompactJournal()
 {
-    CFile entityFile;
-    CFileException fe;
+    if ((m_journal.GetSize() > kJournalCompactSize) && !IsSaving()) {
+        SaveInBackground(false);
+    }
+}
 
-    if (!entityFile.Open(pathname, CFile::modeRead, &fe)) {
-        AfxThrowFileException(fe.m_cause, fe.m_lOsError, pathname);
+
+void MeaPositionLogMgr::ReplayJournal()
+{
+    if (!m_journal.Read()) {
+        return;
     }
 
-    MeaXMLParser entityParser(parser);
+    size_t offset = 0;
+    size_t goodOffset = 0;
+    MeaBinaryLogJournalEntry entry;
+    const BYTE* data;
+    Position* position = NULL;
+    bool valid = true;
 
-    // Read the contents of the entity file into a parsing buffer.
-    //
-    int size = static_cast<int>(entityFile.GetLength());
-    void *buf = entityParser.GetBuffer(size);
-    UINT count = entityFile.Read(buf, size);
+    try {
+        while (m_journal.GetEntry(offset, entry, data)) {
+            switch (entry.op) {
+            case MeaBinaryLogJournal::AddOp:
+                m_positions.Add(LoadJournalPosition(data, entry.size));
+                break;
+            case MeaBinaryLogJournal::ReplaceOp:
+                position = LoadJournalPosition(data, entry.size);
+                m_positions.Set(entry.posIndex, position);
+                position = NULL;
+                break;
+            case MeaBinaryLogJournal::DeleteOp:
+                m_positions.Delete(entry.posIndex);
+                break;
+            case MeaBinaryLogJournal::AddBatchOp:
+                AddJournalPositions(data, entry.size);
+                break;
+            default:
+                throw MeaLogFileException();
+            }
 
-    // Parse the entity file
+            goodOffset = offset;
+            m_modified = true;
+        }
+    }
+    catch (MeaLogFileException&) {
+        valid = false;
+    }
+    catch (std::out_of_range* ex) {
+        delete ex;
+        delete position;
+        valid = false;
+    }
+
+    // Entries that were only partly written, or that could not be
+    // applied, are removed so that the changes journaled from now on
+    // directly follow the entries that were replayed.
     //
-    entityParser.ParseBuffer(count, true);
+    try {
+        m_journal.Truncate(goodOffset);
+    }
+    catch (CFileException* ex) {
+        ex->Delete();
+        m_journal.Discard();
+        m_journal.Detach();
+    }
 
-    entityFile.Close();
+    if (!valid) {
+        CString msg(reinterpret_cast<LPCSTR>(IDS_MEA_INVALID_LOGFILE));
+        MessageBox(*AfxGetMainWnd(), msg, NULL, MB_OK | MB_ICONERROR);
+    }
 }
 
 
-CString MeaPositionLogMgr::GetFilePathname()
+MeaPositionLogMgr::Position* MeaPositionLogMgr::LoadJournalPosition(const BYTE* data, UINT32 size)
 {
-    return m_stdioOpen ? m_stdioFile.GetFilePath() : m_pathname;
+    MeaBinaryLogReader reader;
+
+    reader.Open(data, size);
+
+    const MeaBinaryLogHeader& header = reader.GetHeader();
+    if ((header.desktopCount != 1) || (header.positionCount != 1)) {
+        throw MeaLogFileException();
+    }
+
+    const MeaBinaryLogDesktop& desktop = reader.GetDesktop(0);
+    DesktopInfo desktopInfo(MeaGUID(desktop.id));
+    desktopInfo.Load(reader, desktop);
+    if (m_desktopInfoMap.find(desktopInfo.GetId()) == m_desktopInfoMap.end()) {
+        AddDesktopInfo(desktopInfo);
+    }
+
+    const MeaBinaryLogPosition& record = reader.GetPosition(0);
+    Position* position = new Position(this, desktopInfo.GetId(),
+                                      reader.GetString(record.toolStr),
+                                      reader.GetString(record.timestampStr));
+    position->Load(reader, record);
+
+    return position;
+}
+
+
+void MeaPositionLogMgr::AddJournalPositions(const BYTE* data, UINT32 size)
+{
+    MeaBinaryLogReader reader;
+
+    reader.Open(data, size);
+
+    const MeaBinaryLogHeader& header = reader.GetHeader();
+    if ((header.desktopCount == 0) || (header.positionCount == 0)) {
+        throw MeaLogFileException();
+    }
+
+    for (UINT32 i = 0; i < header.desktopCount; i++) {
+        const MeaBinaryLogDesktop& record = reader.GetDesktop(i);
+        DesktopInfo desktopInfo(MeaGUID(record.id));
+        desktopInfo.Load(reader, record);
+        if (m_desktopInfoMap.find(desktopInfo.GetId()) == m_desktopInfoMap.end()) {
+            AddDesktopInfo(desktopInfo);
+        }
+    }
+
+    m_positions.Reserve(m_positions.Size() + header.positionCount);
+    for (UINT32 i = 0; i < header.positionCount; i++) {
+        const MeaBinaryLogPosition& record = reader.GetPosition(i);
+        Position* position = new Position(this, MeaGUID(reader.GetDesktop(record.desktop).id),
+                                          reader.GetString(record.toolStr),
+                                          reader.GetString(record.timestampStr));
+        position->Load(reader, record);
+        m_positions.Add(position);
+    }
 }
 
 
@@ -679,52 +1522,91 @@ MeaPositionLogMgr::Screen::Screen(const MeaScreenMgr::ScreenIter& screenIter)
 }
 
 
-void MeaPositionLogMgr::Screen::Load(const MeaXMLNode* screenNode)
+void MeaPositionLogMgr::Screen::Load(const MeaXMLStringView& elementName, const MeaXMLAttributes& attrs)
 {
-    CString valueStr;
     bool def;
 
-    screenNode->GetAttributes().GetValueBool(_T("primary"), m_primary, def);
-    screenNode->GetAttributes().GetValueStr(_T("desc"), m_desc, def);
+    if (elementName == _T("screen")) {
+        attrs.GetValueBool(_T("primary"), m_primary, def);
+        attrs.GetValueStr(_T("desc"), m_desc, def);
+    }
+    else if (elementName == _T("rect")) {
+        attrs.GetValueDbl(_T("top"), m_rect.top, def);
+        attrs.GetValueDbl(_T("bottom"), m_rect.bottom, def);
+        attrs.GetValueDbl(_T("left"), m_rect.left, def);
+        attrs.GetValueDbl(_T("right"), m_rect.right, def);
+    }
+    else if (elementName == _T("resolution")) {
+        attrs.GetValueDbl(_T("x"), m_res.cx, def);
+        attrs.GetValueDbl(_T("y"), m_res.cy, def);
+        attrs.GetValueBool(_T("manual"), m_manualRes, def);
+    }
+}
 
-    for (MeaXMLNode::NodeIter_c iter = screenNode->GetChildIter(); !screenNode->AtEnd(iter); ++iter) {
-        MeaXMLNode* node = *iter;
-        const MeaXMLAttributes& attrs = node->GetAttributes();
 
-        if (node->GetType() == MeaXMLNode::Element) {
-            if (node->GetData() == _T("rect")) {
-                attrs.GetValueDbl(_T("top"), m_rect.top, def);
-                attrs.GetValueDbl(_T("bottom"), m_rect.bottom, def);
-                attrs.GetValueDbl(_T("left"), m_rect.left, def);
-                attrs.GetValueDbl(_T("right"), m_rect.right, def);
-            }
-            else if (node->GetData() == _T("resolution")) {
-                attrs.GetValueDbl(_T("x"), m_res.cx, def);
-                attrs.GetValueDbl(_T("y"), m_res.cy, def);
-                attrs.GetValueBool(_T("manual"), m_manualRes, def);
-            }
-        }
-    }
+size_t MeaPositionLogMgr::Screen::GetHash() const
+{
+    size_t seed = 0;
+
+    boost::hash_combine(seed, m_primary);
+    boost::hash_combine(seed, m_manualRes);
+    boost::hash_combine(seed, boost::hash_range(static_cast<LPCTSTR>(m_desc),
+                                                static_cast<LPCTSTR>(m_desc) + m_desc.GetLength()));
+
+    return seed;
+}
+
+
+void MeaPositionLogMgr::Screen::Load(const MeaBinaryLogReader& reader, const MeaBinaryLogScreen& record)
+{
+    m_rect.top      = record.top;
+    m_rect.bottom   = record.bottom;
+    m_rect.left     = record.left;
+    m_rect.right    = record.right;
+    m_res.cx        = record.resX;
+    m_res.cy        = record.resY;
+    m_primary       = (record.primary != 0);
+    m_manualRes     = (record.manualRes != 0);
+    m_desc          = reader.GetString(record.descStr);
+}
+
+
+void MeaPositionLogMgr::Screen::Save(MeaBinaryLogWriter& writer) const
+{
+    MeaBinaryLogScreen record;
+
+    record.top          = m_rect.top;
+    record.bottom       = m_rect.bottom;
+    record.left         = m_rect.left;
+    record.right        = m_rect.right;
+    record.resX         = m_res.cx;
+    record.resY         = m_res.cy;
+    record.primary      = m_primary ? 1 : 0;
+    record.manualRes    = m_manualRes ? 1 : 0;
+    record.descStr      = writer.AddString(m_desc);
+
+    writer.AddScreen(record);
 }
 
 
-void MeaPositionLogMgr::Screen::Save(MeaPositionLogMgr& mgr, int indent) const
+void MeaPositionLogMgr::Screen::Save(MeaXMLWriter& writer) const
         throw(CFileException)
 {
-    mgr.Write(indent, _T("<screen desc=\"%s\" primary=\"%s\">\n"), m_desc,
-        (m_primary ? _T("true") : _T("false")));
-    indent++;
-        mgr.Write(indent, _T("<rect top=\"%s\" bottom=\"%s\" left=\"%s\" right=\"%s\"/>\n"),
-            static_cast<LPCTSTR>(MeaUtils::DblToStr(m_rect.top)),
-            static_cast<LPCTSTR>(MeaUtils::DblToStr(m_rect.bottom)),
-            static_cast<LPCTSTR>(MeaUtils::DblToStr(m_rect.left)),
-            static_cast<LPCTSTR>(MeaUtils::DblToStr(m_rect.right)));
-        mgr.Write(indent, _T("<resolution x=\"%s\" y=\"%s\" manual=\"%s\"/>\n"),
-            static_cast<LPCTSTR>(MeaUtils::DblToStr(m_res.cx)),
-            static_cast<LPCTSTR>(MeaUtils::DblToStr(m_res.cy)),
-            (m_manualRes ? _T("true") : _T("false")));
-    indent--;
-    mgr.Write(indent, _T("</screen>\n"));
+    writer.StartElement(_T("screen"));
+    writer.Attribute(_T("desc"), m_desc);
+    writer.Attribute(_T("primary"), m_primary);
+        writer.StartElement(_T("rect"));
+        writer.Attribute(_T("top"), m_rect.top);
+        writer.Attribute(_T("bottom"), m_rect.bottom);
+        writer.Attribute(_T("left"), m_rect.left);
+        writer.Attribute(_T("right"), m_rect.right);
+        writer.EndElement();
+        writer.StartElement(_T("resolution"));
+        writer.Attribute(_T("x"), m_res.cx);
+        writer.Attribute(_T("y"), m_res.cy);
+        writer.Attribute(_T("manual"), m_manualRes);
+        writer.EndElement();
+    writer.EndElement();
 }
 
 
@@ -739,9 +1621,23 @@ MeaPositionLogMgr::DesktopInfo::DesktopInfo()
 }
 
 
-MeaPositionLogMgr::DesktopInfo::DesktopInfo(LPCTSTR guidStr) : m_id(guidStr)
+MeaPositionLogMgr::DesktopInfo::DesktopInfo(const MeaGUID& id) :
+    m_id(id),
+    m_invertY(MeaUnitsMgr::kDefInvertY),
+    m_customFactor(0.0)
 {
-    Init();
+    MeaUnitsMgr& unitsMgr = MeaUnitsMgr::Instance();
+
+    // Only the units lookup tables are read here. They are built when the
+    // units manager is created and are not modified afterwards.
+    //
+    m_linearUnits   = unitsMgr.GetLinearUnits(MeaUnitsMgr::kDefLinearUnits);
+    m_angularUnits  = unitsMgr.GetAngularUnits(MeaUnitsMgr::kDefAngularUnits);
+
+    m_origin.x  = 0.0;
+    m_origin.y  = 0.0;
+    m_size.cx   = 0.0;
+    m_size.cy   = 0.0;
 }
 
 
@@ -776,12 +1672,102 @@ void MeaPositionLogMgr::DesktopInfo::Init()
         m_customPrecisions.clear();
     }
 
-    MeaScreenMgr::ScreenIter iter;
-    for (iter = screenMgr.GetScreenIter(); !screenMgr.AtEnd(iter); ++iter) {
-        Screen screen(iter);
+    MeaScreenMgr::ScreenIter iter;
+    for (iter = screenMgr.GetScreenIter(); !screenMgr.AtEnd(iter); ++iter) {
+        Screen screen(iter);
+
+        m_screens.push_back(screen);
+    }
+}
+
+
+bool MeaPositionLogMgr::DesktopInfo::RequiresRes() const
+{
+    if (m_linearUnits->GetUnitsId() == MeaCustomId) {
+        MeaCustomUnits::ScaleBasis basis = MeaCustomUnits::kDefScaleBasis;
+        MeaCustomUnits::ParseScaleBasis(m_customBasisStr, basis);
+        return basis != MeaCustomUnits::PixelBasis;
+    }
+
+    return m_linearUnits->RequiresRes();
+}
+
+
+FSIZE MeaPositionLogMgr::DesktopInfo::FromPixels(const FSIZE& res) const
+{
+    if (m_linearUnits->GetUnitsId() == MeaCustomId && m_customFactor > 0.0) {
+        MeaCustomUnits::ScaleBasis basis = MeaCustomUnits::kDefScaleBasis;
+        MeaCustomUnits::ParseScaleBasis(m_customBasisStr, basis);
+        return MeaCustomUnits::CalcFromPixels(basis, m_customFactor, res);
+    }
+
+    return m_linearUnits->GetFromPixels(res);
+}
+
+
+void MeaPositionLogMgr::DesktopInfo::GetUnitsScales(const MeaLinearUnits& units,
+                                                    MeaPositionBatch::ScaleList& scales) const
+{
+    MeaScreenMgr& screenMgr = MeaScreenMgr::Instance();
+
+    scales.clear();
+
+    // The screen resolutions are recorded in the desktop's units, as
+    // converted by MeaLinearUnits::ConvertRes. For pixels that is the
+    // resolution itself, and for units that depend on the resolution it
+    // is the resolution divided by the units per inch. Units that neither
+    // are pixels nor depend on the resolution (custom units based on
+    // pixels) do not record it, so the resolution of the primary screen
+    // is used for them.
+    //
+    bool pixels = (m_linearUnits->GetUnitsId() == MeaPixelsId);
+    bool requiresRes = RequiresRes();
+
+    FSIZE oneRes;
+    oneRes.cx = 1.0;
+    oneRes.cy = 1.0;
+    FSIZE unitsPerInch = FromPixels(oneRes);
+
+    ScreenList::const_iterator iter;
+    for (iter = m_screens.begin(); iter != m_screens.end(); ++iter) {
+        FSIZE res;
+
+        if (pixels) {
+            res = (*iter).GetRes();
+        } else if (requiresRes) {
+            res.cx = (*iter).GetRes().cx * unitsPerInch.cx;
+            res.cy = (*iter).GetRes().cy * unitsPerInch.cy;
+        } else {
+            res = screenMgr.GetScreenRes(screenMgr.GetScreenIter());
+        }
+
+        FSIZE from = FromPixels(res);
+        FSIZE to = units.GetFromPixels(res);
+
+        MeaPositionBatch::Scale scale;
+        scale.rect = (*iter).GetRect();
+        scale.factor.cx = to.cx / from.cx;
+        scale.factor.cy = to.cy / from.cy;
+        scales.push_back(scale);
+    }
+
+    if (scales.empty()) {
+        const FSIZE& res = screenMgr.GetScreenRes(screenMgr.GetScreenIter());
+        FSIZE from = FromPixels(res);
+        FSIZE to = units.GetFromPixels(res);
+
+        MeaPositionBatch::Scale scale;
+        scale.rect.top = scale.rect.bottom = scale.rect.left = scale.rect.right = 0.0;
+        scale.factor.cx = to.cx / from.cx;
+        scale.factor.cy = to.cy / from.cy;
+        scales.push_back(scale);
+    }
+}
+
 
-        m_screens.push_back(screen);
-    }
+double MeaPositionLogMgr::DesktopInfo::GetAngleFactor(const MeaAngularUnits& units) const
+{
+    return units.ConvertAngle(1.0) / m_angularUnits->ConvertAngle(1.0);
 }
 
 
@@ -799,122 +1785,187 @@ void MeaPositionLogMgr::DesktopInfo::SetAngularUnits(const CString& unitsStr)
 }
 
 
-void MeaPositionLogMgr::DesktopInfo::Load(const MeaXMLNode* desktopNode)
+void MeaPositionLogMgr::DesktopInfo::Load(const MeaXMLStringView& elementName, const MeaXMLAttributes& attrs)
 {
     CString valueStr;
     bool def;
 
-    for (MeaXMLNode::NodeIter_c iter = desktopNode->GetChildIter(); !desktopNode->AtEnd(iter); ++iter) {
-        MeaXMLNode* node = *iter;
-        const MeaXMLAttributes& attrs = node->GetAttributes();
-
-        if (node->GetType() == MeaXMLNode::Element) {
-            if (node->GetData() == _T("units")) {
-                attrs.GetValueStr(_T("length"), valueStr, def);
-                SetLinearUnits(valueStr);
-                attrs.GetValueStr(_T("angle"), valueStr, def);
-                SetAngularUnits(valueStr);
-            }
-            else if (node->GetData() == _T("customUnits")) {
-                attrs.GetValueStr(_T("name"), m_customName, def);
-                attrs.GetValueStr(_T("abbrev"), m_customAbbrev, def);
-                attrs.GetValueStr(_T("scaleBasis"), m_customBasisStr, def);
-                attrs.GetValueDbl(_T("scaleFactor"), m_customFactor, def);
-            }
-            else if (node->GetData() == _T("origin")) {
-                attrs.GetValueDbl(_T("xoffset"), m_origin.x, def);
-                attrs.GetValueDbl(_T("yoffset"), m_origin.y, def);
-                attrs.GetValueBool(_T("invertY"), m_invertY, def);
-            }
-            else if (node->GetData() == _T("size")) {
-                attrs.GetValueDbl(_T("x"), m_size.cx, def);
-                attrs.GetValueDbl(_T("y"), m_size.cy, def);
-            }
-            else if (node->GetData() == _T("screens")) {
-                m_screens.clear();
-                for (MeaXMLNode::NodeIter_c screenIter = node->GetChildIter();
-                                            !node->AtEnd(screenIter); ++screenIter) {
-                    Screen screen;
-                    screen.Load(*screenIter);
-                    m_screens.push_back(screen);
-                }
-            }
-            else if (node->GetData() == _T("displayPrecisions")) {
-                MeaXMLNode::NodeIter_c precIter = node->GetChildIter();
-                LoadCustomPrecisions(*precIter);
-            }
+    if (elementName == _T("units")) {
+        attrs.GetValueStr(_T("length"), valueStr, def);
+        SetLinearUnits(valueStr);
+        attrs.GetValueStr(_T("angle"), valueStr, def);
+        SetAngularUnits(valueStr);
+    }
+    else if (elementName == _T("customUnits")) {
+        attrs.GetValueStr(_T("name"), m_customName, def);
+        attrs.GetValueStr(_T("abbrev"), m_customAbbrev, def);
+        attrs.GetValueStr(_T("scaleBasis"), m_customBasisStr, def);
+        attrs.GetValueDbl(_T("scaleFactor"), m_customFactor, def);
+    }
+    else if (elementName == _T("origin")) {
+        attrs.GetValueDbl(_T("xoffset"), m_origin.x, def);
+        attrs.GetValueDbl(_T("yoffset"), m_origin.y, def);
+        attrs.GetValueBool(_T("invertY"), m_invertY, def);
+    }
+    else if (elementName == _T("size")) {
+        attrs.GetValueDbl(_T("x"), m_size.cx, def);
+        attrs.GetValueDbl(_T("y"), m_size.cy, def);
+    }
+    else if (elementName == _T("screens")) {
+        m_screens.clear();
+    }
+    else if (elementName == _T("screen")) {
+        m_screens.push_back(Screen());
+        m_screens.back().Load(elementName, attrs);
+    }
+    else if ((elementName == _T("rect")) || (elementName == _T("resolution"))) {
+        if (!m_screens.empty()) {
+            m_screens.back().Load(elementName, attrs);
         }
     }
 }
 
 
-void MeaPositionLogMgr::DesktopInfo::Save(MeaPositionLogMgr& mgr, int indent) const
+size_t MeaPositionLogMgr::DesktopInfo::GetHash() const
+{
+    size_t seed = 0;
+
+    boost::hash_combine(seed, m_invertY);
+    boost::hash_combine(seed, m_linearUnits);
+    boost::hash_combine(seed, m_angularUnits);
+
+    boost::hash_combine(seed, m_screens.size());
+    for (ScreenList::const_iterator iter = m_screens.begin(); iter != m_screens.end(); ++iter) {
+        boost::hash_combine(seed, (*iter).GetHash());
+    }
+
+    boost::hash_combine(seed, boost::hash_range(static_cast<LPCTSTR>(m_customName),
+                                                static_cast<LPCTSTR>(m_customName) + m_customName.GetLength()));
+    boost::hash_combine(seed, boost::hash_range(static_cast<LPCTSTR>(m_customAbbrev),
+                                                static_cast<LPCTSTR>(m_customAbbrev) + m_customAbbrev.GetLength()));
+    boost::hash_combine(seed, boost::hash_range(static_cast<LPCTSTR>(m_customBasisStr),
+                                                static_cast<LPCTSTR>(m_customBasisStr) + m_customBasisStr.GetLength()));
+    boost::hash_combine(seed, boost::hash_range(m_customPrecisions.begin(), m_customPrecisions.end()));
+
+    return seed;
+}
+
+
+void MeaPositionLogMgr::DesktopInfo::Load(const MeaBinaryLogReader& reader, const MeaBinaryLogDesktop& record)
+{
+    MeaUnitsMgr& unitsMgr = MeaUnitsMgr::Instance();
+    UINT32 i;
+
+    m_linearUnits = unitsMgr.GetLinearUnits(reader.GetString(record.linearUnitsStr));
+    m_angularUnits = unitsMgr.GetAngularUnits(reader.GetString(record.angularUnitsStr));
+    if ((m_linearUnits == NULL) || (m_angularUnits == NULL)) {
+        throw MeaLogFileException();
+    }
+
+    m_id                = record.id;
+    m_origin.x          = record.originX;
+    m_origin.y          = record.originY;
+    m_invertY           = (record.invertY != 0);
+    m_size.cx           = record.sizeX;
+    m_size.cy           = record.sizeY;
+    m_customName        = reader.GetString(record.customNameStr);
+    m_customAbbrev      = reader.GetString(record.customAbbrevStr);
+    m_customBasisStr    = reader.GetString(record.customBasisStr);
+    m_customFactor      = record.customFactor;
+
+    m_screens.clear();
+    for (i = 0; i < record.screenCount; i++) {
+        m_screens.push_back(Screen());
+        m_screens.back().Load(reader, reader.GetScreen(record.firstScreen + i));
+    }
+
+    m_customPrecisions.clear();
+    for (i = 0; i < record.precisionCount; i++) {
+        m_customPrecisions.push_back(reader.GetPrecision(record.firstPrecision + i));
+    }
+}
+
+
+void MeaPositionLogMgr::DesktopInfo::Save(MeaBinaryLogWriter& writer) const
+{
+    MeaBinaryLogDesktop record;
+
+    memset(&record, 0, sizeof(record));
+
+    ScreenList::const_iterator iter;
+    for (iter = m_screens.begin(); iter != m_screens.end(); ++iter) {
+        (*iter).Save(writer);
+    }
+
+    MeaUnits::DisplayPrecisions::const_iterator precIter;
+    for (precIter = m_customPrecisions.begin(); precIter != m_customPrecisions.end(); ++precIter) {
+        writer.AddPrecision(*precIter);
+    }
+
+    record.id               = m_id;
+    record.originX          = m_origin.x;
+    record.originY          = m_origin.y;
+    record.invertY          = m_invertY ? 1 : 0;
+    record.sizeX            = m_size.cx;
+    record.sizeY            = m_size.cy;
+    record.linearUnitsStr   = writer.AddString(m_linearUnits->GetUnitsStr());
+    record.angularUnitsStr  = writer.AddString(m_angularUnits->GetUnitsStr());
+    record.customNameStr    = writer.AddString(m_customName);
+    record.customAbbrevStr  = writer.AddString(m_customAbbrev);
+    record.customBasisStr   = writer.AddString(m_customBasisStr);
+    record.customFactor     = m_customFactor;
+
+    writer.AddDesktop(record);
+}
+
+
+void MeaPositionLogMgr::DesktopInfo::Save(MeaXMLWriter& writer) const
         throw(CFileException)
 {
-    mgr.Write(indent, _T("<desktop id=\"%s\">\n"), static_cast<LPCTSTR>(m_id));
-    indent++;
-        mgr.Write(indent, _T("<units length=\"%s\" angle=\"%s\"/>\n"),
-            static_cast<LPCTSTR>(m_linearUnits->GetUnitsStr()),
-            static_cast<LPCTSTR>(m_angularUnits->GetUnitsStr()));
-        
+    writer.StartElement(_T("desktop"));
+    writer.Attribute(_T("id"), m_id.ToString());
+        writer.StartElement(_T("units"));
+        writer.Attribute(_T("length"), m_linearUnits->GetUnitsStr());
+        writer.Attribute(_T("angle"), m_angularUnits->GetUnitsStr());
+        writer.EndElement();
+
         if (m_linearUnits->GetUnitsId() == MeaCustomId) {
-            mgr.Write(indent, _T("<customUnits name=\"%s\" abbrev=\"%s\" scaleBasis=\"%s\" scaleFactor=\"%f\"/>\n"),
-                static_cast<LPCTSTR>(m_customName),
-                static_cast<LPCTSTR>(m_customAbbrev),
-                static_cast<LPCTSTR>(m_customBasisStr), m_customFactor);
+            writer.StartElement(_T("customUnits"));
+            writer.Attribute(_T("name"), m_customName);
+            writer.Attribute(_T("abbrev"), m_customAbbrev);
+            writer.Attribute(_T("scaleBasis"), m_customBasisStr);
+            writer.Attribute(_T("scaleFactor"), m_customFactor);
+            writer.EndElement();
         }
-        
-        mgr.Write(indent, _T("<origin xoffset=\"%s\" yoffset=\"%s\" invertY=\"%s\"/>\n"),
-            static_cast<LPCTSTR>(MeaUtils::DblToStr(m_origin.x)),
-            static_cast<LPCTSTR>(MeaUtils::DblToStr(m_origin.y)),
-            (m_invertY ? _T("true") : _T("false")));
-        mgr.Write(indent, _T("<size x=\"%s\" y=\"%s\"/>\n"),
-            static_cast<LPCTSTR>(MeaUtils::DblToStr(m_size.cx)),
-            static_cast<LPCTSTR>(MeaUtils::DblToStr(m_size.cy)));
-
-        mgr.Write(indent, _T("<screens>\n"));
-        indent++;
+
+        writer.StartElement(_T("origin"));
+        writer.Attribute(_T("xoffset"), m_origin.x);
+        writer.Attribute(_T("yoffset"), m_origin.y);
+        writer.Attribute(_T("invertY"), m_invertY);
+        writer.EndElement();
+        writer.StartElement(_T("size"));
+        writer.Attribute(_T("x"), m_size.cx);
+        writer.Attribute(_T("y"), m_size.cy);
+        writer.EndElement();
+
+        writer.StartElement(_T("screens"));
             ScreenList::const_iterator iter;
             for (iter = m_screens.begin(); iter != m_screens.end(); ++iter)
-                (*iter).Save(mgr, indent);
-        indent--;
-        mgr.Write(indent, _T("</screens>\n"));
+                (*iter).Save(writer);
+        writer.EndElement();
 
         if (m_linearUnits->GetUnitsId() == MeaCustomId) {
-            mgr.Write(indent, _T("<displayPrecisions>\n"));
-            indent++;
-                SaveCustomPrecisions(mgr, indent);
-            indent--;
-            mgr.Write(indent, _T("</displayPrecisions>\n"));
+            writer.StartElement(_T("displayPrecisions"));
+                SaveCustomPrecisions(writer);
+            writer.EndElement();
         }
-    indent--;
-    mgr.Write(indent, _T("</desktop>\n"));
+    writer.EndElement();
 }
 
 
-void MeaPositionLogMgr::DesktopInfo::LoadCustomPrecisions(const MeaXMLNode* displayPrecisionNode)
+void MeaPositionLogMgr::DesktopInfo::LoadCustomPrecisions(const std::map<CString, int>& precMap)
 {
-    typedef std::map<CString, int> PrecisionMap;
-    typedef PrecisionMap::const_iterator PrecisionIter;
-
-    bool def;
-    PrecisionMap precMap;
-
-    for (MeaXMLNode::NodeIter_c measurementIter = displayPrecisionNode->GetChildIter();
-                                !displayPrecisionNode->AtEnd(measurementIter); ++measurementIter) {
-        MeaXMLNode* measurementNode = *measurementIter;
-        const MeaXMLAttributes& attrs = measurementNode->GetAttributes();
-
-        if (measurementNode->GetData() == _T("measurement")) {
-            CString name;
-            int places;
-
-            attrs.GetValueStr(_T("name"), name, def);
-            attrs.GetValueInt(_T("decimalPlaces"), places, def);
-
-            precMap[name] = places;
-        }
-    }
+    typedef std::map<CString, int>::const_iterator PrecisionIter;
 
     const MeaUnits::DisplayPrecisionNames& precisionNames = m_linearUnits->GetDisplayPrecisionNames();
     const MeaUnits::DisplayPrecisions& precisions = m_linearUnits->GetDisplayPrecisions();
@@ -930,22 +1981,21 @@ void MeaPositionLogMgr::DesktopInfo::LoadCustomPrecisions(const MeaXMLNode* disp
 }
 
 
-void MeaPositionLogMgr::DesktopInfo::SaveCustomPrecisions(MeaPositionLogMgr& mgr,
-                                                          int indent) const
+void MeaPositionLogMgr::DesktopInfo::SaveCustomPrecisions(MeaXMLWriter& writer) const
              throw(CFileException)
 {
     const MeaUnits::DisplayPrecisionNames& precisionNames = m_linearUnits->GetDisplayPrecisionNames();
     unsigned int i;
 
-    mgr.Write(indent, _T("<displayPrecision units=\"%s\">\n"),
-        static_cast<LPCTSTR>(m_linearUnits->GetUnitsStr()));
-    indent++;
+    writer.StartElement(_T("displayPrecision"));
+    writer.Attribute(_T("units"), m_linearUnits->GetUnitsStr());
         for (i = 0; i < m_customPrecisions.size(); i++) {
-            mgr.Write(indent, _T("<measurement name=\"%s\" decimalPlaces=\"%d\"/>\n"),
-                static_cast<LPCTSTR>(precisionNames[i]), m_customPrecisions[i]);
+            writer.StartElement(_T("measurement"));
+            writer.Attribute(_T("name"), precisionNames[i]);
+            writer.Attribute(_T("decimalPlaces"), m_customPrecisions[i]);
+            writer.EndElement();
         }
-    indent--;
-    mgr.Write(indent, _T("</displayPrecision>\n"));
+    writer.EndElement();
 }
 
 
@@ -1006,6 +2056,25 @@ MeaPositionLogMgr::Position::Position(MeaPositionLogMgr* mgr, const CString& des
 }
 
 
+MeaPositionLogMgr::Position::Position(MeaPositionLogMgr* mgr, const MeaGUID& desktopInfoId,
+                              const CString& toolName, const CString& timestamp) :
+        m_mgr(mgr),
+        m_fieldMask(0),
+        m_width(0.0),
+        m_height(0.0),
+        m_distance(0.0),
+        m_area(0.0),
+        m_angle(0.0),
+        m_desktopInfoId(desktopInfoId),
+        m_toolName(toolName),
+        m_timestamp(timestamp)
+{
+    if (m_mgr != NULL) {
+        m_mgr->AddDesktopRef(m_desktopInfoId);
+    }
+}
+
+
 MeaPositionLogMgr::Position::Position(const Position& position) : m_mgr(NULL),
     m_fieldMask(0)
 {
@@ -1056,11 +2125,26 @@ MeaPositionLogMgr::Position& MeaPositionLogMgr::Position::Copy(const Position& p
 }
 
 
+void MeaPositionLogMgr::Position::SetDesktopInfoId(MeaPositionLogMgr* mgr, const MeaGUID& desktopInfoId)
+{
+    if (m_mgr != NULL) {
+        m_mgr->ReleaseDesktopRef(m_desktopInfoId);
+    }
+
+    m_mgr = mgr;
+    m_desktopInfoId = desktopInfoId;
+
+    if (m_mgr != NULL) {
+        m_mgr->AddDesktopRef(m_desktopInfoId);
+    }
+}
+
+
 void MeaPositionLogMgr::Position::RecordXY1(const FPOINT& point)
 {
     m_fieldMask |= MeaX1Field | MeaY1Field;
 
-    m_points[_T("1")] = point;
+    m_points.SetPoint(MeaPositionPoints::Point1, point);
 }
 
 
@@ -1068,7 +2152,7 @@ void MeaPositionLogMgr::Position::RecordXY2(const FPOINT& point)
 {
     m_fieldMask |= MeaX2Field | MeaY2Field;
 
-    m_points[_T("2")] = point;
+    m_points.SetPoint(MeaPositionPoints::Point2, point);
 }
 
 
@@ -1076,7 +2160,7 @@ void MeaPositionLogMgr::Position::RecordXYV(const FPOINT& point)
 {
     m_fieldMask |= MeaXVField | MeaYVField;
 
-    m_points[_T("v")] = point;
+    m_points.SetPoint(MeaPositionPoints::PointV, point);
 }
 
 
@@ -1197,144 +2281,233 @@ void MeaPositionLogMgr::Position::Show() const
 
     // Show the points.
     //
-    PointMap::const_iterator iter;
     MeaRadioTool::PointMap toolPoints;
+    int count = m_points.GetCount();
 
-    for (iter = m_points.begin(); iter != m_points.end(); ++iter) {
-        toolPoints[(*iter).first] = unitsMgr.UnconvertCoord((*iter).second);
+    for (int i = 0; i < count; i++) {
+        toolPoints[m_points.GetNameAt(i)] = unitsMgr.UnconvertCoord(m_points.GetPointAt(i));
     }
 
     toolMgr.SetPosition(toolPoints);
 }
 
 
-void MeaPositionLogMgr::Position::Load(const MeaXMLNode* positionNode)
+void MeaPositionLogMgr::Position::Load(const MeaXMLStringView& elementName, const MeaXMLAttributes& attrs)
 {
     bool def;
 
-    for (MeaXMLNode::NodeIter_c iter = positionNode->GetChildIter(); !positionNode->AtEnd(iter); ++iter) {
-        MeaXMLNode* node = *iter;
-
-        if (node->GetType() == MeaXMLNode::Element) {
-            if (node->GetData() == _T("desc")) {
-                SetDesc(ProcessDataNodes(node));
-            } else if (node->GetData() == _T("points")) {
-                for (MeaXMLNode::NodeIter_c pointIter = node->GetChildIter(); !node->AtEnd(pointIter); ++pointIter) {
-                    MeaXMLNode* pointNode = *pointIter;
-                    const MeaXMLAttributes& attrs = pointNode->GetAttributes();
-
-                    if ((pointNode->GetType() == MeaXMLNode::Element) && (pointNode->GetData() == _T("point"))) {
-                        CString name;
-                        FPOINT pt;
-                        attrs.GetValueStr(_T("name"), name, def);
-                        attrs.GetValueDbl(_T("x"), pt.x, def);
-                        attrs.GetValueDbl(_T("y"), pt.y, def);
-                        AddPoint(name, pt);
-                    }
-                }
-            } else if (node->GetData() == _T("properties")) {
-                for (MeaXMLNode::NodeIter_c pointIter = node->GetChildIter(); !node->AtEnd(pointIter); ++pointIter) {
-                    MeaXMLNode* pointNode = *pointIter;
-                    const MeaXMLAttributes& attrs = pointNode->GetAttributes();
-
-                    if (pointNode->GetType() == MeaXMLNode::Element) {
-                        if (pointNode->GetData() == _T("width")) {
-                            attrs.GetValueDbl(_T("value"), m_width, def);
-                            m_fieldMask |= MeaWidthField;
-                        } else if (pointNode->GetData() == _T("height")) {
-                            attrs.GetValueDbl(_T("value"), m_height, def);
-                            m_fieldMask |= MeaHeightField;
-                        } else if (pointNode->GetData() == _T("distance")) {
-                            attrs.GetValueDbl(_T("value"), m_distance, def);
-                            m_fieldMask |= MeaDistanceField;
-                        } else if (pointNode->GetData() == _T("area")) {
-                            attrs.GetValueDbl(_T("value"), m_area, def);
-                            m_fieldMask |= MeaAreaField;
-                        } else if (pointNode->GetData() == _T("angle")) {
-                            attrs.GetValueDbl(_T("value"), m_angle, def);
-                            m_fieldMask |= MeaAngleField;
-                        }
-                    }
-                }
-            }
+    if (elementName == _T("point")) {
+        CString name;
+        FPOINT pt;
+        attrs.GetValueStr(_T("name"), name, def);
+        attrs.GetValueDbl(_T("x"), pt.x, def);
+        attrs.GetValueDbl(_T("y"), pt.y, def);
+        AddPoint(name, pt);
+    } else if (elementName == _T("width")) {
+        attrs.GetValueDbl(_T("value"), m_width, def);
+        m_fieldMask |= MeaWidthField;
+    } else if (elementName == _T("height")) {
+        attrs.GetValueDbl(_T("value"), m_height, def);
+        m_fieldMask |= MeaHeightField;
+    } else if (elementName == _T("distance")) {
+        attrs.GetValueDbl(_T("value"), m_distance, def);
+        m_fieldMask |= MeaDistanceField;
+    } else if (elementName == _T("area")) {
+        attrs.GetValueDbl(_T("value"), m_area, def);
+        m_fieldMask |= MeaAreaField;
+    } else if (elementName == _T("angle")) {
+        attrs.GetValueDbl(_T("value"), m_angle, def);
+        m_fieldMask |= MeaAngleField;
+    }
+}
+
+
+void MeaPositionLogMgr::Position::Load(const MeaBinaryLogReader& reader, const MeaBinaryLogPosition& record)
+{
+    m_fieldMask = record.fieldMask;
+    m_width     = record.width;
+    m_height    = record.height;
+    m_distance  = record.distance;
+    m_area      = record.area;
+    m_angle     = record.angle;
+    m_desc      = reader.GetString(record.descStr);
+
+    for (UINT32 i = 0; i < record.pointCount; i++) {
+        const MeaBinaryLogPoint& point = reader.GetPoint(record.firstPoint + i);
+        FPOINT pt;
+
+        pt.x = point.x;
+        pt.y = point.y;
+        AddPoint(reader.GetString(point.nameStr), pt);
+    }
+}
+
+
+void MeaPositionLogMgr::Position::Load(const MeaTextLogRecord& record)
+{
+    static const UINT pointFields[MeaPositionPoints::kNumPointIds] = {
+        MeaX1Field | MeaY1Field,
+        MeaX2Field | MeaY2Field,
+        MeaXVField | MeaYVField
+    };
+
+    m_fieldMask = record.fieldMask;
+    m_width     = record.width;
+    m_height    = record.height;
+    m_distance  = record.distance;
+    m_area      = record.area;
+    m_angle     = record.angle;
+    m_desc      = record.desc;
+
+    for (int i = 0; i < MeaPositionPoints::kNumPointIds; i++) {
+        if (record.hasPoint[i]) {
+            m_points.SetPoint(static_cast<MeaPositionPoints::PointId>(i), record.points[i]);
+            m_fieldMask |= pointFields[i];
+        }
+    }
+}
+
+
+void MeaPositionLogMgr::Position::Save(MeaBinaryLogWriter& writer) const
+{
+    if (m_mgr == NULL) {
+        return;
+    }
+
+    MeaBinaryLogPosition record;
+
+    memset(&record, 0, sizeof(record));
+
+    int count = m_points.GetCount();
+    for (int i = 0; i < count; i++) {
+        const FPOINT& pt = m_points.GetPointAt(i);
+        writer.AddPoint(m_points.GetNameAt(i), pt.x, pt.y);
+    }
+
+    record.toolStr      = writer.AddString(m_toolName);
+    record.timestampStr = writer.AddString(m_timestamp);
+    record.descStr      = writer.AddString(m_desc);
+    record.fieldMask    = m_fieldMask;
+    record.width        = m_width;
+    record.height       = m_height;
+    record.distance     = m_distance;
+    record.area         = m_area;
+    record.angle        = m_angle;
+
+    writer.AddPosition(m_desktopInfoId, record);
+}
+
+
+void MeaPositionLogMgr::Position::Save(MeaTextLogRecord& record) const
+{
+    record.Clear();
+
+    record.tool         = m_toolName;
+    record.timestamp    = m_timestamp;
+    record.desc         = m_desc;
+    record.fieldMask    = m_fieldMask;
+    record.width        = m_width;
+    record.height       = m_height;
+    record.distance     = m_distance;
+    record.area         = m_area;
+    record.angle        = m_angle;
+
+    for (int i = 0; i < MeaPositionPoints::kNumPointIds; i++) {
+        MeaPositionPoints::PointId id = static_cast<MeaPositionPoints::PointId>(i);
+        if (m_points.HasPoint(id)) {
+            record.points[id] = m_points.GetPoint(id);
+            record.hasPoint[id] = true;
         }
     }
 }
 
 
-void MeaPositionLogMgr::Position::Save(int indent) const
+int MeaPositionLogMgr::Position::Save(MeaPositionBatch& batch) const
+{
+    return batch.Add(m_fieldMask, m_points, m_width, m_height, m_distance, m_area, m_angle);
+}
+
+
+void MeaPositionLogMgr::Position::Save(MeaXMLWriter& writer) const
         throw(CFileException)
 {
     if (m_mgr == NULL) {
         return;
     }
 
-    m_mgr->Write(indent, _T("<position desktopRef=\"%s\" tool=\"%s\" date=\"%s\">\n"),
-                    static_cast<LPCTSTR>(m_desktopInfoId),
-                    static_cast<LPCTSTR>(m_toolName),
-                    static_cast<LPCTSTR>(m_timestamp));
-    indent++;
+    writer.StartElement(_T("position"));
+    writer.Attribute(_T("desktopRef"), m_desktopInfoId.ToString());
+    writer.Attribute(_T("tool"), m_toolName);
+    writer.Attribute(_T("date"), m_timestamp);
         if (!m_desc.IsEmpty()) {
-            m_mgr->Write(indent, _T("<desc>%s</desc>\n"), MeaXMLParser::Encode(MeaUtils::CRLFtoLF(m_desc)));
+            writer.StartElement(_T("desc"));
+            writer.Text(MeaUtils::CRLFtoLF(m_desc));
+            writer.EndElement();
         }
 
-        m_mgr->Write(indent, _T("<points>\n"));
-        indent++;
-            PointMap::const_iterator iter;
+        writer.StartElement(_T("points"));
+            int count = m_points.GetCount();
+
+            for (int i = 0; i < count; i++) {
+                const FPOINT& pt = m_points.GetPointAt(i);
 
-            for (iter = m_points.begin(); iter != m_points.end(); ++iter) {
-                m_mgr->Write(indent, _T("<point name=\"%s\" x=\"%s\" y=\"%s\"/>\n"),
-                    static_cast<LPCTSTR>((*iter).first),
-                    static_cast<LPCTSTR>(MeaUtils::DblToStr((*iter).second.x)),
-                    static_cast<LPCTSTR>(MeaUtils::DblToStr((*iter).second.y)));
+                writer.StartElement(_T("point"));
+                writer.Attribute(_T("name"), m_points.GetNameAt(i));
+                writer.Attribute(_T("x"), pt.x);
+                writer.Attribute(_T("y"), pt.y);
+                writer.EndElement();
             }
-        indent--;
-        m_mgr->Write(indent, _T("</points>\n"));
+        writer.EndElement();
 
-        m_mgr->Write(indent, _T("<properties>\n"));
-        indent++;
+        writer.StartElement(_T("properties"));
             if (m_fieldMask & MeaWidthField) {
-                m_mgr->Write(indent, _T("<width value=\"%s\"/>\n"),
-                    static_cast<LPCTSTR>(MeaUtils::DblToStr(m_width)));
+                writer.StartElement(_T("width"));
+                writer.Attribute(_T("value"), m_width);
+                writer.EndElement();
             }
             if (m_fieldMask & MeaHeightField) {
-                m_mgr->Write(indent, _T("<height value=\"%s\"/>\n"),
-                    static_cast<LPCTSTR>(MeaUtils::DblToStr(m_height)));
+                writer.StartElement(_T("height"));
+                writer.Attribute(_T("value"), m_height);
+                writer.EndElement();
             }
             if (m_fieldMask & MeaDistanceField) {
-                m_mgr->Write(indent, _T("<distance value=\"%s\"/>\n"),
-                    static_cast<LPCTSTR>(MeaUtils::DblToStr(m_distance)));
+                writer.StartElement(_T("distance"));
+                writer.Attribute(_T("value"), m_distance);
+                writer.EndElement();
             }
             if (m_fieldMask & MeaAreaField) {
-                m_mgr->Write(indent, _T("<area value=\"%s\"/>\n"),
-                    static_cast<LPCTSTR>(MeaUtils::DblToStr(m_area)));
+                writer.StartElement(_T("area"));
+                writer.Attribute(_T("value"), m_area);
+                writer.EndElement();
             }
             if (m_fieldMask & MeaAngleField) {
-                m_mgr->Write(indent, _T("<angle value=\"%s\"/>\n"),
-                    static_cast<LPCTSTR>(MeaUtils::DblToStr(m_angle)));
+                writer.StartElement(_T("angle"));
+                writer.Attribute(_T("value"), m_angle);
+                writer.EndElement();
             }
-        indent--;
-        m_mgr->Write(indent, _T("</properties>\n"));
-
-    indent--;
-    m_mgr->Write(indent, _T("</position>\n"));
+        writer.EndElement();
+    writer.EndElement();
 }
 
 
 //*************************************************************************
-// Positions
+// LogLoader
 //*************************************************************************
 
 
-MeaPositionLogMgr::Positions::Positions()
+MeaPositionLogMgr::LogLoader::LogLoader(const CString& pathname) : MeaXMLParserHandler(),
+    m_pathname(pathname),
+    m_loaded(false),
+    m_loadDesktop(NULL),
+    m_loadPosition(NULL)
 {
 }
 
 
-MeaPositionLogMgr::Positions::~Positions()
+MeaPositionLogMgr::LogLoader::~LogLoader()
 {
     try {
-        DeleteAll();
+        Clear();
     }
     catch(...) {
         MeaAssert(false);
@@ -1342,81 +2515,286 @@ MeaPositionLogMgr::Positions::~Positions()
 }
 
 
-void MeaPositionLogMgr::Positions::Add(Position* position)
+bool MeaPositionLogMgr::LogLoader::Load()
 {
-    int posIndex = Size();
-    m_posMap[posIndex] = position;
+    m_loaded = MeaBinaryLogReader::IsBinaryLog(m_pathname) ? LoadBinary() : LoadXML();
+
+    if (!m_loaded) {
+        Clear();
+    }
+
+    return m_loaded;
 }
 
 
-void MeaPositionLogMgr::Positions::Set(int posIndex, Position* position)
-    throw(std::out_of_range)
+bool MeaPositionLogMgr::LogLoader::LoadXML()
 {
-    PositionMap::iterator iter = m_posMap.find(posIndex);
-    if (iter == m_posMap.end()) {
-        throw new std::out_of_range("Positions::Set posIndex out of range");
+    CFile file;
+    CFileException fe;
+
+    if (!file.Open(m_pathname, CFile::modeRead, &fe)) {
+        TCHAR errStr[256];
+        CString msg;
+        fe.GetErrorMessage(errStr, 256);
+        msg.Format(IDS_MEA_NO_LOAD_LOG, errStr);
+        AddError(msg);
+        return false;
     }
 
-    delete (*iter).second;
-    (*iter).second = position;
+    //
+    // Parse the contents of the log file. The positions are
+    // loaded by the element handlers as the file is parsed.
+    //
+    MeaXMLParser parser(this);
+    bool status = false;
+
+    try {
+        UINT numBytes;
+
+        do {
+            void *buf = parser.GetBuffer(kChunkSize);
+            numBytes = file.Read(buf, kChunkSize);
+            parser.ParseBuffer(numBytes, numBytes == 0);
+        } while (numBytes > 0);
+
+        status = true;
+    } catch (MeaXMLParserException&) {
+        // Reported by the parser.
+    } catch (MeaLogFileException&) {
+        AddError(CString(reinterpret_cast<LPCSTR>(IDS_MEA_INVALID_LOGFILE)));
+    } catch (...) {
+        AddError(CString(reinterpret_cast<LPCSTR>(IDS_MEA_NO_POSITIONS)));
+    }
+
+    file.Close();
+
+    return status;
 }
 
 
-MeaPositionLogMgr::Position& MeaPositionLogMgr::Positions::Get(int posIndex)
-    throw(std::out_of_range)
+bool MeaPositionLogMgr::LogLoader::LoadBinary()
 {
-    PositionMap::const_iterator iter = m_posMap.find(posIndex);
-    if (iter == m_posMap.end()) {
-        throw new std::out_of_range("Positions::Get posIndex out of range");
+    MeaBinaryLogReader reader;
+
+    try {
+        reader.Open(m_pathname);
+    } catch (CFileException* ex) {
+        TCHAR errStr[256];
+        CString msg;
+        ex->GetErrorMessage(errStr, 256);
+        ex->Delete();
+        msg.Format(IDS_MEA_NO_LOAD_LOG, errStr);
+        AddError(msg);
+        return false;
+    } catch (MeaLogFileException&) {
+        AddError(CString(reinterpret_cast<LPCSTR>(IDS_MEA_INVALID_LOGFILE)));
+        return false;
+    }
+
+    const MeaBinaryLogHeader& header = reader.GetHeader();
+    UINT32 i;
+
+    try {
+        m_title = reader.GetString(header.titleStr);
+        m_desc = reader.GetString(header.descStr);
+
+        m_desktops.reserve(header.desktopCount);
+        for (i = 0; i < header.desktopCount; i++) {
+            const MeaBinaryLogDesktop& record = reader.GetDesktop(i);
+            m_desktops.push_back(DesktopInfo(MeaGUID(record.id)));
+            m_desktops.back().Load(reader, record);
+        }
+
+        m_positions.reserve(header.positionCount);
+        for (i = 0; i < header.positionCount; i++) {
+            const MeaBinaryLogPosition& record = reader.GetPosition(i);
+            Position* position = new Position(NULL, m_desktops[record.desktop].GetId(),
+                                              reader.GetString(record.toolStr),
+                                              reader.GetString(record.timestampStr));
+            m_positions.push_back(position);
+            position->Load(reader, record);
+        }
+    } catch (MeaLogFileException&) {
+        AddError(CString(reinterpret_cast<LPCSTR>(IDS_MEA_INVALID_LOGFILE)));
+        return false;
     }
 
-    return *(*iter).second;
+    return true;
 }
 
 
-void MeaPositionLogMgr::Positions::Delete(int posIndex) throw(std::out_of_range)
+void MeaPositionLogMgr::LogLoader::ParseEntity(MeaXMLParser& parser,
+                                               const CString& pathname)
 {
-    // Find the position entry corresponding to the specified
-    // position index.
-    //
-    PositionMap::iterator iter = m_posMap.find(posIndex);
-    if (iter == m_posMap.end()) {
-        throw new std::out_of_range("Positions::Delete posIndex out of range");
+    CFile entityFile;
+    CFileException fe;
+
+    if (!entityFile.Open(pathname, CFile::modeRead, &fe)) {
+        AfxThrowFileException(fe.m_cause, fe.m_lOsError, pathname);
     }
 
-    // Delete the position object associated with the index.
+    MeaXMLParser entityParser(parser);
+
+    // Read the contents of the entity file into a parsing buffer.
     //
-    delete (*iter).second;
+    int size = static_cast<int>(entityFile.GetLength());
+    void *buf = entityParser.GetBuffer(size);
+    UINT count = entityFile.Read(buf, size);
 
-    // Move each position object "down" one index.
+    // Parse the entity file
     //
-    for (iter++; iter != m_posMap.end(); ++iter, posIndex++) {
-        m_posMap[posIndex] = (*iter).second;
+    entityParser.ParseBuffer(count, true);
+
+    entityFile.Close();
+}
+
+
+void MeaPositionLogMgr::LogLoader::StartElementHandler(const MeaXMLStringView& container,
+                                                       const MeaXMLStringView& elementName,
+                                                       const MeaXMLAttributes& attrs)
+{
+    if (m_loadPosition != NULL) {
+        if (elementName == _T("desc")) {
+            m_loadData.Empty();
+        } else {
+            m_loadPosition->Load(elementName, attrs);
+        }
+    } else if (m_loadDesktop != NULL) {
+        if (elementName == _T("displayPrecision")) {
+            m_loadPrecisions.clear();
+        } else if (elementName == _T("measurement")) {
+            CString name;
+            int places;
+            bool def;
+
+            attrs.GetValueStr(_T("name"), name, def);
+            attrs.GetValueInt(_T("decimalPlaces"), places, def);
+
+            m_loadPrecisions[name] = places;
+        } else {
+            m_loadDesktop->Load(elementName, attrs);
+        }
+    } else if (elementName == _T("desktop")) {
+        StartDesktop(attrs);
+    } else if (elementName == _T("position")) {
+        StartPosition(attrs);
+    } else if (container == _T("info")) {
+        m_loadData.Empty();
     }
+}
 
-    // Delete the last entry in the map since it has been
-    // moved "down" one index.
-    //
-    m_posMap.erase(m_posMap.size() - 1);
+
+void MeaPositionLogMgr::LogLoader::EndElementHandler(const MeaXMLStringView& container,
+                                                     const MeaXMLStringView& elementName)
+{
+    if (m_loadPosition != NULL) {
+        if (elementName == _T("desc")) {
+            m_loadPosition->SetDesc(MeaUtils::LFtoCRLF(m_loadData));
+        } else if (elementName == _T("position")) {
+            m_positions.push_back(m_loadPosition);
+            m_loadPosition = NULL;
+        }
+    } else if (m_loadDesktop != NULL) {
+        if (elementName == _T("displayPrecision")) {
+            m_loadDesktop->LoadCustomPrecisions(m_loadPrecisions);
+        } else if (elementName == _T("desktop")) {
+            m_desktops.push_back(*m_loadDesktop);
+
+            delete m_loadDesktop;
+            m_loadDesktop = NULL;
+        }
+    } else if (container == _T("info")) {
+        if (elementName == _T("title")) {
+            m_title = MeaUtils::LFtoCRLF(m_loadData);
+        } else if (elementName == _T("desc")) {
+            m_desc = MeaUtils::LFtoCRLF(m_loadData);
+        }
+    }
+}
+
+
+void MeaPositionLogMgr::LogLoader::CharacterDataHandler(const MeaXMLStringView& container,
+                                                        const MeaXMLStringView& data)
+{
+    if ((container == _T("title")) || (container == _T("desc"))) {
+        m_loadData += data.ToString();
+    }
+}
+
+
+void MeaPositionLogMgr::LogLoader::ReportError(const CString& title, const CString& msg)
+{
+    Error error;
+    error.title = title;
+    error.msg = msg;
+    m_errors.push_back(error);
 }
 
 
-void MeaPositionLogMgr::Positions::DeleteAll()
+void MeaPositionLogMgr::LogLoader::StartDesktop(const MeaXMLAttributes& attrs)
 {
-    PositionMap::const_iterator iter;
+    CString valueStr;
+    bool def;
 
-    for (iter = m_posMap.begin(); iter != m_posMap.end(); ++iter) {
-        delete (*iter).second;
+    attrs.GetValueStr(_T("id"), valueStr, def);
+
+    try {
+        m_loadDesktop = new DesktopInfo(MeaGUID(valueStr));
+    }
+    catch (COleException* ex) {
+        ex->Delete();
+
+        CString msg;
+        msg.Format(IDS_MEA_INVALID_DESKTOPID, static_cast<LPCTSTR>(valueStr));
+        AddError(msg);
     }
-    m_posMap.clear();
 }
 
 
-void MeaPositionLogMgr::Positions::Save(int indent) const throw(CFileException)
+void MeaPositionLogMgr::LogLoader::StartPosition(const MeaXMLAttributes& attrs)
 {
-    PositionMap::const_iterator iter;
-    for (iter = m_posMap.begin(); iter != m_posMap.end(); ++iter) {
-        (*iter).second->Save(indent);
+    CString idStr;
+    CString toolStr;
+    CString dateStr;
+    bool def;
+
+    attrs.GetValueStr(_T("desktopRef"), idStr, def);
+    attrs.GetValueStr(_T("tool"), toolStr, def);
+    attrs.GetValueStr(_T("date"), dateStr, def);
+
+    try {
+        m_loadPosition = new Position(NULL, idStr, toolStr, dateStr);
+    }
+    catch (COleException* ex) {
+        ex->Delete();
+
+        CString msg;
+        msg.Format(IDS_MEA_INVALID_DESKTOPREF, static_cast<LPCTSTR>(idStr));
+        AddError(msg);
     }
 }
 
+
+void MeaPositionLogMgr::LogLoader::AddError(const CString& msg)
+{
+    ReportError(CString(), msg);
+}
+
+
+void MeaPositionLogMgr::LogLoader::Clear()
+{
+    delete m_loadDesktop;
+    m_loadDesktop = NULL;
+
+    delete m_loadPosition;
+    m_loadPosition = NULL;
+
+    for (PositionList::iterator iter = m_positions.begin(); iter != m_positions.end(); ++iter) {
+        delete *iter;
+    }
+    m_positions.clear();
+    m_desktops.clear();
+
+    m_loadPrecisions.clear();
+    m_loadData.Empty();
+}
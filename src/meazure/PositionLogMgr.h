@@ -25,12 +25,22 @@
 #include <list>
 #include <map>
 #include <stdexcept>
+#include <unordered_map>
+#include <vector>
 #include "Units.h"
 #include "Utils.h"
 #include "XMLParser.h"
+#include "XMLWriter.h"
 #include "GUID.h"
 #include "Singleton.h"
 #include "ScreenMgr.h"
+#include "LogFileException.h"
+#include "PositionLogBinary.h"
+#include "PositionLogText.h"
+#include "PositionIndex.h"
+#include "PositionStore.h"
+#include "PositionPoints.h"
+#include "PositionBatch.h"
 
 
 class MeaPositionSaveDlg;
@@ -38,26 +48,12 @@ class MeaPositionLogDlg;
 class MeaPositionLogObserver;
 
 
-/// Exception thrown if a problem occurs while reading or writing
-/// the position log file.
-///
-class MeaLogFileException
-{
-public:
-    /// Constructor for the exception.
-    ///
-    MeaLogFileException() { }
-    
-    /// Destroys the exception.
-    ///
-    virtual ~MeaLogFileException() { }
-};
-
-
 /// Manages the recording, saving and loading of tool positions. The
-/// positions are saved to an XML format file.
+/// positions are saved to an XML format file or, if the file has the
+/// binary log extension, to a memory mappable binary format file (see
+/// PositionLogBinary.h).
 ///
-class MeaPositionLogMgr : public MeaXMLParserHandler, public MeaSingleton_T<MeaPositionLogMgr>
+class MeaPositionLogMgr : public MeaSingleton_T<MeaPositionLogMgr>
 {
 public:
     /// Represents a single monitor attached to the system.
@@ -97,18 +93,42 @@ public:
         ~Screen() { }
 
 
-        /// Loads screen elements of the log file.
+        /// Returns the screen rectangle.
+        /// @return Screen rectangle, in the units in effect when the screen object was created.
+        const FRECT& GetRect() const { return m_rect; }
+
+        /// Returns the screen resolution.
+        /// @return Screen resolution, in the units in effect when the screen object was created.
+        const FSIZE& GetRes() const { return m_res; }
+
+
+        /// Loads a screen element of the log file, or one of its rect
+        /// or resolution child elements, as it is encountered by the
+        /// parser.
+        ///
+        /// @param elementName  [in] Name of the element.
+        /// @param attrs        [in] Attributes of the element.
+        ///
+        void Load(const MeaXMLStringView& elementName, const MeaXMLAttributes& attrs);
+
+        /// Loads the screen from a binary log file record.
+        ///
+        /// @param reader       [in] Binary log file reader.
+        /// @param record       [in] Screen record.
+        ///
+        void Load(const MeaBinaryLogReader& reader, const MeaBinaryLogScreen& record);
+
+        /// Adds the screen to a binary log file.
         ///
-        /// @param screenNode   [in] screen node in the DOM.
+        /// @param writer       [in] Binary log file writer.
         ///
-        void Load(const MeaXMLNode* screenNode);
+        void Save(MeaBinaryLogWriter& writer) const;
         
         /// Saves the screen information
         ///
-        /// @param mgr      [in] Parent manager.
-        /// @param indent   [in] Output indentation level.
+        /// @param writer   [in] Position log file writer.
         ///
-        void Save(MeaPositionLogMgr& mgr, int indent) const
+        void Save(MeaXMLWriter& writer) const
              throw(CFileException);
 
 
@@ -140,6 +160,14 @@ public:
         ///
         bool operator!=(const Screen& screen) const { return !IsEqual(screen); }
 
+        /// Computes a hash of the screen object. Only the fields that
+        /// IsEqual compares exactly contribute to the hash, so screens
+        /// that compare equal always hash the same.
+        ///
+        /// @return Hash value for the screen.
+        ///
+        size_t GetHash() const;
+
     private:
         /// Makes a deep copy of the specified screen object.
         ///
@@ -196,15 +224,20 @@ public:
     class DesktopInfo
     {
     public:
-        /// Constructs a desktop information object.
+        /// Constructs a desktop information object describing the
+        /// current desktop, units and screens.
         ///
         DesktopInfo();
         
-        /// Constructs a desktop information object with the specified unique ID.
+        /// Constructs an empty desktop information object with the
+        /// specified unique ID, to be filled in from a log file. Unlike
+        /// the default constructor, the current desktop is not recorded,
+        /// so this constructor may be used by the log loader threads. The
+        /// units default to the MeaUnitsMgr defaults until they are loaded.
         ///
-        /// @param guidStr      [in] GUID ID for the desktop information object.
+        /// @param id           [in] GUID ID for the desktop information object.
         ///
-        explicit DesktopInfo(LPCTSTR guidStr);
+        explicit DesktopInfo(const MeaGUID& id);
 
         /// Constructs a desktop information object as a copy of the specified object.
         ///
@@ -260,6 +293,10 @@ public:
         /// @param guidStr      [in] GUID ID to set for this object.
         void            SetId(LPCTSTR guidStr) { m_id = guidStr; }
 
+        /// Sets a unique ID for this object.
+        /// @param id           [in] GUID ID to set for this object.
+        void            SetId(const MeaGUID& id) { m_id = id; }
+
 
         /// Returns the name for custom units.
         /// @return Name for custom units.
@@ -282,18 +319,56 @@ public:
         MeaUnits::DisplayPrecisions GetCustomPrecisions() const { return m_customPrecisions; }
 
 
-        /// Loads desktop elements of the log file.
+        /// Returns the factors to convert the positions that reference this
+        /// desktop information object from the linear units in which they
+        /// were recorded to the specified linear units, one set of factors
+        /// per screen. The origin and y-axis orientation of the positions
+        /// are unchanged by the conversion.
+        ///
+        /// @param units    [in] Linear units to convert to.
+        /// @param scales   [out] Conversion factors for each screen.
+        ///
+        void GetUnitsScales(const MeaLinearUnits& units, MeaPositionBatch::ScaleList& scales) const;
+
+        /// Returns the factor to convert the angles of the positions that
+        /// reference this desktop information object from the angular
+        /// units in which they were recorded to the specified angular units.
+        ///
+        /// @param units    [in] Angular units to convert to.
+        ///
+        /// @return Angle conversion factor.
+        ///
+        double GetAngleFactor(const MeaAngularUnits& units) const;
+
+
+        /// Loads a child element of a desktop element of the log file
+        /// as it is encountered by the parser.
+        ///
+        /// @param elementName  [in] Name of the element.
+        /// @param attrs        [in] Attributes of the element.
+        ///
+        void Load(const MeaXMLStringView& elementName, const MeaXMLAttributes& attrs);
+
+        /// Loads the desktop information from a binary log file record.
+        ///
+        /// @param reader       [in] Binary log file reader.
+        /// @param record       [in] Desktop record.
         ///
-        /// @param desktopNode      [in] Desktop node in the DOM.
+        /// @throw MeaLogFileException if the record names unknown units.
         ///
-        void Load(const MeaXMLNode* desktopNode);
+        void Load(const MeaBinaryLogReader& reader, const MeaBinaryLogDesktop& record);
+
+        /// Adds the desktop information and its screens to a binary log file.
+        ///
+        /// @param writer       [in] Binary log file writer.
+        ///
+        void Save(MeaBinaryLogWriter& writer) const;
 
         /// Saves the desktop information
         ///
-        /// @param mgr          [in] Parent manager.
-        /// @param indent       [in] Output indentation level.
+        /// @param writer       [in] Position log file writer.
         ///
-        void Save(MeaPositionLogMgr& mgr, int indent) const
+        void Save(MeaXMLWriter& writer) const
              throw(CFileException);
 
 
@@ -313,6 +388,16 @@ public:
         ///
         bool operator!=(const DesktopInfo& di) const { return !IsEqual(di); }
 
+        /// Computes a fingerprint of the desktop information for use
+        /// as a hash index key. As with IsEqual, the object's unique ID
+        /// does not contribute. Floating point fields, which IsEqual
+        /// compares within a tolerance, are also excluded so that
+        /// objects that compare equal always have the same fingerprint.
+        ///
+        /// @return Hash value for the desktop information.
+        ///
+        size_t GetHash() const;
+
     private:
         typedef std::list<Screen> ScreenList;       ///< List of all display screens attached to the system.
 
@@ -342,11 +427,29 @@ public:
             return *this;
         }
 
-        /// Centralized initialization method for the class. All
-        /// non-copy constructors call this method.
+        /// Initializes the object from the current desktop, units and
+        /// screens. Called by the default constructor on the UI thread.
         ///
         void Init();
 
+        /// Returns the X and Y factors to convert from pixels to the linear
+        /// units of this desktop information object. For custom units, the
+        /// custom units definition recorded with the desktop is used.
+        ///
+        /// @param res      [in] Screen resolution, in pixels/inch.
+        ///
+        /// @return X and Y conversion factors, in units/pixels.
+        ///
+        FSIZE FromPixels(const FSIZE& res) const;
+
+        /// Indicates whether the conversion from pixels to the linear units
+        /// of this desktop information object depends on the screen
+        /// resolution.
+        ///
+        /// @return <b>true</b> if the units require a screen resolution.
+        ///
+        bool RequiresRes() const;
+
         /// Determines whether the specified desktop information object
         /// is equal to this object.
         ///
@@ -387,16 +490,17 @@ public:
 
         /// Loads the display precisions values for the custom units.
         ///
-        /// @param displayPrecisionNode     [in] displayPrecisions element in the DOM.
+        /// @param precMap      [in] Decimal places read from the
+        ///                     displayPrecision element, keyed by
+        ///                     measurement name.
         ///
-        void LoadCustomPrecisions(const MeaXMLNode* displayPrecisionNode);
+        void LoadCustomPrecisions(const std::map<CString, int>& precMap);
 
         /// Saves the display precisions for custom units
         ///
-        /// @param mgr      [in] Parent manager.
-        /// @param indent   [in] Output indentation level.
+        /// @param writer   [in] Position log file writer.
         ///
-        void SaveCustomPrecisions(MeaPositionLogMgr& mgr, int indent) const
+        void SaveCustomPrecisions(MeaXMLWriter& writer) const
              throw(CFileException);
 
 
@@ -426,7 +530,9 @@ public:
     /// for a position depends on the measurement tool whose position is being recorded.
     /// For example, the Point tool requires only one point to completely describe its
     /// position, whereas the Line tool requires two points, one per endpoint of the line.
-    /// Each point is named by the tool (e.g. "v", "1", "2").
+    /// Each point is named by the tool (e.g. "v", "1", "2"). The points are held in
+    /// fixed slots within the position (see MeaPositionPoints) so that recording a
+    /// position does not allocate memory for its points.
     ///
     class Position
     {
@@ -457,6 +563,18 @@ public:
         /// @param timestamp        [in] Identifies when this position was recorded.
         ///
         Position(MeaPositionLogMgr* mgr, const CString& desktopInfoIdStr, const CString& toolName, const CString& timestamp);
+
+        /// Constructs a position object that represents the position of the specified tool at
+        /// the specified time.
+        ///
+        /// @param mgr              [in] Parent manager.
+        /// @param desktopInfoId    [in] GUID representing the desktop information object
+        ///                         referenced by this position.
+        /// @param toolName         [in] Name of the measurement tool whose position is represented
+        ///                         by this position object.
+        /// @param timestamp        [in] Identifies when this position was recorded.
+        ///
+        Position(MeaPositionLogMgr* mgr, const MeaGUID& desktopInfoId, const CString& toolName, const CString& timestamp);
         
         /// Copy constructor.
         ///
@@ -499,6 +617,30 @@ public:
         ///
         CString GetTimeStamp() const { return m_timestamp; }
 
+        /// Returns the name of the tool whose position is represented
+        /// by this object.
+        ///
+        /// @return Name of the measurement tool.
+        ///
+        CString GetToolName() const { return m_toolName; }
+
+        /// Returns the ID of the desktop information object referenced
+        /// by this position.
+        ///
+        /// @return Desktop information object ID.
+        ///
+        const MeaGUID& GetDesktopInfoId() const { return m_desktopInfoId; }
+
+        /// Makes the position reference the specified desktop information
+        /// object of the specified manager. Used to adopt a position that
+        /// was loaded without a manager.
+        ///
+        /// @param mgr              [in] Parent manager.
+        /// @param desktopInfoId    [in] GUID representing the desktop information
+        ///                         object to be referenced by this position.
+        ///
+        void SetDesktopInfoId(MeaPositionLogMgr* mgr, const MeaGUID& desktopInfoId);
+
 
         /// Adds the specified point to the position using the specified name
         /// to identify the point.
@@ -506,7 +648,13 @@ public:
         /// @param name     [in] Name to assign the point.
         /// @param pt       [in] Point to be stored in the position.
         ///
-        void AddPoint(LPCTSTR name, const FPOINT& pt) { m_points[name] = pt; }
+        void AddPoint(LPCTSTR name, const FPOINT& pt) { m_points.SetPoint(name, pt); }
+
+        /// Returns the points of the position.
+        ///
+        /// @return Points of the position, identified by name.
+        ///
+        const MeaPositionPoints& GetPointSet() const { return m_points; }
 
 
         /// Records the specified point as an x1, y1 point.
@@ -563,23 +711,60 @@ public:
         ///
         void Show() const;
 
-        /// Loads the position elements of the log file.
+        /// Loads a point or property element of a position in the log
+        /// file as it is encountered by the parser.
+        ///
+        /// @param elementName  [in] Name of the element.
+        /// @param attrs        [in] Attributes of the element.
+        ///
+        void Load(const MeaXMLStringView& elementName, const MeaXMLAttributes& attrs);
+
+        /// Loads the points and properties of the position from a binary
+        /// log file record.
+        ///
+        /// @param reader       [in] Binary log file reader.
+        /// @param record       [in] Position record.
+        ///
+        void Load(const MeaBinaryLogReader& reader, const MeaBinaryLogPosition& record);
+
+        /// Loads the points and properties of the position from a CSV or
+        /// JSON Lines record.
+        ///
+        /// @param record       [in] Text log record.
+        ///
+        void Load(const MeaTextLogRecord& record);
+
+        /// Adds the position and its points to a binary log file.
+        ///
+        /// @param writer       [in] Binary log file writer.
+        ///
+        void Save(MeaBinaryLogWriter& writer) const;
+
+        /// Fills in the tool, timestamp, description, points and properties
+        /// of a CSV or JSON Lines record from the position. The units are
+        /// not set.
+        ///
+        /// @param record       [out] Text log record.
+        ///
+        void Save(MeaTextLogRecord& record) const;
+
+        /// Adds the points and properties of the position to a batch of
+        /// positions to be converted to other units.
+        ///
+        /// @param batch        [in] Position batch.
         ///
-        /// @param positionNode     [in] Position node in the DOM.
+        /// @return Index of the position in the batch.
         ///
-        void Load(const MeaXMLNode* positionNode);
+        int Save(MeaPositionBatch& batch) const;
 
         /// Saves the position in the position log file.
         ///
-        /// @param indent       [in] Output indentation level.
+        /// @param writer       [in] Position log file writer.
         ///
-        void Save(int indent) const
+        void Save(MeaXMLWriter& writer) const
              throw(CFileException);
 
     private:
-        typedef std::map<CString, FPOINT> PointMap;     ///< Maps a point name to the coordinates of the point.
-
-
         /// Copies the specified position to this object.
         ///
         /// @param position     [in] Position to be copied.
@@ -590,7 +775,7 @@ public:
 
 
         UINT        m_fieldMask;    ///< Data fields defined for this position. Different tools provide different amounts of data.
-        PointMap    m_points;       ///< Location of the current tool, , in the units in effect when the position was recorded.
+        MeaPositionPoints m_points; ///< Location of the current tool, in the units in effect when the position was recorded.
         double      m_width;        ///< Width of rectangle or bounding box, in the units in effect when the position was recorded.
         double      m_height;       ///< Height of rectangle or bounding box, in the units in effect when the position was recorded.
         double      m_distance;     ///< Length of line or diagonal, in the units in effect when the position was recorded.
@@ -608,6 +793,26 @@ public:
     /// Records the position of the current radio tool.
     ///
     void RecordPosition();
+
+    /// Map of tool crosshair names to pixel locations. This is the same
+    /// type as MeaRadioTool::PointMap, which cannot be referenced here
+    /// because the radio tool header includes this header.
+    ///
+    typedef std::map<CString, POINT> ToolPointMap;
+
+    /// Records a batch of positions of the current radio tool. Each point
+    /// map gives the locations of the tool's crosshairs for one position,
+    /// as would be passed to the tool's SetPosition method. The tool is
+    /// not moved and is not strobed. All of the positions share a single
+    /// snapshot of the desktop and a single timestamp, and the observer
+    /// is notified once for the entire batch. This method is intended for
+    /// recording positions at a high rate, such as from a script or a
+    /// sampling timer.
+    ///
+    /// @param points       [in] Array of point maps, one per position.
+    /// @param count        [in] Number of point maps in the array.
+    ///
+    void RecordPositions(const ToolPointMap* points, int count);
     
     /// Replaces the specified position list entry with the
     /// current radio tool position.
@@ -653,6 +858,36 @@ public:
     ///
     Position& GetPosition(int posIndex) { return m_positions.Get(posIndex); }
 
+    /// Sets the description of the position at the specified index.
+    /// If the position is being saved in the background, a copy of the
+    /// position is changed so that the save is not disturbed. The change
+    /// is journaled as a replacement of the position.
+    ///
+    /// @param posIndex     [in] Zero based index of the position.
+    /// @param desc         [in] Descriptive text for the position.
+    ///
+    void SetPositionDesc(int posIndex, const CString& desc);
+
+    /// Converts the points, widths, heights, distances, areas and angles of
+    /// all positions that reference the specified desktop information
+    /// object from the units in which they were recorded to the specified
+    /// units. The positions themselves are not changed; the converted
+    /// values are placed in a position batch. The conversion of all the
+    /// positions is performed in a single pass over the batch (see
+    /// MeaPositionBatch).
+    ///
+    /// @param desktopInfoId    [in] ID of the desktop information object.
+    /// @param linearUnits      [in] Linear units to convert to.
+    /// @param angularUnits     [in] Angular units to convert to.
+    /// @param batch            [out] Converted values of the positions. The
+    ///                         batch is cleared first.
+    /// @param posIndices       [out] Index of the position corresponding to
+    ///                         each position in the batch.
+    ///
+    void ConvertPositions(const MeaGUID& desktopInfoId, const MeaLinearUnits& linearUnits,
+                          const MeaAngularUnits& angularUnits, MeaPositionBatch& batch,
+                          std::vector<int>& posIndices);
+
     /// Works with the tool manager to set the radio tool and
     /// its position based on the specified position in the list.
     ///
@@ -661,6 +896,38 @@ public:
     void ShowPosition(unsigned int posIndex);
 
 
+    /// Finds the positions recorded by the specified tool.
+    ///
+    /// @param toolName     [in] Name of the measurement tool (e.g. "LineTool").
+    /// @param result       [out] Zero based indices of the matching
+    ///                     positions, in ascending order.
+    ///
+    void FindPositionsByTool(LPCTSTR toolName, MeaPositionIndex::IndexList& result) const {
+        m_positions.GetIndex().FindTool(toolName, result);
+    }
+
+    /// Finds the positions recorded within the specified range of times.
+    ///
+    /// @param start        [in] Earliest recording time, inclusive.
+    /// @param end          [in] Latest recording time, inclusive.
+    /// @param result       [out] Zero based indices of the matching
+    ///                     positions, in ascending order.
+    ///
+    void FindPositionsByTime(time_t start, time_t end, MeaPositionIndex::IndexList& result) const;
+
+    /// Finds the positions having at least one point within the specified
+    /// rectangle. Points are compared in the units in effect when each
+    /// position was recorded.
+    ///
+    /// @param rect         [in] Rectangle to search, edges inclusive.
+    /// @param result       [out] Zero based indices of the matching
+    ///                     positions, in ascending order.
+    ///
+    void FindPositionsInRect(const FRECT& rect, MeaPositionIndex::IndexList& result) const {
+        m_positions.GetIndex().FindInRect(rect, result);
+    }
+
+
     /// Loads the specified position log file.
     ///
     /// @param pathname     [in] Pathname of file to load or NULL if a file dialog should be shown.
@@ -669,6 +936,56 @@ public:
     ///
     bool Load(LPCTSTR pathname = NULL);
 
+    typedef std::vector<CString> PathnameList;      ///< Pathnames of position log files.
+
+    /// Asks the user for one or more position log files and merges
+    /// them into the recorded positions.
+    ///
+    /// @return <b>true</b> if any positions were merged, false if canceled
+    ///         or unable to merge.
+    ///
+    bool Merge();
+
+    /// Loads the specified position log files and adds their positions
+    /// to the recorded positions. The files are parsed concurrently by a
+    /// pool of worker threads, each using its own XML parser, and the
+    /// results are merged in the order the files are specified. A desktop
+    /// identical to one already present is shared rather than duplicated,
+    /// and a desktop whose ID is already used by a different desktop is
+    /// given a new ID. A file that cannot be loaded is reported and skipped
+    /// without affecting the others.
+    ///
+    /// @param pathnames    [in] Pathnames of the position log files to merge.
+    ///
+    /// @return <b>true</b> if any positions were merged.
+    ///
+    bool Merge(const PathnameList& pathnames);
+
+    /// Writes the recorded positions to a CSV or JSON Lines file, one
+    /// line per position, for use by analysis tools. The format is
+    /// chosen by the file extension. The positions are written directly
+    /// from the collection, so the memory used does not depend on the
+    /// number of positions.
+    ///
+    /// @param pathname     [in] Pathname of file to write or NULL if a file dialog should be shown.
+    ///
+    /// @return <b>true</b> if exported, false if canceled or unable to export.
+    ///
+    bool Export(LPCTSTR pathname = NULL);
+
+    /// Reads positions from a CSV or JSON Lines file and adds them to the
+    /// recorded positions. The format is chosen by the file extension.
+    /// The file is read one line at a time. Each distinct combination of
+    /// units in the file is given a desktop based on the current desktop.
+    /// If an invalid line is found, it is reported and the positions before
+    /// it are kept.
+    ///
+    /// @param pathname     [in] Pathname of file to read or NULL if a file dialog should be shown.
+    ///
+    /// @return <b>true</b> if any positions were imported.
+    ///
+    bool Import(LPCTSTR pathname = NULL);
+
     /// Saves the recorded positions to a log file.
     ///
     /// @param askPathname  [in] <b>true</b> means ask user to supply a pathname even if there is already a pathname.
@@ -677,6 +994,36 @@ public:
     ///
     bool Save(bool askPathname);
 
+    /// Saves the recorded positions to a log file on a worker thread.
+    /// A snapshot of the positions is taken and the method returns
+    /// immediately so that positions can continue to be recorded while
+    /// the file is written. The observer is informed through LogSaved
+    /// or LogSaveFailed when the save completes.
+    ///
+    /// @param askPathname  [in] <b>true</b> means ask user to supply a pathname even if there is already a pathname.
+    ///
+    /// @return <b>true</b> if the save was started, false if canceled.
+    ///
+    bool SaveInBackground(bool askPathname);
+
+    /// Indicates whether a background save is in progress.
+    ///
+    /// @return <b>true</b> if a background save has not yet completed.
+    ///
+    bool IsSaving() const { return m_saveThread != NULL; }
+
+    /// Waits for any background save to finish and processes its result.
+    ///
+    void WaitForSave();
+
+    /// Called when the MeaPositionLogSavedMsg message is received to
+    /// process the result of a background save.
+    ///
+    /// @param saveId       [in] Identifies the save, as passed in the
+    ///                     message's WPARAM.
+    ///
+    void SaveCompleted(UINT saveId);
+
     /// If there are positions that have not been saved, ask the
     /// user if they should be saved. Called before the app exits or
     /// a load will destroy the unsaved positions.
@@ -719,131 +1066,302 @@ public:
     void    LoadProfile(MeaProfile& profile);
 
 
-    /// Resets the position manager to its default state.
+    /// Enables or disables journaling. When journaling is enabled, each
+    /// change to the positions of a log that has been loaded or saved is
+    /// appended to a journal file alongside the log instead of requiring
+    /// the entire log to be rewritten. The journal is replayed when the
+    /// log is next loaded and is compacted into the log when the log is
+    /// saved. Journaling is disabled by default because it creates a
+    /// journal file alongside the log and rewrites the log as the
+    /// journal grows.
     ///
-    void    MasterReset();
-
+    /// @param journaling   [in] <b>true</b> to enable journaling.
+    ///
+    void    SetJournaling(bool journaling);
 
-    /// Called during the XML parsing of the log file, to parse an
-    /// external entity such as a DTD.
+    /// Indicates whether journaling is enabled.
     ///
-    /// @param parser       [in] XML parser.
-    /// @param pathname     [in] Pathname of the external entity.
+    /// @return <b>true</b> if journaling is enabled.
+    ///
+    bool    IsJournaling() const { return m_journaling; }
+
+
+    /// Resets the position manager to its default state.
     ///
-    virtual void    ParseEntity(MeaXMLParser& parser,
-                                const CString& pathname);
+    void    MasterReset();
+
 
-    /// Returns the pathname of the currently parsed log file.
+    /// Returns the pathname of the current position log file.
     ///
-    /// @return Pathname of the currently parsed position log file.
+    /// @return Pathname of the position log file, or the empty string
+    ///         if the positions have not been loaded or saved.
     ///
-    virtual CString GetFilePathname();
+    CString GetFilePathname() const { return m_pathname; }
 
     /// Tests whether the specified filename represents a position
     /// log file.
     ///
     /// @param filename     [in] File to test
     ///
-    /// @return <b>true</b> if the specified file is a position log file.
+    /// @return <b>true</b> if the specified file is an XML or binary
+    ///         position log file.
     ///
     static bool IsPositionFile(LPCTSTR filename);
 
 private:
-    /// Represents a collection of positions. A position log consists
-    /// of a collection of positions. In turn, a position consists of
-    /// on or more points depending on the measurement tool.
+    /// Represents the collection of recorded positions.
     ///
-    class Positions
+    typedef MeaPositionStore_T<Position> Positions;
+
+private:
+    MEA_SINGLETON_DECL(MeaPositionLogMgr);      ///< Managers are singletons.
+
+    /// Purposely undefined.
+    MeaPositionLogMgr(const MeaPositionLogMgr&);
+
+    /// Purposely undefined.
+    MeaPositionLogMgr& operator=(const MeaPositionLogMgr&);
+
+    typedef std::map<MeaGUID, DesktopInfo, MeaGUID::less> DesktopInfoMap;   ///< Maps GUID to a desktop information object.
+    typedef std::map<MeaGUID, int, MeaGUID::less> RefCountMap;              ///< Maps a GUID to a reference count.
+    typedef std::unordered_multimap<size_t, MeaGUID> DesktopHashIndex;      ///< Maps a desktop information fingerprint to the GUIDs having it.
+    typedef std::map<CString, int> PrecisionMap;                            ///< Maps a measurement name to its decimal places.
+    typedef std::vector<DesktopInfo> DesktopInfoList;                       ///< Desktop information objects in no particular order.
+
+
+    /// Immutable copy of the position log taken when a save starts. The
+    /// snapshot is written to the log file without reference to the
+    /// manager so that it can be saved on a worker thread while the
+    /// manager continues to record positions.
+    ///
+    struct SaveSnapshot
+    {
+        UINT                saveId;         ///< Identifies the save.
+        CString             pathname;       ///< Pathname of the log file to write.
+        bool                binary;         ///< Write the binary log file format.
+        CString             title;          ///< Title for the positions.
+        CString             desc;           ///< Description of the positions.
+        DesktopInfoList     desktops;       ///< Desktop information objects referenced by the positions.
+        Positions::Snapshot positions;      ///< Positions to save.
+        unsigned int        changeCount;    ///< Manager change count when the snapshot was taken.
+        bool                journaled;      ///< Was the journal attached when the snapshot was taken.
+        size_t              journalOffset;  ///< Offset of the end of the journal when the snapshot was taken.
+        HWND                notifyWnd;      ///< Window sent MeaPositionLogSavedMsg when a background save completes.
+        bool                succeeded;      ///< Was the log file written successfully.
+        CString             error;          ///< Description of the error if the log file could not be written.
+    };
+
+
+    typedef std::vector<Position*> PositionList;    ///< Positions in log file order.
+
+
+    /// Loads a position log file into its own set of desktops and
+    /// positions without reference to the manager. This allows several
+    /// log files to be loaded concurrently, each by its own loader and
+    /// XML parser on a separate thread. The loaded positions do not
+    /// reference a manager until they are adopted by one. Errors are
+    /// recorded rather than displayed, so that they can be reported
+    /// once loading has finished.
+    ///
+    class LogLoader : public MeaXMLParserHandler
     {
     public:
-        /// Constructs a position collection object.
+        /// An error encountered loading the log file.
         ///
-        Positions();
-        
-        /// Destroys a position collection object.
+        struct Error
+        {
+            CString title;      ///< Title for the error, or empty for the default title.
+            CString msg;        ///< Description of the error.
+        };
+
+        typedef std::vector<Error> ErrorList;       ///< Errors in the order encountered.
+
+
+        /// Constructs a loader for the specified log file.
+        ///
+        /// @param pathname     [in] Pathname of the XML or binary log file to load.
+        ///
+        explicit LogLoader(const CString& pathname);
+
+        /// Destroys the loader along with any loaded positions that have
+        /// not been released.
         ///
-        ~Positions();
+        virtual ~LogLoader();
 
 
-        /// Indicates if there are any positions stored in the object.
+        /// Loads the log file. This method does not access the manager and
+        /// may be called on any thread while the main thread is waiting.
         ///
-        /// @return <b>true</b> if there are positions.
+        /// @return <b>true</b> if the file was loaded successfully.
         ///
-        bool Empty() const { return m_posMap.empty(); }
-        
-        /// Returns the number of positions stored in the object.
+        bool    Load();
+
+        /// Indicates whether the log file was loaded successfully.
+        /// @return <b>true</b> if Load succeeded.
+        bool    IsLoaded() const { return m_loaded; }
+
+        /// Returns the pathname of the log file.
+        /// @return Log file pathname.
+        const CString&  GetPathname() const { return m_pathname; }
+
+        /// Returns the title read from the log file.
+        /// @return Title for the positions.
+        const CString&  GetTitle() const { return m_title; }
+
+        /// Returns the description read from the log file.
+        /// @return Description of the positions.
+        const CString&  GetDesc() const { return m_desc; }
+
+        /// Returns the desktop information objects read from the log file.
+        /// @return Desktop information objects in log file order.
+        const DesktopInfoList&  GetDesktops() const { return m_desktops; }
+
+        /// Returns the positions read from the log file. The positions
+        /// are owned by the loader until ReleasePositions is called.
+        /// @return Positions in log file order.
+        const PositionList&     GetPositions() const { return m_positions; }
+
+        /// Gives up ownership of the loaded positions, which must have
+        /// been adopted by the caller.
+        ///
+        void    ReleasePositions() { m_positions.clear(); }
+
+        /// Returns the errors encountered loading the log file. Errors
+        /// may be present even if the file was loaded.
+        /// @return Errors in the order encountered.
+        const ErrorList&    GetErrors() const { return m_errors; }
+
+
+        /// Called during the XML parsing of the log file, to parse an
+        /// external entity such as a DTD.
         ///
-        /// @return Number of positions.
+        /// @param parser       [in] XML parser.
+        /// @param pathname     [in] Pathname of the external entity.
         ///
-        unsigned int Size() const { return m_posMap.size(); }
+        virtual void    ParseEntity(MeaXMLParser& parser, const CString& pathname);
 
+        /// Called when the start of an element is encountered while
+        /// parsing the log file. The log file is loaded as it is parsed
+        /// rather than by first building a DOM.
+        ///
+        /// @param container    [in] Name of the parent element.
+        /// @param elementName  [in] Name of the element.
+        /// @param attrs        [in] Attributes of the element.
+        ///
+        virtual void    StartElementHandler(const MeaXMLStringView& container,
+                                            const MeaXMLStringView& elementName,
+                                            const MeaXMLAttributes& attrs);
 
-        /// Adds the specified position to the collection of positions.
+        /// Called when the end of an element is encountered while parsing
+        /// the log file.
         ///
-        /// @param position     [in] Position to add to the collection.
+        /// @param container    [in] Name of the parent element.
+        /// @param elementName  [in] Name of the element.
         ///
-        void Add(Position* position);
-        
-        /// Places the specified position at the specified location in
-        /// the collection.
+        virtual void    EndElementHandler(const MeaXMLStringView& container,
+                                          const MeaXMLStringView& elementName);
+
+        /// Called with the character data of the title and desc elements
+        /// while parsing the log file.
         ///
-        /// @param posIndex     [in] Zero based index indicating where in
-        ///                     the collection to place the position.
-        /// @param position     [in] Position object to insert in the collection.
+        /// @param container    [in] Name of the element containing the data.
+        /// @param data         [in] Character data.
         ///
-        void Set(int posIndex, Position* position) throw(std::out_of_range);
+        virtual void    CharacterDataHandler(const MeaXMLStringView& container,
+                                             const MeaXMLStringView& data);
 
-        /// Returns the position object at the specified location in the collection.
+        /// Returns the pathname of the log file being parsed.
         ///
-        /// @param posIndex     [in] Zero based index into the collection.
+        /// @return Pathname of the position log file.
         ///
-        /// @return Position object located at the specified location in the
-        ///         collection.
+        virtual CString GetFilePathname() { return m_pathname; }
+
+        /// Records a parsing or validation error.
         ///
-        Position& Get(int posIndex) throw(std::out_of_range);
-        
-        /// Removes the position object from the specified location in the
-        /// collection and destroys the object.
+        /// @param title    [in] Title describing the kind of error.
+        /// @param msg      [in] Description of the error.
         ///
-        /// @param posIndex     [in] Zero based index indicating where in
-        ///                     the collection to delete a position.
+        virtual void    ReportError(const CString& title, const CString& msg);
+
+    private:
+        /// Purposely undefined.
+        LogLoader(const LogLoader&);
+
+        /// Purposely undefined.
+        LogLoader& operator=(const LogLoader&);
+
+
+        /// Loads an XML format log file.
         ///
-        void Delete(int posIndex) throw(std::out_of_range);
+        /// @return <b>true</b> if the file was loaded successfully.
+        ///
+        bool    LoadXML();
 
-        /// Removes all positions from the collection and destroys the
-        /// position objects.
+        /// Loads a binary format log file. The file is memory mapped and
+        /// its records are read in place.
+        ///
+        /// @return <b>true</b> if the file was loaded successfully.
         ///
-        void DeleteAll();
+        bool    LoadBinary();
 
+        /// Starts loading a desktop element of the log file.
+        ///
+        /// @param attrs        [in] Attributes of the desktop element.
+        ///
+        void    StartDesktop(const MeaXMLAttributes& attrs);
 
-        /// Saves all positions in the collection to the log file.
+        /// Starts loading a position element of the log file.
         ///
-        /// @param indent       [in] Output indentation level.
+        /// @param attrs        [in] Attributes of the position element.
         ///
-        void Save(int indent) const throw(CFileException);
+        void    StartPosition(const MeaXMLAttributes& attrs);
 
-    private:
-        typedef std::map<int, Position*> PositionMap;       ///< Maps indices to position objects.
+        /// Records an error.
+        ///
+        /// @param msg          [in] Description of the error.
+        ///
+        void    AddError(const CString& msg);
 
-        PositionMap m_posMap;       ///< Collection of positions.
-    };
+        /// Discards everything loaded so far, including any desktop or
+        /// position left partially loaded by a failed parse.
+        ///
+        void    Clear();
 
-private:
-    MEA_SINGLETON_DECL(MeaPositionLogMgr);      ///< Managers are singletons.
 
-    /// Purposely undefined.
-    MeaPositionLogMgr(const MeaPositionLogMgr&);
+        CString         m_pathname;         ///< Pathname of the log file.
+        bool            m_loaded;           ///< Was the log file loaded successfully.
+        CString         m_title;            ///< Title for the positions.
+        CString         m_desc;             ///< Description of the positions.
+        DesktopInfoList m_desktops;         ///< Desktop information objects read from the log file.
+        PositionList    m_positions;        ///< Positions read from the log file.
+        ErrorList       m_errors;           ///< Errors encountered loading the log file.
+        DesktopInfo*    m_loadDesktop;      ///< Desktop being loaded from the log file, or NULL.
+        Position*       m_loadPosition;     ///< Position being loaded from the log file, or NULL.
+        PrecisionMap    m_loadPrecisions;   ///< Custom display precisions read for the desktop being loaded.
+        CString         m_loadData;         ///< Character data read for the current title or desc element.
+    };
 
-    /// Purposely undefined.
-    MeaPositionLogMgr& operator=(const MeaPositionLogMgr&);
+    typedef std::vector<LogLoader*> LogLoaderList;  ///< Loaders for the files of a merge.
 
-    typedef std::map<MeaGUID, DesktopInfo, MeaGUID::less> DesktopInfoMap;   ///< Maps GUID to a desktop information object.
-    typedef std::map<MeaGUID, int, MeaGUID::less> RefCountMap;              ///< Maps a GUID to a reference count.
+
+    /// Log files waiting to be loaded by the merge worker threads.
+    ///
+    struct LoadQueue
+    {
+        LogLoaderList*  loaders;        ///< Loaders to run.
+        volatile LONG   next;           ///< Index of the next loader to run.
+    };
     
 
     static const int    kChunkSize;     ///< Log file parsing buffer allocation increment.
     static LPCTSTR      kExt;           ///< Log file suffix.
+    static LPCTSTR      kBinaryExt;     ///< Binary log file suffix.
+    static const ULONGLONG kJournalCompactSize;     ///< Journal size at which it is compacted into the log file.
     static LPCTSTR      kFilter;        ///< File dialog filter string.
+    static LPCTSTR      kCSVExt;        ///< CSV file suffix.
+    static LPCTSTR      kJSONLinesExt;  ///< JSON Lines file suffix.
+    static LPCTSTR      kTextFilter;    ///< Export and import file dialog filter string.
+    static const DWORD  kMergeBufferSize;           ///< Size of the merge dialog buffer for the selected pathnames, in characters.
 
 
     /// Constructs a file save dialog tailored to saving position log files.
@@ -864,74 +1382,200 @@ private:
     void    ManageDlgDestroyed() { m_manageDialog = NULL; }
 
 
+    /// Asks the user for the pathname of the log file to save, if
+    /// necessary, and remembers it along with the log title and
+    /// description.
+    ///
+    /// @param askPathname  [in] <b>true</b> means ask user to supply a pathname even if there is already a pathname.
+    ///
+    /// @return <b>true</b> if there is a pathname, false if canceled.
+    ///
+    bool    GetSavePathname(bool askPathname);
+
+    /// Copies the position log into the specified snapshot.
+    ///
+    /// @param snapshot     [out] Snapshot of the position log.
+    ///
+    void    TakeSnapshot(SaveSnapshot& snapshot);
+
+    /// Writes the specified snapshot to its log file. This method does
+    /// not access the manager and may be called on any thread.
+    ///
+    /// @param snapshot     [in, out] Snapshot to write. Its succeeded and
+    ///                     error members are set to the result.
+    ///
+    static void WriteSnapshot(SaveSnapshot& snapshot);
+
+    /// Writes the specified snapshot in the XML log file format.
+    /// @param snapshot     [in] Snapshot to write.
+    /// @param file         [in] File open for writing.
+    static void WriteXML(const SaveSnapshot& snapshot, CFile& file) throw(CFileException);
+
+    /// Writes the specified snapshot in the binary log file format.
+    /// @param snapshot     [in] Snapshot to write.
+    /// @param file         [in] File open for writing.
+    static void WriteBinary(const SaveSnapshot& snapshot, CFile& file) throw(CFileException);
+
     /// Writes the general information section of the position log file.
-    /// @param indent       [in] Output indentation level.
-    void    WriteInfoSection(int indent) throw(CFileException);
+    /// @param writer       [in] Position log file writer.
+    /// @param snapshot     [in] Snapshot being written.
+    static void WriteInfoSection(MeaXMLWriter& writer, const SaveSnapshot& snapshot) throw(CFileException);
 
     /// Writes the desktop information section of the position log file.
-    /// @param indent       [in] Output indentation level.
-    void    WriteDesktopsSection(int indent) throw(CFileException);
+    /// @param writer       [in] Position log file writer.
+    /// @param snapshot     [in] Snapshot being written.
+    static void WriteDesktopsSection(MeaXMLWriter& writer, const SaveSnapshot& snapshot) throw(CFileException);
 
     /// Writes the positions section of the position log file.
-    /// @param indent       [in] Output indentation level.
-    void    WritePositionsSection(int indent) throw(CFileException);
+    /// @param writer       [in] Position log file writer.
+    /// @param snapshot     [in] Snapshot being written.
+    static void WritePositionsSection(MeaXMLWriter& writer, const SaveSnapshot& snapshot) throw(CFileException);
+
+    /// Completes a save once its snapshot has been written. The error
+    /// is reported if the save failed, otherwise the journal is reset
+    /// and the modified state updated. The observer is informed of the
+    /// result.
+    ///
+    /// @param snapshot     [in] Snapshot that was written.
+    ///
+    /// @return <b>true</b> if the save succeeded.
+    ///
+    bool    FinishSave(const SaveSnapshot& snapshot);
+
+    /// Entry point for the background save worker thread.
+    ///
+    /// @param pParam       [in] Snapshot to write.
+    ///
+    /// @return Zero.
+    ///
+    static UINT SaveProc(LPVOID pParam);
 
 
-    /// Opens the specified position log file either for reading or writing.
+    /// Tests whether the specified pathname has the binary log file
+    /// extension.
     ///
-    /// @param pathname     [in] Pathname of position log file to open.
-    /// @param mode         [in] one of CFile::modeRead or CFile::modeWrite | CFile::modeCreate
+    /// @param pathname     [in] Pathname to test.
     ///
-    /// @return <b>true</b> if file opened successfully.
+    /// @return <b>true</b> if the positions should be saved in the binary format.
     ///
-    bool    Open(const CString& pathname, UINT mode);
+    static bool IsBinaryPathname(LPCTSTR pathname);
 
-    /// Closes the currently open position log file.
+    /// Determines the text format of a position file from its pathname.
+    ///
+    /// @param pathname     [in] Pathname to test.
+    ///
+    /// @return MeaJSONLinesFormat if the pathname has the JSON Lines
+    ///         extension, otherwise MeaCSVFormat.
     ///
-    void    Close() { m_stdioFile.Close(); m_stdioOpen = false; }
+    static MeaTextLogFormat GetTextFormat(LPCTSTR pathname);
 
-    /// Printf-like method for writing to a position log file.
+    /// Runs the specified loaders on a pool of worker threads, one per
+    /// processor, and waits for them all to finish. The calling thread
+    /// also takes part in the loading.
     ///
-    /// @param indentLevel      [in] Output indentation level.
-    /// @param format           [in] Printf-style format string.
-    /// @param ...              [in] Items to write to the file.
+    /// @param loaders      [in] Loaders to run.
     ///
-    void    Write(int indentLevel, LPCTSTR format, ...) throw(CFileException);
+    static void LoadLogs(LogLoaderList& loaders);
 
+    /// Entry point for the merge load worker threads. Loaders are taken
+    /// from the queue and run until it is empty.
+    ///
+    /// @param pParam       [in] LoadQueue shared by the worker threads.
+    ///
+    /// @return Zero.
+    ///
+    static UINT LoadProc(LPVOID pParam);
 
-    /// Handles the top level elements of the log file DOM and
-    /// supervises the processing of the lower level elements.
+    /// Adds the desktops and positions of a loaded log file to those
+    /// of the manager, taking ownership of the positions. The added
+    /// positions are not journaled; the caller journals them.
     ///
-    /// @param dom          [in] Root node of the DOM.
+    /// @param loader       [in] Loader that has successfully loaded its file.
     ///
-    void    ProcessDOM(const MeaXMLNode* dom);
-    
-    /// Handles the info element of the log file.
+    /// @return Number of positions added.
     ///
-    /// @param infoNode     [in] info node in the DOM.
+    int     MergeLog(LogLoader& loader);
+
+    /// Adds a desktop information object from a log file to the set of
+    /// desktops. An identical desktop that is already present is used
+    /// instead, and the desktop is given a new ID if its ID is already
+    /// used by a different desktop.
     ///
-    void    ProcessInfoNode(const MeaXMLNode* infoNode);
-    
-    /// Handles the desktop elements of the log file.
+    /// @param desktopInfo  [in] Desktop information object to add.
     ///
-    /// @param desktopNode  [in] desktop node in the DOM.
+    /// @return ID by which the desktop is known to the manager.
     ///
-    void    ProcessDesktopNode(const MeaXMLNode* desktopNode);
-    
-    /// Handles the position elements of the log file.
+    MeaGUID MergeDesktopInfo(const DesktopInfo& desktopInfo);
+
+    /// Appends a change to the positions to the journal of the current
+    /// log file, if journaling is active. The journal is compacted into
+    /// the log file once it passes kJournalCompactSize.
     ///
-    /// @param positionNode [in] position node in the DOM
+    /// @param op           [in] Operation performed on the positions.
+    /// @param posIndex     [in] Index of the affected position.
     ///
-    void    ProcessPositionNode(const MeaXMLNode* positionNode);
-    
-    /// Concatenates all child data nodes into a single string.
+    void    JournalPosition(MeaBinaryLogJournal::Operation op, int posIndex);
+
+    /// Appends a batch of positions added at the end of the log to the
+    /// journal as a single entry, if journaling is active. Each desktop
+    /// referenced by the positions is written once, and the journal size
+    /// is checked once for the entire batch.
+    ///
+    /// @param firstIndex   [in] Index of the first added position.
+    /// @param count        [in] Number of positions added.
+    ///
+    void    JournalPositions(int firstIndex, int count);
+
+    /// Saves the log in the background, compacting the journal into the
+    /// log file, once the journal passes kJournalCompactSize.
+    ///
+    void    CompactJournal();
+
+    /// Applies the changes recorded in the journal of the log file that
+    /// has just been loaded.
+    ///
+    void    ReplayJournal();
+
+    /// Creates a position from the binary log held in a journal entry.
+    /// The desktop referenced by the position is added if it is not
+    /// already known.
     ///
-    /// @param elementNode  [in] Parent node of data nodes
+    /// @param data         [in] Journal entry data.
+    /// @param size         [in] Size of the entry data, in bytes.
     ///
-    /// @return String concatenation of all child data nodes.
+    /// @return Newly created position.
     ///
-    static CString ProcessDataNodes(const MeaXMLNode* elementNode);
+    /// @throw MeaLogFileException if the entry data is invalid.
+    ///
+    Position*   LoadJournalPosition(const BYTE* data, UINT32 size);
 
+    /// Adds the positions held in a journal entry for a batch of added
+    /// positions. The desktops referenced by the positions are added if
+    /// they are not already known.
+    ///
+    /// @param data         [in] Journal entry data.
+    /// @param size         [in] Size of the entry data, in bytes.
+    ///
+    /// @throw MeaLogFileException if the entry data is invalid.
+    ///
+    void        AddJournalPositions(const BYTE* data, UINT32 size);
+
+
+    /// Adds the specified desktop information object to the set of
+    /// desktops and to the fingerprint index.
+    ///
+    /// @param desktopInfo  [in] Desktop information object to add.
+    ///
+    void        AddDesktopInfo(const DesktopInfo& desktopInfo);
+
+    /// Looks for a desktop information object that is identical to the
+    /// specified object, ignoring their IDs.
+    ///
+    /// @param desktopInfo  [in] Desktop information object to look for.
+    ///
+    /// @return ID of the identical object, or NULL if there is none.
+    ///
+    const MeaGUID*  FindDesktopInfo(const DesktopInfo& desktopInfo) const;
 
     /// Records the current desktop information if the information
     /// has not already been recorded.
@@ -972,20 +1616,28 @@ private:
     
     MeaPositionLogObserver* m_observer;         ///< Position log manager observer.
     DesktopInfoMap          m_desktopInfoMap;   ///< Desktop information objects
+    DesktopHashIndex        m_desktopHashIndex; ///< Desktop information objects indexed by fingerprint.
     RefCountMap             m_refCountMap;      ///< Desktop information object reference count.
     Positions               m_positions;        ///< Recorded positions.
     MeaPositionSaveDlg*     m_saveDialog;       ///< Position log file save dialog.
     CFileDialog*            m_loadDialog;       ///< Position log file open dialog.
     CString                 m_saveDlgTitle;     ///< Title for the file save dialog.
     CString                 m_loadDlgTitle;     ///< Title for the file open dialog.
+    CString                 m_mergeDlgTitle;    ///< Title for the file merge dialog.
+    CString                 m_exportDlgTitle;   ///< Title for the export dialog.
+    CString                 m_importDlgTitle;   ///< Title for the import dialog.
     CString                 m_initialDir;       ///< Initial directory for the file save and open dialogs.
     CString                 m_pathname;         ///< Pathname of current position log file.
-    CStdioFile              m_stdioFile;        ///< File pointer for an open position log file.
-    bool                    m_stdioOpen;        ///< Is the position log file open.
     CString                 m_title;            ///< Title for the positions.
     CString                 m_desc;             ///< Description of the positions.
     bool                    m_modified;         ///< Have the positions been modified since last save.
     MeaPositionLogDlg*      m_manageDialog;     ///< Position management dialog.
+    MeaBinaryLogJournal     m_journal;          ///< Journal of changes to the current log file.
+    bool                    m_journaling;       ///< Are changes journaled rather than requiring a full save.
+    unsigned int            m_changeCount;      ///< Incremented each time the positions change.
+    UINT                    m_saveCount;        ///< Number of background saves started.
+    SaveSnapshot*           m_saveSnapshot;     ///< Snapshot being saved in the background, or NULL.
+    CWinThread*             m_saveThread;       ///< Background save worker thread, or NULL.
 
     friend class Screen;                ///< Represents a display screen.
     friend class DesktopInfo;           ///< Desktop information object.
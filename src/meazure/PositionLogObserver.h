@@ -47,10 +47,19 @@ public:
     /// Called when a position log file is saved.
     ///
     virtual void LogSaved() = 0;
+
+    /// Called when a background save of the position log file fails.
+    ///
+    virtual void LogSaveFailed() = 0;
     
     /// Called when a new position is recorded.
     /// @param posIndex     [in] Index of the new position.
     virtual void PositionAdded(int posIndex) = 0;
+
+    /// Called when a batch of new positions is recorded.
+    /// @param firstIndex   [in] Index of the first new position.
+    /// @param count        [in] Number of new positions.
+    virtual void PositionsAdded(int firstIndex, int count) = 0;
     
     /// Called when an existing position is replaced with a new position.
     /// @param posIndex     [in] Index of the replaced position.
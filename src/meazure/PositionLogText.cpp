@@ -0,0 +1,935 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include "PositionLogText.h"
+#include "LogFileException.h"
+#include "DataDisplay.h"
+#include "TimeStamp.h"
+#include "MeaAssert.h"
+#include <stdlib.h>
+
+
+namespace
+{
+    /// Describes a measurement property of a record.
+    ///
+    struct Property
+    {
+        UINT                        field;      ///< Field mask bit for the property.
+        double MeaTextLogRecord::*  value;      ///< Record member holding the property.
+        const char*                 name;       ///< CSV column and JSON member name.
+    };
+
+    /// Properties in column order.
+    ///
+    const Property kProperties[] = {
+        { MeaWidthField,    &MeaTextLogRecord::width,       "width" },
+        { MeaHeightField,   &MeaTextLogRecord::height,      "height" },
+        { MeaDistanceField, &MeaTextLogRecord::distance,    "distance" },
+        { MeaAreaField,     &MeaTextLogRecord::area,        "area" },
+        { MeaAngleField,    &MeaTextLogRecord::angle,       "angle" }
+    };
+
+    const int kNumProperties = sizeof(kProperties) / sizeof(kProperties[0]);
+
+    /// UTF-8 point names, in MeaPositionPoints::PointId order.
+    ///
+    const char* const kPointNames[MeaPositionPoints::kNumPointIds] = { "1", "2", "v" };
+
+    const char kCSVHeader[] = "tool,date,linearUnits,angularUnits,x1,y1,x2,y2,xv,yv,width,height,distance,area,angle,desc\r\n";
+
+
+    /// Converts a string to UTF-8.
+    ///
+    /// @param str      [in] String to convert.
+    /// @param utf8     [out] UTF-8 form of the string.
+    ///
+    void ToUTF8(const CString& str, std::string& utf8)
+    {
+        CStringW wide(str);
+        int wideLen = wide.GetLength();
+
+        int len = WideCharToMultiByte(CP_UTF8, 0, wide, wideLen, NULL, 0, NULL, NULL);
+        utf8.resize(len);
+        if (len > 0) {
+            WideCharToMultiByte(CP_UTF8, 0, wide, wideLen, &utf8[0], len, NULL, NULL);
+        }
+    }
+
+    /// Appends the UTF-8 encoding of a code point to a string.
+    ///
+    /// @param utf8     [in, out] String to append to.
+    /// @param cp       [in] Code point to append.
+    ///
+    void AppendUTF8(std::string& utf8, UINT cp)
+    {
+        if (cp < 0x80) {
+            utf8 += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            utf8 += static_cast<char>(0xC0 | (cp >> 6));
+            utf8 += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            utf8 += static_cast<char>(0xE0 | (cp >> 12));
+            utf8 += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            utf8 += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            utf8 += static_cast<char>(0xF0 | (cp >> 18));
+            utf8 += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            utf8 += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            utf8 += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+}
+
+
+//*************************************************************************
+// MeaTextLogRecord
+//*************************************************************************
+
+
+void MeaTextLogRecord::Clear()
+{
+    tool.Empty();
+    timestamp.Empty();
+    linearUnits.Empty();
+    angularUnits.Empty();
+    desc.Empty();
+
+    for (int i = 0; i < MeaPositionPoints::kNumPointIds; i++) {
+        points[i].x = 0.0;
+        points[i].y = 0.0;
+        hasPoint[i] = false;
+    }
+
+    fieldMask   = 0;
+    width       = 0.0;
+    height      = 0.0;
+    distance    = 0.0;
+    area        = 0.0;
+    angle       = 0.0;
+}
+
+
+//*************************************************************************
+// MeaTextLogWriter
+//*************************************************************************
+
+
+MeaTextLogWriter::MeaTextLogWriter(CFile& file, MeaTextLogFormat format, int bufferSize) :
+    m_file(file),
+    m_format(format),
+    m_buffer(bufferSize),
+    m_used(0),
+    m_flushed(0)
+{
+    MeaAssert(bufferSize > 0);
+
+    if (m_format == MeaCSVFormat) {
+        Put(kCSVHeader, sizeof(kCSVHeader) - 1);
+    }
+}
+
+
+MeaTextLogWriter::~MeaTextLogWriter()
+{
+    try {
+        Flush();
+    }
+    catch(...) {
+        MeaAssert(false);
+    }
+}
+
+
+void MeaTextLogWriter::Write(const MeaTextLogRecord& record)
+{
+    if (m_format == MeaCSVFormat) {
+        WriteCSV(record);
+    } else {
+        WriteJSON(record);
+    }
+}
+
+
+void MeaTextLogWriter::Flush()
+{
+    if (m_used > 0) {
+        m_file.Write(&m_buffer[0], static_cast<UINT>(m_used));
+        m_flushed += m_used;
+        m_used = 0;
+    }
+}
+
+
+void MeaTextLogWriter::WriteCSV(const MeaTextLogRecord& record)
+{
+    PutCSVString(record.tool);
+    Put(',');
+    PutCSVString(record.timestamp);
+    Put(',');
+    PutCSVString(record.linearUnits);
+    Put(',');
+    PutCSVString(record.angularUnits);
+
+    for (int i = 0; i < MeaPositionPoints::kNumPointIds; i++) {
+        Put(',');
+        if (record.hasPoint[i]) {
+            PutNumber(record.points[i].x);
+            Put(',');
+            PutNumber(record.points[i].y);
+        } else {
+            Put(',');
+        }
+    }
+
+    for (int i = 0; i < kNumProperties; i++) {
+        Put(',');
+        if (record.fieldMask & kProperties[i].field) {
+            PutNumber(record.*kProperties[i].value);
+        }
+    }
+
+    Put(',');
+    PutCSVString(record.desc);
+    Put("\r\n", 2);
+}
+
+
+void MeaTextLogWriter::WriteJSON(const MeaTextLogRecord& record)
+{
+    bool first = true;
+
+    Put('{');
+    PutJSONName("tool", first);
+    PutJSONString(record.tool);
+    PutJSONName("date", first);
+    PutJSONString(record.timestamp);
+    PutJSONName("linearUnits", first);
+    PutJSONString(record.linearUnits);
+    PutJSONName("angularUnits", first);
+    PutJSONString(record.angularUnits);
+
+    bool firstPoint = true;
+    for (int i = 0; i < MeaPositionPoints::kNumPointIds; i++) {
+        if (record.hasPoint[i]) {
+            if (firstPoint) {
+                PutJSONName("points", first);
+                Put('{');
+            }
+            PutJSONName(kPointNames[i], firstPoint);
+            Put("{\"x\":", 5);
+            PutNumber(record.points[i].x);
+            Put(",\"y\":", 5);
+            PutNumber(record.points[i].y);
+            Put('}');
+        }
+    }
+    if (!firstPoint) {
+        Put('}');
+    }
+
+    for (int i = 0; i < kNumProperties; i++) {
+        if (record.fieldMask & kProperties[i].field) {
+            PutJSONName(kProperties[i].name, first);
+            PutNumber(record.*kProperties[i].value);
+        }
+    }
+
+    if (!record.desc.IsEmpty()) {
+        PutJSONName("desc", first);
+        PutJSONString(record.desc);
+    }
+
+    Put("}\n", 2);
+}
+
+
+void MeaTextLogWriter::PutCSVString(const CString& str)
+{
+    ToUTF8(str, m_utf8);
+
+    if (m_utf8.find_first_of(",\"\r\n") == std::string::npos) {
+        Put(m_utf8.c_str(), m_utf8.size());
+        return;
+    }
+
+    Put('"');
+    for (std::string::const_iterator iter = m_utf8.begin(); iter != m_utf8.end(); ++iter) {
+        if (*iter == '"') {
+            Put('"');
+        }
+        Put(*iter);
+    }
+    Put('"');
+}
+
+
+void MeaTextLogWriter::PutJSONString(const CString& str)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+
+    ToUTF8(str, m_utf8);
+
+    Put('"');
+    for (std::string::const_iterator iter = m_utf8.begin(); iter != m_utf8.end(); ++iter) {
+        unsigned char ch = static_cast<unsigned char>(*iter);
+
+        switch (ch) {
+        case '"':   Put("\\\"", 2); break;
+        case '\\':  Put("\\\\", 2); break;
+        case '\b':  Put("\\b", 2);  break;
+        case '\f':  Put("\\f", 2);  break;
+        case '\n':  Put("\\n", 2);  break;
+        case '\r':  Put("\\r", 2);  break;
+        case '\t':  Put("\\t", 2);  break;
+        default:
+            if (ch < 0x20) {
+                char escape[6] = { '\\', 'u', '0', '0', hexDigits[ch >> 4], hexDigits[ch & 0xF] };
+                Put(escape, sizeof(escape));
+            } else {
+                Put(static_cast<char>(ch));
+            }
+            break;
+        }
+    }
+    Put('"');
+}
+
+
+void MeaTextLogWriter::PutJSONName(const char* name, bool& first)
+{
+    if (first) {
+        first = false;
+    } else {
+        Put(',');
+    }
+    Put('"');
+    Put(name, strlen(name));
+    Put("\":", 2);
+}
+
+
+void MeaTextLogWriter::PutNumber(double value)
+{
+    char numStr[_CVTBUFSIZE];
+
+    int len = _snprintf_s(numStr, sizeof(numStr), _TRUNCATE, "%.15f", value);
+    if (len < 0) {
+        len = static_cast<int>(strlen(numStr));
+    }
+
+    // Remove trailing zeros, keeping at least one digit after the
+    // decimal point.
+    //
+    while ((len > 1) && (numStr[len - 1] == '0') && (numStr[len - 2] != '.')) {
+        len--;
+    }
+
+    Put(numStr, len);
+}
+
+
+void MeaTextLogWriter::PutSlow(const char* bytes, size_t count)
+{
+    Flush();
+
+    if (count > m_buffer.size()) {
+        m_file.Write(bytes, static_cast<UINT>(count));
+        m_flushed += count;
+    } else {
+        memcpy(&m_buffer[0], bytes, count);
+        m_used = count;
+    }
+}
+
+
+//*************************************************************************
+// MeaTextLogReader
+//*************************************************************************
+
+
+MeaTextLogReader::MeaTextLogReader(CFile& file, MeaTextLogFormat format, int bufferSize) :
+    m_file(file),
+    m_format(format),
+    m_buffer(bufferSize),
+    m_pos(0),
+    m_end(0),
+    m_line(1),
+    m_recordLine(1),
+    m_started(false)
+{
+    MeaAssert(bufferSize >= 3);
+}
+
+
+MeaTextLogReader::~MeaTextLogReader()
+{
+}
+
+
+bool MeaTextLogReader::Read(MeaTextLogRecord& record)
+{
+    if (!m_started) {
+        m_started = true;
+
+        // Skip any UTF-8 byte order mark.
+        //
+        if ((Peek() == 0xEF) && (m_end >= 3) &&
+                (m_buffer[1] == static_cast<char>(0xBB)) && (m_buffer[2] == static_cast<char>(0xBF))) {
+            m_pos = 3;
+        }
+
+        if (m_format == MeaCSVFormat) {
+            ReadHeader();
+        }
+    }
+
+    // Skip blank lines.
+    //
+    int ch;
+    while (((ch = Peek()) == '\r') || (ch == '\n')) {
+        Get();
+    }
+    if (ch < 0) {
+        return false;
+    }
+
+    m_recordLine = m_line;
+    record.Clear();
+
+    bool status = (m_format == MeaCSVFormat) ? ReadCSV(record) : ReadJSON(record);
+
+    // A date that is not a valid timestamp could not be displayed once
+    // the record is imported. A missing date is left for the caller to
+    // supply.
+    //
+    if (!record.timestamp.IsEmpty() && !MeaIsTimeStamp(record.timestamp)) {
+        Fail();
+    }
+
+    return status;
+}
+
+
+void MeaTextLogReader::ReadHeader()
+{
+    static const struct {
+        const char* name;
+        Column      column;
+    } columnNames[] = {
+        { "tool",           ToolColumn },
+        { "date",           DateColumn },
+        { "linearUnits",    LinearUnitsColumn },
+        { "angularUnits",   AngularUnitsColumn },
+        { "x1",             X1Column },
+        { "y1",             Y1Column },
+        { "x2",             X2Column },
+        { "y2",             Y2Column },
+        { "xv",             XVColumn },
+        { "yv",             YVColumn },
+        { "width",          WidthColumn },
+        { "height",         HeightColumn },
+        { "distance",       DistanceColumn },
+        { "area",           AreaColumn },
+        { "angle",          AngleColumn },
+        { "desc",           DescColumn }
+    };
+
+    if (Peek() < 0) {
+        return;     // Empty file
+    }
+
+    bool haveTool = false;
+    bool more;
+
+    do {
+        more = ReadCSVField();
+
+        Column column = UnknownColumn;
+        for (size_t i = 0; i < sizeof(columnNames) / sizeof(columnNames[0]); i++) {
+            if (m_field == columnNames[i].name) {
+                column = columnNames[i].column;
+                break;
+            }
+        }
+
+        haveTool = haveTool || (column == ToolColumn);
+        m_columns.push_back(column);
+    } while (more);
+
+    if (!haveTool) {
+        Fail();
+    }
+}
+
+
+bool MeaTextLogReader::ReadCSV(MeaTextLogRecord& record)
+{
+    size_t index = 0;
+    bool more;
+
+    do {
+        more = ReadCSVField();
+        SetField((index < m_columns.size()) ? m_columns[index] : UnknownColumn, record);
+        index++;
+    } while (more);
+
+    return true;
+}
+
+
+bool MeaTextLogReader::ReadCSVField()
+{
+    int ch;
+
+    m_field.clear();
+
+    if (Peek() == '"') {
+        Get();
+        for (;;) {
+            ch = Get();
+            if (ch < 0) {
+                Fail();     // Unterminated quoted field
+            }
+            if (ch == '"') {
+                if (Peek() != '"') {
+                    break;
+                }
+                Get();
+            }
+            m_field += static_cast<char>(ch);
+        }
+    } else {
+        while (((ch = Peek()) >= 0) && (ch != ',') && (ch != '\r') && (ch != '\n')) {
+            m_field += static_cast<char>(ch);
+            Get();
+        }
+    }
+
+    ch = Get();
+    switch (ch) {
+    case ',':
+        return true;
+    case '\r':
+        if (Peek() == '\n') {
+            Get();
+        }
+        return false;
+    case '\n':
+    case -1:
+        return false;
+    default:
+        Fail();     // Text after a quoted field
+        return false;
+    }
+}
+
+
+void MeaTextLogReader::SetField(Column column, MeaTextLogRecord& record)
+{
+    if (m_field.empty()) {
+        return;
+    }
+
+    switch (column) {
+    case ToolColumn:            record.tool = FieldString();                        break;
+    case DateColumn:            record.timestamp = FieldString();                   break;
+    case LinearUnitsColumn:     record.linearUnits = FieldString();                 break;
+    case AngularUnitsColumn:    record.angularUnits = FieldString();                break;
+    case DescColumn:            record.desc = FieldString();                        break;
+    case X1Column:              record.points[MeaPositionPoints::Point1].x = FieldNumber();
+                                record.hasPoint[MeaPositionPoints::Point1] = true;   break;
+    case Y1Column:              record.points[MeaPositionPoints::Point1].y = FieldNumber();
+                                record.hasPoint[MeaPositionPoints::Point1] = true;   break;
+    case X2Column:              record.points[MeaPositionPoints::Point2].x = FieldNumber();
+                                record.hasPoint[MeaPositionPoints::Point2] = true;   break;
+    case Y2Column:              record.points[MeaPositionPoints::Point2].y = FieldNumber();
+                                record.hasPoint[MeaPositionPoints::Point2] = true;   break;
+    case XVColumn:              record.points[MeaPositionPoints::PointV].x = FieldNumber();
+                                record.hasPoint[MeaPositionPoints::PointV] = true;   break;
+    case YVColumn:              record.points[MeaPositionPoints::PointV].y = FieldNumber();
+                                record.hasPoint[MeaPositionPoints::PointV] = true;   break;
+    case WidthColumn:           record.width = FieldNumber();
+                                record.fieldMask |= MeaWidthField;                  break;
+    case HeightColumn:          record.height = FieldNumber();
+                                record.fieldMask |= MeaHeightField;                 break;
+    case DistanceColumn:        record.distance = FieldNumber();
+                                record.fieldMask |= MeaDistanceField;               break;
+    case AreaColumn:            record.area = FieldNumber();
+                                record.fieldMask |= MeaAreaField;                   break;
+    case AngleColumn:           record.angle = FieldNumber();
+                                record.fieldMask |= MeaAngleField;                  break;
+    default:
+        break;
+    }
+}
+
+
+bool MeaTextLogReader::ReadJSON(MeaTextLogRecord& record)
+{
+    Expect('{');
+    SkipJSONSpace();
+
+    if (Peek() == '}') {
+        Get();
+    } else {
+        for (;;) {
+            ReadJSONString();
+            std::string name(m_field);
+
+            Expect(':');
+            SkipJSONSpace();
+
+            CString* str = NULL;
+            if (name == "tool") {
+                str = &record.tool;
+            } else if (name == "date") {
+                str = &record.timestamp;
+            } else if (name == "linearUnits") {
+                str = &record.linearUnits;
+            } else if (name == "angularUnits") {
+                str = &record.angularUnits;
+            } else if (name == "desc") {
+                str = &record.desc;
+            }
+
+            const Property* prop = NULL;
+            for (int i = 0; (prop == NULL) && (i < kNumProperties); i++) {
+                if (name == kProperties[i].name) {
+                    prop = &kProperties[i];
+                }
+            }
+
+            // Values of an unexpected type, such as null, are skipped.
+            //
+            int ch = Peek();
+            if ((name == "points") && (ch == '{')) {
+                ReadJSONPoints(record);
+            } else if ((str != NULL) && (ch == '"')) {
+                ReadJSONString();
+                *str = FieldString();
+            } else if ((prop != NULL) && ((ch == '-') || isdigit(ch))) {
+                record.*prop->value = ReadJSONNumber();
+                record.fieldMask |= prop->field;
+            } else {
+                SkipJSONValue();
+            }
+
+            SkipJSONSpace();
+            ch = Get();
+            if (ch == '}') {
+                break;
+            }
+            if (ch != ',') {
+                Fail();
+            }
+        }
+    }
+
+    // Nothing but white space may follow the object on its line.
+    //
+    int ch;
+    while (((ch = Peek()) == ' ') || (ch == '\t') || (ch == '\r')) {
+        Get();
+    }
+    if (ch == '\n') {
+        Get();
+    } else if (ch >= 0) {
+        Fail();
+    }
+
+    return true;
+}
+
+
+void MeaTextLogReader::ReadJSONPoints(MeaTextLogRecord& record)
+{
+    Expect('{');
+    SkipJSONSpace();
+
+    if (Peek() == '}') {
+        Get();
+        return;
+    }
+
+    for (;;) {
+        ReadJSONString();
+
+        int id;
+        for (id = 0; id < MeaPositionPoints::kNumPointIds; id++) {
+            if (m_field == kPointNames[id]) {
+                break;
+            }
+        }
+
+        Expect(':');
+        Expect('{');
+
+        FPOINT pt;
+        pt.x = 0.0;
+        pt.y = 0.0;
+
+        SkipJSONSpace();
+        if (Peek() == '}') {
+            Get();
+        } else {
+            for (;;) {
+                ReadJSONString();
+                char coord = (m_field.size() == 1) ? m_field[0] : '\0';
+
+                Expect(':');
+                if (coord == 'x') {
+                    pt.x = ReadJSONNumber();
+                } else if (coord == 'y') {
+                    pt.y = ReadJSONNumber();
+                } else {
+                    SkipJSONValue();
+                }
+
+                SkipJSONSpace();
+                int ch = Get();
+                if (ch == '}') {
+                    break;
+                }
+                if (ch != ',') {
+                    Fail();
+                }
+            }
+        }
+
+        // Points other than those the tools use are ignored.
+        //
+        if (id < MeaPositionPoints::kNumPointIds) {
+            record.points[id] = pt;
+            record.hasPoint[id] = true;
+        }
+
+        SkipJSONSpace();
+        int ch = Get();
+        if (ch == '}') {
+            break;
+        }
+        if (ch != ',') {
+            Fail();
+        }
+    }
+}
+
+
+void MeaTextLogReader::ReadJSONString()
+{
+    Expect('"');
+    m_field.clear();
+
+    for (;;) {
+        int ch = Get();
+
+        if ((ch < 0) || (ch == '\n')) {
+            Fail();     // Unterminated string
+        }
+        if (ch == '"') {
+            break;
+        }
+        if (ch != '\\') {
+            m_field += static_cast<char>(ch);
+            continue;
+        }
+
+        ch = Get();
+        switch (ch) {
+        case '"':
+        case '\\':
+        case '/':   m_field += static_cast<char>(ch);   break;
+        case 'b':   m_field += '\b';    break;
+        case 'f':   m_field += '\f';    break;
+        case 'n':   m_field += '\n';    break;
+        case 'r':   m_field += '\r';    break;
+        case 't':   m_field += '\t';    break;
+        case 'u':
+            {
+                UINT cp = ReadJSONHex();
+
+                // Combine a surrogate pair into a single code point.
+                //
+                if ((cp >= 0xD800) && (cp <= 0xDBFF) && (Peek() == '\\')) {
+                    Get();
+                    if (Get() != 'u') {
+                        Fail();
+                    }
+                    UINT low = ReadJSONHex();
+                    if ((low < 0xDC00) || (low > 0xDFFF)) {
+                        Fail();
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                AppendUTF8(m_field, cp);
+            }
+            break;
+        default:
+            Fail();     // Invalid escape
+            break;
+        }
+    }
+}
+
+
+UINT MeaTextLogReader::ReadJSONHex()
+{
+    UINT value = 0;
+
+    for (int i = 0; i < 4; i++) {
+        int ch = Get();
+
+        value <<= 4;
+        if ((ch >= '0') && (ch <= '9')) {
+            value |= ch - '0';
+        } else if ((ch >= 'a') && (ch <= 'f')) {
+            value |= ch - 'a' + 10;
+        } else if ((ch >= 'A') && (ch <= 'F')) {
+            value |= ch - 'A' + 10;
+        } else {
+            Fail();
+        }
+    }
+
+    return value;
+}
+
+
+double MeaTextLogReader::ReadJSONNumber()
+{
+    SkipJSONSpace();
+    m_field.clear();
+
+    int ch;
+    while (((ch = Peek()) >= 0) && (isdigit(ch) || (ch == '-') || (ch == '+') || (ch == '.') ||
+                                    (ch == 'e') || (ch == 'E'))) {
+        m_field += static_cast<char>(ch);
+        Get();
+    }
+
+    return FieldNumber();
+}
+
+
+void MeaTextLogReader::SkipJSONValue()
+{
+    SkipJSONSpace();
+
+    int ch = Peek();
+    if (ch == '"') {
+        ReadJSONString();
+    } else if ((ch == '{') || (ch == '[')) {
+        int depth = 0;
+
+        do {
+            ch = Peek();
+            if (ch == '"') {
+                ReadJSONString();
+                continue;
+            }
+
+            Get();
+            if ((ch < 0) || (ch == '\n')) {
+                Fail();
+            } else if ((ch == '{') || (ch == '[')) {
+                depth++;
+            } else if ((ch == '}') || (ch == ']')) {
+                depth--;
+            }
+        } while (depth > 0);
+    } else {
+        // Number, true, false or null.
+        //
+        bool empty = true;
+        while (((ch = Peek()) >= 0) && (isalnum(ch) || (ch == '-') || (ch == '+') || (ch == '.'))) {
+            Get();
+            empty = false;
+        }
+        if (empty) {
+            Fail();
+        }
+    }
+}
+
+
+void MeaTextLogReader::SkipJSONSpace()
+{
+    int ch;
+    while (((ch = Peek()) == ' ') || (ch == '\t') || (ch == '\r')) {
+        Get();
+    }
+}
+
+
+void MeaTextLogReader::Expect(char ch)
+{
+    SkipJSONSpace();
+    if (Get() != ch) {
+        Fail();
+    }
+}
+
+
+CString MeaTextLogReader::FieldString() const
+{
+    int len = static_cast<int>(m_field.size());
+    if (len == 0) {
+        return CString();
+    }
+
+    int wideLen = MultiByteToWideChar(CP_UTF8, 0, m_field.data(), len, NULL, 0);
+    CStringW wide;
+    MultiByteToWideChar(CP_UTF8, 0, m_field.data(), len, wide.GetBuffer(wideLen), wideLen);
+    wide.ReleaseBuffer(wideLen);
+
+    return CString(wide);
+}
+
+
+double MeaTextLogReader::FieldNumber() const
+{
+    const char* start = m_field.c_str();
+    char* end;
+
+    double value = strtod(start, &end);
+    while ((*end == ' ') || (*end == '\t')) {
+        end++;
+    }
+    if ((end == start) || (*end != '\0')) {
+        Fail();
+    }
+
+    return value;
+}
+
+
+void MeaTextLogReader::Fail() const
+{
+    throw MeaLogFileException();
+}
+
+
+bool MeaTextLogReader::Fill()
+{
+    m_pos = 0;
+    m_end = m_file.Read(&m_buffer[0], static_cast<UINT>(m_buffer.size()));
+    return (m_end > 0);
+}
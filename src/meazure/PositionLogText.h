@@ -0,0 +1,439 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Header file for the CSV and JSON Lines position log formats.
+///
+/// The text formats flatten a position log into one record per position
+/// for use by spreadsheets and analysis tools. Each record carries the
+/// tool name, timestamp, points, measurement properties and the units
+/// they were recorded in. Desktop and screen information is not included.
+///
+/// A CSV file starts with a header line naming its columns:
+///
+/// @code
+///     tool,date,linearUnits,angularUnits,x1,y1,x2,y2,xv,yv,width,height,distance,area,angle,desc
+/// @endcode
+///
+/// A column is empty if the position does not have the point or property.
+/// When reading, the columns are located by name so they may appear in any
+/// order and unknown columns are ignored.
+///
+/// A JSON Lines file contains one JSON object per line, with the same
+/// members except that the points are an object keyed by point name:
+///
+/// @code
+///     {"tool":"LineTool","date":"2011-01-01T00:00:00Z","linearUnits":"px","angularUnits":"deg",
+///      "points":{"1":{"x":10.0,"y":20.0},"2":{"x":30.0,"y":40.0}},"distance":28.284271247461}
+/// @endcode
+///
+/// Both formats are written and read in UTF-8 through a fixed size buffer,
+/// one record at a time, so the memory used does not depend on the size of
+/// the log.
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include "Utils.h"
+#include "PositionPoints.h"
+
+
+/// One position of a position log in flat form.
+///
+struct MeaTextLogRecord
+{
+    /// Constructs an empty record.
+    ///
+    MeaTextLogRecord() { Clear(); }
+
+    /// Removes all values from the record.
+    ///
+    void Clear();
+
+
+    CString tool;                       ///< Name of the tool whose position is recorded.
+    CString timestamp;                  ///< When the position was recorded, in ISO 8601 format.
+    CString linearUnits;                ///< Identifier string of the linear units of the values (e.g. "px").
+    CString angularUnits;               ///< Identifier string of the angular units of the angle (e.g. "deg").
+    CString desc;                       ///< Description of the position.
+    FPOINT  points[MeaPositionPoints::kNumPointIds];    ///< Point coordinates, in the linear units, indexed by point ID.
+    bool    hasPoint[MeaPositionPoints::kNumPointIds];  ///< Is the corresponding point present.
+    UINT    fieldMask;                  ///< Properties that are present, as OR'd MeaFields identifiers.
+    double  width;                      ///< Width property.
+    double  height;                     ///< Height property.
+    double  distance;                   ///< Distance property.
+    double  area;                       ///< Area property.
+    double  angle;                      ///< Angle property, in the angular units.
+};
+
+
+/// Text formats supported for position logs.
+///
+enum MeaTextLogFormat {
+    MeaCSVFormat,           ///< Comma separated values with a header line.
+    MeaJSONLinesFormat      ///< One JSON object per line.
+};
+
+
+/// Writes position records to a file in CSV or JSON Lines format. Output
+/// is accumulated in a buffer and written to the file in blocks.
+///
+class MeaTextLogWriter
+{
+public:
+    /// Constructs a writer that outputs to the specified file. For the
+    /// CSV format, the header line is written immediately.
+    ///
+    /// @param file         [in] File open for writing. The file must
+    ///                     remain open for the life of the writer.
+    /// @param format       [in] Format to write.
+    /// @param bufferSize   [in] Size of the output buffer, in bytes.
+    ///
+    MeaTextLogWriter(CFile& file, MeaTextLogFormat format, int bufferSize = kDefaultBufferSize);
+
+    /// Flushes any buffered output and destroys the writer.
+    ///
+    ~MeaTextLogWriter();
+
+
+    /// Writes the specified record.
+    ///
+    /// @param record       [in] Record to write.
+    ///
+    void    Write(const MeaTextLogRecord& record);
+
+    /// Writes any buffered output to the file.
+    ///
+    void    Flush();
+
+    /// Returns the number of bytes output so far, including those still
+    /// in the buffer.
+    ///
+    /// @return Number of bytes output.
+    ///
+    ULONGLONG   GetBytesWritten() const { return m_flushed + m_used; }
+
+
+    static const int kDefaultBufferSize = 64 * 1024;    ///< Default output buffer size, in bytes.
+
+private:
+    /// Purposely undefined.
+    MeaTextLogWriter(const MeaTextLogWriter&);
+
+    /// Purposely undefined.
+    MeaTextLogWriter& operator=(const MeaTextLogWriter&);
+
+
+    /// Writes the record as a CSV line.
+    ///
+    /// @param record       [in] Record to write.
+    ///
+    void    WriteCSV(const MeaTextLogRecord& record);
+
+    /// Writes the record as a JSON object on its own line.
+    ///
+    /// @param record       [in] Record to write.
+    ///
+    void    WriteJSON(const MeaTextLogRecord& record);
+
+    /// Writes a string as a CSV field, quoting it if it contains a
+    /// delimiter, quote or line break.
+    ///
+    /// @param str          [in] String to write.
+    ///
+    void    PutCSVString(const CString& str);
+
+    /// Writes a string as a quoted JSON string.
+    ///
+    /// @param str          [in] String to write.
+    ///
+    void    PutJSONString(const CString& str);
+
+    /// Writes a JSON member name followed by a colon, preceded by a comma
+    /// if it is not the first member of the object.
+    ///
+    /// @param name         [in] Member name. It must not need escaping.
+    /// @param first        [in, out] Is this the first member of the
+    ///                     object. Cleared by the method.
+    ///
+    void    PutJSONName(const char* name, bool& first);
+
+    /// Writes a number with 15 decimal places and trailing zeros removed,
+    /// as MeaXMLWriter does.
+    ///
+    /// @param value        [in] Number to write.
+    ///
+    void    PutNumber(double value);
+
+    /// Writes the specified bytes to the buffer.
+    ///
+    /// @param bytes        [in] Bytes to write.
+    /// @param count        [in] Number of bytes.
+    ///
+    void    Put(const char* bytes, size_t count) {
+        if (m_used + count > m_buffer.size()) {
+            PutSlow(bytes, count);
+        } else {
+            memcpy(&m_buffer[m_used], bytes, count);
+            m_used += count;
+        }
+    }
+
+    /// Writes the specified byte to the buffer.
+    ///
+    /// @param ch           [in] Byte to write.
+    ///
+    void    Put(char ch) {
+        if (m_used == m_buffer.size()) {
+            Flush();
+        }
+        m_buffer[m_used++] = ch;
+    }
+
+    /// Flushes the buffer and writes the specified bytes, either to the
+    /// buffer or, if they do not fit, directly to the file.
+    ///
+    /// @param bytes        [in] Bytes to write.
+    /// @param count        [in] Number of bytes.
+    ///
+    void    PutSlow(const char* bytes, size_t count);
+
+
+    CFile&              m_file;         ///< File being written.
+    MeaTextLogFormat    m_format;       ///< Format being written.
+    std::vector<char>   m_buffer;       ///< Output buffer.
+    size_t              m_used;         ///< Number of bytes in the buffer.
+    ULONGLONG           m_flushed;      ///< Number of bytes written to the file.
+    std::string         m_utf8;         ///< Scratch space for converting strings to UTF-8.
+};
+
+
+/// Reads position records from a file in CSV or JSON Lines format. The
+/// file is read through a fixed size buffer, one record at a time.
+///
+class MeaTextLogReader
+{
+public:
+    /// Constructs a reader for the specified file. For the CSV format, the
+    /// header line is read by the first call to Read.
+    ///
+    /// @param file         [in] File open for reading. The file must
+    ///                     remain open for the life of the reader.
+    /// @param format       [in] Format to read.
+    /// @param bufferSize   [in] Size of the input buffer, in bytes.
+    ///
+    MeaTextLogReader(CFile& file, MeaTextLogFormat format, int bufferSize = kDefaultBufferSize);
+
+    /// Destroys the reader.
+    ///
+    ~MeaTextLogReader();
+
+
+    /// Reads the next record from the file. Blank lines are skipped. A
+    /// record without a date is returned with an empty timestamp.
+    ///
+    /// @param record       [out] Record read.
+    ///
+    /// @return <b>true</b> if a record was read, <b>false</b> if the end
+    ///         of the file has been reached.
+    ///
+    /// @throw MeaLogFileException if the record or the CSV header is
+    ///        invalid, or the record's date is not a valid timestamp.
+    ///
+    bool    Read(MeaTextLogRecord& record);
+
+    /// Returns the number of the line on which the most recently read
+    /// record starts. If Read throws, this is the line of the invalid
+    /// record.
+    ///
+    /// @return Line number, starting at 1.
+    ///
+    int     GetLineNumber() const { return m_recordLine; }
+
+
+    static const int kDefaultBufferSize = 64 * 1024;    ///< Default input buffer size, in bytes.
+
+private:
+    /// CSV columns that are recognized.
+    ///
+    enum Column {
+        UnknownColumn,
+        ToolColumn,
+        DateColumn,
+        LinearUnitsColumn,
+        AngularUnitsColumn,
+        X1Column,
+        Y1Column,
+        X2Column,
+        Y2Column,
+        XVColumn,
+        YVColumn,
+        WidthColumn,
+        HeightColumn,
+        DistanceColumn,
+        AreaColumn,
+        AngleColumn,
+        DescColumn
+    };
+
+    typedef std::vector<Column> ColumnList;     ///< Meaning of each CSV column, in column order.
+
+
+    /// Purposely undefined.
+    MeaTextLogReader(const MeaTextLogReader&);
+
+    /// Purposely undefined.
+    MeaTextLogReader& operator=(const MeaTextLogReader&);
+
+
+    /// Reads the CSV header line and determines the meaning of each column.
+    ///
+    void    ReadHeader();
+
+    /// Reads a record from a CSV line.
+    ///
+    /// @param record       [out] Record read.
+    ///
+    /// @return <b>true</b> if a record was read.
+    ///
+    bool    ReadCSV(MeaTextLogRecord& record);
+
+    /// Reads a record from a JSON Lines line.
+    ///
+    /// @param record       [out] Record read.
+    ///
+    /// @return <b>true</b> if a record was read.
+    ///
+    bool    ReadJSON(MeaTextLogRecord& record);
+
+    /// Reads one CSV field into m_field.
+    ///
+    /// @return <b>true</b> if the field is followed by another field on
+    ///         the same line, <b>false</b> if it ends the line.
+    ///
+    bool    ReadCSVField();
+
+    /// Assigns the field just read to the record according to its column.
+    ///
+    /// @param column       [in] Column of the field.
+    /// @param record       [in, out] Record receiving the value.
+    ///
+    void    SetField(Column column, MeaTextLogRecord& record);
+
+    /// Reads the points object of a JSON record.
+    ///
+    /// @param record       [in, out] Record receiving the points.
+    ///
+    void    ReadJSONPoints(MeaTextLogRecord& record);
+
+    /// Reads a JSON string into m_field. The opening quote must be next.
+    ///
+    void    ReadJSONString();
+
+    /// Reads the four hexadecimal digits of a JSON \\u escape.
+    ///
+    /// @return Value of the digits.
+    ///
+    UINT    ReadJSONHex();
+
+    /// Reads a JSON number.
+    ///
+    /// @return Value of the number.
+    ///
+    double  ReadJSONNumber();
+
+    /// Reads and discards a JSON value of any type.
+    ///
+    void    SkipJSONValue();
+
+    /// Skips white space within a JSON line.
+    ///
+    void    SkipJSONSpace();
+
+    /// Consumes the specified character, which must be the next
+    /// non-white space character.
+    ///
+    /// @param ch           [in] Character expected.
+    ///
+    void    Expect(char ch);
+
+    /// Converts m_field from UTF-8 to a string.
+    ///
+    /// @return Field value.
+    ///
+    CString FieldString() const;
+
+    /// Converts m_field to a number.
+    ///
+    /// @return Field value.
+    ///
+    double  FieldNumber() const;
+
+    /// Reports invalid data in the current record.
+    ///
+    /// @throw MeaLogFileException always.
+    ///
+    void    Fail() const;
+
+    /// Returns the next byte of the file without consuming it.
+    ///
+    /// @return Next byte, or -1 at the end of the file.
+    ///
+    int     Peek() {
+        if ((m_pos == m_end) && !Fill()) {
+            return -1;
+        }
+        return static_cast<unsigned char>(m_buffer[m_pos]);
+    }
+
+    /// Returns and consumes the next byte of the file. Line feeds are
+    /// counted.
+    ///
+    /// @return Next byte, or -1 at the end of the file.
+    ///
+    int     Get() {
+        int ch = Peek();
+        if (ch >= 0) {
+            m_pos++;
+            if (ch == '\n') {
+                m_line++;
+            }
+        }
+        return ch;
+    }
+
+    /// Refills the buffer from the file.
+    ///
+    /// @return <b>true</b> if more data was read.
+    ///
+    bool    Fill();
+
+
+    CFile&              m_file;         ///< File being read.
+    MeaTextLogFormat    m_format;       ///< Format being read.
+    std::vector<char>   m_buffer;       ///< Input buffer.
+    size_t              m_pos;          ///< Position of the next byte in the buffer.
+    size_t              m_end;          ///< Number of valid bytes in the buffer.
+    int                 m_line;         ///< Number of the current line.
+    int                 m_recordLine;   ///< Number of the line on which the current record starts.
+    bool                m_started;      ///< Has the start of the file been read.
+    ColumnList          m_columns;      ///< Meaning of each CSV column.
+    std::string         m_field;        ///< Current field or string, in UTF-8.
+};
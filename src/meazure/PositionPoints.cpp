@@ -0,0 +1,248 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include "PositionPoints.h"
+#include <algorithm>
+
+
+namespace
+{
+    /// Orders the points without IDs by name.
+    ///
+    struct OtherPointLess
+    {
+        bool operator()(const std::pair<CString, FPOINT>& point, LPCTSTR name) const {
+            return point.first.Compare(name) < 0;
+        }
+    };
+}
+
+
+MeaPositionPoints::MeaPositionPoints() : m_slotMask(0), m_otherPoints(NULL)
+{
+}
+
+
+MeaPositionPoints::MeaPositionPoints(const MeaPositionPoints& points) : m_slotMask(0), m_otherPoints(NULL)
+{
+    *this = points;
+}
+
+
+MeaPositionPoints::MeaPositionPoints(const PointMap& points) : m_slotMask(0), m_otherPoints(NULL)
+{
+    PointMap::const_iterator iter;
+    for (iter = points.begin(); iter != points.end(); ++iter) {
+        SetPoint((*iter).first, (*iter).second);
+    }
+}
+
+
+MeaPositionPoints::~MeaPositionPoints()
+{
+    try {
+        delete m_otherPoints;
+    } catch(...) {
+        MeaAssert(false);
+    }
+}
+
+
+MeaPositionPoints& MeaPositionPoints::operator=(const MeaPositionPoints& points)
+{
+    if (&points != this) {
+        for (int i = 0; i < kNumPointIds; i++) {
+            m_slots[i] = points.m_slots[i];
+        }
+        m_slotMask = points.m_slotMask;
+
+        if (points.m_otherPoints == NULL) {
+            delete m_otherPoints;
+            m_otherPoints = NULL;
+        } else if (m_otherPoints == NULL) {
+            m_otherPoints = new OtherPointList(*points.m_otherPoints);
+        } else {
+            *m_otherPoints = *points.m_otherPoints;
+        }
+    }
+
+    return *this;
+}
+
+
+MeaPositionPoints::PointId MeaPositionPoints::GetPointId(LPCTSTR name)
+{
+    // The point names are a single character, so the first character
+    // identifies the point.
+    //
+    if (name[0] != _T('\0') && name[1] == _T('\0')) {
+        switch (name[0]) {
+        case _T('1'):
+            return Point1;
+        case _T('2'):
+            return Point2;
+        case _T('v'):
+            return PointV;
+        default:
+            break;
+        }
+    }
+
+    return kNumPointIds;
+}
+
+
+LPCTSTR MeaPositionPoints::GetPointName(PointId id)
+{
+    static const LPCTSTR names[kNumPointIds] = { _T("1"), _T("2"), _T("v") };
+
+    MeaAssert(id < kNumPointIds);
+    return names[id];
+}
+
+
+void MeaPositionPoints::SetPoint(PointId id, const FPOINT& pt)
+{
+    MeaAssert(id < kNumPointIds);
+
+    m_slots[id] = pt;
+    m_slotMask |= static_cast<unsigned char>(1 << id);
+}
+
+
+void MeaPositionPoints::SetPoint(LPCTSTR name, const FPOINT& pt)
+{
+    PointId id = GetPointId(name);
+    if (id < kNumPointIds) {
+        SetPoint(id, pt);
+        return;
+    }
+
+    if (m_otherPoints == NULL) {
+        m_otherPoints = new OtherPointList;
+    }
+
+    OtherPointList::iterator iter = std::lower_bound(m_otherPoints->begin(), m_otherPoints->end(),
+                                                     name, OtherPointLess());
+    if (iter != m_otherPoints->end() && (*iter).first == name) {
+        (*iter).second = pt;
+    } else {
+        m_otherPoints->insert(iter, std::make_pair(CString(name), pt));
+    }
+}
+
+
+const FPOINT* MeaPositionPoints::FindPoint(LPCTSTR name) const
+{
+    PointId id = GetPointId(name);
+    if (id < kNumPointIds) {
+        return HasPoint(id) ? &m_slots[id] : NULL;
+    }
+
+    if (m_otherPoints != NULL) {
+        OtherPointList::const_iterator iter = std::lower_bound(m_otherPoints->begin(), m_otherPoints->end(),
+                                                               name, OtherPointLess());
+        if (iter != m_otherPoints->end() && (*iter).first == name) {
+            return &(*iter).second;
+        }
+    }
+
+    return NULL;
+}
+
+
+void MeaPositionPoints::Clear()
+{
+    m_slotMask = 0;
+
+    delete m_otherPoints;
+    m_otherPoints = NULL;
+}
+
+
+int MeaPositionPoints::GetSlotCount() const
+{
+    int count = 0;
+    for (unsigned int mask = m_slotMask; mask != 0; mask >>= 1) {
+        count += mask & 1;
+    }
+    return count;
+}
+
+
+MeaPositionPoints::PointId MeaPositionPoints::GetSlot(int index) const
+{
+    for (int i = 0; i < kNumPointIds; i++) {
+        if ((m_slotMask & (1 << i)) != 0) {
+            if (index == 0) {
+                return static_cast<PointId>(i);
+            }
+            index--;
+        }
+    }
+
+    MeaAssert(false);
+    return kNumPointIds;
+}
+
+
+int MeaPositionPoints::GetCount() const
+{
+    int count = GetSlotCount();
+    if (m_otherPoints != NULL) {
+        count += static_cast<int>(m_otherPoints->size());
+    }
+    return count;
+}
+
+
+LPCTSTR MeaPositionPoints::GetNameAt(int index) const
+{
+    MeaAssert(index >= 0 && index < GetCount());
+
+    int slotCount = GetSlotCount();
+    if (index < slotCount) {
+        return GetPointName(GetSlot(index));
+    }
+    return (*m_otherPoints)[index - slotCount].first;
+}
+
+
+const FPOINT& MeaPositionPoints::GetPointAt(int index) const
+{
+    MeaAssert(index >= 0 && index < GetCount());
+
+    int slotCount = GetSlotCount();
+    if (index < slotCount) {
+        return m_slots[GetSlot(index)];
+    }
+    return (*m_otherPoints)[index - slotCount].second;
+}
+
+
+void MeaPositionPoints::GetPointMap(PointMap& points) const
+{
+    points.clear();
+
+    int count = GetCount();
+    for (int i = 0; i < count; i++) {
+        points[GetNameAt(i)] = GetPointAt(i);
+    }
+}
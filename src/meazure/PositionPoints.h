@@ -0,0 +1,209 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Header file for the named points of a recorded position.
+
+#pragma once
+
+#include <map>
+#include <vector>
+#include "Utils.h"
+#include "MeaAssert.h"
+
+
+/// Holds the named points of a recorded position. The measurement tools
+/// name their points "1", "2" and "v", and no tool has more than one point
+/// of each name. Those points are stored in fixed slots within the object,
+/// identified by a point ID, so that storing the points of a position does
+/// not allocate memory. A point with any other name, which may be found
+/// in a position log file written by another version of the program, is
+/// stored in a separately allocated list.
+///
+/// The points are accessed by their order in the object. The points with
+/// IDs come first, in ID order, followed by any other points in name order.
+/// Since the IDs are in name order, this is the same order as a point map
+/// when only the tool point names are used.
+///
+class MeaPositionPoints
+{
+public:
+    /// Identifies the points that are stored in fixed slots.
+    ///
+    enum PointId {
+        Point1,             ///< First point, named "1".
+        Point2,             ///< Second point, named "2".
+        PointV,             ///< Vertex or center point, named "v".
+        kNumPointIds        ///< Number of point IDs.
+    };
+
+    typedef std::map<CString, FPOINT> PointMap;     ///< Maps a point name to the coordinates of the point.
+
+
+    /// Constructs an object with no points.
+    ///
+    MeaPositionPoints();
+
+    /// Copy constructor.
+    ///
+    /// @param points   [in] Object to be copied.
+    ///
+    MeaPositionPoints(const MeaPositionPoints& points);
+
+    /// Constructs an object holding the points in the specified map.
+    ///
+    /// @param points   [in] Points to be held.
+    ///
+    explicit MeaPositionPoints(const PointMap& points);
+
+    /// Destroys the object.
+    ///
+    ~MeaPositionPoints();
+
+    /// Performs assignment of the specified points to this object.
+    ///
+    /// @param points   [in] Object to be copied to this.
+    ///
+    /// @return This object.
+    ///
+    MeaPositionPoints& operator=(const MeaPositionPoints& points);
+
+
+    /// Returns the ID of the specified point name.
+    ///
+    /// @param name     [in] Point name.
+    ///
+    /// @return Point ID, or kNumPointIds if the name does not have an ID.
+    ///
+    static PointId GetPointId(LPCTSTR name);
+
+    /// Returns the name of the specified point ID.
+    ///
+    /// @param id       [in] Point ID.
+    ///
+    /// @return Point name.
+    ///
+    static LPCTSTR GetPointName(PointId id);
+
+
+    /// Sets the specified point, replacing any point already set with the
+    /// same ID.
+    ///
+    /// @param id       [in] Point ID.
+    /// @param pt       [in] Point coordinates.
+    ///
+    void SetPoint(PointId id, const FPOINT& pt);
+
+    /// Sets the specified point, replacing any point already set with the
+    /// same name.
+    ///
+    /// @param name     [in] Point name.
+    /// @param pt       [in] Point coordinates.
+    ///
+    void SetPoint(LPCTSTR name, const FPOINT& pt);
+
+    /// Indicates whether the point with the specified ID is set.
+    ///
+    /// @param id       [in] Point ID.
+    ///
+    /// @return <b>true</b> if the point is set.
+    ///
+    bool HasPoint(PointId id) const {
+        MeaAssert(id < kNumPointIds);
+        return (m_slotMask & (1 << id)) != 0;
+    }
+
+    /// Returns the point with the specified ID. The point must be set.
+    ///
+    /// @param id       [in] Point ID.
+    ///
+    /// @return Point coordinates.
+    ///
+    const FPOINT& GetPoint(PointId id) const {
+        MeaAssert(HasPoint(id));
+        return m_slots[id];
+    }
+
+    /// Looks up the point with the specified name.
+    ///
+    /// @param name     [in] Point name.
+    ///
+    /// @return Point coordinates, or NULL if there is no point with the name.
+    ///
+    const FPOINT* FindPoint(LPCTSTR name) const;
+
+    /// Removes all points.
+    ///
+    void Clear();
+
+
+    /// Returns the number of points.
+    ///
+    /// @return Number of points.
+    ///
+    int GetCount() const;
+
+    /// Returns the name of a point.
+    ///
+    /// @param index    [in] Order of the point, from 0 to GetCount()-1.
+    ///
+    /// @return Point name.
+    ///
+    LPCTSTR GetNameAt(int index) const;
+
+    /// Returns the coordinates of a point.
+    ///
+    /// @param index    [in] Order of the point, from 0 to GetCount()-1.
+    ///
+    /// @return Point coordinates.
+    ///
+    const FPOINT& GetPointAt(int index) const;
+
+
+    /// Copies the points into the specified map.
+    ///
+    /// @param points   [out] Points, keyed by name. The map is cleared
+    ///                 first.
+    ///
+    void GetPointMap(PointMap& points) const;
+
+private:
+    typedef std::vector<std::pair<CString, FPOINT> > OtherPointList;   ///< Points without IDs, in name order.
+
+
+    /// Returns the slot of a point.
+    ///
+    /// @param index    [in] Order of the point, from 0 to the number of
+    ///                 points in slots minus 1.
+    ///
+    /// @return Point ID of the slot.
+    ///
+    PointId GetSlot(int index) const;
+
+    /// Returns the number of points in slots.
+    ///
+    /// @return Number of points in slots.
+    ///
+    int GetSlotCount() const;
+
+
+    FPOINT          m_slots[kNumPointIds];  ///< Points with IDs.
+    unsigned char   m_slotMask;             ///< Bit per point ID indicating whether the point is set.
+    OtherPointList* m_otherPoints;          ///< Points without IDs, or NULL if there are none.
+};
@@ -0,0 +1,268 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Header file for the collection of recorded positions.
+
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+#include "MeaAssert.h"
+#include "PositionIndex.h"
+
+
+/// Represents a collection of positions. A position log consists of a
+/// collection of positions. In turn, a position consists of one or more
+/// points depending on the measurement tool.
+///
+/// The collection owns the position objects and stores pointers to them
+/// in index order. Positions are heap allocated because the position log
+/// manager's positions adjust the manager's desktop reference counts as
+/// they are created and destroyed, which storing them by value would
+/// trigger on every reallocation.
+///
+/// @param position_t   Type of the position objects. The type must provide
+///                     the GetToolName, GetTimeStamp and GetPointSet methods
+///                     used to index the positions.
+///
+template <class position_t>
+class MeaPositionStore_T
+{
+public:
+    typedef std::vector<const position_t*> Snapshot;    ///< Immutable view of the positions in index order.
+
+
+    /// Constructs a position collection object.
+    ///
+    MeaPositionStore_T() : m_shared(false) {}
+
+    /// Destroys a position collection object.
+    ///
+    ~MeaPositionStore_T() {
+        try {
+            DeleteAll();
+            ReleaseSnapshot();
+        }
+        catch(...) {
+            MeaAssert(false);
+        }
+    }
+
+
+    /// Indicates if there are any positions stored in the object.
+    ///
+    /// @return <b>true</b> if there are positions.
+    ///
+    bool Empty() const { return m_positions.empty(); }
+
+    /// Returns the number of positions stored in the object.
+    ///
+    /// @return Number of positions.
+    ///
+    unsigned int Size() const { return static_cast<unsigned int>(m_positions.size()); }
+
+    /// Preallocates storage for the specified number of positions so
+    /// that a bulk add does not repeatedly grow the collection.
+    ///
+    /// @param count        [in] Number of positions to reserve space for.
+    ///
+    void Reserve(unsigned int count) { m_positions.reserve(count); }
+
+
+    /// Adds the specified position to the collection of positions.
+    ///
+    /// @param position     [in] Position to add to the collection.
+    ///
+    void Add(position_t* position) {
+        m_positions.push_back(position);
+        Index(position, -1);
+    }
+
+    /// Places the specified position at the specified location in
+    /// the collection.
+    ///
+    /// @param posIndex     [in] Zero based index indicating where in
+    ///                     the collection to place the position.
+    /// @param position     [in] Position object to insert in the collection.
+    ///
+    void Set(int posIndex, position_t* position) throw(std::out_of_range) {
+        if ((posIndex < 0) || (posIndex >= static_cast<int>(m_positions.size()))) {
+            throw new std::out_of_range("Positions::Set posIndex out of range");
+        }
+
+        // The index refers to the points of the replaced position, so it is
+        // updated before that position is disposed of.
+        //
+        Index(position, posIndex);
+        Dispose(m_positions[posIndex]);
+        m_positions[posIndex] = position;
+    }
+
+    /// Returns the position object at the specified location in the collection.
+    ///
+    /// @param posIndex     [in] Zero based index into the collection.
+    ///
+    /// @return Position object located at the specified location in the
+    ///         collection.
+    ///
+    position_t& Get(int posIndex) throw(std::out_of_range) {
+        if ((posIndex < 0) || (posIndex >= static_cast<int>(m_positions.size()))) {
+            throw new std::out_of_range("Positions::Get posIndex out of range");
+        }
+
+        return *m_positions[posIndex];
+    }
+
+    /// Removes the position object from the specified location in the
+    /// collection and destroys the object.
+    ///
+    /// @param posIndex     [in] Zero based index indicating where in
+    ///                     the collection to delete a position.
+    ///
+    void Delete(int posIndex) throw(std::out_of_range) { Delete(posIndex, 1); }
+
+    /// Removes a contiguous range of position objects from the
+    /// collection and destroys them. The positions following the
+    /// range are moved down in a single pass.
+    ///
+    /// @param posIndex     [in] Zero based index of the first position
+    ///                     to delete.
+    /// @param count        [in] Number of positions to delete.
+    ///
+    void Delete(int posIndex, int count) throw(std::out_of_range) {
+        if ((posIndex < 0) || (count < 0) ||
+                    (count > static_cast<int>(m_positions.size()) - posIndex)) {
+            throw new std::out_of_range("Positions::Delete posIndex out of range");
+        }
+
+        // The index refers to the points of the deleted positions, so it is
+        // updated before they are disposed of.
+        //
+        m_index.Delete(posIndex, count);
+
+        typename PositionList::iterator first = m_positions.begin() + posIndex;
+        typename PositionList::iterator last = first + count;
+
+        // Delete the position objects in the range.
+        //
+        for (typename PositionList::iterator iter = first; iter != last; ++iter) {
+            Dispose(*iter);
+        }
+
+        // Close the gap by moving the following positions "down".
+        //
+        m_positions.erase(first, last);
+    }
+
+    /// Removes all positions from the collection and destroys the
+    /// position objects.
+    ///
+    void DeleteAll() {
+        m_index.Clear();
+
+        typename PositionList::const_iterator iter;
+
+        for (iter = m_positions.begin(); iter != m_positions.end(); ++iter) {
+            Dispose(*iter);
+        }
+        m_positions.clear();
+    }
+
+
+    /// Copies the positions in the collection into the specified
+    /// snapshot. Until ReleaseSnapshot is called, positions replaced
+    /// or removed from the collection are retired rather than
+    /// destroyed so that the snapshot remains valid.
+    ///
+    /// @param snapshot     [out] Positions in index order.
+    ///
+    void TakeSnapshot(Snapshot& snapshot) {
+        snapshot.assign(m_positions.begin(), m_positions.end());
+        m_shared = true;
+    }
+
+    /// Destroys the positions retired while a snapshot was outstanding.
+    ///
+    void ReleaseSnapshot() {
+        typename PositionList::const_iterator iter;
+
+        for (iter = m_retired.begin(); iter != m_retired.end(); ++iter) {
+            delete *iter;
+        }
+        m_retired.clear();
+
+        m_shared = false;
+    }
+
+    /// Indicates whether a snapshot of the positions is outstanding.
+    ///
+    /// @return <b>true</b> if the positions are shared with a snapshot.
+    ///
+    bool IsShared() const { return m_shared; }
+
+    /// Returns the secondary indexes over the positions, which are
+    /// kept up to date as positions are added, replaced and deleted.
+    ///
+    /// @return Position indexes.
+    ///
+    const MeaPositionIndex& GetIndex() const { return m_index; }
+
+private:
+    typedef std::vector<position_t*> PositionList;      ///< Position objects in index order.
+
+    /// Purposely undefined.
+    MeaPositionStore_T(const MeaPositionStore_T&);
+
+    /// Purposely undefined.
+    MeaPositionStore_T& operator=(const MeaPositionStore_T&);
+
+    /// Destroys the specified position, or retires it if a snapshot
+    /// is outstanding.
+    ///
+    /// @param position     [in] Position removed from the collection.
+    ///
+    void Dispose(position_t* position) {
+        if (m_shared) {
+            m_retired.push_back(position);
+        } else {
+            delete position;
+        }
+    }
+
+    /// Adds the specified position to the indexes or replaces the
+    /// indexed position at the specified index.
+    ///
+    /// @param position     [in] Position to index.
+    /// @param posIndex     [in] Index of the position to replace, or -1
+    ///                     to add the position.
+    ///
+    void Index(const position_t* position, int posIndex) {
+        if (posIndex < 0) {
+            m_index.Add(position->GetToolName(), position->GetTimeStamp(), position->GetPointSet());
+        } else {
+            m_index.Replace(posIndex, position->GetToolName(), position->GetTimeStamp(), position->GetPointSet());
+        }
+    }
+
+    PositionList        m_positions;    ///< Collection of positions.
+    PositionList        m_retired;      ///< Positions removed while a snapshot is outstanding.
+    bool                m_shared;       ///< Is a snapshot of the positions outstanding.
+    MeaPositionIndex    m_index;        ///< Secondary indexes over the positions.
+};
@@ -92,3 +92,10 @@ void MeaRadioTool::SetPosition(const PointMap& /*points*/)
 void MeaRadioTool::OnMouseHook(WPARAM /* wParam */, LPARAM /* lParam */)
 {
 }
+
+
+const POINT& MeaRadioTool::FindPoint(const PointMap& points, LPCTSTR name, const POINT& defaultPoint)
+{
+    PointMap::const_iterator iter = points.find(name);
+    return (iter != points.end()) ? (*iter).second : defaultPoint;
+}
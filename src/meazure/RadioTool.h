@@ -143,6 +143,20 @@ public:
     ///
     virtual void GetPosition(MeaPositionLogMgr::Position& position) const = 0;
 
+    /// Records the position the tool would have if its crosshairs were
+    /// at the specified points, without moving the tool. This method is
+    /// called by the position log manager to record a batch of positions
+    /// at a high rate.
+    ///
+    /// @param points       [in] Map of positions for the tool's crosshairs,
+    ///                     as would be passed to SetPosition. Crosshairs
+    ///                     missing from the map are taken at their current
+    ///                     location.
+    /// @param position     [in] The position is recorded into the position
+    ///                     log manager's position object.
+    ///
+    virtual void GetPosition(const PointMap& points, MeaPositionLogMgr::Position& position) const = 0;
+
 
     /// Called by the OS when the mouse pointer is moved. This base class
     /// implementation does nothing.
@@ -151,5 +165,17 @@ public:
     /// @param lParam   [in] MOUSEHOOKSTRUCT
     ///
     virtual void OnMouseHook(WPARAM wParam, LPARAM lParam);
+
+protected:
+    /// Looks up the specified crosshair in a point map.
+    ///
+    /// @param points       [in] Map of positions for the tool's crosshairs.
+    /// @param name         [in] Name of the crosshair (e.g. "1", "v").
+    /// @param defaultPoint [in] Location to use if the crosshair is not in
+    ///                     the map.
+    ///
+    /// @return Location of the crosshair.
+    ///
+    static const POINT& FindPoint(const PointMap& points, LPCTSTR name, const POINT& defaultPoint);
 };
 
@@ -383,14 +383,29 @@ const POINT& MeaRectTool::GetPosition() const
 
 
 void MeaRectTool::GetPosition(MeaPositionLogMgr::Position& position) const
+{
+    RecordPosition(m_point1, m_point2, position);
+}
+
+
+void MeaRectTool::GetPosition(const PointMap& points, MeaPositionLogMgr::Position& position) const
+{
+    RecordPosition(FindPoint(points, _T("1"), m_point1),
+                   FindPoint(points, _T("2"), m_point2),
+                   position);
+}
+
+
+void MeaRectTool::RecordPosition(const POINT& point1, const POINT& point2,
+                                 MeaPositionLogMgr::Position& position)
 {
     MeaUnitsMgr& units = MeaUnitsMgr::Instance();
         
     // Convert the pixel locations to the current units.
     //
-    FPOINT p1 = units.ConvertCoord(m_point1);
-    FPOINT p2 = units.ConvertCoord(m_point2);
-    FSIZE wh = units.GetWidthHeight(m_point1, m_point2);
+    FPOINT p1 = units.ConvertCoord(point1);
+    FPOINT p2 = units.ConvertCoord(point2);
+    FSIZE wh = units.GetWidthHeight(point1, point2);
 
     // Save the positions in the position object.
     //
@@ -88,3 +88,38 @@ time_t MeaParseTimeStamp(const CString& timeStr)
     //
     return mktime(&tstruct);
 }
+
+
+bool MeaIsTimeStamp(const CString& timeStr)
+{
+    static const TCHAR pattern[] = _T("dddd-dd-ddTdd:dd:ddZ");
+    static const int daysInMonth[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    const int length = sizeof(pattern) / sizeof(pattern[0]) - 1;
+
+    if (timeStr.GetLength() != length) {
+        return false;
+    }
+    for (int i = 0; i < length; i++) {
+        TCHAR ch = timeStr[i];
+        if ((pattern[i] == _T('d')) ? !_istdigit(ch) : (ch != pattern[i])) {
+            return false;
+        }
+    }
+
+    int year, month, day, hour, minute, second;
+    if (_stscanf_s(timeStr, _T("%4d-%2d-%2dT%2d:%2d:%2dZ"),
+                   &year, &month, &day, &hour, &minute, &second) != 6) {
+        return false;
+    }
+
+    // The years are those supported by the boost date routines used by
+    // MeaParseTimeStamp.
+    //
+    if ((year < 1400) || (month < 1) || (month > 12) || (day < 1) || (day > daysInMonth[month - 1]) ||
+                (hour > 23) || (minute > 59) || (second > 59)) {
+        return false;
+    }
+
+    bool leap = ((year % 4) == 0) && (((year % 100) != 0) || ((year % 400) == 0));
+    return (month != 2) || (day <= 28) || leap;
+}
@@ -49,3 +49,17 @@ extern CString  MeaMakeTimeStamp(time_t t);
 ///         system time() function.
 ///
 extern time_t   MeaParseTimeStamp(const CString& timeStr);
+
+/// Determines whether the specified string is an ISO 8601 compliant
+/// time stamp in the format produced by MeaMakeTimeStamp and accepted by
+/// MeaParseTimeStamp:
+///
+/// yyyy-mm-ddThh:mm:ssZ
+///
+/// The date and time fields must be within their valid ranges.
+///
+/// @param timeStr  [in] String to test.
+///
+/// @return <b>true</b> if the string is a valid time stamp.
+///
+extern bool     MeaIsTimeStamp(const CString& timeStr);
@@ -313,6 +313,17 @@ public:
         m_currentRadioTool->GetPosition(position);
     }
 
+    /// Returns the position the current radio tool would have if its
+    /// crosshairs were at the specified points. The tool is not moved.
+    ///
+    /// @param points       [in] Map of positions for the tool's crosshairs.
+    /// @param position     [out] Position representing the location of
+    ///                     the current radio tool at the specified points.
+    ///
+    void    GetPosition(const MeaRadioTool::PointMap& points, MeaPositionLogMgr::Position& position) const {
+        m_currentRadioTool->GetPosition(points, position);
+    }
+
 
     /// Indicates if the current radio tool has a rectangular region
     /// that can be captured.
@@ -1317,22 +1317,28 @@ bool MeaCustomUnits::RequiresRes() const
 
 
 FSIZE MeaCustomUnits::FromPixels(const FSIZE& res) const
+{
+    return CalcFromPixels(m_scaleBasis, m_scaleFactor, res);
+}
+
+
+FSIZE MeaCustomUnits::CalcFromPixels(ScaleBasis scaleBasis, double scaleFactor, const FSIZE& res)
 {
     FSIZE fromPixels;
 
-    switch (m_scaleBasis) {
+    switch (scaleBasis) {
     default:
     case PixelBasis:
-        fromPixels.cx = 1.0 / m_scaleFactor;
-        fromPixels.cy = 1.0 / m_scaleFactor;
+        fromPixels.cx = 1.0 / scaleFactor;
+        fromPixels.cy = 1.0 / scaleFactor;
         break;
     case InchBasis:
-        fromPixels.cx = 1.0 / (res.cx * m_scaleFactor);
-        fromPixels.cy = 1.0 / (res.cy * m_scaleFactor);
+        fromPixels.cx = 1.0 / (res.cx * scaleFactor);
+        fromPixels.cy = 1.0 / (res.cy * scaleFactor);
         break;
     case CentimeterBasis:
-        fromPixels.cx = 2.54 / (res.cx * m_scaleFactor);
-        fromPixels.cy = 2.54 / (res.cy * m_scaleFactor);
+        fromPixels.cx = 2.54 / (res.cx * scaleFactor);
+        fromPixels.cy = 2.54 / (res.cy * scaleFactor);
         break;
     }
 
@@ -1374,12 +1380,22 @@ CString MeaCustomUnits::GetScaleBasisStr() const
 
 
 void MeaCustomUnits::SetScaleBasis(CString scaleBasisStr)
+{
+    ParseScaleBasis(scaleBasisStr, m_scaleBasis);
+}
+
+
+bool MeaCustomUnits::ParseScaleBasis(const CString& scaleBasisStr, ScaleBasis& scaleBasis)
 {
     if (scaleBasisStr == _T("px")) {
-        SetScaleBasis(PixelBasis);
+        scaleBasis = PixelBasis;
     } else if (scaleBasisStr == _T("in")) {
-        SetScaleBasis(InchBasis);
+        scaleBasis = InchBasis;
     } else if (scaleBasisStr == _T("cm")) {
-        SetScaleBasis(CentimeterBasis);
+        scaleBasis = CentimeterBasis;
+    } else {
+        return false;
     }
+
+    return true;
 }
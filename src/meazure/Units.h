@@ -411,6 +411,16 @@ public:
     CString Format(MeaLinearMeasurementId id, double value) const;
 
 
+    /// Returns the X and Y factors to convert from pixels to these units
+    /// on a screen with the specified resolution.
+    ///
+    /// @param res      [in] Screen resolution, in pixels/inch.
+    ///
+    /// @return X and Y conversion factors, in units/pixels.
+    ///
+    FSIZE   GetFromPixels(const FSIZE& res) const { return FromPixels(res); }
+
+
     /// Converts the specified coordinate from pixels to the desired units.
     /// This conversion takes into account the location of the origin and the
     /// orientation of the y-axis.
@@ -953,6 +963,17 @@ public:
     ///
     void        SetScaleBasis(CString scaleBasisStr);
 
+    /// Converts a conversion basis identifying string (e.g. "px") to the
+    /// conversion basis.
+    ///
+    /// @param scaleBasisStr    [in] Conversion basis as an identifying string.
+    /// @param scaleBasis       [out] Conversion basis. Not changed if the
+    ///                         string is not recognized.
+    ///
+    /// @return <b>true</b> if the string identifies a conversion basis.
+    ///
+    static bool ParseScaleBasis(const CString& scaleBasisStr, ScaleBasis& scaleBasis);
+
 
     /// Returns the conversion factor for the custom units.
     ///
@@ -968,6 +989,21 @@ public:
     ///
     void    SetScaleFactor(double scaleFactor) { m_scaleFactor = scaleFactor; }
 
+
+    /// Returns the X and Y factors to convert from pixels to custom units
+    /// with the specified conversion basis and factor. This allows custom
+    /// units other than the current custom units, such as those recorded
+    /// in a position log file, to be converted.
+    ///
+    /// @param scaleBasis   [in] Conversion basis.
+    /// @param scaleFactor  [in] Conversion factor from the conversion
+    ///                     basis to the custom units.
+    /// @param res          [in] Screen resolution, in pixels/inch.
+    ///
+    /// @return X and Y conversion factors, in custom units/pixels.
+    ///
+    static FSIZE CalcFromPixels(ScaleBasis scaleBasis, double scaleFactor, const FSIZE& res);
+
 protected:
     /// Returns the X and Y factors to convert from pixels to the
     /// custom units. In other words, multiplying the values returned
@@ -125,6 +125,18 @@ public:
     ///
     virtual void    GetPosition(MeaPositionLogMgr::Position& position) const;
 
+    /// Records the position the tool would have if its crosshairs were
+    /// at the specified points, without moving the tool. This method is
+    /// called by the position log manager to record a batch of positions.
+    ///
+    /// @param points       [in] Map of positions for the tool's crosshairs.
+    ///                     Crosshairs missing from the map are taken at
+    ///                     their current location.
+    /// @param position     [in] Position object into which the position
+    ///                     is recorded.
+    ///
+    virtual void    GetPosition(const PointMap& points, MeaPositionLogMgr::Position& position) const;
+
 
     /// Returns the name of the tool. Each tool has a unique name
     /// which is used to identify the tool in profiles and position
@@ -149,6 +161,16 @@ public:
     virtual void ColorsChanged();
 
 private:
+    /// Records the position of the tool with its crosshairs at the
+    /// specified locations.
+    ///
+    /// @param point1         [in] Top left corner of the window.
+    /// @param point2         [in] Bottom right corner of the window.
+    /// @param position       [in] Position object into which the position
+    ///                       is recorded.
+    ///
+    static void RecordPosition(const POINT& point1, const POINT& point2, MeaPositionLogMgr::Position& position);
+
     /// Called by the win32 EnumChildWindows function when it enumerates
     /// child windows. Also tests to see if the child window is under the
     /// cursor.
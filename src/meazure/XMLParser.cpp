@@ -20,7 +20,135 @@
 #include "StdAfx.h"
 #include "Resource.h"
 #include "XMLParser.h"
-#include <mbstring.h>
+#include <new>
+
+
+namespace
+{
+    /// Parses an integer from an XML string.
+    ///
+    /// @param str      [in] String to parse.
+    ///
+    /// @return Integer value of the string.
+    ///
+    inline int ParseInt(const XML_Char* str)
+    {
+#ifdef XML_UNICODE
+        return _wtoi(str);
+#else
+        return atoi(str);
+#endif
+    }
+
+    /// Parses a double from an XML string.
+    ///
+    /// @param str      [in] String to parse.
+    ///
+    /// @return Double value of the string.
+    ///
+    inline double ParseDouble(const XML_Char* str)
+    {
+#ifdef XML_UNICODE
+        return wcstod(str, NULL);
+#else
+        return strtod(str, NULL);
+#endif
+    }
+
+    /// Returns the length of an XML string.
+    ///
+    /// @param str      [in] String to measure.
+    ///
+    /// @return Number of characters in the string, not including the
+    ///         terminating NUL.
+    ///
+    inline size_t XMLStrLen(const XML_Char* str)
+    {
+        const XML_Char* end = str;
+        while (*end != 0) {
+            end++;
+        }
+        return end - str;
+    }
+
+    /// Compares an attribute name with a name in the ASCII character set.
+    ///
+    /// @param xmlName  [in] Attribute name provided by expat.
+    /// @param name     [in] Name consisting solely of ASCII characters.
+    ///
+    /// @return <b>true</b> if the names are the same.
+    ///
+    inline bool IsSameName(const XML_Char* xmlName, LPCTSTR name)
+    {
+        while (*name != 0 && static_cast<unsigned int>(*xmlName) == static_cast<unsigned int>(*name)) {
+            xmlName++;
+            name++;
+        }
+        return *xmlName == 0 && *name == 0;
+    }
+
+    /// Returns the number of characters at the start of a string that are
+    /// not XML markup characters.
+    ///
+    /// @param str      [in] String to examine.
+    ///
+    /// @return Number of characters preceeding the first markup character
+    ///         or the end of the string.
+    ///
+    inline int MarkupSpan(LPCTSTR str)
+    {
+#ifdef _UNICODE
+        return static_cast<int>(wcscspn(str, L"&<>'\""));
+#else
+        return static_cast<int>(strcspn(str, "&<>'\""));
+#endif
+    }
+
+    /// Indicates whether a string consists solely of ASCII characters, in
+    /// which case its characters are the same in UTF-8 and in the ACP.
+    ///
+    /// @param str      [in] String to test.
+    ///
+    /// @return <b>true</b> if the string only contains ASCII characters.
+    ///
+    inline bool IsAscii(LPCTSTR str)
+    {
+        for (; *str != 0; str++) {
+            if (static_cast<unsigned int>(*str) > 0x7F) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+
+//*************************************************************************
+// MeaXMLStringView
+//*************************************************************************
+
+
+bool MeaXMLStringView::operator==(LPCTSTR str) const
+{
+    MeaAssert(str != NULL);
+
+    if (!IsAscii(str)) {
+        return ToString() == str;
+    }
+
+    for (int i = 0; i < m_length; i++) {
+        if (str[i] == 0 || static_cast<unsigned int>(m_str[i]) != static_cast<unsigned int>(str[i])) {
+            return false;
+        }
+    }
+    return str[m_length] == 0;
+}
+
+
+CString MeaXMLStringView::ToString() const
+{
+    return MeaXMLParser::FromUTF8(m_str, m_length);
+}
 
 
 //*************************************************************************
@@ -28,26 +156,21 @@
 //*************************************************************************
 
 
-MeaXMLAttributes::MeaXMLAttributes()
+MeaXMLAttributes::MeaXMLAttributes() : m_attributes(m_inline), m_count(0)
 {
 }
 
-MeaXMLAttributes::MeaXMLAttributes(const XML_Char **atts, int numSpecified)
+
+MeaXMLAttributes::MeaXMLAttributes(const MeaXMLAttributes& attrs) : m_attributes(m_inline), m_count(0)
 {
-    MeaAssert(atts != NULL);
+    Assign(attrs);
+}
 
-    // Run through the atts and insert them in the map. Also mark
-    // which attributes are set by default versus  having been
-    // explicitly specified.
-    //
-    numSpecified *= 2;
-    for (int i = 0; atts[i] != NULL; i += 2) {
-        AttributeValue v;
 
-        v.value = MeaXMLParser::FromUTF8(atts[i+1]);
-        v.isDefault = (i >= numSpecified);
-        m_attributeMap[MeaXMLParser::FromUTF8(atts[i])] = v;
-    }
+MeaXMLAttributes::MeaXMLAttributes(const XML_Char **atts, int numSpecified) :
+    m_attributes(m_inline), m_count(0)
+{
+    Reset(atts, numSpecified);
 }
 
 
@@ -56,15 +179,40 @@ MeaXMLAttributes::~MeaXMLAttributes()
 }
 
 
+void MeaXMLAttributes::Reset(const XML_Char **atts, int numSpecified)
+{
+    MeaAssert(atts != NULL);
+
+    m_strings.clear();
+
+    int count = 0;
+    while (atts[count * 2] != NULL) {
+        count++;
+    }
+    Allocate(count);
+
+    // Point at the name and value strings in the atts. Also mark
+    // which attributes are set by default versus  having been
+    // explicitly specified.
+    //
+    for (int i = 0; i < count; i++) {
+        Attribute& attr = m_attributes[i];
+
+        attr.name = atts[i * 2];
+        attr.value = atts[i * 2 + 1];
+        attr.isDefault = (i >= numSpecified);
+        attr.parsed = 0;
+    }
+}
+
+
 bool MeaXMLAttributes::GetValueStr(LPCTSTR name, CString& value,
                                    bool& isDefault) const
 {
-    std::map<CString, AttributeValue>::const_iterator iter;
-    
-    iter = m_attributeMap.find(name);
-    if (iter != m_attributeMap.end()) {
-        value = (*iter).second.value;
-        isDefault = (*iter).second.isDefault;
+    const Attribute* attr = Find(name);
+    if (attr != NULL) {
+        value = MeaXMLParser::FromUTF8(attr->value);
+        isDefault = attr->isDefault;
         return true;
     }
     return false;
@@ -74,12 +222,14 @@ bool MeaXMLAttributes::GetValueStr(LPCTSTR name, CString& value,
 bool MeaXMLAttributes::GetValueInt(LPCTSTR name, int& value,
                                    bool& isDefault) const
 {
-    std::map<CString, AttributeValue>::const_iterator iter;
-    
-    iter = m_attributeMap.find(name);
-    if (iter != m_attributeMap.end()) {
-        value = _ttoi((*iter).second.value);
-        isDefault = (*iter).second.isDefault;
+    const Attribute* attr = Find(name);
+    if (attr != NULL) {
+        if ((attr->parsed & kIntParsed) == 0) {
+            attr->intValue = ParseInt(attr->value);
+            attr->parsed |= kIntParsed;
+        }
+        value = attr->intValue;
+        isDefault = attr->isDefault;
         return true;
     }
     return false;
@@ -89,12 +239,14 @@ bool MeaXMLAttributes::GetValueInt(LPCTSTR name, int& value,
 bool MeaXMLAttributes::GetValueDbl(LPCTSTR name, double& value,
                                    bool& isDefault) const
 {
-    std::map<CString, AttributeValue>::const_iterator iter;
-    
-    iter = m_attributeMap.find(name);
-    if (iter != m_attributeMap.end()) {
-        value = _tcstod((*iter).second.value, NULL);
-        isDefault = (*iter).second.isDefault;
+    const Attribute* attr = Find(name);
+    if (attr != NULL) {
+        if ((attr->parsed & kDblParsed) == 0) {
+            attr->dblValue = ParseDouble(attr->value);
+            attr->parsed |= kDblParsed;
+        }
+        value = attr->dblValue;
+        isDefault = attr->isDefault;
         return true;
     }
     return false;
@@ -104,13 +256,10 @@ bool MeaXMLAttributes::GetValueDbl(LPCTSTR name, double& value,
 bool MeaXMLAttributes::GetValueBool(LPCTSTR name, bool& value,
                                     bool& isDefault) const
 {
-    std::map<CString, AttributeValue>::const_iterator iter;
-    
-    iter = m_attributeMap.find(name);
-    if (iter != m_attributeMap.end()) {
-        CString vstr = (*iter).second.value;
-        value = (vstr == _T("true") || vstr == _T("1"));
-        isDefault = (*iter).second.isDefault;
+    const Attribute* attr = Find(name);
+    if (attr != NULL) {
+        value = IsSameName(attr->value, _T("true")) || IsSameName(attr->value, _T("1"));
+        isDefault = attr->isDefault;
         return true;
     }
     return false;
@@ -119,60 +268,197 @@ bool MeaXMLAttributes::GetValueBool(LPCTSTR name, bool& value,
 
 MeaXMLAttributes& MeaXMLAttributes::Assign(const MeaXMLAttributes& attrs)
 {
-    m_attributeMap = attrs.m_attributeMap;
+    if (&attrs == this) {
+        return *this;
+    }
+
+    // The copy owns its strings, so that it remains valid after the
+    // expat callback that provided the original has returned.
+    //
+    size_t length = 0;
+    for (int i = 0; i < attrs.m_count; i++) {
+        length += XMLStrLen(attrs.m_attributes[i].name) + XMLStrLen(attrs.m_attributes[i].value) + 2;
+    }
+
+    std::vector<XML_Char> strings(length);
+    XML_Char* next = strings.empty() ? NULL : &strings[0];
+
+    Allocate(attrs.m_count);
+
+    for (int i = 0; i < attrs.m_count; i++) {
+        const Attribute& src = attrs.m_attributes[i];
+        Attribute& dst = m_attributes[i];
+
+        dst = src;
+
+        size_t len = XMLStrLen(src.name) + 1;
+        memcpy(next, src.name, len * sizeof(XML_Char));
+        dst.name = next;
+        next += len;
+
+        len = XMLStrLen(src.value) + 1;
+        memcpy(next, src.value, len * sizeof(XML_Char));
+        dst.value = next;
+        next += len;
+    }
+
+    m_strings.swap(strings);
+
     return *this;
 }
 
 
+void MeaXMLAttributes::Allocate(int count)
+{
+    if (count > kInlineCount) {
+        m_overflow.resize(count);
+        m_attributes = &m_overflow[0];
+    } else {
+        m_overflow.clear();
+        m_attributes = m_inline;
+    }
+    m_count = count;
+}
+
+
+const MeaXMLAttributes::Attribute* MeaXMLAttributes::Find(LPCTSTR name) const
+{
+    MeaAssert(name != NULL);
+
+    if (IsAscii(name)) {
+        for (int i = 0; i < m_count; i++) {
+            if (IsSameName(m_attributes[i].name, name)) {
+                return &m_attributes[i];
+            }
+        }
+    } else {
+        for (int i = 0; i < m_count; i++) {
+            if (MeaXMLParser::FromUTF8(m_attributes[i].name) == name) {
+                return &m_attributes[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+
 //*************************************************************************
-// MeaXMLNode
+// MeaXMLArena
 //*************************************************************************
 
 
-MeaXMLNode::MeaXMLNode() : m_type(Unknown), m_parent(NULL)
+const size_t MeaXMLArena::kDefaultBlockSize = 64 * 1024;
+const size_t MeaXMLArena::kAlignment = 8;
+
+
+MeaXMLArena::MeaXMLArena(size_t blockSize) :
+    m_blockSize(blockSize),
+    m_reservedSize(0),
+    m_next(NULL),
+    m_end(NULL)
 {
 }
 
 
-MeaXMLNode::MeaXMLNode(const CString& elementName,
-                       const MeaXMLAttributes& attrs) : m_type(Element),
-                       m_data(elementName), m_attributes(attrs),
-                       m_parent(NULL)
+MeaXMLArena::~MeaXMLArena()
 {
+    try {
+        Clear();
+    }
+    catch(...) {
+        MeaAssert(false);
+    }
 }
 
 
-MeaXMLNode::MeaXMLNode(const CString& data) : m_type(Data), m_data(data),
-    m_parent(NULL)
+void* MeaXMLArena::Allocate(size_t size)
 {
+    size = (size + kAlignment - 1) & ~(kAlignment - 1);
+
+    if (size > static_cast<size_t>(m_end - m_next)) {
+        // Large allocations get a block of their own so that the
+        // remainder of the current block is not wasted.
+        //
+        if (size > m_blockSize / 4) {
+            return AllocateBlock(size);
+        }
+
+        m_next = AllocateBlock(m_blockSize);
+        m_end = m_next + m_blockSize;
+    }
+
+    void* mem = m_next;
+    m_next += size;
+    return mem;
 }
 
 
-MeaXMLNode::~MeaXMLNode()
+LPCTSTR MeaXMLArena::CopyString(LPCTSTR str, int len)
 {
-    try {
-        NodeList::const_iterator iter;
+    MeaAssert(len >= 0);
 
-        for (iter = m_children.begin(); iter != m_children.end(); ++iter) {
-            delete (*iter);
-        }
-        m_children.clear();
-    }
-    catch(...) {
-        MeaAssert(false);
+    TCHAR* copy = static_cast<TCHAR*>(Allocate((len + 1) * sizeof(TCHAR)));
+    memcpy(copy, str, len * sizeof(TCHAR));
+    copy[len] = _T('\0');
+    return copy;
+}
+
+
+void MeaXMLArena::Clear()
+{
+    for (BlockList::const_iterator iter = m_blocks.begin(); iter != m_blocks.end(); ++iter) {
+        delete [] (*iter);
     }
+    m_blocks.clear();
+
+    m_reservedSize = 0;
+    m_next = NULL;
+    m_end = NULL;
 }
 
 
-MeaXMLNode& MeaXMLNode::Assign(const MeaXMLNode& node)
+char* MeaXMLArena::AllocateBlock(size_t size)
 {
-    m_type          = node.m_type;
-    m_data          = node.m_data;
-    m_attributes    = node.m_attributes;
-    m_children      = node.m_children;
-    m_parent        = node.m_parent;
+    // Reserve the list entry first so that the block cannot leak.
+    //
+    m_blocks.reserve(m_blocks.size() + 1);
 
-    return *this;
+    char* block = new char[size];
+    m_blocks.push_back(block);
+    m_reservedSize += size;
+    return block;
+}
+
+
+//*************************************************************************
+// MeaXMLNode
+//*************************************************************************
+
+
+MeaXMLNode::MeaXMLNode(Type type, LPCTSTR data, int len) :
+    m_type(type),
+    m_data(data),
+    m_dataLength(len),
+    m_attributes(NULL),
+    m_attributeCount(0),
+    m_parent(NULL),
+    m_firstChild(NULL),
+    m_lastChild(NULL),
+    m_nextSibling(NULL)
+{
+}
+
+
+bool MeaXMLNode::GetAttributeValue(LPCTSTR name, LPCTSTR& value, bool& isDefault) const
+{
+    for (int i = 0; i < m_attributeCount; i++) {
+        if (_tcscmp(m_attributes[i].name, name) == 0) {
+            value = m_attributes[i].value;
+            isDefault = m_attributes[i].isDefault;
+            return true;
+        }
+    }
+    return false;
 }
 
 
@@ -197,9 +483,9 @@ void MeaXMLNode::Dump() const
         break;
     }
 
-    for (NodeIter_c iter = GetChildIter(); !AtEnd(iter); ++iter) {
+    for (const MeaXMLNode* child = GetFirstChild(); child != NULL; child = child->GetNextSibling()) {
         indent += 4;
-        (*iter)->Dump();
+        child->Dump();
         indent -= 4;
     }
 }
@@ -231,6 +517,28 @@ void MeaXMLParserHandler::CharacterDataHandler(const CString& /* container */,
 }
 
 
+void MeaXMLParserHandler::StartElementHandler(const MeaXMLStringView& container,
+                                              const MeaXMLStringView& elementName,
+                                              const MeaXMLAttributes& attrs)
+{
+    StartElementHandler(container.ToString(), elementName.ToString(), attrs);
+}
+
+
+void MeaXMLParserHandler::EndElementHandler(const MeaXMLStringView& container,
+                                            const MeaXMLStringView& elementName)
+{
+    EndElementHandler(container.ToString(), elementName.ToString());
+}
+
+
+void MeaXMLParserHandler::CharacterDataHandler(const MeaXMLStringView& container,
+                                               const MeaXMLStringView& data)
+{
+    CharacterDataHandler(container.ToString(), data.ToString());
+}
+
+
 void MeaXMLParserHandler::ParseEntity(MeaXMLParser& /*parser*/,
                                       const CString& /*pathname*/)
 {
@@ -243,21 +551,32 @@ CString MeaXMLParserHandler::GetFilePathname()
 }
 
 
+void MeaXMLParserHandler::ReportError(const CString& title, const CString& msg)
+{
+    MessageBox(*AfxGetMainWnd(), msg, title, MB_OK | MB_ICONERROR);
+}
+
+
 //*************************************************************************
 // MeaXMLParser
 //*************************************************************************
 
 
 LPCTSTR MeaXMLParser::m_homeURL = _T("http://www.cthing.com/");
+__declspec(thread) wchar_t MeaXMLParser::m_scratch[MeaXMLParser::kScratchSize];
+MeaXMLParser::GrammarMap MeaXMLParser::m_grammarCache;
+CCriticalSection MeaXMLParser::m_grammarCacheLock;
 
 
-MeaXMLParser::MeaXMLParser(MeaXMLParserHandler *handler, bool buildDOM) :
+MeaXMLParser::MeaXMLParser(MeaXMLParserHandler *handler, bool buildDOM,
+                           const XML_Memory_Handling_Suite* memsuite) :
     IValidationHandler(),
     m_isSubParser(false),
     m_handler(handler),
     m_haveDTD(false),
     m_context(NULL),
     m_buildDOM(buildDOM),
+    m_arena(NULL),
     m_dom(NULL)
 {
     // Create the XML parser and set its handlers.
@@ -265,8 +584,11 @@ MeaXMLParser::MeaXMLParser(MeaXMLParserHandler *handler, bool buildDOM) :
     m_pathnameStack = new PathnameStack;
     m_elementStack  = new ElementStack;
     m_nodeStack     = new NodeStack;
+    if (m_buildDOM) {
+        m_arena     = new MeaXMLArena;
+    }
     
-    m_parser = XML_ParserCreate(NULL);
+    m_parser = XML_ParserCreate_MM(NULL, memsuite, NULL);
     MeaAssert(m_parser != NULL);
 
     XML_SetUserData(m_parser, this);
@@ -280,6 +602,8 @@ MeaXMLParser::MeaXMLParser(MeaXMLParserHandler *handler, bool buildDOM) :
     XML_SetElementHandler(m_parser, StartElementHandler, EndElementHandler);
     XML_SetElementDeclHandler(m_parser, ElementDeclHandler);
     XML_SetAttlistDeclHandler(m_parser, AttributeDeclHandler);
+    XML_SetNotationDeclHandler(m_parser, NotationDeclHandler);
+    XML_SetEntityDeclHandler(m_parser, EntityDeclHandler);
 
     // Create the validator.
     //
@@ -297,6 +621,7 @@ MeaXMLParser::MeaXMLParser(const MeaXMLParser& parentParser) :
     m_haveDTD(parentParser.m_haveDTD),
     m_context(parentParser.m_context),
     m_buildDOM(parentParser.m_buildDOM),
+    m_arena(parentParser.m_arena),
     m_dom(parentParser.m_dom),
     m_nodeStack(parentParser.m_nodeStack)
 {
@@ -318,7 +643,7 @@ MeaXMLParser::~MeaXMLParser()
             delete m_pathnameStack;
             delete m_elementStack;
             delete m_nodeStack;
-            delete m_dom;
+            delete m_arena;
         }
     }
     catch(...) {
@@ -351,16 +676,16 @@ void MeaXMLParser::StartElementHandler(void *userData, const XML_Char *elementNa
         ps->m_validator->StartElement(ps->m_parser, elementName, attrs);
     }
 
-    MeaXMLAttributes attributes(attrs, XML_GetSpecifiedAttributeCount(ps->m_parser));
-    CString name(FromUTF8(elementName));
-    CString container;
-    if (!ps->m_elementStack->empty())
-        container = ps->m_elementStack->top();
-    ps->m_handler->StartElementHandler(container, name, attributes);
-    ps->m_elementStack->push(name);
+    // Expat reports the specified attributes as an index into the attrs
+    // array, which holds two entries (name and value) per attribute.
+    //
+    MeaXMLAttributes attributes(attrs, XML_GetSpecifiedAttributeCount(ps->m_parser) / 2);
+    MeaXMLStringView name(elementName, static_cast<int>(XMLStrLen(elementName)));
+    ps->m_handler->StartElementHandler(ps->m_elementStack->Top(), name, attributes);
+    ps->m_elementStack->Push(elementName);
 
     if (ps->m_buildDOM) {
-        MeaXMLNode* node = new MeaXMLNode(name, attributes);
+        MeaXMLNode* node = ps->CreateElementNode(name.ToString(), attributes);
         if (ps->m_nodeStack->empty()) {
             MeaAssert(ps->m_dom == NULL);
             ps->m_dom = node;
@@ -380,14 +705,10 @@ void MeaXMLParser::EndElementHandler(void *userData, const XML_Char *elementName
     if (ps->m_haveDTD)
         ps->m_validator->EndElement(ps->m_parser);
 
-    CString name(FromUTF8(elementName));
-    MeaAssert(!ps->m_elementStack->empty());
-    ps->m_elementStack->pop();
-    CString container;
-    if (!ps->m_elementStack->empty()) {
-        container = ps->m_elementStack->top();
-    }
-    ps->m_handler->EndElementHandler(container, name);
+    MeaXMLStringView name(elementName, static_cast<int>(XMLStrLen(elementName)));
+    MeaAssert(!ps->m_elementStack->IsEmpty());
+    ps->m_elementStack->Pop();
+    ps->m_handler->EndElementHandler(ps->m_elementStack->Top(), name);
 
     if (ps->m_buildDOM && !ps->m_nodeStack->empty()) {
         ps->m_nodeStack->pop();
@@ -402,16 +723,16 @@ void MeaXMLParser::CharacterDataHandler(void *userData, const XML_Char *s, int l
         ps->m_validator->CharacterData(ps->m_parser, s, len);
     }
     
-    CString container;
-    if (!ps->m_elementStack->empty()) {
-        container = ps->m_elementStack->top();
-    }
-    if (!container.IsEmpty() && ps->m_validator->IsMixed(container)) {
-        CString data(s, len);
+    // The names on the element stack are NUL terminated, so the
+    // container can be looked up directly.
+    //
+    MeaXMLStringView container(ps->m_elementStack->Top());
+    if (!container.IsEmpty() && ps->m_validator->IsMixed(container.GetData())) {
+        MeaXMLStringView data(s, len);
         ps->m_handler->CharacterDataHandler(container, data);
 
         if (ps->m_buildDOM && !ps->m_nodeStack->empty()) {
-            ps->m_nodeStack->top()->AddChild(new MeaXMLNode(data));
+            ps->m_nodeStack->top()->AddChild(ps->CreateNode(MeaXMLNode::Data, data.ToString()));
         }
     }
 }
@@ -435,6 +756,27 @@ int MeaXMLParser::ExternalEntityRefHandler(XML_Parser parser,
             sysId = CString(drive) + CString(dir) + sysId.Mid(_tcslen(MeaXMLParser::m_homeURL));
             sysId.Replace(_T('/'), _T('\\'));
 
+            // The external DTD subset (i.e. the entity without a context) is
+            // compiled once and shared by all parsers. The expat parser still
+            // parses the DTD to obtain the default attribute values, but the
+            // validator ignores the declarations when it uses a cached DTD.
+            // If the document has an internal DTD subset, its declarations
+            // are already in the validator and the DTD is compiled for this
+            // document alone.
+            //
+            CString grammarKey;
+            bool cacheGrammar = (context == NULL) && ps->m_validator->GetGrammar().IsEmpty() &&
+                                GetGrammarKey(FromUTF8(systemId), sysId, grammarKey);
+            bool haveGrammar = false;
+
+            if (cacheGrammar) {
+                ev::GrammarPtr grammar = FindGrammar(grammarKey);
+                if (grammar) {
+                    ps->m_validator->SetGrammar(grammar);
+                    haveGrammar = true;
+                }
+            }
+
             ps->m_pathnameStack->push(sysId);
 
             ps->m_context = context;
@@ -442,6 +784,10 @@ int MeaXMLParser::ExternalEntityRefHandler(XML_Parser parser,
             ps->m_context = NULL;
 
             ps->m_pathnameStack->pop();
+
+            if (cacheGrammar && !haveGrammar) {
+                AddGrammar(grammarKey, ps->m_validator->ShareGrammar());
+            }
         }
     }
 
@@ -485,6 +831,117 @@ void MeaXMLParser::AttributeDeclHandler(void *userData,
 }
 
 
+void MeaXMLParser::NotationDeclHandler(void *userData,
+                                       const XML_Char *notationName,
+                                       const XML_Char * /* base */,
+                                       const XML_Char * /* systemId */,
+                                       const XML_Char * /* publicId */)
+{
+    MeaXMLParser *ps = static_cast<MeaXMLParser*>(userData);
+    ps->m_validator->AddNotationDecl(notationName);
+}
+
+
+void MeaXMLParser::EntityDeclHandler(void *userData,
+                                     const XML_Char *entityName,
+                                     int is_parameter_entity,
+                                     const XML_Char * /* value */,
+                                     int /* value_length */,
+                                     const XML_Char * /* base */,
+                                     const XML_Char * /* systemId */,
+                                     const XML_Char * /* publicId */,
+                                     const XML_Char *notationName)
+{
+    // Only unparsed entities can be named by ENTITY attributes.
+    //
+    if (!is_parameter_entity && (notationName != NULL)) {
+        MeaXMLParser *ps = static_cast<MeaXMLParser*>(userData);
+        ps->m_validator->AddEntityDecl(entityName);
+    }
+}
+
+
+bool MeaXMLParser::GetGrammarKey(const CString& systemId, const CString& pathname, CString& key)
+{
+    CFile dtdFile;
+
+    if (!dtdFile.Open(pathname, CFile::modeRead | CFile::shareDenyWrite)) {
+        return false;
+    }
+
+    // 64 bit FNV-1a hash of the file contents.
+    //
+    ULONGLONG hash = 14695981039346656037ULL;
+    BYTE buf[4096];
+    UINT count;
+
+    while ((count = dtdFile.Read(buf, sizeof(buf))) > 0) {
+        for (UINT i = 0; i < count; i++) {
+            hash ^= buf[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    dtdFile.Close();
+
+    key.Format(_T("%s#%016I64x"), static_cast<LPCTSTR>(systemId), hash);
+    return true;
+}
+
+
+ev::GrammarPtr MeaXMLParser::FindGrammar(const CString& key)
+{
+    CSingleLock lock(&m_grammarCacheLock, TRUE);
+
+    GrammarMap::const_iterator iter = m_grammarCache.find(key);
+    return (iter == m_grammarCache.end()) ? ev::GrammarPtr() : (*iter).second;
+}
+
+
+void MeaXMLParser::AddGrammar(const CString& key, const ev::GrammarPtr& grammar)
+{
+    CSingleLock lock(&m_grammarCacheLock, TRUE);
+
+    m_grammarCache.insert(GrammarMap::value_type(key, grammar));
+}
+
+
+MeaXMLNode* MeaXMLParser::CreateNode(MeaXMLNode::Type type, const CString& data)
+{
+    MeaAssert(m_arena != NULL);
+
+    LPCTSTR str = m_arena->CopyString(data, data.GetLength());
+    return new (m_arena->Allocate(sizeof(MeaXMLNode))) MeaXMLNode(type, str, data.GetLength());
+}
+
+
+MeaXMLNode* MeaXMLParser::CreateElementNode(const CString& elementName, const MeaXMLAttributes& attrs)
+{
+    MeaXMLNode* node = CreateNode(MeaXMLNode::Element, elementName);
+
+    int count = attrs.m_count;
+    if (count > 0) {
+        MeaXMLNodeAttribute* nodeAttrs =
+            static_cast<MeaXMLNodeAttribute*>(m_arena->Allocate(count * sizeof(MeaXMLNodeAttribute)));
+
+        for (int i = 0; i < count; i++) {
+            const MeaXMLAttributes::Attribute& attr = attrs.m_attributes[i];
+            CString name(FromUTF8(attr.name));
+            CString value(FromUTF8(attr.value));
+
+            nodeAttrs[i].name = m_arena->CopyString(name, name.GetLength());
+            nodeAttrs[i].value = m_arena->CopyString(value, value.GetLength());
+            nodeAttrs[i].isDefault = attr.isDefault;
+        }
+
+        node->m_attributes = nodeAttrs;
+        node->m_attributeCount = count;
+    }
+
+    return node;
+}
+
+
 void MeaXMLParser::HandleParserError()
 {
     CString title(reinterpret_cast<LPCSTR>(IDS_MEA_PARSER_TITLE));
@@ -577,7 +1034,7 @@ void MeaXMLParser::HandleParserError()
         return;
     }
 
-    MessageBox(*AfxGetMainWnd(), msg + errorMsg, title, MB_OK | MB_ICONERROR);
+    m_handler->ReportError(title, msg + errorMsg);
 }
 
 
@@ -640,23 +1097,44 @@ void MeaXMLParser::HandleValidationError(const ev::ValidationError& error)
         break;
     }
 
-    MessageBox(*AfxGetMainWnd(), msg + errorMsg, title, MB_OK | MB_ICONERROR);
+    m_handler->ReportError(title, msg + errorMsg);
 
     throw MeaXMLParserException();
 }
 
 
 CString MeaXMLParser::FromUTF8(const XML_Char* str)
+{
+    return FromUTF8(str, static_cast<int>(XMLStrLen(str)));
+}
+
+
+CString MeaXMLParser::FromUTF8(const XML_Char* str, int len)
 {
 #ifdef XML_UNICODE
-    return str;
+    return CString(str, len);
 #else
-    int numChars = MultiByteToWideChar(CP_UTF8, 0, str, -1, NULL, 0);
-    wchar_t* buf = new wchar_t[numChars];
-    MultiByteToWideChar(CP_UTF8, 0, str, -1, buf, numChars);
-    CString buffer(buf);
-    delete [] buf;
-    return buffer;
+    // ASCII characters are the same in UTF-8 and the ACP.
+    //
+    int i = 0;
+    while (i < len && static_cast<unsigned char>(str[i]) < 0x80) {
+        i++;
+    }
+    if (i == len) {
+        return CString(str, len);
+    }
+
+    int numChars = MultiByteToWideChar(CP_UTF8, 0, str, len, NULL, 0);
+
+    std::vector<wchar_t> heapBuf;
+    wchar_t* buf = m_scratch;
+    if (numChars > kScratchSize) {
+        heapBuf.resize(numChars);
+        buf = &heapBuf[0];
+    }
+
+    MultiByteToWideChar(CP_UTF8, 0, str, len, buf, numChars);
+    return CString(buf, numChars);
 #endif /* XML_UNICODE */
 }
 
@@ -666,17 +1144,27 @@ CString MeaXMLParser::ToUTF8(const CString& str)
 #ifdef _UNICODE
     return str;
 #else
-    int numWChars = MultiByteToWideChar(CP_ACP, 0, str, -1, NULL, 0);
-    wchar_t* wbuf = new wchar_t[numWChars];
-    MultiByteToWideChar(CP_ACP, 0, str, -1, wbuf, numWChars);
+    if (IsAscii(str)) {
+        return str;
+    }
+
+    int len = str.GetLength();
+    int numWChars = MultiByteToWideChar(CP_ACP, 0, str, len, NULL, 0);
+
+    std::vector<wchar_t> heapBuf;
+    wchar_t* wbuf = m_scratch;
+    if (numWChars > kScratchSize) {
+        heapBuf.resize(numWChars);
+        wbuf = &heapBuf[0];
+    }
+
+    MultiByteToWideChar(CP_ACP, 0, str, len, wbuf, numWChars);
 
     CString buffer;
 
     int numMBChars = WideCharToMultiByte(CP_UTF8, 0, wbuf, numWChars, NULL, 0, NULL, NULL);
     WideCharToMultiByte(CP_UTF8, 0, wbuf, numWChars, buffer.GetBufferSetLength(numMBChars), numMBChars, NULL, NULL);
-    buffer.ReleaseBuffer();
-
-    delete [] wbuf;
+    buffer.ReleaseBuffer(numMBChars);
 
     return buffer;
 #endif
@@ -685,40 +1173,36 @@ CString MeaXMLParser::ToUTF8(const CString& str)
 
 CString MeaXMLParser::Encode(const CString& src)
 {
-    CString encStr;
+    LPCTSTR str = src;
+    int len = src.GetLength();
 
-#ifdef _UNICODE
-    for (int i = 0; i < src.GetLength(); i++) {
-        TCHAR ch = src.GetAt(i);
-        switch(ch) {
-        case _T('&'):
-            encStr += _T("&amp;");
-            break;
-        case _T('<'):
-            encStr += _T("&lt;");
-            break;
-        case _T('>'):
-            encStr += _T("&gt;");
-            break;
-        case _T('\''):
-            encStr += _T("&apos;");
-            break;
-        case _T('\"'):
-            encStr += _T("&quot;");
-            break;
-        default:
-            encStr += ch;
-            break;
-        }
+    // Most strings contain no markup, in which case the string is
+    // returned as is. The markup characters are all below 0x40, so they
+    // never occur as the trail byte of a double byte character and the
+    // string can be searched without regard to character boundaries.
+    //
+    int run = MarkupSpan(str);
+    if (run == len) {
+        return src;
     }
-#else
-    const unsigned char *str = reinterpret_cast<const unsigned char*>(static_cast<LPCTSTR>(src));
-    const unsigned char *sptr;
-    int len = _mbslen(str);
-    int i;
 
-    for (i = 0, sptr = str; i < len; i++, sptr = _mbsinc(sptr)) {
-        switch(*sptr) {
+    CString encStr;
+    encStr.Preallocate(len + len / 8 + 8);
+
+    int i = 0;
+    while (i < len) {
+        // Copy the run of characters preceeding the next markup
+        // character in one operation.
+        //
+        if (run > 0) {
+            encStr.Append(str + i, run);
+            i += run;
+            if (i == len) {
+                break;
+            }
+        }
+
+        switch (str[i]) {
         case _T('&'):
             encStr += _T("&amp;");
             break;
@@ -734,12 +1218,11 @@ CString MeaXMLParser::Encode(const CString& src)
         case _T('\"'):
             encStr += _T("&quot;");
             break;
-        default:
-            encStr += *sptr;
-            break;
         }
+        i++;
+
+        run = MarkupSpan(str + i);
     }
-#endif
 
     return encStr;
 }
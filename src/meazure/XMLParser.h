@@ -24,8 +24,10 @@
 
 #include "exval.h"
 #include "MeaAssert.h"
+#include "afxmt.h"
 #include <map>
 #include <stack>
+#include <vector>
 
 
 class MeaXMLParser;
@@ -38,23 +40,105 @@ class MeaXMLParserException
 };
 
 
+/// A view of a UTF-8 string provided by the expat parser, such as an
+/// element name or a chunk of character data. The view does not own the
+/// string and is only valid for the duration of the parser callback that
+/// provides it. The string need not be NUL terminated. Comparisons with
+/// ASCII strings, such as element names, are made without converting the
+/// string, so a CString is only created when ToString is called.
+///
+class MeaXMLStringView
+{
+public:
+    /// Constructs an empty view.
+    ///
+    MeaXMLStringView() : m_str(NULL), m_length(0) {}
+
+    /// Constructs a view of the specified string.
+    ///
+    /// @param str      [in] UTF-8 string.
+    /// @param len      [in] Length of the string, in characters.
+    ///
+    MeaXMLStringView(const XML_Char* str, int len) : m_str(str), m_length(len) {}
+
+
+    /// Returns the characters of the string.
+    /// @return Characters of the string. The string is not necessarily NUL terminated.
+    const XML_Char* GetData() const { return m_str; }
+
+    /// Returns the length of the string.
+    /// @return Number of characters in the string.
+    int             GetLength() const { return m_length; }
+
+    /// Indicates whether the string is empty.
+    /// @return <b>true</b> if the string has no characters.
+    bool            IsEmpty() const { return m_length == 0; }
+
+
+    /// Compares the string with the specified string.
+    ///
+    /// @param str      [in] String to compare, in ACP encoding.
+    ///
+    /// @return <b>true</b> if the strings are the same.
+    ///
+    bool operator==(LPCTSTR str) const;
+
+    /// Compares the string with the specified string.
+    ///
+    /// @param str      [in] String to compare, in ACP encoding.
+    ///
+    /// @return <b>true</b> if the strings differ.
+    ///
+    bool operator!=(LPCTSTR str) const { return !(*this == str); }
+
+
+    /// Converts the string to ACP encoding.
+    ///
+    /// @return String in ACP encoding.
+    ///
+    CString ToString() const;
+
+private:
+    const XML_Char* m_str;      ///< UTF-8 string, owned by the parser.
+    int             m_length;   ///< Length of the string, in characters.
+};
+
+
 /// The class contains the attributes associated with an XML start element.
 /// In addition to iterating through the attributes, the class provides
 /// searching and other attribute manipulation capabilities.
 ///
+/// Elements have only a few attributes, so the attributes are kept in a
+/// flat array that is searched linearly. The array is held within the
+/// object unless there are more than kInlineCount attributes. When the
+/// parser constructs the attributes for a start element, the names and
+/// values refer directly to the strings provided by expat and are valid
+/// only for the duration of the StartElementHandler callback. A copy of
+/// the attributes owns its strings. Numeric values are parsed on first
+/// request and cached.
+///
 class MeaXMLAttributes
 {
     friend class MeaXMLParser;
+    friend class MeaXMLReader;
 
 protected:
-    /// Represents an attribute value.
-    ///
-    struct AttributeValue {
-        CString value;      ///< The value of the attribute
-        bool    isDefault;  ///< <b>true</b> means that the value is set from the DTD default;
-                            ///< <b>false</b> means that the value explicitly specified in the XML file.
+    /// Represents an attribute.
+    ///
+    struct Attribute {
+        const XML_Char* name;       ///< Name of the attribute, in UTF-8.
+        const XML_Char* value;      ///< The value of the attribute, in UTF-8.
+        bool            isDefault;  ///< <b>true</b> means that the value is set from the DTD default;
+                                    ///< <b>false</b> means that the value explicitly specified in the XML file.
+        mutable UINT    parsed;     ///< Numeric values that have been parsed and cached (kIntParsed, kDblParsed).
+        mutable int     intValue;   ///< Cached integer value.
+        mutable double  dblValue;   ///< Cached double value.
     };
 
+    static const int  kInlineCount = 8;     ///< Number of attributes stored without a heap allocation.
+    static const UINT kIntParsed   = 0x1;   ///< The integer value of the attribute is cached.
+    static const UINT kDblParsed   = 0x2;   ///< The double value of the attribute is cached.
+
 public:
     /// Constructs an empty instance of the XML attributes class.
     ///
@@ -65,7 +149,7 @@ public:
     ///
     /// @param attrs    [in] XML attribute object instance to copy.
     ///
-    MeaXMLAttributes(const MeaXMLAttributes& attrs) { Assign(attrs); }
+    MeaXMLAttributes(const MeaXMLAttributes& attrs);
     
     /// Destroys an instance of the XML attributes class.
     ///
@@ -128,62 +212,161 @@ protected:
     ///                     In the array the name is followed by the value which
     ///                     is then followed by another name and so on until a
     ///                     NULL is encountered.
-    /// @param numSpecified [in] Number of attributes in the array that have been
-    ///                     explicitly specified versus set by default from the DTD.
-    ///                     The atts array is organized such that the explicitly
-    ///                     specified attributes come first.
+    /// @param numSpecified [in] Number of attributes (name/value pairs, not
+    ///                     array entries) that have been explicitly specified
+    ///                     versus set by default from the DTD. The atts array
+    ///                     is organized such that the explicitly specified
+    ///                     attributes come first.
     ///
     MeaXMLAttributes(const XML_Char **atts, int numSpecified);
-    
-    std::map<CString, AttributeValue>   m_attributeMap;     ///< Maps attribute names to their values.
+
+    /// Replaces the attributes with those provided by the expat parser.
+    /// The names and values refer directly to the strings in the array.
+    ///
+    /// @param atts         [in] Array of attribute name/value pairs (see the
+    ///                     constructor).
+    /// @param numSpecified [in] Number of attributes (name/value pairs) that
+    ///                     have been explicitly specified (see the constructor).
+    ///
+    void Reset(const XML_Char **atts, int numSpecified);
+
+    /// Sizes the attribute array to hold the specified number of
+    /// attributes.
+    ///
+    /// @param count        [in] Number of attributes.
+    ///
+    void Allocate(int count);
+
+    /// Searches for the specified attribute.
+    ///
+    /// @param name         [in] Attribute name.
+    ///
+    /// @return Attribute or NULL if the attribute is not found.
+    ///
+    const Attribute* Find(LPCTSTR name) const;
+
+    Attribute               m_inline[kInlineCount]; ///< Storage for elements with few attributes.
+    std::vector<Attribute>  m_overflow;             ///< Storage for elements with many attributes.
+    Attribute*              m_attributes;           ///< The attributes, either m_inline or m_overflow.
+    int                     m_count;                ///< Number of attributes.
+    std::vector<XML_Char>   m_strings;              ///< Names and values owned by a copy of the attributes.
 };
 
 
-/// A node in the XML DOM. The MeaXMLParser class can build a DOM
-/// from the parsed file. This is a very minimal DOM and does not
-/// conform to the W3C DOM spec.
+/// Bump allocator for the XML DOM. Memory is handed out sequentially
+/// from large blocks and is only released when the arena is destroyed or
+/// cleared, at which point the entire DOM is freed at once. Objects placed
+/// in the arena must not require their destructors to be run.
 ///
-class MeaXMLNode
+class MeaXMLArena
 {
 public:
-    typedef std::list<MeaXMLNode*>      NodeList;       ///< Represents a list of DOM nodes.
-    typedef NodeList::const_iterator    NodeIter_c;     ///< Constant iterator over the DOM nodes.
+    /// Constructs an empty arena. No memory is allocated until the first
+    /// call to Allocate.
+    ///
+    /// @param blockSize    [in] Size of each block of memory obtained from
+    ///                     the heap, in bytes.
+    ///
+    explicit MeaXMLArena(size_t blockSize = kDefaultBlockSize);
 
-    /// Indicates the type of the DOM node.
+    /// Destroys the arena and frees all memory allocated from it.
     ///
-    enum Type {
-        Unknown,        ///< Initial type for a DOM node.
-        Element,        ///< The node represents an XML element.
-        Data            ///< The node represents data contained between XML elements.
-    };
+    ~MeaXMLArena();
 
 
-    /// Constructs an empty DOM node of unknown type.
+    /// Allocates memory from the arena. The memory is suitably aligned for
+    /// any of the DOM types.
     ///
-    MeaXMLNode();
-    
-    /// Constructs a DOM node representing the specified element.
+    /// @param size     [in] Number of bytes to allocate.
     ///
-    /// @param elementName  [in] The node represents this element.
-    /// @param attrs        [in] Attributes associated with the element.
+    /// @return Pointer to the allocated memory. The memory is owned by the
+    ///         arena and must not be freed.
     ///
-    MeaXMLNode(const CString& elementName, const MeaXMLAttributes& attrs);
+    void*   Allocate(size_t size);
 
-    /// Constructs a DOM node representing the specified data.
+    /// Copies the specified string into the arena.
+    ///
+    /// @param str      [in] String to copy.
+    /// @param len      [in] Number of characters to copy, not including a
+    ///                 terminating NUL.
     ///
-    /// @param data     [in] Data for the node.
+    /// @return NUL terminated copy of the string.
     ///
-    explicit MeaXMLNode(const CString& data);
+    LPCTSTR CopyString(LPCTSTR str, int len);
 
-    /// Copy constructor.
+    /// Frees all memory allocated from the arena. Pointers previously
+    /// obtained from the arena are no longer valid.
     ///
-    /// @param node     [in] Node to copy.
+    void    Clear();
+
+    /// Returns the number of bytes obtained from the heap by the arena.
     ///
-    MeaXMLNode(const MeaXMLNode& node) { Assign(node); }
-    
-    /// Destroys a node.
+    /// @return Total size of the arena's blocks, in bytes.
     ///
-    virtual ~MeaXMLNode();
+    size_t  GetReservedSize() const { return m_reservedSize; }
+
+    static const size_t kDefaultBlockSize;  ///< Default size of an arena block, in bytes.
+
+private:
+    typedef std::vector<char*> BlockList;   ///< Blocks of memory obtained from the heap.
+
+    static const size_t kAlignment;         ///< Alignment of allocations, in bytes.
+
+    /// The arena has no copy semantics, so this constructor is purposely undefined.
+    MeaXMLArena(const MeaXMLArena&);
+
+    /// The arena has no assignment semantics, so this method is purposely undefined.
+    MeaXMLArena& operator=(const MeaXMLArena&);
+
+    /// Obtains a new block of memory from the heap.
+    ///
+    /// @param size     [in] Size of the block, in bytes.
+    ///
+    /// @return Pointer to the new block.
+    ///
+    char*   AllocateBlock(size_t size);
+
+    BlockList   m_blocks;       ///< Blocks obtained from the heap.
+    size_t      m_blockSize;    ///< Size of a standard block, in bytes.
+    size_t      m_reservedSize; ///< Total size of all blocks, in bytes.
+    char*       m_next;         ///< Next free byte in the current block.
+    char*       m_end;          ///< End of the current block.
+};
+
+
+/// An attribute of an element node in the XML DOM. The strings are
+/// allocated from the DOM's arena.
+///
+struct MeaXMLNodeAttribute
+{
+    LPCTSTR name;           ///< Name of the attribute.
+    LPCTSTR value;          ///< Value of the attribute.
+    bool    isDefault;      ///< <b>true</b> means that the value is set from the DTD default;
+                            ///< <b>false</b> means that the value explicitly specified in the XML file.
+};
+
+
+/// A node in the XML DOM. The MeaXMLParser class can build a DOM
+/// from the parsed file. This is a very minimal DOM and does not
+/// conform to the W3C DOM spec.
+///
+/// The nodes, their attributes and their strings are allocated from an
+/// arena owned by the parser, and the children of a node are linked
+/// through their siblings. The DOM is freed in one operation when the
+/// parser is destroyed.
+///
+class MeaXMLNode
+{
+    friend class MeaXMLParser;
+
+public:
+    /// Indicates the type of the DOM node.
+    ///
+    enum Type {
+        Unknown,        ///< Initial type for a DOM node.
+        Element,        ///< The node represents an XML element.
+        Data            ///< The node represents data contained between XML elements.
+    };
 
 
     /// Returns the type of the node.
@@ -199,54 +382,48 @@ public:
     /// <tr><td>Element</td><td>Element name</td></tr>
     /// <tr><td>Data</td><td>Data</td></tr>
     /// </table>
-    /// @return Data appropriate for the node.
+    /// @return Data appropriate for the node. The string is owned by the DOM.
     ///
-    const CString&  GetData() const { return m_data; }
+    LPCTSTR         GetData() const { return m_data; }
 
-    /// Returns the attributes associated with the node if it
-    /// is of type Element.
-    /// @return Attributes associated with the node.
-    const MeaXMLAttributes& GetAttributes() const { return m_attributes; }
-
-
-    /// Performs a deep copy assignment of the specified node to this.
-    /// @param node     [in] DOM node to assign to this.
-    /// @return this
-    MeaXMLNode& operator=(const MeaXMLNode& node) { return Assign(node); }
+    /// Returns the length of the data for the node.
+    /// @return Number of characters returned by GetData.
+    int             GetDataLength() const { return m_dataLength; }
 
 
-    /// Adds the specified DOM node as a child of this node.
-    ///
-    /// @param child        [in] Node to add as a child.
-    ///
-    void AddChild(MeaXMLNode* child) {
-        MeaAssert(child != NULL);
-        child->SetParent(this);
-        m_children.push_back(child);
+    /// Returns the number of attributes associated with the node if it
+    /// is of type Element.
+    /// @return Number of attributes.
+    int             GetAttributeCount() const { return m_attributeCount; }
+
+    /// Returns the specified attribute of the node.
+    /// @param index    [in] Index of the attribute, from 0 to GetAttributeCount() - 1.
+    /// @return Attribute of the node.
+    const MeaXMLNodeAttribute& GetAttribute(int index) const {
+        MeaAssert(index >= 0 && index < m_attributeCount);
+        return m_attributes[index];
     }
 
+    /// Returns the value of the specified attribute.
+    /// @param name         [in] Attribute name.
+    /// @param value        [out] Attribute value. The string is owned by the DOM.
+    /// @param isDefault    [out] <b>true</b> if the value is the DTD default.
+    /// @return <b>true</b> if the attribute is found.
+    bool            GetAttributeValue(LPCTSTR name, LPCTSTR& value, bool& isDefault) const;
 
-    /// Performs a deep copy assignment of the specified node to this.
-    /// @param node     [in] DOM node to assign to this.
-    /// @return this
-    MeaXMLNode& Assign(const MeaXMLNode& node);
 
+    /// Returns the parent of this node.
+    /// @return Parent node, or NULL if this is the root node.
+    const MeaXMLNode*   GetParent() const { return m_parent; }
 
-    /// Returns a constant iterator over the children of this node.
-    ///
-    /// @return Constant iterator over the children nodes.
-    ///
-    NodeIter_c  GetChildIter() const { return m_children.begin(); }
-    
-    /// Indicates whether the specified iterator has reached the end
-    /// of the list of children nodes.
-    ///
-    /// @param iter     [in] Constant iter to test.
-    ///
-    /// @return <b>true</b> if the iterator has reached the end of the
-    ///         list of children nodes.
-    ///
-    bool        AtEnd(const NodeIter_c& iter) const { return iter == m_children.end(); }
+    /// Returns the first child of this node. The remaining children
+    /// are obtained by calling GetNextSibling on each child in turn.
+    /// @return First child node, or NULL if the node has no children.
+    const MeaXMLNode*   GetFirstChild() const { return m_firstChild; }
+
+    /// Returns the next child of this node's parent.
+    /// @return Next sibling node, or NULL if this is the last child.
+    const MeaXMLNode*   GetNextSibling() const { return m_nextSibling; }
 
 #ifdef MEA_XMLNODE_DEBUG
     /// Dumps the state of the node to the debug output using TRACE
@@ -256,19 +433,50 @@ public:
 #endif
 
 private:
-    /// Sets the specified node as the parent for this node. This
-    /// allows moving up the node hierarchy to the root.
+    /// Constructs a DOM node of the specified type. Nodes are only
+    /// created by the parser, in its arena.
     ///
-    /// @param parent   [in] Node to set as the parent of this.
+    /// @param type     [in] Type of the node.
+    /// @param data     [in] Element name or character data, allocated
+    ///                 from the arena.
+    /// @param len      [in] Length of the data, in characters.
     ///
-    void SetParent(MeaXMLNode* parent) { m_parent = parent; }
+    MeaXMLNode(Type type, LPCTSTR data, int len);
+
+    /// Nodes are freed with their arena, so this destructor is purposely undefined.
+    ~MeaXMLNode();
+
+    /// Nodes are not copied, so this constructor is purposely undefined.
+    MeaXMLNode(const MeaXMLNode&);
+
+    /// Nodes are not assigned, so this method is purposely undefined.
+    MeaXMLNode& operator=(const MeaXMLNode&);
 
-    Type                m_type;         ///< Type for the node.
-    CString             m_data;         ///< Either empty, element name, or character data
-                                        ///< depending on the node type.
-    MeaXMLAttributes    m_attributes;   ///< Attributes associated with an element node.
-    NodeList            m_children;     ///< Children of this node.
-    MeaXMLNode*         m_parent;       ///< Parent of this node.
+    /// Adds the specified DOM node as the last child of this node.
+    ///
+    /// @param child        [in] Node to add as a child.
+    ///
+    void AddChild(MeaXMLNode* child) {
+        MeaAssert(child != NULL);
+        child->m_parent = this;
+        if (m_lastChild == NULL) {
+            m_firstChild = child;
+        } else {
+            m_lastChild->m_nextSibling = child;
+        }
+        m_lastChild = child;
+    }
+
+    Type                        m_type;             ///< Type for the node.
+    LPCTSTR                     m_data;             ///< Either empty, element name, or character data
+                                                    ///< depending on the node type.
+    int                         m_dataLength;       ///< Length of the data, in characters.
+    const MeaXMLNodeAttribute*  m_attributes;       ///< Attributes associated with an element node.
+    int                         m_attributeCount;   ///< Number of attributes.
+    MeaXMLNode*                 m_parent;           ///< Parent of this node.
+    MeaXMLNode*                 m_firstChild;       ///< First child of this node.
+    MeaXMLNode*                 m_lastChild;        ///< Last child of this node.
+    MeaXMLNode*                 m_nextSibling;      ///< Next child of this node's parent.
 };
 
 
@@ -322,6 +530,42 @@ public:
     virtual void CharacterDataHandler(const CString& container,
                                       const CString& data);
 
+    /// Called when a new element is opened, with views of the UTF-8
+    /// strings provided by the parser. A handler that compares element
+    /// names rather than storing them can override this method to avoid
+    /// converting the names. This class's implementation of this method
+    /// converts the strings and calls the CString version of the method.
+    ///
+    /// @param container    [in] Parent element.
+    /// @param elementName  [in] Name of the element being opened.
+    /// @param attrs        [in] Attributes associated with the element.
+    ///
+    virtual void StartElementHandler(const MeaXMLStringView& container,
+                                     const MeaXMLStringView& elementName,
+                                     const MeaXMLAttributes& attrs);
+
+    /// Called when an element is closed, with views of the UTF-8 strings
+    /// provided by the parser. This class's implementation of this method
+    /// converts the strings and calls the CString version of the method.
+    ///
+    /// @param container    [in] Parent element.
+    /// @param elementName  [in] Name of the element being closed.
+    ///
+    virtual void EndElementHandler(const MeaXMLStringView& container,
+                                   const MeaXMLStringView& elementName);
+
+    /// Called for the character data of elements with mixed content, with
+    /// views of the UTF-8 strings provided by the parser. This class's
+    /// implementation of this method converts the strings and calls the
+    /// CString version of the method.
+    ///
+    /// @param container    [in] Name of the closest open element containing
+    ///                     the character data.
+    /// @param data         [in] Character data.
+    ///
+    virtual void CharacterDataHandler(const MeaXMLStringView& container,
+                                      const MeaXMLStringView& data);
+
     /// Called to parse an external entity.
     ///
     /// @param parser   [in] Current XML parser.
@@ -336,6 +580,18 @@ public:
     ///         the empty string.
     ///
     virtual CString GetFilePathname();
+
+    /// Called to report a parsing or validation error. Parsing stops
+    /// once the error has been reported. This class's implementation
+    /// of this method displays the error in a message box. A handler
+    /// used on a worker thread should override this method to record
+    /// the error for later display.
+    ///
+    /// @param title    [in] Title describing the kind of error.
+    /// @param msg      [in] Description of the error, including the
+    ///                 pathname of the file and the error location.
+    ///
+    virtual void ReportError(const CString& title, const CString& msg);
 };
 
 
@@ -355,8 +611,12 @@ public:
     ///
     /// @param handler      [in] Callback object for parsing events.
     /// @param buildDOM     [in] Indicates whether a DOM should be built.
+    /// @param memsuite     [in] Functions expat uses to manage its memory,
+    ///                     or NULL to use the C runtime heap. External
+    ///                     entity sub-parsers use the same functions.
     ///
-    explicit MeaXMLParser(MeaXMLParserHandler *handler, bool buildDOM = false);
+    explicit MeaXMLParser(MeaXMLParserHandler *handler, bool buildDOM = false,
+                          const XML_Memory_Handling_Suite* memsuite = NULL);
     
     /// Creates an external entity parser. When an external is encountered,
     /// the MeaXMLParserHandler::ParseEntity method is called. This method
@@ -404,6 +664,8 @@ public:
 
 
     /// If a DOM was constructed, this method returns its root node.
+    /// The DOM is owned by the parser and is freed when the parser
+    /// is destroyed.
     ///
     /// @return Root node of the DOM or NULL if none was constructed.
     ///
@@ -419,6 +681,19 @@ public:
     ///
     static CString FromUTF8(const XML_Char* str);
 
+    /// Converts the specified number of characters from UTF8 encoding to
+    /// a string in ACP encoding. ASCII strings are copied without
+    /// conversion. Other strings are converted through a thread local
+    /// scratch buffer, so that short strings are converted without a
+    /// temporary heap allocation.
+    ///
+    /// @param str      [in] String in UTF-8 encoding.
+    /// @param len      [in] Number of characters to convert.
+    ///
+    /// @return String in ACP encoding.
+    ///
+    static CString FromUTF8(const XML_Char* str, int len);
+
     /// Convenience method for converting the specified string from
     /// ACP encoding to UTF-8 encoding.
     ///
@@ -442,9 +717,55 @@ public:
     static CString Encode(const CString& str);
 
 private:
-    typedef std::stack<CString>     ElementStack;       ///< A stack type for elements.
+    /// Stack of the names of the open elements. The NUL terminated UTF-8
+    /// names are stored one after another in a single buffer, so that opening an
+    /// element does not require a heap allocation once the buffer has
+    /// grown to the depth of the document.
+    ///
+    class ElementStack
+    {
+    public:
+        /// Indicates whether there are any open elements.
+        /// @return <b>true</b> if no elements are open.
+        bool IsEmpty() const { return m_starts.empty(); }
+
+        /// Adds the specified element to the top of the stack.
+        /// @param name     [in] Name of the element, in UTF-8.
+        void Push(const XML_Char* name) {
+            m_starts.push_back(m_names.size());
+            for (; *name != 0; name++) {
+                m_names.push_back(*name);
+            }
+            m_names.push_back(0);
+        }
+
+        /// Removes the element at the top of the stack.
+        void Pop() {
+            MeaAssert(!m_starts.empty());
+            m_names.resize(m_starts.back());
+            m_starts.pop_back();
+        }
+
+        /// Returns the name of the element at the top of the stack. The
+        /// view is valid until the stack is next changed.
+        /// @return Name of the innermost open element, or an empty view
+        ///         if there are no open elements.
+        MeaXMLStringView Top() const {
+            if (m_starts.empty()) {
+                return MeaXMLStringView();
+            }
+            size_t start = m_starts.back();
+            return MeaXMLStringView(&m_names[start], static_cast<int>(m_names.size() - start - 1));
+        }
+
+    private:
+        std::vector<XML_Char>   m_names;    ///< Names of the open elements.
+        std::vector<size_t>     m_starts;   ///< Start of each name in m_names.
+    };
+
     typedef std::stack<MeaXMLNode*> NodeStack;          ///< A stack type for DOM nodes.
     typedef std::stack<CString>     PathnameStack;      ///< A stack type for entity pathnames.
+    typedef std::map<CString, ev::GrammarPtr> GrammarMap;   ///< Compiled DTDs keyed by system identifier and content hash.
 
     /// The parser has not assignment semantics so this method is purposely undefined.
     MeaXMLParser& operator=(const MeaXMLParser&);
@@ -542,9 +863,95 @@ private:
                                      const XML_Char *dflt,
                                      int isrequired);
 
+    /// Called by the underlying expat parser when a DTD notation declaration
+    /// is encountered.
+    ///
+    /// @param userData     [in] this
+    /// @param notationName [in] Name of the notation being declared.
+    /// @param base         [in] Base for resolving the system identifier.
+    /// @param systemId     [in] System identifier of the notation, if any.
+    /// @param publicId     [in] Public identifier of the notation, if any.
+    ///
+    static void NotationDeclHandler(void *userData,
+                                    const XML_Char *notationName,
+                                    const XML_Char *base,
+                                    const XML_Char *systemId,
+                                    const XML_Char *publicId);
+
+    /// Called by the underlying expat parser when a DTD entity declaration is
+    /// encountered. Unparsed entities are registered with the validator so
+    /// that ENTITY and ENTITIES attributes can be checked.
+    ///
+    /// @param userData             [in] this
+    /// @param entityName           [in] Name of the entity being declared.
+    /// @param is_parameter_entity  [in] Non-zero for a parameter entity.
+    /// @param value                [in] Value of an internal entity, or NULL.
+    /// @param value_length         [in] Number of characters in the value.
+    /// @param base                 [in] Base for resolving the system identifier.
+    /// @param systemId             [in] System identifier of an external entity.
+    /// @param publicId             [in] Public identifier of an external entity.
+    /// @param notationName         [in] Notation of an unparsed entity, or NULL.
+    ///
+    static void EntityDeclHandler(void *userData,
+                                  const XML_Char *entityName,
+                                  int is_parameter_entity,
+                                  const XML_Char *value,
+                                  int value_length,
+                                  const XML_Char *base,
+                                  const XML_Char *systemId,
+                                  const XML_Char *publicId,
+                                  const XML_Char *notationName);
+
+    /// Forms the key identifying a compiled DTD in the DTD cache. The key
+    /// consists of the DTD's system identifier and a hash of the contents
+    /// of the DTD file, so that a DTD file that is changed is compiled again.
+    ///
+    /// @param systemId     [in] The XML system identifier for the DTD.
+    /// @param pathname     [in] Pathname of the DTD file.
+    /// @param key          [out] Cache key for the DTD.
+    ///
+    /// @return <b>true</b> if the key was formed, <b>false</b> if the DTD
+    ///         file could not be read.
+    ///
+    static bool GetGrammarKey(const CString& systemId, const CString& pathname, CString& key);
+
+    /// Looks up a compiled DTD in the process wide DTD cache.
+    ///
+    /// @param key          [in] Cache key for the DTD (see GetGrammarKey).
+    ///
+    /// @return The compiled DTD or an empty pointer if the DTD is not in the cache.
+    ///
+    static ev::GrammarPtr FindGrammar(const CString& key);
+
+    /// Adds a compiled DTD to the process wide DTD cache. If another parser
+    /// has already added a DTD with the same key, the cache is not changed.
+    ///
+    /// @param key          [in] Cache key for the DTD (see GetGrammarKey).
+    /// @param grammar      [in] Compiled DTD.
+    ///
+    static void AddGrammar(const CString& key, const ev::GrammarPtr& grammar);
+
+    /// Creates a DOM node in the parser's arena.
+    ///
+    /// @param type     [in] Type of the node.
+    /// @param data     [in] Element name or character data for the node.
+    ///
+    /// @return Newly created node.
+    ///
+    MeaXMLNode*  CreateNode(MeaXMLNode::Type type, const CString& data);
+
+    /// Creates a DOM node for an element in the parser's arena.
+    ///
+    /// @param elementName  [in] Name of the element.
+    /// @param attrs        [in] Attributes of the element.
+    ///
+    /// @return Newly created node.
+    ///
+    MeaXMLNode*  CreateElementNode(const CString& elementName, const MeaXMLAttributes& attrs);
+
     /// Called when an XML parsing error occurrs. Queries
-    /// the parser to determine the error and displays a dialog
-    /// with a description of the problem.
+    /// the parser to determine the error and reports a description
+    /// of the problem to the handler.
     ///
     void         HandleParserError();
     
@@ -554,7 +961,12 @@ private:
     ///
     virtual void HandleValidationError(const ev::ValidationError& error);
 
+    static const int kScratchSize = 512;        ///< Size of the UTF-8 conversion scratch buffer, in characters.
+
     static LPCTSTR          m_homeURL;          ///< URL for cthing.com
+    static __declspec(thread) wchar_t m_scratch[kScratchSize];  ///< Scratch buffer for UTF-8 conversions (thread local).
+    static GrammarMap       m_grammarCache;     ///< Compiled DTDs shared by all parsers in the process.
+    static CCriticalSection m_grammarCacheLock; ///< Guards the compiled DTD cache, which parsers on different threads use.
 
     XML_Parser              m_parser;           ///< The expat XML parser.
     bool                    m_isSubParser;      ///< Indicates whether this is an external entity sub-parser.
@@ -566,6 +978,7 @@ private:
     const XML_Char*         m_context;          ///< Internal expat parser state.
 
     bool                    m_buildDOM;         ///< Indicates whether a DOM is being built.
+    MeaXMLArena*            m_arena;            ///< Memory for the DOM, or NULL if a DOM is not being built.
     MeaXMLNode*             m_dom;              ///< Root node of the DOM being built, or NULL.
     NodeStack*              m_nodeStack;        ///< Stack of XML DOM nodes.
 };
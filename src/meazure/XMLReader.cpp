@@ -0,0 +1,315 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include "XMLReader.h"
+#include "MeaAssert.h"
+
+
+MeaXMLReader::MeaXMLReader(CFile& file, MeaXMLParserHandler* handler) :
+    MeaXMLParserHandler(),
+    m_parser(NULL),
+    m_handler(handler),
+    m_file(&file),
+    m_data(NULL),
+    m_size(0),
+    m_offset(0),
+    m_parsedAll(false),
+    m_nextEvent(0),
+    m_event(StartElement),
+    m_depth(0),
+    m_record(NULL),
+    m_haveAttributes(false)
+{
+    m_parser = new MeaXMLParser(this);
+}
+
+
+MeaXMLReader::MeaXMLReader(const void* data, size_t size, MeaXMLParserHandler* handler) :
+    MeaXMLParserHandler(),
+    m_parser(NULL),
+    m_handler(handler),
+    m_file(NULL),
+    m_data(static_cast<const BYTE*>(data)),
+    m_size(size),
+    m_offset(0),
+    m_parsedAll(false),
+    m_nextEvent(0),
+    m_event(StartElement),
+    m_depth(0),
+    m_record(NULL),
+    m_haveAttributes(false)
+{
+    MeaAssert(data != NULL || size == 0);
+
+    m_parser = new MeaXMLParser(this);
+}
+
+
+MeaXMLReader::~MeaXMLReader()
+{
+    try {
+        delete m_parser;
+    }
+    catch(...) {
+        MeaAssert(false);
+    }
+}
+
+
+MeaXMLReader::Event MeaXMLReader::Next()
+{
+    if (m_event == EndDocument) {
+        return EndDocument;
+    }
+
+    m_record = NULL;
+    m_name = MeaXMLStringView();
+    m_text = MeaXMLStringView();
+    m_haveAttributes = false;
+
+    while (m_nextEvent >= m_events.size()) {
+        if (m_parsedAll) {
+            m_event = EndDocument;
+            return m_event;
+        }
+        ParseChunk();
+    }
+
+    m_record = &m_events[m_nextEvent++];
+    m_event = m_record->event;
+
+    MeaXMLStringView str(&m_strings[m_record->str], m_record->length);
+
+    switch (m_event) {
+    case StartElement:
+        m_depth++;
+        m_name = str;
+        break;
+    case EndElement:
+        m_depth--;
+        m_name = str;
+        break;
+    case Text:
+        m_text = str;
+        break;
+    default:
+        MeaAssert(false);
+        break;
+    }
+
+    return m_event;
+}
+
+
+void MeaXMLReader::Skip()
+{
+    MeaAssert(m_event == StartElement);
+
+    int depth = m_depth - 1;
+
+    while (Next() != EndDocument) {
+        if (m_event == EndElement && m_depth == depth) {
+            break;
+        }
+    }
+}
+
+
+const MeaXMLAttributes& MeaXMLReader::GetAttributes() const
+{
+    if (!m_haveAttributes) {
+        m_attrPtrs.clear();
+
+        if (m_record != NULL && m_event == StartElement) {
+            for (int i = 0; i < m_record->attrCount * 2; i++) {
+                m_attrPtrs.push_back(&m_strings[m_attrs[m_record->firstAttr + i]]);
+            }
+        }
+        m_attrPtrs.push_back(NULL);
+
+        m_attributes.Reset(&m_attrPtrs[0], (m_record != NULL) ? m_record->numSpecified : 0);
+        m_haveAttributes = true;
+    }
+
+    return m_attributes;
+}
+
+
+void MeaXMLReader::StartElementHandler(const MeaXMLStringView& /* container */,
+                                       const MeaXMLStringView& elementName,
+                                       const MeaXMLAttributes& attrs)
+{
+    EventRecord record;
+
+    record.event = StartElement;
+    record.str = AddString(elementName.GetData(), elementName.GetLength());
+    record.length = elementName.GetLength();
+    record.firstAttr = m_attrs.size();
+    record.attrCount = attrs.m_count;
+    record.numSpecified = 0;
+
+    for (int i = 0; i < attrs.m_count; i++) {
+        const MeaXMLAttributes::Attribute& attr = attrs.m_attributes[i];
+
+        m_attrs.push_back(AddString(attr.name));
+        m_attrs.push_back(AddString(attr.value));
+        if (!attr.isDefault) {
+            record.numSpecified++;
+        }
+    }
+
+    m_events.push_back(record);
+}
+
+
+void MeaXMLReader::EndElementHandler(const MeaXMLStringView& /* container */,
+                                     const MeaXMLStringView& elementName)
+{
+    EventRecord record;
+
+    record.event = EndElement;
+    record.str = AddString(elementName.GetData(), elementName.GetLength());
+    record.length = elementName.GetLength();
+    record.firstAttr = 0;
+    record.attrCount = 0;
+    record.numSpecified = 0;
+
+    m_events.push_back(record);
+}
+
+
+void MeaXMLReader::CharacterDataHandler(const MeaXMLStringView& /* container */,
+                                        const MeaXMLStringView& data)
+{
+    // Character data is often delivered in several pieces. If the
+    // previous event is also character data, its string is the last one
+    // in the buffer, so the new data is appended to it.
+    //
+    if (!m_events.empty() && m_events.back().event == Text) {
+        EventRecord& record = m_events.back();
+
+        m_strings.pop_back();
+        m_strings.insert(m_strings.end(), data.GetData(), data.GetData() + data.GetLength());
+        m_strings.push_back(0);
+        record.length += data.GetLength();
+        return;
+    }
+
+    EventRecord record;
+
+    record.event = Text;
+    record.str = AddString(data.GetData(), data.GetLength());
+    record.length = data.GetLength();
+    record.firstAttr = 0;
+    record.attrCount = 0;
+    record.numSpecified = 0;
+
+    m_events.push_back(record);
+}
+
+
+void MeaXMLReader::ParseEntity(MeaXMLParser& parser, const CString& pathname)
+{
+    CFile entityFile;
+    CFileException fe;
+
+    if (!entityFile.Open(pathname, CFile::modeRead, &fe)) {
+        AfxThrowFileException(fe.m_cause, fe.m_lOsError, pathname);
+    }
+
+    MeaXMLParser entityParser(parser);
+
+    // Read the contents of the entity file into a parsing buffer.
+    //
+    int size = static_cast<int>(entityFile.GetLength());
+    void *buf = entityParser.GetBuffer(size);
+    UINT count = entityFile.Read(buf, size);
+
+    // Parse the entity file
+    //
+    entityParser.ParseBuffer(count, true);
+
+    entityFile.Close();
+}
+
+
+CString MeaXMLReader::GetFilePathname()
+{
+    return (m_handler != NULL) ? m_handler->GetFilePathname() : MeaXMLParserHandler::GetFilePathname();
+}
+
+
+void MeaXMLReader::ReportError(const CString& title, const CString& msg)
+{
+    if (m_handler != NULL) {
+        m_handler->ReportError(title, msg);
+    } else {
+        MeaXMLParserHandler::ReportError(title, msg);
+    }
+}
+
+
+void MeaXMLReader::ParseChunk()
+{
+    // The events of the previous chunk have all been reported, so their
+    // buffers are reused.
+    //
+    m_events.clear();
+    m_strings.clear();
+    m_attrs.clear();
+    m_nextEvent = 0;
+
+    void* buf = m_parser->GetBuffer(kChunkSize);
+    UINT count;
+
+    if (m_file != NULL) {
+        count = m_file->Read(buf, kChunkSize);
+    } else {
+        size_t remaining = m_size - m_offset;
+        count = (remaining < kChunkSize) ? static_cast<UINT>(remaining) : kChunkSize;
+        memcpy(buf, m_data + m_offset, count);
+        m_offset += count;
+    }
+
+    m_parsedAll = (count == 0);
+    m_parser->ParseBuffer(count, m_parsedAll);
+}
+
+
+size_t MeaXMLReader::AddString(const XML_Char* str, int len)
+{
+    size_t offset = m_strings.size();
+
+    m_strings.insert(m_strings.end(), str, str + len);
+    m_strings.push_back(0);
+    return offset;
+}
+
+
+size_t MeaXMLReader::AddString(const XML_Char* str)
+{
+    size_t offset = m_strings.size();
+
+    for (; *str != 0; str++) {
+        m_strings.push_back(*str);
+    }
+    m_strings.push_back(0);
+    return offset;
+}
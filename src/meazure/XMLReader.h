@@ -0,0 +1,276 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Header file for a pull style XML reader.
+
+#pragma once
+
+#include "XMLParser.h"
+#include <vector>
+
+
+/// Reads an XML document as a sequence of events that the caller pulls
+/// one at a time, rather than having the parser call back for each
+/// event. A loader can then be written as straight line code that walks
+/// the document and skips the elements it does not need.
+///
+/// The reader is layered on MeaXMLParser, so documents are validated
+/// against their DTD as usual. The document is fed to the parser in
+/// chunks as events are requested, either from a file or from a block of
+/// memory such as a memory mapped file. The events of each chunk are
+/// recorded in buffers that are reused for the following chunks, so no
+/// memory is allocated once the buffers have grown to the size needed by
+/// the document.
+///
+/// As with the MeaXMLParser callbacks, character data is only reported
+/// for elements with mixed content. Consecutive chunks of character data
+/// are reported as a single Text event where possible. For example:
+///
+/// @code
+///     MeaXMLReader reader(file);
+///
+///     while (reader.Next() != MeaXMLReader::EndDocument) {
+///         if (reader.GetEvent() != MeaXMLReader::StartElement) {
+///             continue;
+///         }
+///         if (reader.GetName() == _T("point")) {
+///             reader.GetAttributes().GetValueDbl(_T("x"), x, isDefault);
+///         } else if (reader.GetName() == _T("desc")) {
+///             reader.Skip();
+///         }
+///     }
+/// @endcode
+///
+class MeaXMLReader : public MeaXMLParserHandler
+{
+public:
+    /// Types of events reported by the reader.
+    ///
+    enum Event {
+        StartElement,   ///< An element has been opened.
+        EndElement,     ///< An element has been closed.
+        Text,           ///< Character data of an element with mixed content.
+        EndDocument     ///< The end of the document has been reached.
+    };
+
+
+    /// Constructs a reader for the XML document in the specified file.
+    /// The file is read in chunks as events are requested.
+    ///
+    /// @param file         [in] File open for reading. The file must remain
+    ///                     open for the life of the reader.
+    /// @param handler      [in] Handler used to report errors and to
+    ///                     provide the pathname of the document, or NULL to
+    ///                     use the MeaXMLParserHandler implementations.
+    ///
+    explicit MeaXMLReader(CFile& file, MeaXMLParserHandler* handler = NULL);
+
+    /// Constructs a reader for the XML document in the specified memory.
+    ///
+    /// @param data         [in] XML document. The memory must remain valid
+    ///                     for the life of the reader.
+    /// @param size         [in] Size of the document, in bytes.
+    /// @param handler      [in] Handler used to report errors and to
+    ///                     provide the pathname of the document, or NULL to
+    ///                     use the MeaXMLParserHandler implementations.
+    ///
+    MeaXMLReader(const void* data, size_t size, MeaXMLParserHandler* handler = NULL);
+
+    /// Destroys the reader.
+    ///
+    virtual ~MeaXMLReader();
+
+
+    /// Sets the base path for resolving relative external entities.
+    ///
+    /// @param path     [in] Base path.
+    ///
+    void    SetBasePath(const CString& path) { m_parser->SetBasePath(path); }
+
+
+    /// Advances to the next event in the document. The strings and
+    /// attributes of the previous event are no longer valid.
+    ///
+    /// @return Type of the event. Once EndDocument is returned, it is
+    ///         returned by all subsequent calls.
+    ///
+    /// @throw MeaXMLParserException if a parsing or validation error
+    ///         occurs. The error has been reported to the handler.
+    ///
+    Event   Next();
+
+    /// Skips the remainder of the element opened by the current
+    /// StartElement event, including all of its children. The current
+    /// event becomes the element's EndElement event.
+    ///
+    /// @throw MeaXMLParserException if a parsing or validation error
+    ///         occurs. The error has been reported to the handler.
+    ///
+    void    Skip();
+
+
+    /// Returns the type of the current event.
+    /// @return Type of the event returned by the last call to Next.
+    Event   GetEvent() const { return m_event; }
+
+    /// Returns the name of the element opened or closed by the current
+    /// event. The view is valid until the next call to Next.
+    /// @return Name of the element, or an empty view for a Text event.
+    const MeaXMLStringView& GetName() const { return m_name; }
+
+    /// Returns the character data of the current Text event. The view is
+    /// valid until the next call to Next.
+    /// @return Character data, or an empty view for other events.
+    const MeaXMLStringView& GetText() const { return m_text; }
+
+    /// Returns the attributes of the element opened by the current
+    /// StartElement event. The attributes are valid until the next call
+    /// to Next.
+    /// @return Attributes of the element. Empty for other events.
+    const MeaXMLAttributes& GetAttributes() const;
+
+    /// Returns the number of elements open at the current event. The
+    /// element opened by a StartElement event is included, and the
+    /// element closed by an EndElement event is not.
+    /// @return Depth of the current event in the document.
+    int     GetDepth() const { return m_depth; }
+
+
+    /// Called by the parser when an element is opened. Records the event.
+    ///
+    /// @param container    [in] Parent element.
+    /// @param elementName  [in] Name of the element being opened.
+    /// @param attrs        [in] Attributes associated with the element.
+    ///
+    virtual void StartElementHandler(const MeaXMLStringView& container,
+                                     const MeaXMLStringView& elementName,
+                                     const MeaXMLAttributes& attrs);
+
+    /// Called by the parser when an element is closed. Records the event.
+    ///
+    /// @param container    [in] Parent element.
+    /// @param elementName  [in] Name of the element being closed.
+    ///
+    virtual void EndElementHandler(const MeaXMLStringView& container,
+                                   const MeaXMLStringView& elementName);
+
+    /// Called by the parser with the character data of elements with
+    /// mixed content. Records the event.
+    ///
+    /// @param container    [in] Name of the element containing the data.
+    /// @param data         [in] Character data.
+    ///
+    virtual void CharacterDataHandler(const MeaXMLStringView& container,
+                                      const MeaXMLStringView& data);
+
+    /// Called by the parser to parse an external entity such as a DTD.
+    /// The entity file is read and parsed in its entirety.
+    ///
+    /// @param parser       [in] Current XML parser.
+    /// @param pathname     [in] Pathname of the external entity.
+    ///
+    virtual void ParseEntity(MeaXMLParser& parser, const CString& pathname);
+
+    /// Returns the pathname of the document, as provided by the handler.
+    ///
+    /// @return Pathname of the document being read.
+    ///
+    virtual CString GetFilePathname();
+
+    /// Reports a parsing or validation error to the handler.
+    ///
+    /// @param title    [in] Title describing the kind of error.
+    /// @param msg      [in] Description of the error.
+    ///
+    virtual void ReportError(const CString& title, const CString& msg);
+
+
+    static const UINT kChunkSize = 64 * 1024;   ///< Number of bytes parsed at a time.
+
+private:
+    /// An event recorded while parsing a chunk of the document. Strings
+    /// are recorded as offsets into the string buffer, which may be
+    /// reallocated while the chunk is parsed.
+    ///
+    struct EventRecord
+    {
+        Event   event;          ///< Type of the event.
+        size_t  str;            ///< Offset of the element name or character data.
+        int     length;         ///< Length of the element name or character data.
+        size_t  firstAttr;      ///< Index of the first attribute in the attribute list.
+        int     attrCount;      ///< Number of attributes.
+        int     numSpecified;   ///< Number of attributes explicitly specified in the document.
+    };
+
+    typedef std::vector<EventRecord> EventList;     ///< Events recorded for a chunk.
+
+
+    /// Purposely undefined.
+    MeaXMLReader(const MeaXMLReader&);
+
+    /// Purposely undefined.
+    MeaXMLReader& operator=(const MeaXMLReader&);
+
+
+    /// Parses the next chunk of the document, recording its events.
+    ///
+    void    ParseChunk();
+
+    /// Copies the specified string into the string buffer.
+    ///
+    /// @param str      [in] String to copy.
+    /// @param len      [in] Number of characters to copy.
+    ///
+    /// @return Offset of the string in the buffer.
+    ///
+    size_t  AddString(const XML_Char* str, int len);
+
+    /// Copies the specified NUL terminated string into the string buffer.
+    ///
+    /// @param str      [in] String to copy.
+    ///
+    /// @return Offset of the string in the buffer.
+    ///
+    size_t  AddString(const XML_Char* str);
+
+
+    MeaXMLParser*           m_parser;       ///< Parser feeding the reader.
+    MeaXMLParserHandler*    m_handler;      ///< Error and pathname handler, or NULL.
+    CFile*                  m_file;         ///< Document file, or NULL if reading from memory.
+    const BYTE*             m_data;         ///< Document in memory, or NULL if reading from a file.
+    size_t                  m_size;         ///< Size of the document in memory.
+    size_t                  m_offset;       ///< Offset of the next chunk of the document in memory.
+    bool                    m_parsedAll;    ///< Has the entire document been parsed.
+
+    EventList               m_events;       ///< Events recorded for the current chunk.
+    size_t                  m_nextEvent;    ///< Index of the next event to report.
+    std::vector<XML_Char>   m_strings;      ///< Names, character data and attributes of the recorded events.
+    std::vector<size_t>     m_attrs;        ///< Name and value offsets of the recorded attributes.
+
+    Event                   m_event;        ///< Current event.
+    MeaXMLStringView        m_name;         ///< Element name for the current event.
+    MeaXMLStringView        m_text;         ///< Character data for the current event.
+    int                     m_depth;        ///< Number of open elements.
+    const EventRecord*      m_record;       ///< Record of the current event, or NULL.
+
+    mutable std::vector<const XML_Char*>    m_attrPtrs;     ///< Attribute array for the current event.
+    mutable MeaXMLAttributes                m_attributes;   ///< Attributes for the current event.
+    mutable bool                            m_haveAttributes;   ///< Have the current attributes been set up.
+};
@@ -0,0 +1,408 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include "XMLWriter.h"
+#include "MeaAssert.h"
+#include <emmintrin.h>
+#include <intrin.h>
+
+
+namespace
+{
+    /// Indicates whether the specified character is replaced by an entity
+    /// reference when escaped.
+    ///
+    /// @param ch       [in] ASCII character to test.
+    ///
+    /// @return <b>true</b> if the character is markup.
+    ///
+    inline bool IsMarkup(UINT ch)
+    {
+        return (ch == '&') || (ch == '<') || (ch == '>') || (ch == '\'') || (ch == '"');
+    }
+
+    /// Returns the number of characters at the start of the specified
+    /// string that can be written without conversion, that is, ASCII
+    /// characters other than markup characters if the string is escaped.
+    /// In the multibyte build the string is examined 16 bytes at a time.
+    /// The markup characters are all below 0x40, so they never occur as
+    /// the trail byte of a double byte character and can be searched for
+    /// byte by byte.
+    ///
+    /// @param str      [in] String to examine.
+    /// @param len      [in] Number of characters in the string.
+    /// @param escape   [in] <b>true</b> if markup characters will be escaped.
+    ///
+    /// @return Number of characters that can be written as is.
+    ///
+    size_t PlainRunLength(LPCTSTR str, size_t len, bool escape)
+    {
+        size_t i = 0;
+
+#ifndef _UNICODE
+        const __m128i amp  = _mm_set1_epi8('&');
+        const __m128i lt   = _mm_set1_epi8('<');
+        const __m128i gt   = _mm_set1_epi8('>');
+        const __m128i apos = _mm_set1_epi8('\'');
+        const __m128i quot = _mm_set1_epi8('"');
+
+        for (; (i + 16) <= len; i += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+
+            // The sign bit of each byte marks a non-ASCII character.
+            //
+            int mask = _mm_movemask_epi8(chunk);
+            if (escape) {
+                __m128i markup = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_cmpeq_epi8(chunk, lt)),
+                                              _mm_or_si128(_mm_cmpeq_epi8(chunk, gt),
+                                                           _mm_or_si128(_mm_cmpeq_epi8(chunk, apos),
+                                                                        _mm_cmpeq_epi8(chunk, quot))));
+                mask |= _mm_movemask_epi8(markup);
+            }
+
+            if (mask != 0) {
+                unsigned long index;
+                _BitScanForward(&index, static_cast<unsigned long>(mask));
+                return i + index;
+            }
+        }
+#endif
+
+        for (; i < len; i++) {
+            UINT ch = static_cast<_TUCHAR>(str[i]);
+            if ((ch >= 0x80) || (escape && IsMarkup(ch))) {
+                break;
+            }
+        }
+        return i;
+    }
+}
+
+
+MeaXMLWriter::MeaXMLWriter(CFile& file, int bufferSize) :
+    m_file(file),
+    m_buffer(bufferSize),
+    m_used(0),
+    m_flushed(0),
+    m_startTagOpen(false)
+{
+    MeaAssert(bufferSize > 0);
+}
+
+
+MeaXMLWriter::~MeaXMLWriter()
+{
+    try {
+        Flush();
+    }
+    catch(...) {
+        MeaAssert(false);
+    }
+}
+
+
+void MeaXMLWriter::Declaration(bool standalone)
+{
+    static const char decl[] = "<?xml version=\"1.0\" encoding=\"UTF-8\"";
+    static const char standaloneDecl[] = " standalone=\"yes\"";
+
+    Put(decl, sizeof(decl) - 1);
+    if (standalone) {
+        Put(standaloneDecl, sizeof(standaloneDecl) - 1);
+    }
+    Put("?>\n", 3);
+}
+
+
+void MeaXMLWriter::Doctype(LPCTSTR rootName, LPCTSTR systemId)
+{
+    Put("<!DOCTYPE ", 10);
+    PutString(rootName, false);
+    Put(" SYSTEM \"", 9);
+    PutString(systemId, true);
+    Put("\">\n", 3);
+}
+
+
+void MeaXMLWriter::StartElement(LPCTSTR name)
+{
+    CloseStartTag();
+
+    if (!m_elements.empty()) {
+        m_elements.back().hasChildren = true;
+    }
+
+    PutIndent(m_elements.size());
+    Put('<');
+
+    size_t start = m_used;
+    ULONGLONG flushed = m_flushed;
+    PutString(name, false);
+
+    // Keep the UTF-8 form of the name for the end tag. It is normally
+    // still in the buffer, otherwise it is converted again.
+    //
+    m_elements.push_back(Element());
+    Element& element = m_elements.back();
+    if (m_flushed == flushed) {
+        element.name.assign(&m_buffer[start], m_used - start);
+    } else {
+        element.name = CW2A(CStringW(name), CP_UTF8);
+    }
+    element.hasChildren = false;
+
+    m_startTagOpen = true;
+}
+
+
+void MeaXMLWriter::Attribute(LPCTSTR name, LPCTSTR value)
+{
+    PutAttributeName(name);
+    PutString(value, true);
+    Put('"');
+}
+
+
+void MeaXMLWriter::Attribute(LPCTSTR name, int value)
+{
+    char numStr[16];
+
+    _itoa_s(value, numStr, sizeof(numStr), 10);
+
+    PutAttributeName(name);
+    Put(numStr, strlen(numStr));
+    Put('"');
+}
+
+
+void MeaXMLWriter::Attribute(LPCTSTR name, double value)
+{
+    char numStr[_CVTBUFSIZE];
+
+    int len = _snprintf_s(numStr, sizeof(numStr), _TRUNCATE, "%.15f", value);
+    if (len < 0) {
+        len = static_cast<int>(strlen(numStr));
+    }
+
+    // Remove trailing zeros, keeping at least one digit after the
+    // decimal point.
+    //
+    while ((len > 1) && (numStr[len - 1] == '0') && (numStr[len - 2] != '.')) {
+        len--;
+    }
+
+    PutAttributeName(name);
+    Put(numStr, len);
+    Put('"');
+}
+
+
+void MeaXMLWriter::Attribute(LPCTSTR name, bool value)
+{
+    PutAttributeName(name);
+    if (value) {
+        Put("true\"", 5);
+    } else {
+        Put("false\"", 6);
+    }
+}
+
+
+void MeaXMLWriter::Text(LPCTSTR text)
+{
+    MeaAssert(!m_elements.empty());
+
+    if (m_startTagOpen) {
+        Put('>');
+        m_startTagOpen = false;
+    }
+    PutString(text, true);
+}
+
+
+void MeaXMLWriter::EndElement()
+{
+    MeaAssert(!m_elements.empty());
+
+    const Element& element = m_elements.back();
+
+    if (m_startTagOpen) {
+        Put("/>\n", 3);
+        m_startTagOpen = false;
+    } else {
+        if (element.hasChildren) {
+            PutIndent(m_elements.size() - 1);
+        }
+        Put("</", 2);
+        Put(element.name.c_str(), element.name.size());
+        Put(">\n", 2);
+    }
+
+    m_elements.pop_back();
+}
+
+
+void MeaXMLWriter::Flush()
+{
+    if (m_used > 0) {
+        m_file.Write(&m_buffer[0], static_cast<UINT>(m_used));
+        m_flushed += m_used;
+        m_used = 0;
+    }
+}
+
+
+void MeaXMLWriter::CloseStartTag()
+{
+    if (m_startTagOpen) {
+        Put(">\n", 2);
+        m_startTagOpen = false;
+    }
+}
+
+
+void MeaXMLWriter::PutIndent(size_t depth)
+{
+    static const char spaces[] = "                                ";
+    size_t count = depth * kIndentSize;
+
+    while (count > 0) {
+        size_t n = (count < sizeof(spaces) - 1) ? count : sizeof(spaces) - 1;
+        Put(spaces, n);
+        count -= n;
+    }
+}
+
+
+void MeaXMLWriter::PutSlow(const char* bytes, size_t count)
+{
+    Flush();
+
+    if (count > m_buffer.size()) {
+        m_file.Write(bytes, static_cast<UINT>(count));
+        m_flushed += count;
+    } else {
+        memcpy(&m_buffer[0], bytes, count);
+        m_used = count;
+    }
+}
+
+
+void MeaXMLWriter::PutString(LPCTSTR str, bool escape)
+{
+    if (str == NULL) {
+        return;
+    }
+
+    size_t len = _tcslen(str);
+    size_t i = 0;
+
+    while (i < len) {
+        // Copy the run of characters that need neither escaping nor
+        // conversion straight into the buffer.
+        //
+        size_t run = PlainRunLength(str + i, len - i, escape);
+        if (run > 0) {
+#ifdef _UNICODE
+            for (size_t j = 0; j < run; j++) {
+                Put(static_cast<char>(str[i + j]));
+            }
+#else
+            Put(str + i, run);
+#endif
+            i += run;
+            if (i == len) {
+                break;
+            }
+        }
+
+        UINT ch = static_cast<_TUCHAR>(str[i]);
+
+        if (ch < 0x80) {
+            switch (ch) {
+            case '&':   Put("&amp;", 5);    break;
+            case '<':   Put("&lt;", 4);     break;
+            case '>':   Put("&gt;", 4);     break;
+            case '\'':  Put("&apos;", 6);   break;
+            case '"':   Put("&quot;", 6);   break;
+            default:    Put(static_cast<char>(ch)); break;
+            }
+            i++;
+            continue;
+        }
+
+#ifdef _UNICODE
+        // Combine a surrogate pair into a single code point.
+        //
+        if ((ch >= 0xD800) && (ch <= 0xDBFF) && (str[i + 1] >= 0xDC00) && (str[i + 1] <= 0xDFFF)) {
+            ch = 0x10000 + ((ch - 0xD800) << 10) + (static_cast<UINT>(str[i + 1]) - 0xDC00);
+            i++;
+        }
+        i++;
+        PutCodePoint(ch);
+#else
+        // Convert one ACP character, which may be a double byte
+        // character, to UTF-16 and then to UTF-8.
+        //
+        int charLen = (IsDBCSLeadByte(static_cast<BYTE>(ch)) && (str[i + 1] != '\0')) ? 2 : 1;
+        WCHAR wide[2];
+        int wideLen = MultiByteToWideChar(CP_ACP, 0, str + i, charLen, wide, 2);
+        for (int j = 0; j < wideLen; j++) {
+            PutCodePoint(wide[j]);
+        }
+        i += charLen;
+#endif
+    }
+}
+
+
+void MeaXMLWriter::PutCodePoint(UINT cp)
+{
+    char bytes[4];
+
+    if (cp < 0x80) {
+        Put(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        bytes[0] = static_cast<char>(0xC0 | (cp >> 6));
+        bytes[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        Put(bytes, 2);
+    } else if (cp < 0x10000) {
+        bytes[0] = static_cast<char>(0xE0 | (cp >> 12));
+        bytes[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        bytes[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        Put(bytes, 3);
+    } else {
+        bytes[0] = static_cast<char>(0xF0 | (cp >> 18));
+        bytes[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        bytes[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        bytes[3] = static_cast<char>(0x80 | (cp & 0x3F));
+        Put(bytes, 4);
+    }
+}
+
+
+void MeaXMLWriter::PutAttributeName(LPCTSTR name)
+{
+    MeaAssert(m_startTagOpen);
+
+    Put(' ');
+    PutString(name, false);
+    Put("=\"", 2);
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright 2001, 2004, 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Header file for a buffered UTF-8 XML file writer.
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+
+/// Writes an indented XML document to a file in UTF-8 encoding. Output
+/// is accumulated in a large buffer and written to the file in blocks.
+/// Strings are escaped and converted to UTF-8 directly into the buffer,
+/// and numbers are formatted without creating intermediate strings.
+///
+/// Elements are written using StartElement, Attribute, Text and
+/// EndElement. An element with no content is written as an empty element
+/// tag. An element containing text is written on a single line. An element
+/// containing other elements has its start and end tags on separate lines
+/// with the children indented between them. For example:
+///
+/// @code
+///     writer.StartElement(_T("info"));
+///         writer.StartElement(_T("title"));
+///         writer.Text(title);
+///         writer.EndElement();
+///         writer.StartElement(_T("created"));
+///         writer.Attribute(_T("date"), timestamp);
+///         writer.EndElement();
+///     writer.EndElement();
+/// @endcode
+///
+/// produces:
+///
+/// @code
+///     <info>
+///         <title>My Title</title>
+///         <created date="2011-01-01T00:00:00Z"/>
+///     </info>
+/// @endcode
+///
+class MeaXMLWriter
+{
+public:
+    /// Constructs a writer that outputs to the specified file.
+    ///
+    /// @param file         [in] File open for writing. The file must
+    ///                     remain open for the life of the writer.
+    /// @param bufferSize   [in] Size of the output buffer, in bytes.
+    ///
+    explicit MeaXMLWriter(CFile& file, int bufferSize = kDefaultBufferSize);
+
+    /// Flushes any buffered output and destroys the writer.
+    ///
+    ~MeaXMLWriter();
+
+
+    /// Writes the XML declaration.
+    ///
+    /// @param standalone   [in] <b>true</b> to declare the document standalone.
+    ///
+    void    Declaration(bool standalone = false);
+
+    /// Writes a document type declaration referencing an external DTD.
+    ///
+    /// @param rootName     [in] Name of the root element.
+    /// @param systemId     [in] System identifier of the DTD.
+    ///
+    void    Doctype(LPCTSTR rootName, LPCTSTR systemId);
+
+
+    /// Starts a new element as a child of the current element.
+    ///
+    /// @param name         [in] Element name.
+    ///
+    void    StartElement(LPCTSTR name);
+
+    /// Adds an attribute to the element just started. Must be called
+    /// before any content is added to the element.
+    ///
+    /// @param name         [in] Attribute name.
+    /// @param value        [in] Attribute value. It is escaped as needed.
+    ///
+    void    Attribute(LPCTSTR name, LPCTSTR value);
+
+    /// Adds an integer valued attribute to the element just started.
+    ///
+    /// @param name         [in] Attribute name.
+    /// @param value        [in] Attribute value.
+    ///
+    void    Attribute(LPCTSTR name, int value);
+
+    /// Adds a floating point valued attribute to the element just started.
+    /// The value is formatted with 15 decimal places with trailing zeros
+    /// removed, as MeaUtils::DblToStr does.
+    ///
+    /// @param name         [in] Attribute name.
+    /// @param value        [in] Attribute value.
+    ///
+    void    Attribute(LPCTSTR name, double value);
+
+    /// Adds a boolean valued attribute to the element just started. The
+    /// value is written as "true" or "false".
+    ///
+    /// @param name         [in] Attribute name.
+    /// @param value        [in] Attribute value.
+    ///
+    void    Attribute(LPCTSTR name, bool value);
+
+    /// Adds character data to the current element.
+    ///
+    /// @param text         [in] Text to add. It is escaped as needed.
+    ///
+    void    Text(LPCTSTR text);
+
+    /// Ends the current element.
+    ///
+    void    EndElement();
+
+
+    /// Writes any buffered output to the file.
+    ///
+    void    Flush();
+
+    /// Returns the number of bytes output so far, including those still
+    /// in the buffer.
+    ///
+    /// @return Number of bytes output.
+    ///
+    ULONGLONG   GetBytesWritten() const { return m_flushed + m_used; }
+
+
+    static const int kDefaultBufferSize = 64 * 1024;    ///< Default output buffer size, in bytes.
+    static const int kIndentSize = 4;                   ///< Number of spaces per indentation level.
+
+private:
+    /// Tracks the state of an element that has been started but not ended.
+    ///
+    struct Element
+    {
+        std::string name;           ///< Element name, in UTF-8.
+        bool        hasChildren;    ///< Has a child element been written.
+    };
+
+    typedef std::vector<Element> ElementStack;      ///< Elements that have been started but not ended.
+
+
+    /// Purposely undefined.
+    MeaXMLWriter(const MeaXMLWriter&);
+
+    /// Purposely undefined.
+    MeaXMLWriter& operator=(const MeaXMLWriter&);
+
+
+    /// Closes the start tag of the current element, if it is still open.
+    ///
+    void    CloseStartTag();
+
+    /// Writes the indentation for the specified element depth.
+    ///
+    /// @param depth        [in] Element nesting depth.
+    ///
+    void    PutIndent(size_t depth);
+
+    /// Writes the specified bytes to the buffer.
+    ///
+    /// @param bytes        [in] Bytes to write.
+    /// @param count        [in] Number of bytes.
+    ///
+    void    Put(const char* bytes, size_t count) {
+        if (m_used + count > m_buffer.size()) {
+            PutSlow(bytes, count);
+        } else {
+            memcpy(&m_buffer[m_used], bytes, count);
+            m_used += count;
+        }
+    }
+
+    /// Writes the specified byte to the buffer.
+    ///
+    /// @param ch           [in] Byte to write.
+    ///
+    void    Put(char ch) {
+        if (m_used == m_buffer.size()) {
+            Flush();
+        }
+        m_buffer[m_used++] = ch;
+    }
+
+    /// Writes bytes that may not fit in the remaining buffer space.
+    ///
+    /// @param bytes        [in] Bytes to write.
+    /// @param count        [in] Number of bytes.
+    ///
+    void    PutSlow(const char* bytes, size_t count);
+
+    /// Converts the specified string to UTF-8 and writes it to the buffer.
+    ///
+    /// @param str          [in] String to write.
+    /// @param escape       [in] <b>true</b> to replace markup characters
+    ///                     with entity references.
+    ///
+    void    PutString(LPCTSTR str, bool escape);
+
+    /// Writes the specified Unicode code point in UTF-8.
+    ///
+    /// @param cp           [in] Code point to write.
+    ///
+    void    PutCodePoint(UINT cp);
+
+    /// Writes the start of an attribute, up to and including the
+    /// opening quote.
+    ///
+    /// @param name         [in] Attribute name.
+    ///
+    void    PutAttributeName(LPCTSTR name);
+
+
+    CFile&              m_file;         ///< Output file.
+    std::vector<char>   m_buffer;       ///< Output buffer.
+    size_t              m_used;         ///< Number of bytes used in the output buffer.
+    ULONGLONG           m_flushed;      ///< Number of bytes written to the file.
+    ElementStack        m_elements;     ///< Open elements.
+    bool                m_startTagOpen; ///< Is the start tag of the current element still open.
+};
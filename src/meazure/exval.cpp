@@ -20,6 +20,7 @@
 #pragma warning(disable: 4702)
 #include "exval.h"
 #include "MeaAssert.h"
+#include <algorithm>
 #pragma warning(disable: 4511 4512)
 #include <boost/tokenizer.hpp>
 #include <boost/format.hpp>
@@ -575,7 +576,7 @@ protected:
     void    Followpos();
 
 
-    static int  m_currentId;        ///< ID to assign to the parse node created next.
+    static __declspec(thread) int   m_currentId;    ///< ID to assign to the parse node created next. Thread local so that validators on separate threads can build DFAs concurrently.
 
     int         m_id;               ///< ID for this parse node.
     Type        m_type;             ///< Parse node's type.
@@ -616,6 +617,8 @@ public:
     typedef std::map<EVString, State*>  TransMap;       ///< Represents a transition to a state based on an input symbol.
     typedef TransMap::iterator          TransIter;      ///< Iterator over the state transition map.
     typedef TransMap::const_iterator    TransIter_c;    ///< Constant iterator over the state transition map.
+    typedef std::vector<const State*>   TransTable;     ///< Next state indexed by the symbol ID of the input symbol.
+    typedef std::map<const State*, State*>  StateMap;   ///< Maps a state to the state replacing it.
 
 
     /// Constructs a DFA state.
@@ -639,14 +642,16 @@ public:
     virtual ~State();
 
 
-    /// Based on the specified input symbol (i.e. element name), a transition
+    /// Based on the specified input symbol (i.e. element), a transition
     /// arc is selected and the state pointed to by that arc is returned.
     ///
-    /// @param elementName      [in] Input symbol that selects the transition arc to the next state.
+    /// @param symbol       [in] Symbol ID of the input symbol that selects the
+    ///                     transition arc to the next state.
     ///
-    /// @return The next state based on following the transition arc selected by the element name.
+    /// @return The next state based on following the transition arc selected by
+    ///         the symbol, or NULL if there is no such arc.
     ///
-    const State* GetNextState(const EVString& elementName) const;
+    const State* GetNextState(int symbol) const;
 
 
     /// Indicates if the state represents plain element content.
@@ -709,9 +714,7 @@ public:
     /// @param symbol       [in] Input symbol that will cause the transition.
     /// @param nextState    [in] The state pointed to by the transition arc.
     ///
-    void    AddTransition(const EVString& symbol, State *nextState) {
-        m_transitions[symbol] = nextState;
-    }
+    void    AddTransition(const EVString& symbol, State *nextState);
 
     /// The set of symbols from all the transition arc from this state.
     ///
@@ -724,6 +727,22 @@ public:
         }
     }
 
+    /// Returns the transition arcs from this state.
+    ///
+    /// @return Map of input symbols to the states pointed to by the arcs.
+    ///
+    const TransMap& GetTransitions() const { return m_transitions; }
+
+    /// Redirects the transition arcs from this state to the states that
+    /// replace their targets. Used when equivalent states of a DFA are
+    /// merged.
+    ///
+    /// @param stateMap     [in] Maps every state of the DFA to the state
+    ///                     replacing it, or to NULL if arcs to the state
+    ///                     are to be removed.
+    ///
+    void    RemapTransitions(const StateMap& stateMap);
+
 
     /// Resets the ID assigned to the states.
     ///
@@ -764,7 +783,7 @@ protected:
     /// Purposely undefined.
     State& operator=(const State& state);
 
-    static int  m_currentId;        ///< ID to assign to the parse node created next.
+    static __declspec(thread) int   m_currentId;    ///< ID to assign to the state created next (thread local).
 
 
     /// Indicates if this state contains a terminal parse node.
@@ -787,6 +806,7 @@ protected:
     bool                m_marked;           ///< Used during DFA construction to indicate this state is marked.
     bool                m_accepting;        ///< Indicates if this state allows a match pattern to terminate.
     TransMap            m_transitions;      ///< Transitions from this state to the next states based on element names.
+    TransTable          m_transTable;       ///< Transitions from this state indexed by the symbol IDs of the element names.
 };
 
 
@@ -802,21 +822,21 @@ class DFA
 public:
     /// Constructs a DFA.
     ///
-    /// @param validator    [in] The parent validator for this DFA.
+    /// @param grammar      [in] The parent grammar for this DFA.
     /// @param contentModel [in] Content model represented by this DFA.
     ///
-    DFA(Validator& validator, const ContentModel& contentModel);
+    DFA(Grammar& grammar, const ContentModel& contentModel);
     
     /// Destroys an instance of a DFA.
     ///
     virtual ~DFA();
 
 
-    /// Returns the parent validator for this DFA.
+    /// Returns the parent grammar for this DFA.
     ///
-    /// @return Parent validator for this DFA.
+    /// @return Parent grammar for this DFA.
     ///
-    Validator&  GetValidator() { return m_validator; }
+    Grammar&    GetGrammar() { return m_grammar; }
 
     /// Returns the start state of the DFA.
     ///
@@ -847,7 +867,7 @@ protected:
     /// Purposely undefined.
     DFA& operator=(const DFA& dfa);
 
-    static int  m_currentId;        ///< ID to assign to the parse node created next.
+    static __declspec(thread) int   m_currentId;    ///< ID to assign to the DFA created next (thread local).
 
 
     /// Builds the DFA for an element with an EMPTY content model.
@@ -883,6 +903,16 @@ protected:
     ///
     void        BuildComplexDFA(const ParseNode *parseTree);
 
+    /// Minimizes the DFA by merging equivalent states using Hopcroft's
+    /// partition refinement algorithm. The states built for a complex
+    /// content model correspond to sets of parse positions, so different
+    /// positions of the same element (e.g. the two b's in ((a,b)|(c,b)))
+    /// produce states that accept the same remaining content.
+    ///
+    /// @param symbols          [in] Input symbols of the DFA.
+    ///
+    void        MinimizeDFA(const SymbolSet& symbols);
+
 
     /// Builds a parse tree from the specified element content model.
     ///
@@ -913,7 +943,7 @@ protected:
     int             m_id;               ///< ID for the DFA.
     ParseNode       *m_parseTree;       ///< Parse tree for a complex DFA.
     StateList       m_states;           ///< States that comprise the DFA.
-    Validator&      m_validator;        ///< Parent validator for the DFA.
+    Grammar&        m_grammar;          ///< Parent grammar for the DFA.
 
 #ifdef EV_TIMING
     clock_t m_complexTotalTime;         ///< Time to construct a complex DFA, in seconds.
@@ -946,10 +976,10 @@ public:
 
     /// Constructs an element declaration.
     ///
-    /// @param validator    [in] Parent validator for the declaration.
+    /// @param grammar      [in] Parent grammar for the declaration.
     /// @param elementName  [in] Name of the element being declared.
     ///
-    ElementDecl(Validator& validator, const XML_Char* elementName);
+    ElementDecl(Grammar& grammar, const XML_Char* elementName);
     
     /// Destroys an element declaration.
     ///
@@ -1021,11 +1051,11 @@ public:
     }
 
 
-    /// Returns the parent validator for the element declaration.
+    /// Returns the parent grammar for the element declaration.
     ///
-    /// @return Parent validator for the element declaration.
+    /// @return Parent grammar for the element declaration.
     ///
-    const Validator&    GetValidator() const { return m_validator; }
+    const Grammar&  GetGrammar() const { return m_grammar; }
 
 protected:
     typedef AttributeMap::iterator  AttributeIter;  ///< Iterator over the element's attributes.
@@ -1041,7 +1071,7 @@ protected:
     EVString        m_elementName;          ///< Name of the element being declared.
     AttributeMap    m_attributes;           ///< Attributes for the element.
     AttributeMap    m_requiredAttributes;   ///< Required attributes for the element.
-    Validator&      m_validator;            ///< Parent validator for the element.
+    Grammar&        m_grammar;              ///< Parent grammar for the element.
 };
 
 
@@ -1234,91 +1264,178 @@ using namespace ev;
 
 
 //*************************************************************************
-// Validator
+// NameSet
 //*************************************************************************
 
- 
-Validator::Validator(IValidationHandler *handler) : m_handler(handler),
-    m_foundDocumentElement(false), m_errorShutdown(false)
+
+NameSet::NameSet()
 {
 }
 
 
-Validator::~Validator()
+bool NameSet::Insert(const XML_Char* name, size_t len)
 {
-    try {
-        Clear();
-        m_handler = NULL;
+    // Keep the table at most half full so that probe sequences are short
+    // and there is always an empty slot to end a search.
+    //
+    if ((m_entries.size() + 1) * 2 > m_slots.size()) {
+        Grow();
     }
-    catch(...) {
-        MeaAssert(false);
+
+    unsigned int hash = Hash(name, len);
+    size_t slot = FindSlot(name, len, hash);
+    if (m_slots[slot] != 0) {
+        return false;
     }
+
+    Entry entry;
+    entry.offset = m_pool.size();
+    entry.length = len;
+    entry.hash = hash;
+
+    m_pool.insert(m_pool.end(), name, name + len);
+    m_pool.push_back(0);
+    m_entries.push_back(entry);
+    m_slots[slot] = static_cast<int>(m_entries.size());
+
+    return true;
 }
 
 
-void Validator::Clear()
+void NameSet::Clear()
 {
-    Reset();
+    m_pool.clear();
+    m_entries.clear();
+    std::fill(m_slots.begin(), m_slots.end(), 0);
+}
 
-    for (ElementDeclIter diter = m_elementDecls.begin(); diter != m_elementDecls.end(); ++diter) {
-        delete (*diter).second;
-    }
-    m_elementDecls.clear();
 
-    for (DFAIter fiter = m_dfas.begin(); fiter != m_dfas.end(); ++fiter) {
-        delete (*fiter).second;
+unsigned int NameSet::Hash(const XML_Char* name, size_t len)
+{
+    unsigned int hash = 2166136261U;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= static_cast<unsigned int>(name[i]);
+        hash *= 16777619U;
     }
-    m_dfas.clear();
+
+    return hash;
 }
 
 
-void Validator::Reset()
+size_t NameSet::FindSlot(const XML_Char* name, size_t len, unsigned int hash) const
 {
-    m_errorShutdown = false;
-    m_foundDocumentElement = false;
+    MeaAssert(!m_slots.empty());
 
-    while (!IsStateStackEmpty()) {
-        PopState();
+    size_t mask = m_slots.size() - 1;
+
+    for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+        int index = m_slots[slot];
+        if (index == 0) {
+            return slot;
+        }
+
+        const Entry& entry = m_entries[index - 1];
+        if ((entry.hash == hash) && (entry.length == len) &&
+                std::equal(name, name + len, m_pool.begin() + entry.offset)) {
+            return slot;
+        }
     }
+}
 
-    while (!IsElementStackEmpty()) {
-        PopElement();
+
+void NameSet::Grow()
+{
+    size_t size = kInitialSlots;
+    if (!m_slots.empty()) {
+        size = m_slots.size() * 2;
     }
 
-    m_ids.clear();
-    m_idRefs.clear();
+    m_slots.assign(size, 0);
+
+    size_t mask = size - 1;
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        size_t slot = m_entries[i].hash & mask;
+        while (m_slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        m_slots[slot] = static_cast<int>(i + 1);
+    }
 }
 
 
-SymbolSet Validator::GetAllowableElements() const
+//*************************************************************************
+// Grammar
+//*************************************************************************
+
+ 
+const int Grammar::kNoSymbol = -1;
+
+
+Grammar::Grammar()
 {
-    SymbolSet symbols;
+}
 
-    const State *currentState = TopState();
 
-    if (currentState == NULL) {
-        if (!m_documentElement.empty()) {
-            symbols.insert(m_documentElement);
+Grammar::~Grammar()
+{
+    try {
+        for (ElementDeclIter diter = m_elementDecls.begin(); diter != m_elementDecls.end(); ++diter) {
+            delete (*diter).second;
         }
-    } else {
-        if (currentState->IsAny()) {
-            symbols = m_anyElements;
-        } else {
-            currentState->GetSymbolSet(symbols);
+        m_elementDecls.clear();
+
+        for (DFAIter fiter = m_dfas.begin(); fiter != m_dfas.end(); ++fiter) {
+            delete (*fiter).second;
         }
+        m_dfas.clear();
     }
+    catch(...) {
+        MeaAssert(false);
+    }
+}
 
-    return symbols;
+
+int Grammar::InternSymbol(const EVString& elementName)
+{
+    std::pair<SymbolIdMap::iterator, bool> result =
+        m_symbolIds.insert(SymbolIdMap::value_type(elementName, static_cast<int>(m_symbols.size())));
+    if (result.second) {
+        m_symbols.push_back(Symbol());
+    }
+    return (*result.first).second;
 }
 
 
-void Validator::AddElementDecl(const XML_Char* elementName,
-                               const XML_Content *contentModel)
+ElementDecl* Grammar::CreateElementDecl(const XML_Char* elementName)
+{
+    ElementDecl *elementDecl;
+    ElementDeclIter iter = m_elementDecls.find(elementName);
+
+    if (iter == m_elementDecls.end()) {
+        elementDecl = new ElementDecl(*this, elementName);
+        m_elementDecls[elementName] = elementDecl;
+        m_symbols[InternSymbol(elementName)].elementDecl = elementDecl;
+    } else {
+        elementDecl = (*iter).second;
+    }
+
+    return elementDecl;
+}
+
+
+void Grammar::AddElementDecl(const XML_Char* elementName,
+                             const XML_Content *contentModel)
 {
     MeaAssert(elementName != NULL);
 
     ContentModel model(contentModel);
 
+    // Intern the element name before building its DFA so that the
+    // DFA can refer to the element by its symbol ID.
+    //
+    int symbol = InternSymbol(elementName);
+
     // Form the signature of the content model and see if
     // we already have a DFA for it.
     //
@@ -1333,59 +1450,37 @@ void Validator::AddElementDecl(const XML_Char* elementName,
         dfa = (*diter).second;
     }
 
-    // If it is a mixed element, add it to the
-    // set of mixed elements so that clients can
-    // query whether a particular element takes
-    // PCDATA.
+    // Record whether it is a mixed element so
+    // that clients can query whether a particular
+    // element takes PCDATA.
     //
-    m_mixedElements[elementName] = model.IsMixed();
+    m_symbols[symbol].mixed = model.IsMixed();
+    m_symbols[symbol].declared = true;
+    m_declaredElements.insert(elementName);
 
     // Create an element declaration for this element, if it
     // has not already been created by a previous attribute
     // declaration.
     //
-    ElementDecl *elementDecl;
-    ElementDeclIter iter = m_elementDecls.find(elementName);
-
-    if (iter == m_elementDecls.end()) {
-        elementDecl = new ElementDecl(*this, elementName);
-        m_elementDecls[elementName] = elementDecl;
-    } else {
-        elementDecl = (*iter).second;
-    }
+    ElementDecl *elementDecl = CreateElementDecl(elementName);
 
     // Give the element its content DFA
     //
     elementDecl->SetDFA(dfa);
-
-    // Add the element to the ANY set if it is not the document
-    // element.
-    //
-    if (m_documentElement != elementName) {
-        m_anyElements.insert(elementName);
-    }
 }
 
 
-void Validator::AddAttributeDecl(const XML_Char* elementName,
-                                 const XML_Char* attrName,
-                                 const XML_Char* attrType,
-                                 const XML_Char* defValue,
-                                 int isRequired)
+void Grammar::AddAttributeDecl(const XML_Char* elementName,
+                               const XML_Char* attrName,
+                               const XML_Char* attrType,
+                               const XML_Char* defValue,
+                               int isRequired)
 {
     // Create an element declaration for this attribute, if it
     // has not already been created by a previous element
     // declaration.
     //
-    ElementDecl *elementDecl;
-    ElementDeclIter iter = m_elementDecls.find(elementName);
-
-    if (iter == m_elementDecls.end()) {
-        elementDecl = new ElementDecl(*this, elementName);
-        m_elementDecls[elementName] = elementDecl;
-    } else {
-        elementDecl = (*iter).second;
-    }
+    ElementDecl *elementDecl = CreateElementDecl(elementName);
     MeaAssert(elementDecl != NULL);
 
     // Add the attribute decl to the element decl
@@ -1395,9 +1490,115 @@ void Validator::AddAttributeDecl(const XML_Char* elementName,
 }
 
 
+//*************************************************************************
+// Validator
+//*************************************************************************
+
+
+Validator::Validator(IValidationHandler *handler) : m_handler(handler),
+    m_documentSymbol(Grammar::kNoSymbol), m_declGrammar(new Grammar),
+    m_foundDocumentElement(false), m_errorShutdown(false)
+{
+    m_grammar.reset(m_declGrammar);
+}
+
+
+Validator::~Validator()
+{
+    try {
+        Clear();
+        m_handler = NULL;
+    }
+    catch(...) {
+        MeaAssert(false);
+    }
+}
+
+
+void Validator::Clear()
+{
+    Reset();
+
+    m_declGrammar = new Grammar;
+    m_grammar.reset(m_declGrammar);
+
+    m_documentElement.clear();
+    m_documentSymbol = Grammar::kNoSymbol;
+}
+
+
+void Validator::Reset()
+{
+    m_errorShutdown = false;
+    m_foundDocumentElement = false;
+
+    while (!IsStateStackEmpty()) {
+        PopState();
+    }
+
+    while (!IsElementStackEmpty()) {
+        PopElement();
+    }
+
+    m_ids.Clear();
+    m_unresolvedIdRefs.Clear();
+}
+
+
+GrammarPtr Validator::ShareGrammar()
+{
+    m_declGrammar = NULL;
+    return m_grammar;
+}
+
+
+void Validator::SetGrammar(const GrammarPtr& grammar)
+{
+    MeaAssert(grammar);
+
+    m_declGrammar = NULL;
+    m_grammar = grammar;
+    m_documentSymbol = Grammar::kNoSymbol;
+}
+
+
+SymbolSet Validator::GetAllowableElements() const
+{
+    SymbolSet symbols;
+
+    const State *currentState = TopState();
+
+    if (currentState == NULL) {
+        if (!m_documentElement.empty()) {
+            symbols.insert(m_documentElement);
+        }
+    } else {
+        if (currentState->IsAny()) {
+            symbols = GetAnyElements();
+        } else {
+            currentState->GetSymbolSet(symbols);
+        }
+    }
+
+    return symbols;
+}
+
+
+SymbolSet Validator::GetAnyElements() const
+{
+    SymbolSet symbols(m_grammar->GetDeclaredElements());
+    symbols.erase(m_documentElement);
+    return symbols;
+}
+
+
 void Validator::SetDocumentElement(const XML_Char* elementName)
 {
+    // The document element's symbol is found when validation starts,
+    // because the DTD has not been declared at this point.
+    //
     m_documentElement = elementName;
+    m_documentSymbol = Grammar::kNoSymbol;
 }
 
 
@@ -1409,8 +1610,11 @@ bool Validator::StartElement(XML_Parser parser, const XML_Char* elementName,
     }
 
     // Get the element declaration that corresponds to this element.
+    // The element name is looked up once and the element is referred
+    // to by its symbol ID from then on.
     //
-    const ElementDecl *elementDecl = GetElementDecl(elementName);
+    int symbol = m_grammar->FindSymbol(elementName);
+    const ElementDecl *elementDecl = m_grammar->GetElementDecl(symbol);
     if (elementDecl == NULL) {
         SendError(parser, ValidationError::UndeclaredElement, elementName);
         return false;
@@ -1428,7 +1632,7 @@ bool Validator::StartElement(XML_Parser parser, const XML_Char* elementName,
         if (m_foundDocumentElement) {
             // We have more than one occurrence of the document element.
             //
-            if (IsDocumentElement(elementName)) {
+            if (IsDocumentElement(symbol)) {
                 SendError(parser, ValidationError::MultipleDocumentElements, elementName);
                 return false;
             }
@@ -1439,8 +1643,9 @@ bool Validator::StartElement(XML_Parser parser, const XML_Char* elementName,
             // in the DOCTYPE declaration.
             //
             m_foundDocumentElement = true;
+            m_documentSymbol = m_grammar->FindSymbol(m_documentElement.c_str());
 
-            if (!IsDocumentElement(elementName)) {
+            if (!IsDocumentElement(symbol)) {
                 SendError(parser, ValidationError::InvalidDocumentElement, elementName);
                 return false;
             }
@@ -1452,7 +1657,13 @@ bool Validator::StartElement(XML_Parser parser, const XML_Char* elementName,
     else {
         const State *currentState = TopState();
         MeaAssert(currentState != NULL);
-        const State *nextState = currentState->GetNextState(elementName);
+        const State *nextState = currentState->GetNextState(symbol);
+
+        // The document element is not allowed in ANY content.
+        //
+        if (currentState->IsAny() && (symbol == m_documentSymbol)) {
+            nextState = NULL;
+        }
 
         if (nextState == NULL) {
             SendError(parser, ValidationError::InvalidElement, elementName, TopElement()->GetName().c_str());
@@ -1506,25 +1717,16 @@ bool Validator::StartElement(XML_Parser parser, const XML_Char* elementName,
         case AttributeDecl::CDATA:
             break;
         case AttributeDecl::ENTITY:
-            // If this is an ENTITY attribute, verify that the entity has
-            // has been declared in the DTD.
-            //
-            if (m_entities.find(avalue) != m_entities.end()) {
-                SendError(parser, ValidationError::UndeclaredEntity, aname, elementName);
-                return false;
-            }
-            break;
         case AttributeDecl::ENTITIES:
-            // If this is an ENTITIES attribute, verify that each entity has
-            // has been declared in the DTD.
+            // If this is an ENTITY or ENTITIES attribute, verify that each
+            // entity has been declared in the DTD.
             //
             {
-                static EVSeparator delim(EV_T(" \t"));
-                EVString vstr(avalue);
+                const XML_Char* token;
+                size_t len;
 
-                EVTokenizer tokens(vstr, delim);
-                for (EVTokenizer::const_iterator iter = tokens.begin(); iter != tokens.end(); ++iter) {
-                    if (m_entities.find(*iter) != m_entities.end()) {
+                for (const XML_Char* str = avalue; NextToken(str, token, len); ) {
+                    if (!m_grammar->HasEntity(token, len)) {
                         SendError(parser, ValidationError::UndeclaredEntity, aname, elementName);
                         return false;
                     }
@@ -1534,31 +1736,26 @@ bool Validator::StartElement(XML_Parser parser, const XML_Char* elementName,
         case AttributeDecl::ID:
             // If this is an ID attribute, verify that this ID is unique.
             //
-            if (m_ids.find(avalue) != m_ids.end()) {
+            if (!m_ids.Insert(avalue)) {
                 SendError(parser, ValidationError::DuplicateId, aname, elementName);
                 return false;
             }
-            m_ids.insert(avalue);
             break;
         case AttributeDecl::IDREF:
-            // Add the ID reference to the set of references. When the document
-            // element is ended, all ID references will be reconciled against
-            // the ID values defined in the document.
-            //
-            m_idRefs.insert(avalue);
-            break;
         case AttributeDecl::IDREFS:
-            // Add the ID references to the set of references. When the document
-            // element is ended, all ID references will be reconciled against
-            // the ID values defined in the document.
+            // A reference to an ID that has already been defined is resolved
+            // immediately. Forward references are remembered and reconciled
+            // against the ID values defined in the document when the document
+            // element is ended.
             //
             {
-                static EVSeparator delim(EV_T(" \t"));
-                EVString vstr(avalue);
+                const XML_Char* token;
+                size_t len;
 
-                EVTokenizer tokens(vstr, delim);
-                for (EVTokenizer::const_iterator iter = tokens.begin(); iter != tokens.end(); ++iter) {
-                    m_idRefs.insert(*iter);
+                for (const XML_Char* str = avalue; NextToken(str, token, len); ) {
+                    if (!m_ids.Contains(token, len)) {
+                        m_unresolvedIdRefs.Insert(token, len);
+                    }
                 }
             }
             break;
@@ -1570,7 +1767,7 @@ bool Validator::StartElement(XML_Parser parser, const XML_Char* elementName,
             // If this is a NOTATION attribute, verify that the notation has
             // has been declared in the DTD.
             //
-            if (m_notations.find(avalue) != m_notations.end()) {
+            if (!m_grammar->HasNotation(avalue)) {
                 SendError(parser, ValidationError::UndeclaredNotation, aname, elementName);
                 return false;
             }
@@ -1620,12 +1817,15 @@ bool Validator::EndElement(XML_Parser parser)
     PopElement();
 
     // If the state stack is empty, we have closed the document element.
-    // Reconcile any IDREF values against their corresponding ID values.
+    // Reconcile the forward IDREF values against their corresponding ID
+    // values. References to IDs defined earlier were resolved as they
+    // were encountered.
     //
     if (IsStateStackEmpty()) {
-        for (IDRefIter_c iter = m_idRefs.begin(); iter != m_idRefs.end(); ++iter) {
-            if (m_ids.find(*iter) == m_ids.end()) {
-                SendError(parser, ValidationError::IdNotFound, (*iter).c_str());
+        for (int i = 0; i < m_unresolvedIdRefs.GetCount(); i++) {
+            const XML_Char* idRef = m_unresolvedIdRefs.GetName(i);
+            if (!m_ids.Contains(idRef)) {
+                SendError(parser, ValidationError::IdNotFound, idRef);
                 return false;
             }
         }
@@ -1702,6 +1902,27 @@ bool Validator::IsWhitespace(const XML_Char* str, int len) const
 }
 
 
+bool Validator::NextToken(const XML_Char*& str, const XML_Char*& token, size_t& len)
+{
+    MeaAssert(str != NULL);
+
+    while (IsSeparator(*str)) {
+        str++;
+    }
+    if (*str == 0) {
+        return false;
+    }
+
+    token = str;
+    while ((*str != 0) && !IsSeparator(*str)) {
+        str++;
+    }
+    len = str - token;
+
+    return true;
+}
+
+
 //*************************************************************************
 // ValidationError
 //*************************************************************************
@@ -1777,7 +1998,7 @@ ValidationError::ValidationError(XML_Parser parser, Code errorCode,
 //*************************************************************************
 
 
-int ParseNode::m_currentId = 0;
+__declspec(thread) int ParseNode::m_currentId = 0;
 
 
 ParseNode::ParseNode(Type type):
@@ -1961,7 +2182,7 @@ void ParseNode::GetSymbolSet(SymbolSet& symbols) const
 //*************************************************************************
 
 
-int State::m_currentId = 0;
+__declspec(thread) int State::m_currentId = 0;
 
 
 State::State(DFA& dfa, Type type, const ParseNode::NodeSet& positions) :
@@ -1992,18 +2213,56 @@ bool State::operator==(const State& rhs) const
 }
 
 
-const State* State::GetNextState(const EVString& elementName) const
+void State::RemapTransitions(const StateMap& stateMap)
 {
-    if (IsEmpty()) {
+    for (TransIter iter = m_transitions.begin(); iter != m_transitions.end(); ) {
+        StateMap::const_iterator mapIter = stateMap.find((*iter).second);
+        MeaAssert(mapIter != stateMap.end());
+
+        if ((*mapIter).second == NULL) {
+            m_transitions.erase(iter++);
+        } else {
+            (*iter).second = (*mapIter).second;
+            ++iter;
+        }
+    }
+
+    for (TransTable::iterator titer = m_transTable.begin(); titer != m_transTable.end(); ++titer) {
+        if (*titer != NULL) {
+            StateMap::const_iterator mapIter = stateMap.find(*titer);
+            MeaAssert(mapIter != stateMap.end());
+            *titer = (*mapIter).second;
+        }
+    }
+}
+
+
+void State::AddTransition(const EVString& symbol, State *nextState)
+{
+    m_transitions[symbol] = nextState;
+
+    // The table only extends to the highest symbol ID with a transition.
+    // Symbols interned after the DFA is built cannot have transitions
+    // from this state and fall beyond the end of the table.
+    //
+    int symbolId = m_dfa.GetGrammar().InternSymbol(symbol);
+    if (symbolId >= static_cast<int>(m_transTable.size())) {
+        m_transTable.resize(symbolId + 1, NULL);
+    }
+    m_transTable[symbolId] = nextState;
+}
+
+
+const State* State::GetNextState(int symbol) const
+{
+    if (IsEmpty() || (symbol == Grammar::kNoSymbol)) {
         return NULL;
     }
     if (IsAny()) {
-        const SymbolSet& anyElements = m_dfa.GetValidator().GetAnyElements();
-        return ((anyElements.find(elementName) == anyElements.end()) ? NULL : this);
+        return (m_dfa.GetGrammar().IsDeclared(symbol) ? this : NULL);
     }
 
-    TransIter_c iter = m_transitions.find(elementName);
-    return ((iter == m_transitions.end()) ? NULL : (*iter).second);
+    return ((symbol < static_cast<int>(m_transTable.size())) ? m_transTable[symbol] : NULL);
 }
 
 
@@ -2012,11 +2271,11 @@ const State* State::GetNextState(const EVString& elementName) const
 //*************************************************************************
 
 
-int DFA::m_currentId = 0;
+__declspec(thread) int DFA::m_currentId = 0;
 
 
-DFA::DFA(Validator& validator, const ContentModel& contentModel) :
-    m_id(++m_currentId), m_parseTree(NULL), m_validator(validator) 
+DFA::DFA(Grammar& grammar, const ContentModel& contentModel) :
+    m_id(++m_currentId), m_parseTree(NULL), m_grammar(grammar) 
 {
 #ifdef EV_TIMING
     m_complexTotalTime = 0;
@@ -2264,6 +2523,168 @@ void DFA::BuildComplexDFA(const ParseNode *parseTree)
             }
         }
     }
+
+    MinimizeDFA(symbols);
+}
+
+
+void DFA::MinimizeDFA(const SymbolSet& symbols)
+{
+    typedef std::vector<int>        IndexList;
+    typedef std::pair<int, int>     Splitter;       // Block and symbol index
+
+    // Number the states in order, so that the start state is 0. Missing
+    // transitions lead to an implicit dead state, numbered last.
+    //
+    std::vector<State*> states(m_states.begin(), m_states.end());
+    std::map<const State*, int> stateIndex;
+    for (size_t i = 0; i < states.size(); i++) {
+        stateIndex[states[i]] = static_cast<int>(i);
+    }
+
+    int numStates = static_cast<int>(states.size()) + 1;
+    int deadState = numStates - 1;
+    int numSymbols = static_cast<int>(symbols.size());
+
+    // For each symbol and state, list the states with a transition to
+    // the state on the symbol.
+    //
+    std::vector<std::vector<IndexList> > inverse(numSymbols, std::vector<IndexList>(numStates));
+    int symbol = 0;
+    for (SymbolSet::const_iterator siter = symbols.begin(); siter != symbols.end(); ++siter, ++symbol) {
+        for (int p = 0; p < numStates; p++) {
+            int q = deadState;
+            if (p != deadState) {
+                const State::TransMap& transitions = states[p]->GetTransitions();
+                State::TransIter_c titer = transitions.find(*siter);
+                if (titer != transitions.end()) {
+                    q = stateIndex[(*titer).second];
+                }
+            }
+            inverse[symbol][q].push_back(p);
+        }
+    }
+
+    // The initial partition separates the accepting states from the rest.
+    //
+    IndexList accepting, rejecting;
+    for (int p = 0; p < numStates; p++) {
+        if ((p != deadState) && states[p]->IsAccepting()) {
+            accepting.push_back(p);
+        } else {
+            rejecting.push_back(p);
+        }
+    }
+    if (accepting.empty()) {
+        return;
+    }
+
+    std::vector<IndexList> blocks;
+    IndexList block(numStates);
+    blocks.push_back(accepting);
+    blocks.push_back(rejecting);
+    for (int b = 0; b < 2; b++) {
+        for (IndexList::const_iterator iter = blocks[b].begin(); iter != blocks[b].end(); ++iter) {
+            block[*iter] = b;
+        }
+    }
+
+    std::list<Splitter> work;
+    std::vector<std::vector<bool> > inWork(2, std::vector<bool>(numSymbols, false));
+    int smaller = (accepting.size() <= rejecting.size()) ? 0 : 1;
+    for (int a = 0; a < numSymbols; a++) {
+        work.push_back(Splitter(smaller, a));
+        inWork[smaller][a] = true;
+    }
+
+    // Refine the partition until no block contains states that lead
+    // to different blocks on the same symbol.
+    //
+    while (!work.empty()) {
+        Splitter splitter = work.front();
+        work.pop_front();
+        inWork[splitter.first][splitter.second] = false;
+
+        // Group the states leading into the splitter block by their own
+        // block. A state has one transition per symbol, so each state is
+        // found at most once.
+        //
+        std::map<int, IndexList> predecessors;
+        const IndexList& members = blocks[splitter.first];
+        for (IndexList::const_iterator miter = members.begin(); miter != members.end(); ++miter) {
+            const IndexList& preds = inverse[splitter.second][*miter];
+            for (IndexList::const_iterator piter = preds.begin(); piter != preds.end(); ++piter) {
+                predecessors[block[*piter]].push_back(*piter);
+            }
+        }
+
+        for (std::map<int, IndexList>::const_iterator iter = predecessors.begin(); iter != predecessors.end(); ++iter) {
+            int b = (*iter).first;
+            const IndexList& split = (*iter).second;
+
+            if (split.size() == blocks[b].size()) {
+                continue;
+            }
+
+            // Move the predecessors into a new block.
+            //
+            int nb = static_cast<int>(blocks.size());
+            blocks.push_back(split);
+            for (IndexList::const_iterator siter = split.begin(); siter != split.end(); ++siter) {
+                block[*siter] = nb;
+            }
+
+            IndexList remainder;
+            for (IndexList::const_iterator riter = blocks[b].begin(); riter != blocks[b].end(); ++riter) {
+                if (block[*riter] == b) {
+                    remainder.push_back(*riter);
+                }
+            }
+            blocks[b].swap(remainder);
+
+            inWork.push_back(std::vector<bool>(numSymbols, false));
+            for (int a = 0; a < numSymbols; a++) {
+                int next = nb;
+                if (!inWork[b][a] && (blocks[b].size() < blocks[nb].size())) {
+                    next = b;
+                }
+                work.push_back(Splitter(next, a));
+                inWork[next][a] = true;
+            }
+        }
+    }
+
+    // States in the same block as the dead state cannot lead to a valid
+    // match and arcs to them are removed. Every state built from a content
+    // model can reach an accepting state, so this is only a safeguard.
+    //
+    int deadBlock = block[deadState];
+    if (block[0] == deadBlock || static_cast<int>(blocks.size()) == numStates) {
+        return;
+    }
+
+    // Each block is replaced by its first state, so the start state
+    // remains first.
+    //
+    std::vector<State*> replacement(blocks.size(), NULL);
+    State::StateMap stateMap;
+    for (int p = 0; p < deadState; p++) {
+        int b = block[p];
+        if ((b != deadBlock) && (replacement[b] == NULL)) {
+            replacement[b] = states[p];
+        }
+        stateMap[states[p]] = replacement[b];
+    }
+
+    m_states.clear();
+    for (int p = 0; p < deadState; p++) {
+        if (stateMap[states[p]] == states[p]) {
+            states[p]->RemapTransitions(stateMap);
+            m_states.push_back(states[p]);
+        } else {
+            delete states[p];
+        }
+    }
 }
 
 
@@ -2645,10 +3066,10 @@ ContentModel::Category ContentModel::Categorize() const
 //*************************************************************************
 
 
-ElementDecl::ElementDecl(Validator& validator, const XML_Char* elementName) :
+ElementDecl::ElementDecl(Grammar& grammar, const XML_Char* elementName) :
     m_dfa(NULL),
     m_elementName((elementName != NULL) ? elementName : EV_T("")),
-    m_validator(validator)
+    m_grammar(grammar)
 {
 }
 
@@ -2738,7 +3159,7 @@ AttributeDecl::~AttributeDecl()
 
 void AttributeDecl::ParseValues(const XML_Char* valueStr)
 {
-    static EVSeparator sep(EV_T("()|"));
+    EVSeparator sep(EV_T("()|"));
     EVString vstr(valueStr);
 
     EVTokenizer tokens(vstr, sep);
@@ -2755,31 +3176,37 @@ void AttributeDecl::ParseValues(const XML_Char* valueStr)
 
 EVOstream& ev::operator<<(EVOstream& stream, const Validator& validator)
 {
-    stream << EV_T("Number of elements: ") << validator.m_elementDecls.size() << std::endl;
-    stream << EV_T("Number of DFAs: ") << validator.m_dfas.size() << std::endl;
+    return stream << *validator.m_grammar;
+}
+
+
+EVOstream& ev::operator<<(EVOstream& stream, const Grammar& grammar)
+{
+    stream << EV_T("Number of elements: ") << grammar.m_elementDecls.size() << std::endl;
+    stream << EV_T("Number of DFAs: ") << grammar.m_dfas.size() << std::endl;
     stream << std::endl;
 
-    for (Validator::DFAIter_c iter = validator.m_dfas.begin(); iter != validator.m_dfas.end(); ++iter) {
+    for (Grammar::DFAIter_c iter = grammar.m_dfas.begin(); iter != grammar.m_dfas.end(); ++iter) {
         stream << EV_T("DFA: ") << (*iter).second->GetId() << EV_T(" (") << (*iter).first.c_str() << EV_T(")") << std::endl;
         stream << (*iter).second << std::endl;
     }
 
-    for (Validator::ElementDeclIter_c declIter = validator.m_elementDecls.begin(); declIter != validator.m_elementDecls.end(); ++declIter) {
+    for (Grammar::ElementDeclIter_c declIter = grammar.m_elementDecls.begin(); declIter != grammar.m_elementDecls.end(); ++declIter) {
         stream << EV_T("Element: ") << (*declIter).first.c_str() << std::endl;
         stream << (*declIter).second << std::endl;
     }
 
-    if (!validator.m_notations.empty()) {
+    if (!grammar.m_notations.IsEmpty()) {
         stream << EV_T("Notations: ") << std::endl;
-        for (Validator::NotationIter_c niter = validator.m_notations.begin(); niter != validator.m_notations.end(); ++niter) {
-            stream << EV_T("    ") << (*niter).c_str() << std::endl;
+        for (int i = 0; i < grammar.m_notations.GetCount(); i++) {
+            stream << EV_T("    ") << grammar.m_notations.GetName(i) << std::endl;
         }
     }
 
-    if (!validator.m_entities.empty()) {
+    if (!grammar.m_entities.IsEmpty()) {
         stream << EV_T("Entities: ") << std::endl;
-        for (Validator::EntityIter_c eiter = validator.m_entities.begin(); eiter != validator.m_entities.end(); ++eiter) {
-            stream << EV_T("    ") << (*eiter).c_str() << std::endl;
+        for (int i = 0; i < grammar.m_entities.GetCount(); i++) {
+            stream << EV_T("    ") << grammar.m_entities.GetName(i) << std::endl;
         }
     }
 
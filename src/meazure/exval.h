@@ -30,6 +30,9 @@
 #include <list>
 #include <stack>
 #include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
 
 
 /// exval uses the namespace ev for everything.
@@ -190,6 +193,363 @@ public:
 };
 
 
+/// A set of names such as IDs, notations and entities. The names are
+/// interned into a single character pool and located using an open
+/// addressing hash table with linear probing, so adding a name allocates
+/// memory only when the pool or table must grow, and testing for a name
+/// requires a hash and typically a single string comparison. Names are
+/// counted rather than NUL terminated, so that the tokens of an attribute
+/// value such as IDREFS can be added and tested without copying them.
+///
+class NameSet
+{
+public:
+    /// Constructs an empty set.
+    ///
+    NameSet();
+
+
+    /// Adds the specified name to the set.
+    ///
+    /// @param name     [in] Name to add (need not be NUL terminated).
+    /// @param len      [in] Number of characters in the name.
+    ///
+    /// @return <b>true</b> if the name was added, <b>false</b> if the
+    ///         name was already in the set.
+    ///
+    bool    Insert(const XML_Char* name, size_t len);
+
+    /// Adds the specified NUL terminated name to the set.
+    ///
+    /// @param name     [in] Name to add.
+    ///
+    /// @return <b>true</b> if the name was added, <b>false</b> if the
+    ///         name was already in the set.
+    ///
+    bool    Insert(const XML_Char* name) { return Insert(name, Length(name)); }
+
+    /// Indicates whether the specified name is in the set.
+    ///
+    /// @param name     [in] Name to look up (need not be NUL terminated).
+    /// @param len      [in] Number of characters in the name.
+    ///
+    /// @return <b>true</b> if the name is in the set.
+    ///
+    bool    Contains(const XML_Char* name, size_t len) const {
+        return !m_entries.empty() && (m_slots[FindSlot(name, len, Hash(name, len))] != 0);
+    }
+
+    /// Indicates whether the specified NUL terminated name is in the set.
+    ///
+    /// @param name     [in] Name to look up.
+    ///
+    /// @return <b>true</b> if the name is in the set.
+    ///
+    bool    Contains(const XML_Char* name) const { return Contains(name, Length(name)); }
+
+    /// Removes all names from the set. The memory used by the set is
+    /// kept so that the set can be refilled without allocating.
+    ///
+    void    Clear();
+
+    /// Indicates whether the set is empty.
+    ///
+    /// @return <b>true</b> if there are no names in the set.
+    ///
+    bool    IsEmpty() const { return m_entries.empty(); }
+
+    /// Returns the number of names in the set.
+    ///
+    /// @return Number of names in the set.
+    ///
+    int     GetCount() const { return static_cast<int>(m_entries.size()); }
+
+    /// Returns the specified name. Names are indexed in the order they
+    /// were added to the set. The pointer is valid until the next name
+    /// is added to the set.
+    ///
+    /// @param index    [in] Index of the name, from 0 to GetCount() - 1.
+    ///
+    /// @return NUL terminated name.
+    ///
+    const XML_Char* GetName(int index) const { return &m_pool[m_entries[index].offset]; }
+
+private:
+    /// A name in the set.
+    ///
+    struct Entry
+    {
+        size_t          offset;     ///< Offset of the name in the character pool.
+        size_t          length;     ///< Number of characters in the name.
+        unsigned int    hash;       ///< Hash of the name.
+    };
+
+    typedef std::vector<Entry>      EntryList;      ///< Names in the order they were added.
+    typedef std::vector<int>        SlotList;       ///< Hash table of entry indices.
+    typedef std::vector<XML_Char>   CharPool;       ///< Interned name characters.
+
+
+    /// Returns the length of the specified NUL terminated name.
+    ///
+    /// @param name     [in] Name to measure.
+    ///
+    /// @return Number of characters in the name.
+    ///
+    static size_t   Length(const XML_Char* name) {
+        const XML_Char* end = name;
+        while (*end != 0) {
+            end++;
+        }
+        return end - name;
+    }
+
+    /// Returns the FNV-1a hash of the specified name.
+    ///
+    /// @param name     [in] Name to hash.
+    /// @param len      [in] Number of characters in the name.
+    ///
+    /// @return Hash of the name.
+    ///
+    static unsigned int Hash(const XML_Char* name, size_t len);
+
+    /// Locates the hash table slot for the specified name.
+    ///
+    /// @param name     [in] Name to look up.
+    /// @param len      [in] Number of characters in the name.
+    /// @param hash     [in] Hash of the name.
+    ///
+    /// @return Index of the slot holding the name, or of the empty slot
+    ///         where the name would be added.
+    ///
+    size_t  FindSlot(const XML_Char* name, size_t len, unsigned int hash) const;
+
+    /// Doubles the size of the hash table and rehashes the names.
+    ///
+    void    Grow();
+
+
+    static const size_t kInitialSlots = 64;     ///< Initial size of the hash table. Must be a power of 2.
+
+    CharPool    m_pool;         ///< Characters of the names, each NUL terminated.
+    EntryList   m_entries;      ///< Names in the order they were added.
+    SlotList    m_slots;        ///< Hash table holding entry index + 1, or 0 for an empty slot.
+};
+
+
+/// A compiled DTD. The grammar holds the element and attribute declarations,
+/// the DFAs for the element content models, the notations and entities, and
+/// the table of element symbols. A grammar is built as the DTD is declared
+/// and is not modified once the validator using it has shared it (see
+/// Validator::ShareGrammar). A shared grammar can be used by any number of
+/// validators at the same time, including validators on different threads,
+/// so a DTD need only be compiled once for all the documents that use it.
+///
+/// Element names are interned as the DTD is declared. Each name is assigned
+/// an integer symbol ID and the DFA states hold their transitions in arrays
+/// indexed by symbol ID. Validating an element therefore requires a single
+/// hash lookup of its name, after which the element's declaration and the
+/// next state of its container's DFA are found by indexing arrays.
+///
+class Grammar
+{
+    friend EVOstream& operator<<(EVOstream& stream, const Grammar& grammar);
+
+public:
+    static const int kNoSymbol;     ///< Symbol ID returned for an element name that has not been interned.
+
+
+    /// Constructs an empty grammar.
+    ///
+    Grammar();
+
+    /// Destroys a grammar and all its declarations.
+    ///
+    virtual ~Grammar();
+
+
+    /// Registers an element declaration.
+    ///
+    /// @param elementName      [in] Name of the element being declared.
+    /// @param contentModel     [in] Content model for the element as constructed by expat.
+    ///
+    void AddElementDecl(const XML_Char* elementName, const XML_Content *contentModel);
+
+    /// Registers an attribute declaration.
+    ///
+    /// @param elementName      [in] Name of the element containing the attribute.
+    /// @param attrName         [in] Name of the attribute being declared.
+    /// @param attrType         [in] Type of the attribute.
+    /// @param defValue         [in] Default value for the attribute, or NULL if no default.
+    /// @param isRequired       [in] Non-zero if the attribute is required.
+    ///
+    void AddAttributeDecl(const XML_Char* elementName, const XML_Char* attrName,
+                        const XML_Char* attrType, const XML_Char* defValue,
+                        int isRequired);
+
+    /// Registers a notation declaration.
+    ///
+    /// @param notationName     [in] Name for the notation.
+    ///
+    void AddNotationDecl(const XML_Char* notationName) {
+        m_notations.Insert(notationName);
+    }
+
+    /// Registers an entity declaration.
+    ///
+    /// @param entityName       [in] Name for the entity.
+    ///
+    void AddEntityDecl(const XML_Char* entityName) {
+        m_entities.Insert(entityName);
+    }
+
+
+    /// Indicates whether anything has been declared in the grammar.
+    ///
+    /// @return <b>true</b> if there are no declarations in the grammar.
+    ///
+    bool IsEmpty() const {
+        return m_elementDecls.empty() && m_notations.IsEmpty() && m_entities.IsEmpty();
+    }
+
+
+    /// Returns the symbol ID assigned to the specified element name,
+    /// assigning the next ID if the name has not been seen before.
+    /// Symbol IDs are assigned consecutively starting at zero.
+    ///
+    /// @param elementName  [in] Element name to intern.
+    ///
+    /// @return Symbol ID for the element name.
+    ///
+    int     InternSymbol(const EVString& elementName);
+
+    /// Returns the symbol ID assigned to the specified element name.
+    ///
+    /// @param elementName  [in] Element name to look up.
+    ///
+    /// @return Symbol ID for the element name, or kNoSymbol if the name
+    ///         has not been interned.
+    ///
+    int     FindSymbol(const XML_Char* elementName) const {
+        SymbolIter_c iter = m_symbolIds.find(elementName);
+        return (iter == m_symbolIds.end()) ? kNoSymbol : (*iter).second;
+    }
+
+    /// Returns the declaration for the specified element.
+    ///
+    /// @param symbol       [in] Symbol ID of the element whose declaration is desired.
+    ///
+    /// @return Declaration object for the specified element or NULL if the
+    ///         declaration could not be found.
+    ///
+    const ElementDecl* GetElementDecl(int symbol) const {
+        return (symbol == kNoSymbol) ? NULL : m_symbols[symbol].elementDecl;
+    }
+
+    /// Indicates whether the specified element has an element declaration.
+    ///
+    /// @param symbol       [in] Symbol ID of the element.
+    ///
+    /// @return <b>true</b> if the element has been declared.
+    ///
+    bool    IsDeclared(int symbol) const {
+        return (symbol != kNoSymbol) && m_symbols[symbol].declared;
+    }
+
+    /// Indicates whether the specified element allows PCDATA.
+    ///
+    /// @param symbol       [in] Symbol ID of the element.
+    ///
+    /// @return <b>true</b> if the element allows PCDATA. An element that
+    ///         has not been declared is assumed to allow PCDATA.
+    ///
+    bool    IsMixed(int symbol) const {
+        return (symbol == kNoSymbol) ? true : m_symbols[symbol].mixed;
+    }
+
+    /// Returns the names of all elements that have an element declaration.
+    ///
+    /// @return A set of element names.
+    ///
+    const SymbolSet&    GetDeclaredElements() const { return m_declaredElements; }
+
+
+    /// Indicates whether the specified notation has been declared.
+    ///
+    /// @param notationName     [in] Name of the notation.
+    ///
+    /// @return <b>true</b> if the notation has been declared.
+    ///
+    bool    HasNotation(const XML_Char* notationName) const {
+        return m_notations.Contains(notationName);
+    }
+
+    /// Indicates whether the specified entity has been declared.
+    ///
+    /// @param entityName       [in] Name of the entity (need not be NUL terminated).
+    /// @param len              [in] Number of characters in the name.
+    ///
+    /// @return <b>true</b> if the entity has been declared.
+    ///
+    bool    HasEntity(const XML_Char* entityName, size_t len) const {
+        return m_entities.Contains(entityName, len);
+    }
+
+protected:
+    typedef std::map<EVString, ElementDecl*>    ElementDeclMap;     ///< Maps an element name to its declaration.
+    typedef ElementDeclMap::iterator            ElementDeclIter;    ///< Iterator over the element declaration map.
+    typedef ElementDeclMap::const_iterator      ElementDeclIter_c;  ///< Constant iterator over the element declaration map.
+    typedef std::map<EVString, DFA*>            DFAMap;             ///< Maps the signature of a content model to its validation DFA.
+    typedef DFAMap::iterator                    DFAIter;            ///< Iterator over the DFA map.
+    typedef DFAMap::const_iterator              DFAIter_c;          ///< Constant iterator over the DFA map.
+    typedef std::unordered_map<EVString, int>   SymbolIdMap;        ///< Maps an element name to its symbol ID.
+    typedef SymbolIdMap::const_iterator         SymbolIter_c;       ///< Constant iterator over the symbol ID map.
+
+
+    /// Information about an element, indexed by the element's symbol ID.
+    ///
+    struct Symbol
+    {
+        Symbol() : elementDecl(NULL), mixed(true), declared(false) { }
+
+        ElementDecl *elementDecl;       ///< Element declaration, or NULL if the element has not been declared.
+        bool        mixed;              ///< Indicates if the element accepts PCDATA.
+        bool        declared;           ///< Indicates if the element has an element declaration.
+    };
+
+    typedef std::vector<Symbol>                 SymbolList;         ///< Element information indexed by symbol ID.
+
+
+    /// Purposely undefined.
+    ///
+    Grammar(const Grammar& grammar);
+
+    /// Purposely undefined.
+    ///
+    Grammar& operator=(const Grammar& grammar);
+
+
+    /// Returns the declaration for the specified element, creating it if
+    /// it has not already been created.
+    ///
+    /// @param elementName  [in] Name of the element whose declaration is desired.
+    ///
+    /// @return Declaration object for the specified element.
+    ///
+    ElementDecl*    CreateElementDecl(const XML_Char* elementName);
+
+    DFAMap              m_dfas;                 ///< DFAs for all elements.
+    ElementDeclMap      m_elementDecls;         ///< Element declarations.
+    SymbolIdMap         m_symbolIds;            ///< Symbol IDs of the interned element names.
+    SymbolList          m_symbols;              ///< Element information indexed by symbol ID.
+    SymbolSet           m_declaredElements;     ///< Elements with an element declaration.
+    NameSet             m_notations;            ///< Set of notations.
+    NameSet             m_entities;             ///< Set of entities.
+};
+
+
+typedef std::shared_ptr<const Grammar>  GrammarPtr;     ///< Reference to a grammar shared between validators.
+
+
 /// The star of the show, this call performs XML validation for the expat
 /// parser. An application instantiates a Validator object and ties it
 /// into the expat parser via the parser's handler functions.
@@ -197,7 +557,9 @@ public:
 /// The validator constructs a DFA for each element's content model using
 /// the venerable algorithm 3.5 from the Dragon book. Optimizations bypass
 /// the algorithm and directly construct the DFA for simple content models
-/// (e.g. singletons, pure choice, pure sequence).
+/// (e.g. singletons, pure choice, pure sequence). The DFAs built by the
+/// algorithm are minimized so that equivalent states are merged. Elements
+/// with identical content models share a single DFA.
 ///
 /// The validator is a C++ object with methods that you call from expat
 /// handlers. The method parameters are of the same types as those passed
@@ -218,6 +580,13 @@ public:
 ///     <tr><td>CharacterData</td>      <td>XML_CharacterDataHandler</td></tr>
 /// </table>
 ///
+/// The declarations are compiled into the validator's Grammar. The validator
+/// itself holds only the state of the document being validated (e.g. the open
+/// element stack and the IDs). Once the DTD has been declared, its grammar can
+/// be shared with other validators by calling ShareGrammar and passing the
+/// result to their SetGrammar method, so that they need not compile the DTD
+/// again. A validator using a shared grammar ignores declarations.
+///
 /// Encoding uses expat's XML_Char encoding based on whether XML_UNICODE is
 /// defined. exval defines the types ev::EVString and ev::EVOStream but these
 /// are just convenience wrappers around the appropriate STL string and stream
@@ -253,7 +622,8 @@ public:
     }
 
     /// Deletes the entire state of the validator bringing it back to
-    /// its newly constructed state. All DFA's and other maps are cleared.
+    /// its newly constructed state. The validator's grammar is released
+    /// and replaced with an empty grammar.
     ///
     void Clear();
 
@@ -264,6 +634,31 @@ public:
     ///
     void Reset();
 
+
+    /// Returns the validator's grammar and marks it as shared. Declarations
+    /// made to the validator after this call are ignored, so that the grammar
+    /// is not modified while it is used by other validators.
+    ///
+    /// @return The validator's grammar.
+    ///
+    GrammarPtr          ShareGrammar();
+
+    /// Uses the specified shared grammar in place of the validator's
+    /// grammar. Declarations made to the validator after this call are
+    /// ignored.
+    ///
+    /// @param grammar      [in] Grammar obtained from the ShareGrammar method
+    ///                     of another validator.
+    ///
+    void                SetGrammar(const GrammarPtr& grammar);
+
+    /// Returns the validator's grammar.
+    ///
+    /// @return The validator's grammar.
+    ///
+    const Grammar&      GetGrammar() const { return *m_grammar; }
+
+
     /// Call this method from the expat XML_ElementDeclHandler to register
     /// an element declaration with the validator. The method takes the name
     /// of the element and its content model as provided by expat.
@@ -271,7 +666,11 @@ public:
     /// @param elementName      [in] Name of the element being declared.
     /// @param contentModel     [in] Content model for the element as constructed by expat.
     ///
-    void AddElementDecl(const XML_Char* elementName, const XML_Content *contentModel);
+    void AddElementDecl(const XML_Char* elementName, const XML_Content *contentModel) {
+        if (m_declGrammar != NULL) {
+            m_declGrammar->AddElementDecl(elementName, contentModel);
+        }
+    }
 
     /// Call this method from the expat XML_AttlistDeclHandler to register
     /// an attribute declaration. The method takes the name of the element
@@ -287,7 +686,11 @@ public:
     ///
     void AddAttributeDecl(const XML_Char* elementName, const XML_Char* attrName,
                         const XML_Char* attrType, const XML_Char* defValue,
-                        int isRequired);
+                        int isRequired) {
+        if (m_declGrammar != NULL) {
+            m_declGrammar->AddAttributeDecl(elementName, attrName, attrType, defValue, isRequired);
+        }
+    }
 
     /// Call this method from the expat XML_NotationDeclHandler to register
     /// a notation declaration. The method takes the name of the notation as
@@ -296,7 +699,9 @@ public:
     /// @param notationName     [in] Name for the notation.
     ///
     void AddNotationDecl(const XML_Char* notationName) {
-        m_notations.insert(notationName);
+        if (m_declGrammar != NULL) {
+            m_declGrammar->AddNotationDecl(notationName);
+        }
     }
 
     /// Call this method from the expat XML_EntityDeclHandler to register
@@ -306,7 +711,9 @@ public:
     /// @param entityName       [in] Name for the entity.
     ///
     void AddEntityDecl(const XML_Char* entityName) {
-        m_entities.insert(entityName);
+        if (m_declGrammar != NULL) {
+            m_declGrammar->AddEntityDecl(entityName);
+        }
     }
 
     /// An XML file must have a single top level element, known as the
@@ -338,10 +745,33 @@ public:
     SymbolSet           GetAllowableElements() const;
 
     /// Returns the set of elements that are allowable for an ANY element.
+    /// These are all the declared elements other than the document element.
     ///
     /// @return A set of element names.
     ///
-    const SymbolSet&    GetAnyElements() const { return m_anyElements; }
+    SymbolSet           GetAnyElements() const;
+
+    /// Returns the symbol ID assigned to the specified element name.
+    ///
+    /// @param elementName  [in] Element name to look up.
+    ///
+    /// @return Symbol ID for the element name, or kNoSymbol if the name
+    ///         has not been interned.
+    ///
+    int                 FindSymbol(const XML_Char* elementName) const {
+        return m_grammar->FindSymbol(elementName);
+    }
+
+    /// Indicates whether the specified element is allowable in an ANY
+    /// element.
+    ///
+    /// @param symbol       [in] Symbol ID of the element.
+    ///
+    /// @return <b>true</b> if the element is allowable in an ANY element.
+    ///
+    bool                IsAnySymbol(int symbol) const {
+        return m_grammar->IsDeclared(symbol) && (symbol != m_documentSymbol);
+    }
 
     /// Call this method from the expat XML_StartElementHandler to
     /// test whether the element is valid according to the content
@@ -402,29 +832,12 @@ public:
         // If we cannot find the element (e.g. no DTD), just assume
         // it takes PCDATA
         //
-        MixedIter iter = m_mixedElements.find(elementName);
-        return ((iter == m_mixedElements.end()) ? true : (*iter).second);
+        return m_grammar->IsMixed(m_grammar->FindSymbol(elementName));
     }
 
 protected:
-    typedef std::map<EVString, ElementDecl*>    ElementDeclMap;     ///< Maps an element name to its declaration.
-    typedef ElementDeclMap::iterator            ElementDeclIter;    ///< Iterator over the element declaration map.
-    typedef ElementDeclMap::const_iterator      ElementDeclIter_c;  ///< Constant iterator over the element declaration map.
     typedef std::stack<const ElementDecl*>      ElementStack;       ///< Open element stack.
-    typedef std::map<EVString, bool>            MixedMap;           ///< Indicates whether the specified element name accepts PCDATA.
-    typedef MixedMap::const_iterator            MixedIter;          ///< Iterates over the element PCDATA map.
     typedef std::stack<const State*>            StateStack;         ///< Validation DFA state stack.
-    typedef std::set<EVString>                  IDSet;              ///< Element ID set.
-    typedef IDSet::const_iterator               IDIter_c;           ///< Iterator over the element ID set.
-    typedef std::set<EVString>                  IDRefSet;           ///< IDREF set.
-    typedef IDRefSet::const_iterator            IDRefIter_c;        ///< Iterator over the IDREF set.
-    typedef std::set<EVString>                  NotationSet;        ///< Set of notations.
-    typedef NotationSet::const_iterator         NotationIter_c;     ///< Iterator over the set of notations.
-    typedef std::set<EVString>                  EntitySet;          ///< Set of entities.
-    typedef EntitySet::const_iterator           EntityIter_c;       ///< Iterator over the set of entities.
-    typedef std::map<EVString, DFA*>            DFAMap;             ///< Maps the name of an element to its validation DFA.
-    typedef DFAMap::iterator                    DFAIter;            ///< Iterator over the DFA map.
-    typedef DFAMap::const_iterator              DFAIter_c;          ///< Constant iterator over the DFA map.
 
 
     /// Purposely undefined.
@@ -438,26 +851,14 @@ protected:
 
     /// Indicates whether the specified element is the document element.
     ///
-    /// @param elementName      [in] Name of element to test.
+    /// @param symbol       [in] Symbol ID of the element to test.
     ///
     /// @return <b>true</b> if the specified element is the document element.
     ///
-    bool    IsDocumentElement(const XML_Char* elementName) const {
+    bool    IsDocumentElement(int symbol) const {
         if (m_documentElement.empty())
             return true;
-        return (m_documentElement == elementName);
-    }
-
-    /// Returns the declaration for the specified element.
-    ///
-    /// @param elementName  [in] Name of element whose declaration is desired.
-    ///
-    /// @return Declaration object for the specified element or NULL if the
-    ///         declaration could not be found.
-    ///
-    const ElementDecl* GetElementDecl(const EVString& elementName) const {
-        ElementDeclIter_c iter = m_elementDecls.find(elementName);
-        return (iter == m_elementDecls.end()) ? NULL : (*iter).second;
+        return (m_documentSymbol == symbol);
     }
 
     /// Indicates whether the specified set of attributes contains the
@@ -551,6 +952,31 @@ protected:
     ///
     bool    IsWhitespace(const XML_Char* str, int len) const;
 
+    /// Tests whether the specified character separates the tokens of an
+    /// attribute value (e.g. IDREFS, ENTITIES).
+    ///
+    /// @param ch       [in] Character to test.
+    ///
+    /// @return <b>true</b> if the character is XML whitespace.
+    ///
+    static bool IsSeparator(XML_Char ch) {
+        return (ch == EV_T('\x20')) || (ch == EV_T('\x09')) || (ch == EV_T('\x0D')) || (ch == EV_T('\x0A'));
+    }
+
+    /// Locates the next token in an attribute value consisting of a list
+    /// of whitespace separated tokens (e.g. IDREFS, ENTITIES). The token
+    /// is not copied.
+    ///
+    /// @param str      [in, out] Position in the NUL terminated attribute
+    ///                 value. On return, the position following the token.
+    /// @param token    [out] Start of the token.
+    /// @param len      [out] Number of characters in the token.
+    ///
+    /// @return <b>true</b> if a token was found, <b>false</b> if the end
+    ///         of the attribute value has been reached.
+    ///
+    static bool NextToken(const XML_Char*& str, const XML_Char*& token, size_t& len);
+
     /// Sends the specified error message to the validation handler.
     ///
     /// @param parser               [in] XML parser.
@@ -565,21 +991,29 @@ protected:
 
     IValidationHandler  *m_handler;             ///< Validation error handler object.
     EVString            m_documentElement;      ///< XML document element.
-    DFAMap              m_dfas;                 ///< DFAs for all elements.
-    ElementDeclMap      m_elementDecls;         ///< Element declarations.
-    MixedMap            m_mixedElements;        ///< Elements that can contain PCDATA.
-    SymbolSet           m_anyElements;          ///< Set of elements allowable in ANY.
+    int                 m_documentSymbol;       ///< Symbol ID of the document element, once validation has started.
+    GrammarPtr          m_grammar;              ///< Compiled DTD.
+    Grammar             *m_declGrammar;         ///< Grammar accepting declarations, or NULL if the grammar is shared.
     ElementStack        m_elementStack;         ///< Open element stack.
     StateStack          m_dfaStateStack;        ///< DFA stack stack.
-    IDSet               m_ids;                  ///< ID set.
-    IDRefSet            m_idRefs;               ///< IDREF set.
-    NotationSet         m_notations;            ///< Set of notations.
-    EntitySet           m_entities;             ///< Set of entities.
+    NameSet             m_ids;                  ///< IDs defined in the document.
+    NameSet             m_unresolvedIdRefs;     ///< IDREF values seen before the ID they reference.
     bool                m_foundDocumentElement; ///< Indicates if document element found.
     bool                m_errorShutdown;        ///< Indicates if validation error should stop due to errors.
 };
 
 
+/// Output stream operator for a grammar. Used to dump the
+/// declarations of the grammar to the specified output stream
+/// for debugging purposes.
+///
+/// @param stream       [in] Output stream.
+/// @param grammar      [in] Grammar object to output.
+///
+/// @return Output stream.
+///
+EVOstream& operator<<(EVOstream& stream, const Grammar& grammar);
+
 /// Output stream operator for a validator. Used to dump the
 /// state of the validator to the specified output stream for
 /// debugging purposes.
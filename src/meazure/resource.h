@@ -170,6 +170,7 @@
 #define IDC_MEA_ORIGIN_MARKER           1178
 #define IDC_MASTER_RESET                1179
 #define IDC_SCREENGRABS_DIR             1180
+#define IDC_MEA_POSITION_LIST           1181
 #define ID_MEA_CURSOR                   32771
 #define ID_MEA_POINT                    32772
 #define ID_MEA_LINE                     32773
@@ -227,6 +228,9 @@
 #define ID_MEA_UNITS_CUSTOM             32844
 #define ID_MEA_UNITS_DEF_CUSTOM         32845
 #define ID_MEA_GRAB_RGN                 32848
+#define ID_MEA_MERGE_POSITIONS          32851
+#define ID_MEA_EXPORT_POSITIONS         32852
+#define ID_MEA_IMPORT_POSITIONS         32853
 #define IDS_MEA_PIXELS                  61204
 #define IDS_MEA_CM                      61205
 #define IDS_MEA_MM                      61206
@@ -391,6 +395,17 @@
 #define IDS_MEA_CIRCLE_STATUS           61367
 #define IDS_MEA_PREC_MIN                61368
 #define IDS_MEA_PREC_VALUE              61369
+#define IDS_MEA_MERGE_LOG_DLG           61370
+#define IDS_MEA_NO_MERGE_LOG            61371
+#define IDS_MEA_EXPORT_LOG_DLG          61372
+#define IDS_MEA_IMPORT_LOG_DLG          61373
+#define IDS_MEA_NO_EXPORT_LOG           61374
+#define IDS_MEA_NO_IMPORT_LOG           61375
+#define IDS_MEA_BAD_IMPORT_LINE         61376
+#define IDS_MEA_POSLIST_NUM             61377
+#define IDS_MEA_POSLIST_TOOL            61378
+#define IDS_MEA_POSLIST_DATE            61379
+#define IDS_MEA_POSLIST_DESC            61380
 
 // Next default values for new objects
 // 
@@ -398,8 +413,8 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_3D_CONTROLS                     1
 #define _APS_NEXT_RESOURCE_VALUE        165
-#define _APS_NEXT_COMMAND_VALUE         32851
-#define _APS_NEXT_CONTROL_VALUE         1181
+#define _APS_NEXT_COMMAND_VALUE         32854
+#define _APS_NEXT_CONTROL_VALUE         1182
 #define _APS_NEXT_SYMED_VALUE           129
 #endif
 #endif
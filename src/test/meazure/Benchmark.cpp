@@ -0,0 +1,98 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Runs the Meazure benchmarks.
+///
+/// The benchmarks are run by hand and are not part of the test suite.
+/// With no arguments every benchmark is run with its default settings.
+/// Otherwise the named benchmark is run and is passed the remaining
+/// arguments:
+///
+/// @code
+///     MeazureBenchmark [name [args...]]
+/// @endcode
+
+#include "StdAfx.h"
+#include "Benchmark.h"
+#include <iostream>
+
+CWinApp theApp;
+
+
+using namespace std;
+
+
+namespace
+{
+    /// A benchmark that can be run from the command line.
+    ///
+    struct Benchmark
+    {
+        const char* name;                           ///< Name used to run the benchmark.
+        int (*run)(int argc, char* argv[]);         ///< Runs the benchmark.
+    };
+
+    const Benchmark kBenchmarks[] = {
+        { "Exval",            RunExvalBenchmark },
+        { "GUID",             RunGUIDBenchmark },
+        { "PositionBatch",    RunPositionBatchBenchmark },
+        { "PositionIndex",    RunPositionIndexBenchmark },
+        { "PositionLogText",  RunPositionLogTextBenchmark },
+        { "PositionPoints",   RunPositionPointsBenchmark },
+        { "PositionStore",    RunPositionStoreBenchmark },
+        { "XMLParser",        RunXMLParserBenchmark },
+        { "XMLWriter",        RunXMLWriterBenchmark }
+    };
+
+    const int kNumBenchmarks = sizeof(kBenchmarks) / sizeof(kBenchmarks[0]);
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
+        cerr << "Fatail Error: MFC initialization failed\n";
+        return 1;
+    }
+
+    if (argc > 1) {
+        for (int i = 0; i < kNumBenchmarks; i++) {
+            if (_stricmp(argv[1], kBenchmarks[i].name) == 0) {
+                return kBenchmarks[i].run(argc - 2, argv + 2);
+            }
+        }
+
+        cerr << "Usage: MeazureBenchmark [name [args...]]\nBenchmarks:";
+        for (int i = 0; i < kNumBenchmarks; i++) {
+            cerr << ' ' << kBenchmarks[i].name;
+        }
+        cerr << '\n';
+        return 1;
+    }
+
+    int numFailed = 0;
+    for (int i = 0; i < kNumBenchmarks; i++) {
+        cout << "*** " << kBenchmarks[i].name << '\n';
+        if (kBenchmarks[i].run(0, NULL) != 0) {
+            numFailed++;
+        }
+    }
+    return (numFailed == 0) ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Support shared by the benchmarks in the MeazureBenchmark program.
+
+#pragma once
+
+#include <psapi.h>
+
+
+/// Measures elapsed wall clock time using the high resolution
+/// performance counter.
+///
+class BenchmarkTimer
+{
+public:
+    /// Constructs a timer and starts it.
+    ///
+    BenchmarkTimer() {
+        QueryPerformanceFrequency(&m_frequency);
+        Start();
+    }
+
+    /// Restarts the timer.
+    ///
+    void Start() { QueryPerformanceCounter(&m_start); }
+
+    /// Returns the time since the timer was started.
+    ///
+    /// @return Elapsed time, in milliseconds.
+    ///
+    double GetElapsedMs() const {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        return static_cast<double>(now.QuadPart - m_start.QuadPart) * 1000.0 / m_frequency.QuadPart;
+    }
+
+private:
+    LARGE_INTEGER   m_frequency;    ///< Counts per second of the performance counter.
+    LARGE_INTEGER   m_start;        ///< Performance counter when the timer was started.
+};
+
+
+/// Returns the private memory committed by the process.
+///
+/// @return Private bytes of the process.
+///
+inline SIZE_T GetPrivateBytes()
+{
+    PROCESS_MEMORY_COUNTERS_EX counters;
+    counters.cb = sizeof(counters);
+    GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters),
+                         sizeof(counters));
+    return counters.PrivateUsage;
+}
+
+
+// Entry points of the benchmarks, each defined in the benchmark's own
+// file. The arguments are those following the benchmark name on the
+// command line. Each returns 0 if the benchmark ran successfully.
+//
+
+int RunExvalBenchmark(int argc, char* argv[]);
+int RunGUIDBenchmark(int argc, char* argv[]);
+int RunPositionBatchBenchmark(int argc, char* argv[]);
+int RunPositionIndexBenchmark(int argc, char* argv[]);
+int RunPositionLogTextBenchmark(int argc, char* argv[]);
+int RunPositionPointsBenchmark(int argc, char* argv[]);
+int RunPositionStoreBenchmark(int argc, char* argv[]);
+int RunXMLParserBenchmark(int argc, char* argv[]);
+int RunXMLWriterBenchmark(int argc, char* argv[]);
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Benchmark of the XML validator.
+///
+/// A synthetic 100 MB position log is parsed with and without validation
+/// to measure the cost of validating each element, and many small logs are
+/// validated with and without sharing the compiled DTD:
+///
+/// @code
+///     MeazureBenchmark Exval
+/// @endcode
+
+#include "StdAfx.h"
+#include "Benchmark.h"
+#include "ValidatingParser.h"
+#include <exval.h>
+#include <iostream>
+#include <string>
+#include <string.h>
+
+
+using namespace std;
+
+
+namespace
+{
+    /// Parses a synthetic position log with or without validation. The
+    /// log is fed to the parser a block of positions at a time, so the
+    /// whole log is never held in memory.
+    ///
+    /// @param validate     [in] true to validate the log as it is parsed.
+    /// @param block        [in] Block of positions repeated to form the log.
+    /// @param numBlocks    [in] Number of times the block is repeated.
+    /// @param ms           [out] Time taken to parse the log, in milliseconds.
+    ///
+    /// @return true if the log was parsed without error.
+    ///
+    bool ParsePositionLog(bool validate, const string& block, int numBlocks, double& ms)
+    {
+        ValidatingParser parser(validate);
+        BenchmarkTimer timer;
+
+        string head = string(kPositionLogDTD) + kPositionLogStart;
+        if (!parser.Parse(head.c_str(), static_cast<int>(head.size()), false)) {
+            return false;
+        }
+        for (int i = 0; i < numBlocks; i++) {
+            if (!parser.Parse(block.c_str(), static_cast<int>(block.size()), false)) {
+                return false;
+            }
+        }
+        if (!parser.Parse(kPositionLogEnd, static_cast<int>(strlen(kPositionLogEnd)), true)) {
+            return false;
+        }
+
+        ms = timer.GetElapsedMs();
+        return !parser.HaveError();
+    }
+
+    /// Validates many small position logs, compiling the DTD for each log
+    /// and sharing a single compiled DTD among all logs.
+    ///
+    /// @return true if the logs were validated without error.
+    ///
+    bool BenchmarkSharedGrammar()
+    {
+        const int kNumLogs = 2000;
+        string log = MakeLog(MakePosition(1));
+
+        BenchmarkTimer timer;
+        for (int i = 0; i < kNumLogs; i++) {
+            ValidatingParser parser;
+            if (!parser.Parse(log) || parser.HaveError()) {
+                return false;
+            }
+        }
+        double compileMs = timer.GetElapsedMs();
+
+        ev::GrammarPtr grammar;
+        {
+            ValidatingParser parser;
+            if (!parser.Parse(log)) {
+                return false;
+            }
+            grammar = parser.GetValidator().ShareGrammar();
+        }
+
+        timer.Start();
+        for (int i = 0; i < kNumLogs; i++) {
+            ValidatingParser parser;
+            parser.GetValidator().SetGrammar(grammar);
+            if (!parser.Parse(log) || parser.HaveError()) {
+                return false;
+            }
+        }
+        double sharedMs = timer.GetElapsedMs();
+
+        cout << "Compiled DTD per log: " << kNumLogs << " logs in " << compileMs << " ms\n";
+        cout << "Shared compiled DTD: " << kNumLogs << " logs in " << sharedMs << " ms ("
+             << (compileMs / sharedMs) << "x)\n";
+        return true;
+    }
+
+    /// Parses a 100 MB position log with and without validation and
+    /// reports the cost of validation.
+    ///
+    /// @return true if the log was parsed without error.
+    ///
+    bool BenchmarkPositionLog()
+    {
+        const int kPositionsPerBlock = 1000;
+        const double kLogBytes = 100.0 * 1024.0 * 1024.0;
+
+        string block;
+        for (int i = 0; i < kPositionsPerBlock; i++) {
+            block += MakePosition(i);
+        }
+
+        int numBlocks = static_cast<int>(kLogBytes / block.size()) + 1;
+        double mbytes = static_cast<double>(block.size()) * numBlocks / (1024.0 * 1024.0);
+        int numPositions = numBlocks * kPositionsPerBlock;
+
+        double parseMs;
+        double validateMs;
+        if (!ParsePositionLog(false, block, numBlocks, parseMs) ||
+            !ParsePositionLog(true, block, numBlocks, validateMs)) {
+            return false;
+        }
+
+        cout << "Position log: " << mbytes << " MB, " << numPositions << " positions\n";
+        cout << "Parse only: " << parseMs << " ms (" << (mbytes * 1000.0 / parseMs) << " MB/s)\n";
+        cout << "Parse and validate: " << validateMs << " ms (" << (mbytes * 1000.0 / validateMs) << " MB/s)\n";
+        cout << "Validation: " << (validateMs - parseMs) << " ms ("
+             << ((validateMs - parseMs) * 1000000.0 / (numPositions * 10.0)) << " ns per element)\n";
+        return true;
+    }
+}
+
+
+int RunExvalBenchmark(int /* argc */, char* /* argv */[])
+{
+    bool ok = BenchmarkSharedGrammar();
+    ok = BenchmarkPositionLog() && ok;
+    return ok ? 0 : 1;
+}
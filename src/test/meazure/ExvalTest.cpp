@@ -0,0 +1,322 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include "ValidatingParser.h"
+#include <exval.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <boost/test/included/unit_test_framework.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+CWinApp theApp;
+
+
+using namespace std;
+using namespace boost::unit_test;
+using boost::unit_test_framework::test_suite;
+
+
+namespace
+{
+
+    void TestValidLog()
+    {
+        ValidatingParser parser;
+
+        BOOST_REQUIRE(parser.Parse(MakeLog(MakePosition(1) + MakePosition(2))));
+        BOOST_CHECK(!parser.HaveError());
+    }
+
+    void TestInvalidLogs()
+    {
+        {
+            // Points must precede the properties.
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(MakeLog(
+                "<position desktopRef=\"desktop1\" tool=\"PointTool\" date=\"2011-03-05T12:34:56Z\">"
+                "<properties/><points><point name=\"1\" x=\"0\" y=\"0\"/></points></position>")));
+            BOOST_CHECK(parser.HaveError());
+            BOOST_CHECK_EQUAL(parser.GetErrorCode(), ev::ValidationError::InvalidElement);
+        }
+        {
+            // A position must have points.
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(MakeLog(
+                "<position desktopRef=\"desktop1\" tool=\"PointTool\" date=\"2011-03-05T12:34:56Z\">"
+                "<desc>No points</desc></position>")));
+            BOOST_CHECK(parser.HaveError());
+            BOOST_CHECK_EQUAL(parser.GetErrorCode(), ev::ValidationError::InvalidElementPattern);
+        }
+        {
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(MakeLog("<bogus/>")));
+            BOOST_CHECK(parser.HaveError());
+            BOOST_CHECK_EQUAL(parser.GetErrorCode(), ev::ValidationError::UndeclaredElement);
+        }
+        {
+            // The document element must match the DOCTYPE declaration.
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(string(kPositionLogDTD) + "<positions/>"));
+            BOOST_CHECK(parser.HaveError());
+            BOOST_CHECK_EQUAL(parser.GetErrorCode(), ev::ValidationError::InvalidDocumentElement);
+        }
+        {
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(MakeLog(MakePosition(1, "desktop2"))));
+            BOOST_CHECK(parser.HaveError());
+            BOOST_CHECK_EQUAL(parser.GetErrorCode(), ev::ValidationError::IdNotFound);
+        }
+    }
+
+    void TestSymbols()
+    {
+        ValidatingParser parser;
+        ev::Validator& validator = parser.GetValidator();
+
+        BOOST_REQUIRE(parser.Parse(MakeLog("")));
+        BOOST_CHECK(!parser.HaveError());
+
+        int positionSymbol = validator.FindSymbol("position");
+        BOOST_CHECK(positionSymbol != ev::Grammar::kNoSymbol);
+        BOOST_CHECK(validator.FindSymbol("points") != positionSymbol);
+        BOOST_CHECK_EQUAL(validator.FindSymbol("bogus"), ev::Grammar::kNoSymbol);
+
+        // The document element is not allowed in ANY content.
+        BOOST_CHECK(validator.IsAnySymbol(positionSymbol));
+        BOOST_CHECK(!validator.IsAnySymbol(validator.FindSymbol("positionLog")));
+        BOOST_CHECK(!validator.IsAnySymbol(ev::Grammar::kNoSymbol));
+        BOOST_CHECK(validator.GetAnyElements().count("position") == 1);
+        BOOST_CHECK(validator.GetAnyElements().count("positionLog") == 0);
+
+        BOOST_CHECK(validator.IsMixed("desc"));
+        BOOST_CHECK(!validator.IsMixed("points"));
+        BOOST_CHECK(validator.IsMixed("bogus"));
+
+        ev::Grammar grammar;
+        int newSymbol = grammar.InternSymbol("bogus");
+        BOOST_CHECK_EQUAL(grammar.FindSymbol("bogus"), newSymbol);
+        BOOST_CHECK_EQUAL(grammar.InternSymbol("bogus"), newSymbol);
+        BOOST_CHECK(!grammar.IsDeclared(newSymbol));
+        BOOST_CHECK(grammar.IsEmpty());
+    }
+
+    void TestSharedGrammar()
+    {
+        ValidatingParser firstParser;
+        BOOST_REQUIRE(firstParser.Parse(MakeLog(MakePosition(1))));
+        BOOST_CHECK(!firstParser.HaveError());
+
+        ev::GrammarPtr grammar = firstParser.GetValidator().ShareGrammar();
+        BOOST_REQUIRE(grammar);
+        BOOST_CHECK(!grammar->IsEmpty());
+
+        // The DTD declarations are ignored by a validator using a shared
+        // grammar, so the grammar is not modified.
+        {
+            ValidatingParser parser;
+            parser.GetValidator().SetGrammar(grammar);
+            BOOST_REQUIRE(parser.Parse(MakeLog(MakePosition(1) + MakePosition(2))));
+            BOOST_CHECK(!parser.HaveError());
+            BOOST_CHECK(&parser.GetValidator().GetGrammar() == grammar.get());
+        }
+        {
+            ValidatingParser parser;
+            parser.GetValidator().SetGrammar(grammar);
+            BOOST_REQUIRE(parser.Parse(MakeLog(
+                "<position desktopRef=\"desktop1\" tool=\"PointTool\" date=\"2011-03-05T12:34:56Z\">"
+                "<desc>No points</desc></position>")));
+            BOOST_CHECK(parser.HaveError());
+            BOOST_CHECK_EQUAL(parser.GetErrorCode(), ev::ValidationError::InvalidElementPattern);
+        }
+
+        // The grammar outlives the validator that compiled it.
+        firstParser.GetValidator().Clear();
+        BOOST_CHECK(firstParser.GetValidator().GetGrammar().IsEmpty());
+        BOOST_CHECK(!grammar->IsEmpty());
+        BOOST_CHECK(grammar->IsDeclared(grammar->FindSymbol("positionLog")));
+    }
+
+    void TestNameSet()
+    {
+        ev::NameSet names;
+
+        BOOST_CHECK(names.IsEmpty());
+        BOOST_CHECK(!names.Contains("a"));
+
+        BOOST_CHECK(names.Insert("abc"));
+        BOOST_CHECK(!names.Insert("abc"));
+        BOOST_CHECK(names.Insert("abcd", 2));
+        BOOST_CHECK(names.Contains("ab"));
+        BOOST_CHECK(names.Contains("abc"));
+        BOOST_CHECK(!names.Contains("abcd"));
+        BOOST_CHECK(names.Contains("abcd", 3));
+        BOOST_CHECK_EQUAL(names.GetCount(), 2);
+        BOOST_CHECK_EQUAL(string(names.GetName(0)), "abc");
+        BOOST_CHECK_EQUAL(string(names.GetName(1)), "ab");
+
+        // Grow the table well beyond its initial size.
+        for (int i = 0; i < 10000; i++) {
+            ostringstream name;
+            name << "id" << i;
+            BOOST_REQUIRE(names.Insert(name.str().c_str()));
+        }
+        BOOST_CHECK_EQUAL(names.GetCount(), 10002);
+        BOOST_CHECK(names.Contains("id0"));
+        BOOST_CHECK(names.Contains("id9999"));
+        BOOST_CHECK(!names.Contains("id10000"));
+        BOOST_CHECK_EQUAL(string(names.GetName(10001)), "id9999");
+
+        names.Clear();
+        BOOST_CHECK(names.IsEmpty());
+        BOOST_CHECK(!names.Contains("abc"));
+        BOOST_CHECK(!names.Contains("id0"));
+        BOOST_CHECK(names.Insert("id0"));
+        BOOST_CHECK(names.Contains("id0"));
+    }
+
+    /// Returns a document whose internal subset declares ID, IDREF,
+    /// IDREFS, ENTITY and NOTATION attributes.
+    ///
+    string MakeRefDoc(const string& body)
+    {
+        return string(
+            "<?xml version=\"1.0\"?>\n"
+            "<!DOCTYPE doc [\n"
+            "<!NOTATION png SYSTEM \"image/png\">\n"
+            "<!NOTATION gif SYSTEM \"image/gif\">\n"
+            "<!ENTITY logo SYSTEM \"logo.png\" NDATA png>\n"
+            "<!ENTITY icon SYSTEM \"icon.gif\" NDATA gif>\n"
+            "<!ELEMENT doc (item|ref|image)*>\n"
+            "<!ELEMENT item EMPTY>\n"
+            "<!ATTLIST item id ID #REQUIRED>\n"
+            "<!ELEMENT ref EMPTY>\n"
+            "<!ATTLIST ref to IDREF #IMPLIED all IDREFS #IMPLIED>\n"
+            "<!ELEMENT image EMPTY>\n"
+            "<!ATTLIST image src ENTITY #IMPLIED srcs ENTITIES #IMPLIED type NOTATION (png|gif) #IMPLIED>\n"
+            "]>\n"
+            "<doc>") + body + "</doc>\n";
+    }
+
+    void TestIds()
+    {
+        {
+            // References to IDs both before and after their definition.
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(MakeRefDoc(
+                "<item id=\"a\"/><ref to=\"a\"/><ref to=\"b\" all=\"a  b\"/><item id=\"b\"/>")));
+            BOOST_CHECK(!parser.HaveError());
+        }
+        {
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(MakeRefDoc("<item id=\"a\"/><ref all=\"a c\"/><item id=\"b\"/>")));
+            BOOST_CHECK(parser.HaveError());
+            BOOST_CHECK_EQUAL(parser.GetErrorCode(), ev::ValidationError::IdNotFound);
+        }
+        {
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(MakeRefDoc("<item id=\"a\"/><item id=\"a\"/>")));
+            BOOST_CHECK(parser.HaveError());
+            BOOST_CHECK_EQUAL(parser.GetErrorCode(), ev::ValidationError::DuplicateId);
+        }
+        {
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(MakeRefDoc(
+                "<image src=\"logo\" srcs=\"logo icon\" type=\"gif\"/>")));
+            BOOST_CHECK(!parser.HaveError());
+        }
+        {
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(MakeRefDoc("<image srcs=\"logo banner\"/>")));
+            BOOST_CHECK(parser.HaveError());
+            BOOST_CHECK_EQUAL(parser.GetErrorCode(), ev::ValidationError::UndeclaredEntity);
+        }
+    }
+
+    void TestMinimizedDFA()
+    {
+        const string dtd =
+            "<?xml version=\"1.0\"?>\n"
+            "<!DOCTYPE doc [\n"
+            "<!ELEMENT doc ((a,b)|(c,b))>\n"
+            "<!ELEMENT a EMPTY>\n"
+            "<!ELEMENT b EMPTY>\n"
+            "<!ELEMENT c EMPTY>\n"
+            "]>\n";
+
+        {
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(dtd + "<doc><a/><b/></doc>"));
+            BOOST_CHECK(!parser.HaveError());
+
+            // The states following a and c are merged, leaving the start,
+            // before b and accepting states of doc, and the state of the
+            // EMPTY DFA shared by a, b and c.
+            ostringstream dump;
+            dump << parser.GetValidator().GetGrammar();
+            string text = dump.str();
+            int numStates = 0;
+            for (string::size_type pos = text.find("State: "); pos != string::npos; pos = text.find("State: ", pos + 1)) {
+                numStates++;
+            }
+            BOOST_CHECK_EQUAL(numStates, 4);
+        }
+        {
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(dtd + "<doc><c/><b/></doc>"));
+            BOOST_CHECK(!parser.HaveError());
+        }
+        {
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(dtd + "<doc><c/></doc>"));
+            BOOST_CHECK(parser.HaveError());
+            BOOST_CHECK_EQUAL(parser.GetErrorCode(), ev::ValidationError::InvalidElementPattern);
+        }
+        {
+            ValidatingParser parser;
+            BOOST_REQUIRE(parser.Parse(dtd + "<doc><a/><c/></doc>"));
+            BOOST_CHECK(parser.HaveError());
+            BOOST_CHECK_EQUAL(parser.GetErrorCode(), ev::ValidationError::InvalidElement);
+        }
+    }
+}
+
+
+test_suite* init_unit_test_suite(int argc, char* argv[])
+{
+    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
+        cerr << "Fatail Error: MFC initialization failed\n";
+        return NULL;
+    }
+
+    test_suite* suite = BOOST_TEST_SUITE("Exval Tests");
+    suite->add(BOOST_TEST_CASE(&TestValidLog));
+    suite->add(BOOST_TEST_CASE(&TestInvalidLogs));
+    suite->add(BOOST_TEST_CASE(&TestSymbols));
+    suite->add(BOOST_TEST_CASE(&TestSharedGrammar));
+    suite->add(BOOST_TEST_CASE(&TestNameSet));
+    suite->add(BOOST_TEST_CASE(&TestIds));
+    suite->add(BOOST_TEST_CASE(&TestMinimizedDFA));
+    return suite;
+}
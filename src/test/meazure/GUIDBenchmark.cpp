@@ -0,0 +1,100 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Benchmark of maps keyed by MeaGUID.
+///
+/// GUIDs are inserted into and looked up in maps ordered by the string
+/// form of the GUID, by the GUID fields, and by hash:
+///
+/// @code
+///     MeazureBenchmark GUID
+/// @endcode
+
+#include "StdAfx.h"
+#include "Benchmark.h"
+#include <GUID.h>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <iostream>
+
+
+using namespace std;
+
+
+namespace
+{
+    /// Reproduces the string based ordering MeaGUID::less used before
+    /// comparing the GUID fields directly.
+    struct StringLess {
+        bool operator()(const MeaGUID& lhs, const MeaGUID& rhs) const
+        {
+            return lhs.ToString() < rhs.ToString();
+        }
+    };
+
+    /// Inserts the GUIDs into a map and then finds each of them repeatedly.
+    ///
+    /// @return false if a GUID was not found.
+    ///
+    template <class Map>
+    bool BenchmarkMap(const char* title, const vector<MeaGUID>& guids)
+    {
+        const int kRepeat = 10;
+        Map guidMap;
+        int found = 0;
+
+        BenchmarkTimer timer;
+        for (vector<MeaGUID>::const_iterator iter = guids.begin(); iter != guids.end(); ++iter) {
+            guidMap[*iter] = 1;
+        }
+        double insertMs = timer.GetElapsedMs();
+
+        timer.Start();
+        for (int i = 0; i < kRepeat; i++) {
+            for (vector<MeaGUID>::const_iterator iter = guids.begin(); iter != guids.end(); ++iter) {
+                found += guidMap.find(*iter)->second;
+            }
+        }
+        double findMs = timer.GetElapsedMs();
+
+        cout << title << ": insert " << guids.size() << " in " << insertMs
+             << " ms, find " << (guids.size() * kRepeat) << " in " << findMs << " ms\n";
+
+        return found == static_cast<int>(guids.size()) * kRepeat;
+    }
+}
+
+
+int RunGUIDBenchmark(int /* argc */, char* /* argv */[])
+{
+    const int kNumGuids = 20000;
+    vector<MeaGUID> guids;
+
+    for (int i = 0; i < kNumGuids; i++) {
+        guids.push_back(MeaGUID());
+    }
+
+    bool ok = BenchmarkMap<map<MeaGUID, int, StringLess> >("string less", guids);
+    ok = BenchmarkMap<map<MeaGUID, int, MeaGUID::less> >("binary less", guids) && ok;
+    ok = BenchmarkMap<unordered_map<MeaGUID, int> >("hash", guids) && ok;
+
+    return ok ? 0 : 1;
+}
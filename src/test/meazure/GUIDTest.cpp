@@ -20,6 +20,7 @@
 #include "StdAfx.h"
 #include <GUID.h>
 #include <set>
+#include <unordered_set>
 #include <boost/test/included/unit_test_framework.hpp>
 #include <boost/test/included/unit_test.hpp>
 
@@ -257,7 +258,7 @@ namespace
         GUID guid2 = guid1;
         validateEqual(guid1, guid2);
         
-        LPCTSTR guid3Str = guid1;
+        CString guid3Str = guid1.ToString();
         MeaGUID guid3(guid3Str);
         validateEqual(guid1, guid3);
     }
@@ -283,11 +284,64 @@ namespace
         guidSet.insert(guid3);
         
         iter = guidSet.find(guid2);
-        BOOST_CHECK_EQUAL(guid2, *iter);
+        BOOST_CHECK(guid2 == *iter);
         iter = guidSet.find(guid1);
-        BOOST_CHECK_EQUAL(guid1, *iter);
+        BOOST_CHECK(guid1 == *iter);
         iter = guidSet.find(guid3);
-        BOOST_CHECK_EQUAL(guid3, *iter);
+        BOOST_CHECK(guid3 == *iter);
+    }
+    
+    void TestCompare()
+    {
+        MeaGUID guid1(_T("6B29FC40-CA47-1067-B31D-00DD010662DA"));
+        MeaGUID guid2(_T("6B29FC40-CA47-1067-B31D-00DD010662DB"));
+        MeaGUID guid3(_T("7B29FC40-0A47-0067-031D-00DD010662DA"));
+        MeaGUID guid4(guid1);
+        MeaGUID::less lessThan;
+        
+        BOOST_CHECK(guid1.Compare(guid2) < 0);
+        BOOST_CHECK(guid2.Compare(guid1) > 0);
+        BOOST_CHECK(guid2.Compare(guid3) < 0);
+        BOOST_CHECK_EQUAL(0, guid1.Compare(guid4));
+        
+        // The binary order must match the lexical order of the strings.
+        for (int i = 0; i < 100; i++) {
+            MeaGUID lhs;
+            MeaGUID rhs;
+            BOOST_CHECK_EQUAL(lessThan(lhs, rhs), lhs.ToString() < rhs.ToString());
+        }
+    }
+    
+    void TestHash()
+    {
+        std::hash<MeaGUID> hasher;
+        MeaGUID guid1;
+        MeaGUID guid2(guid1.ToString());
+        
+        BOOST_CHECK_EQUAL(hasher(guid1), hasher(guid2));
+        BOOST_CHECK_EQUAL(guid1.GetHash(), hasher(guid1));
+        
+        std::unordered_set<MeaGUID> guidSet;
+        MeaGUID guid3;
+        MeaGUID guid4;
+        guidSet.insert(guid1);
+        guidSet.insert(guid3);
+        
+        BOOST_CHECK(guidSet.find(guid2) != guidSet.end());
+        BOOST_CHECK(guidSet.find(guid3) != guidSet.end());
+        BOOST_CHECK(guidSet.find(guid4) == guidSet.end());
+    }
+    
+    void TestToStringCopies()
+    {
+        MeaGUID guid(_T("6B29FC40-CA47-1067-B31D-00DD010662DA"));
+        CString str1 = guid.ToString();
+        
+        guid = _T("7B29FC40-CA47-1067-B31D-00DD010662DA");
+        CString str2 = guid.ToString();
+        
+        BOOST_CHECK(str1 == _T("6B29FC40-CA47-1067-B31D-00DD010662DA"));
+        BOOST_CHECK(str2 == _T("7B29FC40-CA47-1067-B31D-00DD010662DA"));
     }
 }
 
@@ -315,5 +369,8 @@ test_suite* init_unit_test_suite(int argc, char* argv[])
     suite->add(BOOST_TEST_CASE(&TestCast));
     suite->add(BOOST_TEST_CASE(&TestToString));
     suite->add(BOOST_TEST_CASE(&TestLess));
+    suite->add(BOOST_TEST_CASE(&TestCompare));
+    suite->add(BOOST_TEST_CASE(&TestHash));
+    suite->add(BOOST_TEST_CASE(&TestToStringCopies));
     return suite;
 }
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Benchmark of the batch conversion of positions.
+///
+/// One million positions stored by position and stored by field in a
+/// batch are converted, on one screen and on two screens:
+///
+/// @code
+///     MeazureBenchmark PositionBatch
+/// @endcode
+
+#include "StdAfx.h"
+#include "Benchmark.h"
+#include <PositionBatch.h>
+#include <DataDisplay.h>
+#include <iostream>
+#include <vector>
+#include <math.h>
+
+
+using namespace std;
+
+
+namespace
+{
+    const UINT kLineFields = MeaX1Field | MeaY1Field | MeaX2Field | MeaY2Field |
+                             MeaWidthField | MeaHeightField | MeaDistanceField | MeaAngleField;
+
+    FPOINT MakePoint(double x, double y)
+    {
+        FPOINT pt;
+        pt.x = x;
+        pt.y = y;
+        return pt;
+    }
+
+    MeaPositionBatch::Scale MakeScale(double left, double top, double right, double bottom, double fx, double fy)
+    {
+        MeaPositionBatch::Scale scale;
+        scale.rect.left = left;
+        scale.rect.top = top;
+        scale.rect.right = right;
+        scale.rect.bottom = bottom;
+        scale.factor.cx = fx;
+        scale.factor.cy = fy;
+        return scale;
+    }
+
+    /// A position stored by position rather than by field, for comparison.
+    ///
+    struct PositionRecord
+    {
+        UINT    fieldMask;
+        FPOINT  points[MeaPositionPoints::kNumPointIds];
+        double  width;
+        double  height;
+        double  distance;
+        double  area;
+        double  angle;
+    };
+
+    bool IsClose(double value, double expected)
+    {
+        return fabs(value - expected) <= fabs(expected) * 1e-11;
+    }
+}
+
+
+int RunPositionBatchBenchmark(int /* argc */, char* /* argv */[])
+{
+    const int kNumPositions = 1000000;
+
+    MeaPositionBatch::ScaleList oneScreen;
+    oneScreen.push_back(MakeScale(0.0, 0.0, 2000.0, 2000.0, 2.54, 2.54));
+
+    // The two screen conversion is applied to the positions after the
+    // one screen conversion, so its rectangles are scaled to match.
+    MeaPositionBatch::ScaleList twoScreens;
+    twoScreens.push_back(MakeScale(0.0, 0.0, 2540.0, 5080.0, 2.54, 2.54));
+    twoScreens.push_back(MakeScale(2540.0, 0.0, 5080.0, 5080.0, 1.27, 1.27));
+
+    vector<PositionRecord> records(kNumPositions);
+    for (int i = 0; i < kNumPositions; i++) {
+        PositionRecord& record = records[i];
+        record.fieldMask = kLineFields;
+        record.points[MeaPositionPoints::Point1] = MakePoint(i % 2000, i % 1000);
+        record.points[MeaPositionPoints::Point2] = MakePoint(i % 2000 + 3.0, i % 1000 + 4.0);
+        record.points[MeaPositionPoints::PointV] = MakePoint(0.0, 0.0);
+        record.width = 3.0;
+        record.height = 4.0;
+        record.distance = 5.0;
+        record.area = 12.0;
+        record.angle = 0.5;
+    }
+
+    BenchmarkTimer timer;
+    for (int i = 0; i < kNumPositions; i++) {
+        PositionRecord& record = records[i];
+        double fx = oneScreen[0].factor.cx;
+        double fy = oneScreen[0].factor.cy;
+
+        for (int id = 0; id < MeaPositionPoints::kNumPointIds; id++) {
+            record.points[id].x *= fx;
+            record.points[id].y *= fy;
+        }
+        record.width *= fx;
+        record.height *= fy;
+        record.distance *= fx;
+        record.area *= fx * fy;
+        record.angle *= 2.0;
+    }
+    double recordMs = timer.GetElapsedMs();
+    cout << "By position, one screen: " << kNumPositions << " positions in " << recordMs << " ms\n";
+
+    MeaPositionBatch batch;
+    batch.Reserve(kNumPositions);
+
+    timer.Start();
+    for (int i = 0; i < kNumPositions; i++) {
+        MeaPositionPoints points;
+        points.SetPoint(MeaPositionPoints::Point1, MakePoint(i % 2000, i % 1000));
+        points.SetPoint(MeaPositionPoints::Point2, MakePoint(i % 2000 + 3.0, i % 1000 + 4.0));
+        batch.Add(kLineFields, points, 3.0, 4.0, 5.0, 12.0, 0.5);
+    }
+    cout << "Batch fill: " << kNumPositions << " positions in " << timer.GetElapsedMs() << " ms\n";
+
+    timer.Start();
+    batch.Convert(oneScreen, 2.0);
+    double batchMs = timer.GetElapsedMs();
+    cout << "By field, one screen: " << kNumPositions << " positions in " << batchMs << " ms ("
+         << (recordMs / batchMs) << "x)\n";
+
+    timer.Start();
+    batch.Convert(twoScreens, 1.0);
+    cout << "By field, two screens: " << kNumPositions << " positions in " << timer.GetElapsedMs() << " ms\n";
+
+    // Position 1001 is on the second screen in the last conversion.
+    FPOINT pt;
+    bool ok = batch.GetPoint(1001, MeaPositionPoints::Point1, pt) &&
+              IsClose(pt.x, 1001.0 * 2.54 * 1.27) &&
+              IsClose(records[1001].points[MeaPositionPoints::Point1].x, 1001.0 * 2.54);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include <PositionBatch.h>
+#include <DataDisplay.h>
+#include <iostream>
+#include <math.h>
+#include <boost/test/included/unit_test_framework.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+CWinApp theApp;
+
+
+using namespace std;
+using namespace boost::unit_test;
+using boost::unit_test_framework::test_suite;
+
+
+namespace
+{
+    const UINT kLineFields = MeaX1Field | MeaY1Field | MeaX2Field | MeaY2Field |
+                             MeaWidthField | MeaHeightField | MeaDistanceField | MeaAngleField;
+
+    FPOINT MakePoint(double x, double y)
+    {
+        FPOINT pt;
+        pt.x = x;
+        pt.y = y;
+        return pt;
+    }
+
+    MeaPositionBatch::Scale MakeScale(double left, double top, double right, double bottom, double fx, double fy)
+    {
+        MeaPositionBatch::Scale scale;
+        scale.rect.left = left;
+        scale.rect.top = top;
+        scale.rect.right = right;
+        scale.rect.bottom = bottom;
+        scale.factor.cx = fx;
+        scale.factor.cy = fy;
+        return scale;
+    }
+
+    int AddLine(MeaPositionBatch& batch, double x1, double y1, double x2, double y2)
+    {
+        MeaPositionPoints points;
+        points.SetPoint(MeaPositionPoints::Point1, MakePoint(x1, y1));
+        points.SetPoint(MeaPositionPoints::Point2, MakePoint(x2, y2));
+
+        double width = fabs(x2 - x1);
+        double height = fabs(y2 - y1);
+        return batch.Add(kLineFields, points, width, height, sqrt(width * width + height * height),
+                         width * height, atan2(y2 - y1, x2 - x1));
+    }
+
+    void TestUniform()
+    {
+        MeaPositionBatch batch;
+        MeaPositionBatch::ScaleList scales;
+        FPOINT pt;
+
+        // An odd number of positions exercises the scalar tail of the
+        // conversion loops.
+        for (int i = 0; i < 5; i++) {
+            AddLine(batch, i, 2.0 * i, i + 3.0, 2.0 * i + 4.0);
+        }
+
+        MeaPositionPoints vertex;
+        vertex.SetPoint(MeaPositionPoints::PointV, MakePoint(1.0, -1.0));
+        batch.Add(MeaXVField | MeaYVField, vertex, 0.0, 0.0, 0.0, 0.0, 0.0);
+
+        scales.push_back(MakeScale(0.0, 0.0, 10.0, 10.0, 2.54, 2.54));
+        scales.push_back(MakeScale(10.0, 0.0, 20.0, 10.0, 2.54, 2.54));
+        batch.Convert(scales, 2.0);
+
+        BOOST_REQUIRE_EQUAL(batch.GetCount(), 6);
+        for (int i = 0; i < 5; i++) {
+            BOOST_CHECK_EQUAL(batch.GetFieldMask(i), kLineFields);
+            BOOST_REQUIRE(batch.GetPoint(i, MeaPositionPoints::Point1, pt));
+            BOOST_CHECK_CLOSE(pt.x + 1.0, 2.54 * i + 1.0, 1e-9);
+            BOOST_CHECK_CLOSE(pt.y + 1.0, 5.08 * i + 1.0, 1e-9);
+            BOOST_REQUIRE(batch.GetPoint(i, MeaPositionPoints::Point2, pt));
+            BOOST_CHECK_CLOSE(pt.x, 2.54 * (i + 3.0), 1e-9);
+            BOOST_CHECK(!batch.GetPoint(i, MeaPositionPoints::PointV, pt));
+            BOOST_CHECK_CLOSE(batch.GetWidth(i), 3.0 * 2.54, 1e-9);
+            BOOST_CHECK_CLOSE(batch.GetHeight(i), 4.0 * 2.54, 1e-9);
+            BOOST_CHECK_CLOSE(batch.GetDistance(i), 5.0 * 2.54, 1e-9);
+            BOOST_CHECK_CLOSE(batch.GetArea(i), 12.0 * 2.54 * 2.54, 1e-9);
+            BOOST_CHECK_CLOSE(batch.GetAngle(i), 2.0 * atan2(4.0, 3.0), 1e-9);
+        }
+
+        BOOST_CHECK(!batch.GetPoint(5, MeaPositionPoints::Point1, pt));
+        BOOST_REQUIRE(batch.GetPoint(5, MeaPositionPoints::PointV, pt));
+        BOOST_CHECK_CLOSE(pt.x, 2.54, 1e-9);
+        BOOST_CHECK_CLOSE(pt.y, -2.54, 1e-9);
+    }
+
+    void TestNonSquare()
+    {
+        MeaPositionBatch batch;
+        MeaPositionBatch::ScaleList scales;
+
+        AddLine(batch, 0.0, 0.0, 3.0, 4.0);
+
+        MeaPositionPoints center;
+        center.SetPoint(MeaPositionPoints::PointV, MakePoint(0.0, 0.0));
+        batch.Add(MeaXVField | MeaYVField | MeaDistanceField, center, 0.0, 0.0, 2.0, 0.0, 0.0);
+
+        scales.push_back(MakeScale(0.0, 0.0, 10.0, 10.0, 2.0, 3.0));
+        batch.Convert(scales, 1.0);
+
+        BOOST_CHECK_CLOSE(batch.GetWidth(0), 6.0, 1e-9);
+        BOOST_CHECK_CLOSE(batch.GetHeight(0), 12.0, 1e-9);
+        BOOST_CHECK_CLOSE(batch.GetDistance(0), sqrt(6.0 * 6.0 + 12.0 * 12.0), 1e-9);
+        BOOST_CHECK_CLOSE(batch.GetArea(0), 12.0 * 6.0, 1e-9);
+
+        // Without a width and height the distance has no direction.
+        BOOST_CHECK_CLOSE(batch.GetDistance(1), 2.0 * sqrt(6.0), 1e-9);
+    }
+
+    void TestScreens()
+    {
+        MeaPositionBatch batch;
+        MeaPositionBatch::ScaleList scales;
+        FPOINT pt;
+
+        AddLine(batch, 1.0, 1.0, 2.0, 2.0);         // Left screen
+        AddLine(batch, 11.0, 1.0, 12.0, 2.0);       // Right screen
+        AddLine(batch, 9.0, 1.0, 11.0, 1.0);        // Straddles both screens
+        AddLine(batch, 50.0, 50.0, 51.0, 51.0);     // Off all screens
+
+        // The y-axis is inverted, so the rectangles have their top below
+        // their bottom.
+        scales.push_back(MakeScale(0.0, 10.0, 10.0, 0.0, 2.0, 2.0));
+        scales.push_back(MakeScale(10.5, 10.0, 20.0, 0.0, 3.0, 3.0));
+        batch.Convert(scales, 1.0);
+
+        BOOST_REQUIRE(batch.GetPoint(0, MeaPositionPoints::Point2, pt));
+        BOOST_CHECK_CLOSE(pt.x, 4.0, 1e-9);
+        BOOST_CHECK_CLOSE(batch.GetWidth(0), 2.0, 1e-9);
+
+        BOOST_REQUIRE(batch.GetPoint(1, MeaPositionPoints::Point1, pt));
+        BOOST_CHECK_CLOSE(pt.x, 33.0, 1e-9);
+        BOOST_CHECK_CLOSE(batch.GetWidth(1), 3.0, 1e-9);
+        BOOST_CHECK_CLOSE(batch.GetArea(1), 9.0, 1e-9);
+
+        BOOST_REQUIRE(batch.GetPoint(2, MeaPositionPoints::Point1, pt));
+        BOOST_CHECK_CLOSE(pt.x, 18.0, 1e-9);
+        BOOST_REQUIRE(batch.GetPoint(2, MeaPositionPoints::Point2, pt));
+        BOOST_CHECK_CLOSE(pt.x, 33.0, 1e-9);
+        BOOST_CHECK_CLOSE(batch.GetWidth(2), 4.0, 1e-9);
+
+        BOOST_REQUIRE(batch.GetPoint(3, MeaPositionPoints::Point1, pt));
+        BOOST_CHECK_CLOSE(pt.x, 100.0, 1e-9);
+    }
+}
+
+
+test_suite* init_unit_test_suite(int argc, char* argv[])
+{
+    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
+        cerr << "Fatail Error: MFC initialization failed\n";
+        return NULL;
+    }
+
+    test_suite* suite = BOOST_TEST_SUITE("PositionBatch Tests");
+    suite->add(BOOST_TEST_CASE(&TestUniform));
+    suite->add(BOOST_TEST_CASE(&TestNonSquare));
+    suite->add(BOOST_TEST_CASE(&TestScreens));
+    return suite;
+}
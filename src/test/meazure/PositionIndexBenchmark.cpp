@@ -0,0 +1,135 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Benchmark of the position log query index.
+///
+/// A million positions are indexed and then queried by tool, time range
+/// and rectangle, and deleted:
+///
+/// @code
+///     MeazureBenchmark PositionIndex
+/// @endcode
+
+#include "StdAfx.h"
+#include "Benchmark.h"
+#include <PositionIndex.h>
+#include <iostream>
+#include <list>
+
+
+using namespace std;
+
+
+namespace
+{
+    /// The index refers to the points of a position rather than copying
+    /// them, so the points are kept in a list that outlives the index.
+    typedef list<MeaPositionPoints> PointsStore;
+
+    const MeaPositionPoints& MakePoints(PointsStore& store, double x, double y)
+    {
+        FPOINT pt;
+
+        store.push_back(MeaPositionPoints());
+        MeaPositionPoints& points = store.back();
+
+        pt.x = x;
+        pt.y = y;
+        points.SetPoint(MeaPositionPoints::Point1, pt);
+        pt.x = x + 10.0;
+        pt.y = y + 10.0;
+        points.SetPoint(MeaPositionPoints::Point2, pt);
+        return points;
+    }
+
+    FRECT MakeRect(double left, double top, double right, double bottom)
+    {
+        FRECT rect;
+        rect.left = left;
+        rect.top = top;
+        rect.right = right;
+        rect.bottom = bottom;
+        return rect;
+    }
+}
+
+
+int RunPositionIndexBenchmark(int /* argc */, char* /* argv */[])
+{
+    const int kNumPositions = 1000000;
+    const int kNumQueries = 100;
+    LPCTSTR tools[] = { _T("CursorTool"), _T("PointTool"), _T("LineTool"), _T("RectTool"),
+                        _T("CircleTool"), _T("AngleTool") };
+    const int kNumTools = sizeof(tools) / sizeof(tools[0]);
+    PointsStore store;
+    MeaPositionIndex index;
+    MeaPositionIndex::IndexList result;
+    BenchmarkTimer timer;
+    size_t found;
+    int i;
+
+    srand(1);
+
+    for (i = 0; i < kNumPositions; i++) {
+        CString timestamp;
+        timestamp.Format(_T("2011-%02d-%02dT%02d:%02d:%02dZ"), 1 + (i / 2592000) % 12,
+                         1 + (i / 86400) % 28, (i / 3600) % 24, (i / 60) % 60, i % 60);
+        index.Add(tools[i % kNumTools], timestamp,
+                  MakePoints(store, rand() % 4000, rand() % 3000));
+    }
+    cout << "index " << kNumPositions << " positions in " << timer.GetElapsedMs() << " ms\n";
+
+    found = 0;
+    timer.Start();
+    for (i = 0; i < kNumQueries; i++) {
+        index.FindTool(tools[i % kNumTools], result);
+        found += result.size();
+    }
+    cout << "tool query: " << (timer.GetElapsedMs() / kNumQueries) << " ms, "
+         << (found / kNumQueries) << " positions\n";
+
+    found = 0;
+    timer.Start();
+    for (i = 0; i < kNumQueries; i++) {
+        index.FindTimeRange(_T("2011-01-05T00:00:00Z"), _T("2011-01-05T01:00:00Z"), result);
+        found += result.size();
+    }
+    cout << "time range query: " << (timer.GetElapsedMs() / kNumQueries) << " ms, "
+         << (found / kNumQueries) << " positions\n";
+
+    found = 0;
+    timer.Start();
+    for (i = 0; i < kNumQueries; i++) {
+        double x = rand() % 3800;
+        double y = rand() % 2800;
+        index.FindInRect(MakeRect(x, y, x + 200.0, y + 200.0), result);
+        found += result.size();
+    }
+    cout << "rectangle query: " << (timer.GetElapsedMs() / kNumQueries) << " ms, "
+         << (found / kNumQueries) << " positions\n";
+
+    timer.Start();
+    for (i = 0; i < kNumQueries; i++) {
+        index.Delete(static_cast<unsigned int>(rand()) % index.Size(), 1);
+    }
+    cout << "delete: " << (timer.GetElapsedMs() / kNumQueries) << " ms\n";
+
+    return (index.Size() == static_cast<unsigned int>(kNumPositions - kNumQueries)) ? 0 : 1;
+}
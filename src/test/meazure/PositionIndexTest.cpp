@@ -0,0 +1,290 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ * 
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include <PositionIndex.h>
+#include <iostream>
+#include <list>
+#include <boost/test/included/unit_test_framework.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+CWinApp theApp;
+
+
+using namespace std;
+using namespace boost::unit_test;
+using boost::unit_test_framework::test_suite;
+
+
+namespace
+{
+    /// The index refers to the points of a position rather than copying
+    /// them, so the points are kept in a list that outlives the index.
+    typedef std::list<MeaPositionPoints> PointsStore;
+
+    const MeaPositionPoints& MakePoints(PointsStore& store, double x, double y)
+    {
+        FPOINT pt;
+
+        store.push_back(MeaPositionPoints());
+        MeaPositionPoints& points = store.back();
+
+        pt.x = x;
+        pt.y = y;
+        points.SetPoint(MeaPositionPoints::Point1, pt);
+        pt.x = x + 10.0;
+        pt.y = y + 10.0;
+        points.SetPoint(MeaPositionPoints::Point2, pt);
+        return points;
+    }
+
+    FRECT MakeRect(double left, double top, double right, double bottom)
+    {
+        FRECT rect;
+        rect.left = left;
+        rect.top = top;
+        rect.right = right;
+        rect.bottom = bottom;
+        return rect;
+    }
+
+    void PopulateIndex(MeaPositionIndex& index, PointsStore& store)
+    {
+        index.Add(_T("LineTool"),  _T("2011-01-01T00:00:00Z"), MakePoints(store, 0.0, 0.0));
+        index.Add(_T("PointTool"), _T("2011-01-02T00:00:00Z"), MakePoints(store, 100.0, 100.0));
+        index.Add(_T("LineTool"),  _T("2011-01-03T00:00:00Z"), MakePoints(store, 200.0, 200.0));
+        index.Add(_T("RectTool"),  _T("2011-01-04T00:00:00Z"), MakePoints(store, 300.0, 300.0));
+        index.Add(_T("LineTool"),  _T("2011-01-05T00:00:00Z"), MakePoints(store, 400.0, 400.0));
+    }
+
+    void TestFindTool()
+    {
+        PointsStore store;
+        MeaPositionIndex index;
+        MeaPositionIndex::IndexList result;
+
+        PopulateIndex(index, store);
+        BOOST_CHECK_EQUAL(index.Size(), 5U);
+
+        index.FindTool(_T("LineTool"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 3U);
+        BOOST_CHECK_EQUAL(result[0], 0U);
+        BOOST_CHECK_EQUAL(result[1], 2U);
+        BOOST_CHECK_EQUAL(result[2], 4U);
+
+        index.FindTool(_T("CircleTool"), result);
+        BOOST_CHECK(result.empty());
+    }
+
+    void TestFindTimeRange()
+    {
+        PointsStore store;
+        MeaPositionIndex index;
+        MeaPositionIndex::IndexList result;
+
+        PopulateIndex(index, store);
+
+        index.FindTimeRange(_T("2011-01-02T00:00:00Z"), _T("2011-01-04T00:00:00Z"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 3U);
+        BOOST_CHECK_EQUAL(result[0], 1U);
+        BOOST_CHECK_EQUAL(result[1], 2U);
+        BOOST_CHECK_EQUAL(result[2], 3U);
+
+        index.FindTimeRange(_T("2012-01-01T00:00:00Z"), _T("2012-12-31T00:00:00Z"), result);
+        BOOST_CHECK(result.empty());
+    }
+
+    void TestFindInRect()
+    {
+        PointsStore store;
+        MeaPositionIndex index;
+        MeaPositionIndex::IndexList result;
+
+        PopulateIndex(index, store);
+
+        index.FindInRect(MakeRect(95.0, 95.0, 205.0, 205.0), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 2U);
+        BOOST_CHECK_EQUAL(result[0], 1U);
+        BOOST_CHECK_EQUAL(result[1], 2U);
+
+        // Only the second point of the first position is in the rectangle.
+        //
+        index.FindInRect(MakeRect(5.0, 5.0, 15.0, 15.0), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 1U);
+        BOOST_CHECK_EQUAL(result[0], 0U);
+
+        // Inverted rectangle edges are accepted.
+        //
+        index.FindInRect(MakeRect(305.0, 305.0, 295.0, 295.0), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 1U);
+        BOOST_CHECK_EQUAL(result[0], 3U);
+
+        // A rectangle covering many more cells than are occupied.
+        //
+        index.FindInRect(MakeRect(-1.0e9, -1.0e9, 1.0e9, 1.0e9), result);
+        BOOST_CHECK_EQUAL(result.size(), 5U);
+
+        index.FindInRect(MakeRect(50.0, 50.0, 60.0, 60.0), result);
+        BOOST_CHECK(result.empty());
+    }
+
+    void TestReplace()
+    {
+        PointsStore store;
+        MeaPositionIndex index;
+        MeaPositionIndex::IndexList result;
+
+        PopulateIndex(index, store);
+        index.Replace(2, _T("CircleTool"), _T("2011-02-01T00:00:00Z"), MakePoints(store, 1000.0, 1000.0));
+
+        index.FindTool(_T("LineTool"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 2U);
+        BOOST_CHECK_EQUAL(result[0], 0U);
+        BOOST_CHECK_EQUAL(result[1], 4U);
+
+        index.FindTool(_T("CircleTool"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 1U);
+        BOOST_CHECK_EQUAL(result[0], 2U);
+
+        index.FindTimeRange(_T("2011-02-01T00:00:00Z"), _T("2011-02-01T00:00:00Z"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 1U);
+        BOOST_CHECK_EQUAL(result[0], 2U);
+
+        index.FindInRect(MakeRect(195.0, 195.0, 215.0, 215.0), result);
+        BOOST_CHECK(result.empty());
+
+        BOOST_CHECK_THROW(index.Replace(5, _T("LineTool"), _T(""), MakePoints(store, 0.0, 0.0)), std::out_of_range*);
+    }
+
+    void TestDelete()
+    {
+        PointsStore store;
+        MeaPositionIndex index;
+        MeaPositionIndex::IndexList result;
+
+        PopulateIndex(index, store);
+        index.Delete(1, 2);
+        BOOST_CHECK_EQUAL(index.Size(), 3U);
+
+        // The remaining positions are renumbered.
+        //
+        index.FindTool(_T("LineTool"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 2U);
+        BOOST_CHECK_EQUAL(result[0], 0U);
+        BOOST_CHECK_EQUAL(result[1], 2U);
+
+        index.FindTool(_T("RectTool"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 1U);
+        BOOST_CHECK_EQUAL(result[0], 1U);
+
+        index.Add(_T("PointTool"), _T("2011-01-06T00:00:00Z"), MakePoints(store, 500.0, 500.0));
+        index.FindTimeRange(_T("2011-01-04T00:00:00Z"), _T("2011-01-06T00:00:00Z"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 3U);
+        BOOST_CHECK_EQUAL(result[0], 1U);
+        BOOST_CHECK_EQUAL(result[1], 2U);
+        BOOST_CHECK_EQUAL(result[2], 3U);
+
+        index.Delete(0, 1);
+        index.FindInRect(MakeRect(-100.0, -100.0, 100.0, 100.0), result);
+        BOOST_CHECK(result.empty());
+
+        BOOST_CHECK_THROW(index.Delete(2, 2), std::out_of_range*);
+
+        index.Clear();
+        BOOST_CHECK_EQUAL(index.Size(), 0U);
+        index.FindTool(_T("LineTool"), result);
+        BOOST_CHECK(result.empty());
+    }
+
+    void TestCompact()
+    {
+        PointsStore store;
+        MeaPositionIndex index;
+        MeaPositionIndex::IndexList result;
+
+        // Deleting more positions than remain reassigns the IDs of the
+        // remaining positions.
+        //
+        PopulateIndex(index, store);
+        index.Delete(0, 3);
+        BOOST_CHECK_EQUAL(index.Size(), 2U);
+
+        index.FindTool(_T("LineTool"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 1U);
+        BOOST_CHECK_EQUAL(result[0], 1U);
+
+        index.FindTool(_T("RectTool"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 1U);
+        BOOST_CHECK_EQUAL(result[0], 0U);
+
+        index.FindTool(_T("PointTool"), result);
+        BOOST_CHECK(result.empty());
+
+        index.FindTimeRange(_T("2011-01-01T00:00:00Z"), _T("2011-12-31T00:00:00Z"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 2U);
+        BOOST_CHECK_EQUAL(result[0], 0U);
+        BOOST_CHECK_EQUAL(result[1], 1U);
+
+        index.FindInRect(MakeRect(-1.0e9, -1.0e9, 1.0e9, 1.0e9), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 2U);
+        BOOST_CHECK_EQUAL(result[0], 0U);
+        BOOST_CHECK_EQUAL(result[1], 1U);
+
+        // The compacted index continues to be updated.
+        //
+        index.Add(_T("PointTool"), _T("2011-01-06T00:00:00Z"), MakePoints(store, 500.0, 500.0));
+        index.Replace(0, _T("LineTool"), _T("2011-01-07T00:00:00Z"), MakePoints(store, 600.0, 600.0));
+
+        index.FindTool(_T("LineTool"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 2U);
+        BOOST_CHECK_EQUAL(result[0], 0U);
+        BOOST_CHECK_EQUAL(result[1], 1U);
+
+        index.FindInRect(MakeRect(295.0, 295.0, 315.0, 315.0), result);
+        BOOST_CHECK(result.empty());
+
+        index.Delete(1, 1);
+        index.FindInRect(MakeRect(495.0, 495.0, 615.0, 615.0), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 2U);
+        BOOST_CHECK_EQUAL(result[0], 0U);
+        BOOST_CHECK_EQUAL(result[1], 1U);
+    }
+}
+
+
+test_suite* init_unit_test_suite(int argc, char* argv[])
+{
+    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
+        cerr << "Fatail Error: MFC initialization failed\n";
+        return NULL;
+    }
+    
+    test_suite* suite = BOOST_TEST_SUITE("PositionIndex Tests");
+    suite->add(BOOST_TEST_CASE(&TestFindTool));
+    suite->add(BOOST_TEST_CASE(&TestFindTimeRange));
+    suite->add(BOOST_TEST_CASE(&TestFindInRect));
+    suite->add(BOOST_TEST_CASE(&TestReplace));
+    suite->add(BOOST_TEST_CASE(&TestDelete));
+    suite->add(BOOST_TEST_CASE(&TestCompact));
+    return suite;
+}
@@ -0,0 +1,653 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include <PositionLogBinary.h>
+#include <LogFileException.h>
+#include <vector>
+#include <iostream>
+#include <boost/test/included/unit_test_framework.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+CWinApp theApp;
+
+
+using namespace std;
+using namespace boost::unit_test;
+using boost::unit_test_framework::test_suite;
+
+
+namespace
+{
+    typedef vector<BYTE> Bytes;
+
+
+    MeaBinaryLogDesktop MakeDesktop(const MeaGUID& id, MeaBinaryLogWriter& writer)
+    {
+        MeaBinaryLogDesktop desktop;
+
+        memset(&desktop, 0, sizeof(desktop));
+        desktop.id = id;
+        desktop.sizeX = 1600.0;
+        desktop.sizeY = 1200.0;
+        desktop.linearUnitsStr = writer.AddString(_T("px"));
+        desktop.angularUnitsStr = writer.AddString(_T("deg"));
+        return desktop;
+    }
+
+    MeaBinaryLogScreen MakeScreen(double right, MeaBinaryLogWriter& writer)
+    {
+        MeaBinaryLogScreen screen;
+
+        memset(&screen, 0, sizeof(screen));
+        screen.right = right;
+        screen.bottom = 1200.0;
+        screen.resX = 96.0;
+        screen.resY = 96.0;
+        screen.descStr = writer.AddString(_T("Screen"));
+        return screen;
+    }
+
+    void AddPosition(const MeaGUID& desktopId, int i, MeaBinaryLogWriter& writer)
+    {
+        MeaBinaryLogPosition position;
+
+        writer.AddPoint(_T("1"), i, i + 0.5);
+        writer.AddPoint(_T("2"), i + 10.0, i + 10.5);
+
+        memset(&position, 0, sizeof(position));
+        position.toolStr = writer.AddString(_T("LineTool"));
+        position.timestampStr = writer.AddString(_T("2011-01-01T00:00:00Z"));
+        position.distance = i * 2.0;
+        writer.AddPosition(desktopId, position);
+    }
+
+    /// Builds a log with two desktops, the first with two screens and two
+    /// precisions, and three positions alternating between the desktops.
+    ///
+    void BuildLog(const MeaGUID& desktop1, const MeaGUID& desktop2, MeaBinaryLogWriter& writer)
+    {
+        writer.SetInfo(_T("Title"), _T("Description"));
+
+        writer.AddScreen(MakeScreen(800.0, writer));
+        writer.AddScreen(MakeScreen(1600.0, writer));
+        writer.AddPrecision(1);
+        writer.AddPrecision(2);
+        writer.AddDesktop(MakeDesktop(desktop1, writer));
+
+        writer.AddScreen(MakeScreen(1024.0, writer));
+        writer.AddDesktop(MakeDesktop(desktop2, writer));
+
+        AddPosition(desktop1, 0, writer);
+        AddPosition(desktop2, 1, writer);
+        AddPosition(desktop1, 2, writer);
+    }
+
+    Bytes GetBytes(const MeaBinaryLogWriter& writer)
+    {
+        CMemFile file;
+        writer.Write(file);
+
+        Bytes bytes(static_cast<size_t>(file.GetLength()));
+        file.SeekToBegin();
+        file.Read(&bytes[0], static_cast<UINT>(bytes.size()));
+        return bytes;
+    }
+
+    MeaBinaryLogHeader& GetHeader(Bytes& bytes)
+    {
+        return *reinterpret_cast<MeaBinaryLogHeader*>(&bytes[0]);
+    }
+
+    template <class T>
+    T& GetRecord(Bytes& bytes, UINT32 offset, UINT32 index)
+    {
+        return reinterpret_cast<T*>(&bytes[offset])[index];
+    }
+
+    bool IsValid(const Bytes& bytes)
+    {
+        MeaBinaryLogReader reader;
+
+        try {
+            reader.Open(&bytes[0], bytes.size());
+        }
+        catch (MeaLogFileException&) {
+            return false;
+        }
+        return true;
+    }
+
+    CString MakeTempPathname()
+    {
+        TCHAR dir[MAX_PATH];
+        TCHAR pathname[MAX_PATH];
+
+        GetTempPath(MAX_PATH, dir);
+        GetTempFileName(dir, _T("mea"), 0, pathname);
+        return pathname;
+    }
+
+    void WriteFile(const CString& pathname, const void* data, UINT size)
+    {
+        CFile file(pathname, CFile::modeCreate | CFile::modeWrite);
+        file.Write(data, size);
+        file.Close();
+    }
+
+    void SetFileLength(const CString& pathname, ULONGLONG length)
+    {
+        CFile file(pathname, CFile::modeWrite | CFile::modeNoTruncate);
+        file.SetLength(length);
+        file.Close();
+    }
+
+    ULONGLONG GetFileLength(const CString& pathname)
+    {
+        CFileStatus status;
+        return CFile::GetStatus(pathname, status) ? status.m_size : 0;
+    }
+
+    bool FileExists(const CString& pathname)
+    {
+        CFileStatus status;
+        return CFile::GetStatus(pathname, status) != FALSE;
+    }
+
+    /// Builds the log held by a journal entry for an added or replaced
+    /// position.
+    ///
+    void BuildEntryLog(const MeaGUID& desktopId, int i, MeaBinaryLogWriter& writer)
+    {
+        writer.AddScreen(MakeScreen(1600.0, writer));
+        writer.AddDesktop(MakeDesktop(desktopId, writer));
+        AddPosition(desktopId, i, writer);
+    }
+
+    /// Reads the next journal entry and checks its operation and position
+    /// index. For an entry with data, returns the distance of its position.
+    ///
+    double CheckEntry(const MeaBinaryLogJournal& journal, size_t& offset,
+                      MeaBinaryLogJournal::Operation op, int posIndex)
+    {
+        MeaBinaryLogJournalEntry entry;
+        const BYTE* data;
+
+        BOOST_REQUIRE(journal.GetEntry(offset, entry, data));
+        BOOST_CHECK_EQUAL(entry.op, static_cast<UINT32>(op));
+        BOOST_CHECK_EQUAL(entry.posIndex, posIndex);
+
+        if (entry.size == 0) {
+            BOOST_CHECK(data == NULL);
+            return 0.0;
+        }
+
+        MeaBinaryLogReader reader;
+        reader.Open(data, entry.size);
+        BOOST_CHECK_EQUAL(reader.GetHeader().desktopCount, 1U);
+        BOOST_REQUIRE_EQUAL(reader.GetHeader().positionCount, 1U);
+        return reader.GetPosition(0).distance;
+    }
+
+
+    void TestRoundTrip()
+    {
+        MeaGUID desktop1;
+        MeaGUID desktop2;
+        MeaBinaryLogWriter writer;
+
+        BuildLog(desktop1, desktop2, writer);
+        Bytes bytes = GetBytes(writer);
+
+        MeaBinaryLogReader reader;
+        reader.Open(&bytes[0], bytes.size());
+
+        const MeaBinaryLogHeader& header = reader.GetHeader();
+        BOOST_CHECK_EQUAL(header.desktopCount, 2U);
+        BOOST_CHECK_EQUAL(header.screenCount, 3U);
+        BOOST_CHECK_EQUAL(header.precisionCount, 2U);
+        BOOST_CHECK_EQUAL(header.positionCount, 3U);
+        BOOST_CHECK_EQUAL(header.pointCount, 6U);
+        BOOST_CHECK(reader.GetString(header.titleStr) == _T("Title"));
+        BOOST_CHECK(reader.GetString(header.descStr) == _T("Description"));
+
+        const MeaBinaryLogDesktop& d1 = reader.GetDesktop(0);
+        BOOST_CHECK(desktop1 == d1.id);
+        BOOST_CHECK_EQUAL(d1.firstScreen, 0U);
+        BOOST_CHECK_EQUAL(d1.screenCount, 2U);
+        BOOST_CHECK_EQUAL(d1.firstPrecision, 0U);
+        BOOST_CHECK_EQUAL(d1.precisionCount, 2U);
+        BOOST_CHECK_EQUAL(reader.GetPrecision(d1.firstPrecision + 1), 2);
+        BOOST_CHECK_EQUAL(reader.GetScreen(d1.firstScreen + 1).right, 1600.0);
+        BOOST_CHECK(reader.GetString(d1.linearUnitsStr) == _T("px"));
+
+        const MeaBinaryLogDesktop& d2 = reader.GetDesktop(1);
+        BOOST_CHECK(desktop2 == d2.id);
+        BOOST_CHECK_EQUAL(d2.firstScreen, 2U);
+        BOOST_CHECK_EQUAL(d2.screenCount, 1U);
+        BOOST_CHECK_EQUAL(d2.precisionCount, 0U);
+        BOOST_CHECK_EQUAL(reader.GetScreen(d2.firstScreen).right, 1024.0);
+
+        for (UINT32 i = 0; i < header.positionCount; i++) {
+            const MeaBinaryLogPosition& position = reader.GetPosition(i);
+
+            BOOST_CHECK_EQUAL(position.desktop, i % 2);
+            BOOST_CHECK_EQUAL(position.firstPoint, i * 2);
+            BOOST_CHECK_EQUAL(position.pointCount, 2U);
+            BOOST_CHECK_EQUAL(position.distance, i * 2.0);
+            BOOST_CHECK(reader.GetString(position.toolStr) == _T("LineTool"));
+            BOOST_CHECK(reader.GetString(position.descStr).IsEmpty());
+
+            const MeaBinaryLogPoint& point = reader.GetPoint(position.firstPoint + 1);
+            BOOST_CHECK(reader.GetString(point.nameStr) == _T("2"));
+            BOOST_CHECK_EQUAL(point.x, i + 10.0);
+            BOOST_CHECK_EQUAL(point.y, i + 10.5);
+        }
+
+        // Identical strings are stored once.
+        //
+        BOOST_CHECK_EQUAL(reader.GetPosition(0).toolStr, reader.GetPosition(2).toolStr);
+        BOOST_CHECK_EQUAL(reader.GetPosition(0).descStr, 0U);
+    }
+
+    void TestFile()
+    {
+        MeaGUID desktop1;
+        MeaGUID desktop2;
+        MeaBinaryLogWriter writer;
+
+        BuildLog(desktop1, desktop2, writer);
+        Bytes bytes = GetBytes(writer);
+
+        CString pathname(MakeTempPathname());
+        WriteFile(pathname, &bytes[0], static_cast<UINT>(bytes.size()));
+
+        BOOST_CHECK(MeaBinaryLogReader::IsBinaryLog(pathname));
+        {
+            MeaBinaryLogReader reader;
+            reader.Open(pathname);
+            BOOST_CHECK_EQUAL(reader.GetHeader().positionCount, 3U);
+            BOOST_CHECK(desktop2 == reader.GetDesktop(1).id);
+        }
+
+        const char text[] = "<?xml version=\"1.0\"?>";
+        WriteFile(pathname, text, sizeof(text) - 1);
+        BOOST_CHECK(!MeaBinaryLogReader::IsBinaryLog(pathname));
+        {
+            MeaBinaryLogReader reader;
+            BOOST_CHECK_THROW(reader.Open(pathname), MeaLogFileException);
+        }
+
+        DeleteFile(pathname);
+    }
+
+    void TestCorruptTables()
+    {
+        MeaGUID desktop1;
+        MeaGUID desktop2;
+        MeaBinaryLogWriter writer;
+
+        BuildLog(desktop1, desktop2, writer);
+        const Bytes good = GetBytes(writer);
+        BOOST_REQUIRE(IsValid(good));
+
+        {
+            Bytes bytes(good.begin(), good.begin() + sizeof(MeaBinaryLogHeader) - 1);
+            BOOST_CHECK(!IsValid(bytes));
+        }
+        {
+            Bytes bytes(good);
+            GetHeader(bytes).magic[0] = 'X';
+            BOOST_CHECK(!IsValid(bytes));
+        }
+        {
+            Bytes bytes(good);
+            GetHeader(bytes).formatVersion++;
+            BOOST_CHECK(!IsValid(bytes));
+        }
+        {
+            // The string table extends past the end of the data.
+            Bytes bytes(good.begin(), good.end() - 1);
+            BOOST_CHECK(!IsValid(bytes));
+        }
+        {
+            Bytes bytes(good);
+            GetHeader(bytes).positionCount = 0x10000000;
+            BOOST_CHECK(!IsValid(bytes));
+        }
+        {
+            Bytes bytes(good);
+            GetHeader(bytes).pointOffset = 0;
+            BOOST_CHECK(!IsValid(bytes));
+        }
+    }
+
+    void TestCorruptReferences()
+    {
+        MeaGUID desktop1;
+        MeaGUID desktop2;
+        MeaBinaryLogWriter writer;
+
+        BuildLog(desktop1, desktop2, writer);
+        const Bytes good = GetBytes(writer);
+        const MeaBinaryLogHeader header = *reinterpret_cast<const MeaBinaryLogHeader*>(&good[0]);
+
+        {
+            Bytes bytes(good);
+            GetHeader(bytes).titleStr = header.stringSize;
+            BOOST_CHECK(!IsValid(bytes));
+        }
+        {
+            Bytes bytes(good);
+            GetRecord<MeaBinaryLogPosition>(bytes, header.positionOffset, 1).toolStr = header.stringSize - 2;
+            BOOST_CHECK(!IsValid(bytes));
+        }
+        {
+            // A string whose character count runs past the string table.
+            Bytes bytes(good);
+            UINT32 count = header.stringSize;
+            memcpy(&bytes[header.stringOffset], &count, sizeof(count));
+            BOOST_CHECK(!IsValid(bytes));
+        }
+        {
+            Bytes bytes(good);
+            GetRecord<MeaBinaryLogPosition>(bytes, header.positionOffset, 2).desktop = header.desktopCount;
+            BOOST_CHECK(!IsValid(bytes));
+        }
+        {
+            Bytes bytes(good);
+            GetRecord<MeaBinaryLogPosition>(bytes, header.positionOffset, 2).pointCount = 3;
+            BOOST_CHECK(!IsValid(bytes));
+        }
+        {
+            Bytes bytes(good);
+            GetRecord<MeaBinaryLogDesktop>(bytes, header.desktopOffset, 1).screenCount = 2;
+            BOOST_CHECK(!IsValid(bytes));
+        }
+        {
+            Bytes bytes(good);
+            GetRecord<MeaBinaryLogDesktop>(bytes, header.desktopOffset, 0).firstPrecision = 0xFFFFFFFF;
+            BOOST_CHECK(!IsValid(bytes));
+        }
+        {
+            Bytes bytes(good);
+            GetRecord<MeaBinaryLogPoint>(bytes, header.pointOffset, 5).nameStr = header.stringSize;
+            BOOST_CHECK(!IsValid(bytes));
+        }
+    }
+
+    void TestJournalReplay()
+    {
+        CString log(MakeTempPathname());
+        WriteFile(log, "log", 3);
+
+        MeaGUID desktopId;
+        MeaBinaryLogWriter added;
+        MeaBinaryLogWriter replaced;
+        BuildEntryLog(desktopId, 4, added);
+        BuildEntryLog(desktopId, 5, replaced);
+
+        {
+            MeaBinaryLogJournal journal;
+            journal.Attach(log);
+            BOOST_CHECK(journal.IsAttached());
+            BOOST_CHECK_EQUAL(journal.GetSize(), 0U);
+            BOOST_CHECK_EQUAL(journal.GetEndOffset(), 0U);
+            BOOST_CHECK(!journal.Read());
+
+            journal.Append(MeaBinaryLogJournal::AddOp, 3, &added);
+            journal.Append(MeaBinaryLogJournal::ReplaceOp, 1, &replaced);
+            journal.Append(MeaBinaryLogJournal::DeleteOp, 0, NULL);
+            BOOST_CHECK(journal.GetSize() > sizeof(MeaBinaryLogJournalHeader));
+
+            journal.Detach();
+            BOOST_CHECK(!journal.IsAttached());
+        }
+
+        // The journal is read back by a new journal object, as it is when
+        // the log is next loaded.
+        //
+        MeaBinaryLogJournal journal;
+        journal.Attach(log);
+        BOOST_REQUIRE(journal.Read());
+
+        size_t offset = 0;
+        BOOST_CHECK_EQUAL(CheckEntry(journal, offset, MeaBinaryLogJournal::AddOp, 3), 8.0);
+        BOOST_CHECK_EQUAL(CheckEntry(journal, offset, MeaBinaryLogJournal::ReplaceOp, 1), 10.0);
+        CheckEntry(journal, offset, MeaBinaryLogJournal::DeleteOp, 0);
+
+        MeaBinaryLogJournalEntry entry;
+        const BYTE* data;
+        BOOST_CHECK(!journal.GetEntry(offset, entry, data));
+        BOOST_CHECK_EQUAL(offset, journal.GetEndOffset());
+
+        journal.Discard();
+        DeleteFile(log);
+    }
+
+    void TestJournalStale()
+    {
+        CString log(MakeTempPathname());
+        CString journalPathname(log + MeaBinaryLogJournal::kSuffix);
+        WriteFile(log, "log", 3);
+
+        MeaBinaryLogJournal journal;
+        journal.Attach(log);
+        journal.Append(MeaBinaryLogJournal::DeleteOp, 0, NULL);
+        BOOST_CHECK(FileExists(journalPathname));
+
+        // The log was saved without the journal being compacted into it,
+        // so the journal no longer applies and is discarded.
+        //
+        WriteFile(log, "saved log", 9);
+        BOOST_CHECK(!journal.Read());
+        BOOST_CHECK(!FileExists(journalPathname));
+
+        // A file that is not a journal is also discarded.
+        //
+        WriteFile(journalPathname, "not a journal, but long enough to hold a header", 48);
+        BOOST_CHECK(!journal.Read());
+        BOOST_CHECK(!FileExists(journalPathname));
+
+        DeleteFile(log);
+    }
+
+    void TestJournalPartialEntry()
+    {
+        CString log(MakeTempPathname());
+        CString journalPathname(log + MeaBinaryLogJournal::kSuffix);
+        WriteFile(log, "log", 3);
+
+        MeaGUID desktopId;
+        MeaBinaryLogWriter writer;
+        BuildEntryLog(desktopId, 1, writer);
+
+        MeaBinaryLogJournal journal;
+        journal.Attach(log);
+        journal.Append(MeaBinaryLogJournal::AddOp, 0, &writer);
+        size_t firstEnd = journal.GetEndOffset();
+        journal.Append(MeaBinaryLogJournal::AddOp, 1, &writer);
+
+        ULONGLONG headerSize = sizeof(MeaBinaryLogJournalHeader);
+        MeaBinaryLogJournalEntry entry;
+        const BYTE* data;
+        size_t offset;
+
+        // Meazure exited while writing the data of the second entry.
+        //
+        SetFileLength(journalPathname, GetFileLength(journalPathname) - 5);
+        BOOST_REQUIRE(journal.Read());
+        offset = 0;
+        CheckEntry(journal, offset, MeaBinaryLogJournal::AddOp, 0);
+        BOOST_CHECK(!journal.GetEntry(offset, entry, data));
+        BOOST_CHECK_EQUAL(offset, firstEnd);
+
+        // Meazure exited while writing the header of the second entry.
+        //
+        SetFileLength(journalPathname, headerSize + firstEnd + sizeof(entry) - 1);
+        BOOST_REQUIRE(journal.Read());
+        offset = 0;
+        CheckEntry(journal, offset, MeaBinaryLogJournal::AddOp, 0);
+        BOOST_CHECK(!journal.GetEntry(offset, entry, data));
+
+        // The partial entry is removed so that the next entry directly
+        // follows the first.
+        //
+        journal.Truncate(offset);
+        BOOST_CHECK_EQUAL(GetFileLength(journalPathname), headerSize + firstEnd);
+        BOOST_CHECK_EQUAL(journal.GetEndOffset(), firstEnd);
+
+        journal.Append(MeaBinaryLogJournal::DeleteOp, 0, NULL);
+        BOOST_REQUIRE(journal.Read());
+        offset = 0;
+        CheckEntry(journal, offset, MeaBinaryLogJournal::AddOp, 0);
+        CheckEntry(journal, offset, MeaBinaryLogJournal::DeleteOp, 0);
+        BOOST_CHECK(!journal.GetEntry(offset, entry, data));
+
+        journal.Discard();
+        DeleteFile(log);
+    }
+
+    void TestJournalRebase()
+    {
+        CString log(MakeTempPathname());
+        CString savedLog(MakeTempPathname());
+        WriteFile(log, "log", 3);
+
+        MeaBinaryLogJournal journal;
+        journal.Attach(log);
+        journal.Append(MeaBinaryLogJournal::DeleteOp, 0, NULL);
+        size_t offset = journal.GetEndOffset();
+        journal.Append(MeaBinaryLogJournal::DeleteOp, 7, NULL);
+
+        // The log was saved with the first change, while the second was
+        // journaled during the save.
+        //
+        WriteFile(savedLog, "saved log", 9);
+        journal.Rebase(savedLog, offset);
+        BOOST_CHECK(!FileExists(log + MeaBinaryLogJournal::kSuffix));
+        BOOST_REQUIRE(journal.Read());
+
+        size_t entryOffset = 0;
+        MeaBinaryLogJournalEntry entry;
+        const BYTE* data;
+        CheckEntry(journal, entryOffset, MeaBinaryLogJournal::DeleteOp, 7);
+        BOOST_CHECK(!journal.GetEntry(entryOffset, entry, data));
+
+        // Rebasing with no later changes leaves no journal.
+        //
+        journal.Rebase(savedLog, journal.GetEndOffset());
+        BOOST_CHECK(journal.IsAttached());
+        BOOST_CHECK(!FileExists(savedLog + MeaBinaryLogJournal::kSuffix));
+        BOOST_CHECK(!journal.Read());
+
+        DeleteFile(log);
+        DeleteFile(savedLog);
+    }
+
+    void TestJournalDiscard()
+    {
+        CString log(MakeTempPathname());
+        WriteFile(log, "log", 3);
+
+        MeaBinaryLogJournal journal;
+        journal.Attach(log);
+        journal.Append(MeaBinaryLogJournal::DeleteOp, 0, NULL);
+        BOOST_CHECK(journal.GetSize() > 0);
+
+        journal.Discard();
+        BOOST_CHECK(!FileExists(log + MeaBinaryLogJournal::kSuffix));
+        BOOST_CHECK_EQUAL(journal.GetSize(), 0U);
+        BOOST_CHECK_EQUAL(journal.GetEndOffset(), 0U);
+        BOOST_CHECK(!journal.Read());
+
+        DeleteFile(log);
+    }
+
+    void TestJournalBatch()
+    {
+        CString log(MakeTempPathname());
+        WriteFile(log, "log", 3);
+
+        MeaGUID desktop1;
+        MeaGUID desktop2;
+        MeaBinaryLogWriter writer;
+        BuildLog(desktop1, desktop2, writer);
+        BOOST_CHECK(writer.HasDesktop(desktop1));
+        BOOST_CHECK(writer.HasDesktop(desktop2));
+        BOOST_CHECK(!writer.HasDesktop(MeaGUID()));
+
+        MeaBinaryLogJournal journal;
+        journal.Attach(log);
+        journal.AppendPositions(5, writer);
+        journal.Append(MeaBinaryLogJournal::DeleteOp, 6, NULL);
+        BOOST_REQUIRE(journal.Read());
+
+        size_t offset = 0;
+        MeaBinaryLogJournalEntry entry;
+        const BYTE* data;
+
+        // The batch is a single entry holding every position and each
+        // desktop once.
+        //
+        BOOST_REQUIRE(journal.GetEntry(offset, entry, data));
+        BOOST_CHECK_EQUAL(entry.op, static_cast<UINT32>(MeaBinaryLogJournal::AddBatchOp));
+        BOOST_CHECK_EQUAL(entry.posIndex, 5);
+        {
+            MeaBinaryLogReader reader;
+            reader.Open(data, entry.size);
+            BOOST_CHECK_EQUAL(reader.GetHeader().desktopCount, 2U);
+            BOOST_REQUIRE_EQUAL(reader.GetHeader().positionCount, 3U);
+            BOOST_CHECK_EQUAL(reader.GetPosition(1).desktop, 1U);
+            BOOST_CHECK_EQUAL(reader.GetPosition(2).distance, 4.0);
+        }
+
+        CheckEntry(journal, offset, MeaBinaryLogJournal::DeleteOp, 6);
+        BOOST_CHECK(!journal.GetEntry(offset, entry, data));
+
+        journal.Discard();
+        DeleteFile(log);
+    }
+}
+
+
+test_suite* init_unit_test_suite(int argc, char* argv[])
+{
+    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
+        cerr << "Fatail Error: MFC initialization failed\n";
+        return NULL;
+    }
+
+    test_suite* suite = BOOST_TEST_SUITE("Binary Position Log Tests");
+    suite->add(BOOST_TEST_CASE(&TestRoundTrip));
+    suite->add(BOOST_TEST_CASE(&TestFile));
+    suite->add(BOOST_TEST_CASE(&TestCorruptTables));
+    suite->add(BOOST_TEST_CASE(&TestCorruptReferences));
+    suite->add(BOOST_TEST_CASE(&TestJournalReplay));
+    suite->add(BOOST_TEST_CASE(&TestJournalStale));
+    suite->add(BOOST_TEST_CASE(&TestJournalPartialEntry));
+    suite->add(BOOST_TEST_CASE(&TestJournalRebase));
+    suite->add(BOOST_TEST_CASE(&TestJournalDiscard));
+    suite->add(BOOST_TEST_CASE(&TestJournalBatch));
+    return suite;
+}
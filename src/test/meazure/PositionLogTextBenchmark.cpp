@@ -0,0 +1,159 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Benchmark of the CSV and JSON Lines position logs.
+///
+/// Writing 100,000 positions in the text formats is compared with writing
+/// the same positions through the XML writer, as
+/// MeaPositionLogMgr::Position::Save does, and reading the text formats
+/// back is timed:
+///
+/// @code
+///     MeazureBenchmark PositionLogText
+/// @endcode
+
+#include "StdAfx.h"
+#include "Benchmark.h"
+#include <PositionLogText.h>
+#include <XMLWriter.h>
+#include <string>
+#include <iostream>
+
+
+using namespace std;
+
+
+namespace
+{
+    void MakeLineRecord(MeaTextLogRecord& record, int i)
+    {
+        record.Clear();
+        record.tool = _T("LineTool");
+        record.timestamp = _T("2011-01-01T00:00:00Z");
+        record.linearUnits = _T("px");
+        record.angularUnits = _T("deg");
+        record.points[MeaPositionPoints::Point1].x = i * 0.5;
+        record.points[MeaPositionPoints::Point1].y = i * 0.25;
+        record.hasPoint[MeaPositionPoints::Point1] = true;
+        record.points[MeaPositionPoints::Point2].x = i * 1.5;
+        record.points[MeaPositionPoints::Point2].y = i * 1.25;
+        record.hasPoint[MeaPositionPoints::Point2] = true;
+        record.distance = i * 3.0;
+    }
+
+    void Report(const char* what, int count, ULONGLONG bytes, double ms)
+    {
+        double mb = static_cast<double>(bytes) / (1024.0 * 1024.0);
+
+        cout << what << " " << count << " positions (" << mb << " MB) in " << ms
+             << " ms, " << (mb * 1000.0 / ms) << " MB/s\n";
+    }
+}
+
+
+int RunPositionLogTextBenchmark(int /* argc */, char* /* argv */[])
+{
+    const int kNumPositions = 100000;
+    MeaTextLogRecord record;
+    bool ok = true;
+
+    {
+        CMemFile file(4 * 1024 * 1024);
+
+        BenchmarkTimer timer;
+        {
+            MeaXMLWriter writer(file);
+
+            writer.Declaration();
+            writer.StartElement(_T("positionLog"));
+            writer.Attribute(_T("version"), 1);
+            writer.StartElement(_T("positions"));
+            for (int i = 0; i < kNumPositions; i++) {
+                MakeLineRecord(record, i);
+
+                writer.StartElement(_T("position"));
+                writer.Attribute(_T("desktopRef"), _T("00000000-0000-0000-0000-000000000000"));
+                writer.Attribute(_T("tool"), record.tool);
+                writer.Attribute(_T("date"), record.timestamp);
+                    writer.StartElement(_T("points"));
+                    writer.StartElement(_T("point"));
+                    writer.Attribute(_T("name"), _T("1"));
+                    writer.Attribute(_T("x"), record.points[MeaPositionPoints::Point1].x);
+                    writer.Attribute(_T("y"), record.points[MeaPositionPoints::Point1].y);
+                    writer.EndElement();
+                    writer.StartElement(_T("point"));
+                    writer.Attribute(_T("name"), _T("2"));
+                    writer.Attribute(_T("x"), record.points[MeaPositionPoints::Point2].x);
+                    writer.Attribute(_T("y"), record.points[MeaPositionPoints::Point2].y);
+                    writer.EndElement();
+                    writer.EndElement();
+                    writer.StartElement(_T("properties"));
+                    writer.StartElement(_T("distance"));
+                    writer.Attribute(_T("value"), record.distance);
+                    writer.EndElement();
+                    writer.EndElement();
+                writer.EndElement();
+            }
+            writer.EndElement();
+            writer.EndElement();
+        }
+        double ms = timer.GetElapsedMs();
+
+        ok = ok && file.GetLength() > 0;
+        Report("XML write", kNumPositions, file.GetLength(), ms);
+    }
+
+    MeaTextLogFormat formats[] = { MeaCSVFormat, MeaJSONLinesFormat };
+    const char* names[] = { "CSV", "JSON Lines" };
+
+    for (int f = 0; f < 2; f++) {
+        CMemFile file(4 * 1024 * 1024);
+
+        BenchmarkTimer timer;
+        {
+            MeaTextLogWriter writer(file, formats[f]);
+            for (int i = 0; i < kNumPositions; i++) {
+                MakeLineRecord(record, i);
+                writer.Write(record);
+            }
+        }
+        double ms = timer.GetElapsedMs();
+
+        ok = ok && file.GetLength() > 0;
+        Report((string(names[f]) + " write").c_str(), kNumPositions, file.GetLength(), ms);
+
+        file.SeekToBegin();
+        int count = 0;
+
+        timer.Start();
+        {
+            MeaTextLogReader reader(file, formats[f]);
+            while (reader.Read(record)) {
+                count++;
+            }
+        }
+        ms = timer.GetElapsedMs();
+
+        ok = ok && count == kNumPositions;
+        Report((string(names[f]) + " read").c_str(), count, file.GetLength(), ms);
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,330 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include <PositionLogText.h>
+#include <LogFileException.h>
+#include <DataDisplay.h>
+#include <string>
+#include <iostream>
+#include <boost/test/included/unit_test_framework.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+CWinApp theApp;
+
+
+using namespace std;
+using namespace boost::unit_test;
+using boost::unit_test_framework::test_suite;
+
+
+namespace
+{
+    std::string GetContents(CMemFile& file)
+    {
+        std::string contents(static_cast<size_t>(file.GetLength()), '\0');
+
+        file.SeekToBegin();
+        if (!contents.empty()) {
+            file.Read(&contents[0], static_cast<UINT>(contents.size()));
+        }
+        return contents;
+    }
+
+    void SetContents(CMemFile& file, const std::string& contents)
+    {
+        file.SetLength(0);
+        file.Write(contents.data(), static_cast<UINT>(contents.size()));
+        file.SeekToBegin();
+    }
+
+    void MakeLineRecord(MeaTextLogRecord& record, int i)
+    {
+        record.Clear();
+        record.tool = _T("LineTool");
+        record.timestamp = _T("2011-01-01T00:00:00Z");
+        record.linearUnits = _T("px");
+        record.angularUnits = _T("deg");
+        record.points[MeaPositionPoints::Point1].x = i * 0.5;
+        record.points[MeaPositionPoints::Point1].y = i * 0.25;
+        record.hasPoint[MeaPositionPoints::Point1] = true;
+        record.points[MeaPositionPoints::Point2].x = i * 1.5;
+        record.points[MeaPositionPoints::Point2].y = i * 1.25;
+        record.hasPoint[MeaPositionPoints::Point2] = true;
+        record.distance = i * 3.0;
+        record.fieldMask = MeaDistanceField;
+    }
+
+    void CheckEqual(const MeaTextLogRecord& actual, const MeaTextLogRecord& expected)
+    {
+        BOOST_CHECK(actual.tool == expected.tool);
+        BOOST_CHECK(actual.timestamp == expected.timestamp);
+        BOOST_CHECK(actual.linearUnits == expected.linearUnits);
+        BOOST_CHECK(actual.angularUnits == expected.angularUnits);
+        BOOST_CHECK(actual.desc == expected.desc);
+        for (int i = 0; i < MeaPositionPoints::kNumPointIds; i++) {
+            BOOST_CHECK_EQUAL(actual.hasPoint[i], expected.hasPoint[i]);
+            BOOST_CHECK_EQUAL(actual.points[i].x, expected.points[i].x);
+            BOOST_CHECK_EQUAL(actual.points[i].y, expected.points[i].y);
+        }
+        BOOST_CHECK_EQUAL(actual.fieldMask, expected.fieldMask);
+        BOOST_CHECK_EQUAL(actual.width, expected.width);
+        BOOST_CHECK_EQUAL(actual.height, expected.height);
+        BOOST_CHECK_EQUAL(actual.distance, expected.distance);
+        BOOST_CHECK_EQUAL(actual.area, expected.area);
+        BOOST_CHECK_EQUAL(actual.angle, expected.angle);
+    }
+
+    void TestWriteCSV()
+    {
+        CMemFile file;
+        MeaTextLogRecord record;
+
+        MakeLineRecord(record, 2);
+        record.desc = _T("a, \"quoted\" desc");
+        {
+            MeaTextLogWriter writer(file, MeaCSVFormat);
+            writer.Write(record);
+        }
+        BOOST_CHECK_EQUAL(GetContents(file),
+            "tool,date,linearUnits,angularUnits,x1,y1,x2,y2,xv,yv,width,height,distance,area,angle,desc\r\n"
+            "LineTool,2011-01-01T00:00:00Z,px,deg,1.0,0.5,3.0,2.5,,,,,6.0,,,\"a, \"\"quoted\"\" desc\"\r\n");
+    }
+
+    void TestWriteJSON()
+    {
+        CMemFile file;
+        MeaTextLogRecord record;
+
+        MakeLineRecord(record, 2);
+        record.desc = _T("line\r\n\"two\"");
+        {
+            MeaTextLogWriter writer(file, MeaJSONLinesFormat);
+            writer.Write(record);
+        }
+        BOOST_CHECK_EQUAL(GetContents(file),
+            "{\"tool\":\"LineTool\",\"date\":\"2011-01-01T00:00:00Z\",\"linearUnits\":\"px\",\"angularUnits\":\"deg\","
+            "\"points\":{\"1\":{\"x\":1.0,\"y\":0.5},\"2\":{\"x\":3.0,\"y\":2.5}},\"distance\":6.0,"
+            "\"desc\":\"line\\r\\n\\\"two\\\"\"}\n");
+    }
+
+    void TestRoundTrip()
+    {
+        MeaTextLogFormat formats[] = { MeaCSVFormat, MeaJSONLinesFormat };
+
+        for (int f = 0; f < 2; f++) {
+            CMemFile file;
+            MeaTextLogRecord expected[3];
+
+            MakeLineRecord(expected[0], 1);
+            expected[0].desc = _T("multi\r\nline, \"desc\"");
+
+            expected[1].tool = _T("AngleTool");
+            expected[1].timestamp = _T("2011-02-03T04:05:06Z");
+            expected[1].linearUnits = _T("in");
+            expected[1].angularUnits = _T("rad");
+            expected[1].points[MeaPositionPoints::PointV].x = -1.125;
+            expected[1].points[MeaPositionPoints::PointV].y = 7.0;
+            expected[1].hasPoint[MeaPositionPoints::PointV] = true;
+            expected[1].angle = 0.785398163397448;
+            expected[1].fieldMask = MeaAngleField;
+
+            expected[2].tool = _T("RectTool");
+            expected[2].desc = CString(L"\x00E9\x20AC");
+            expected[2].width = 10.0;
+            expected[2].height = 20.0;
+            expected[2].area = 200.0;
+            expected[2].fieldMask = MeaWidthField | MeaHeightField | MeaAreaField;
+
+            {
+                MeaTextLogWriter writer(file, formats[f], 16);
+                for (int i = 0; i < 3; i++) {
+                    writer.Write(expected[i]);
+                }
+            }
+
+            file.SeekToBegin();
+            MeaTextLogReader reader(file, formats[f], 16);
+            MeaTextLogRecord actual;
+
+            for (int i = 0; i < 3; i++) {
+                BOOST_CHECK(reader.Read(actual));
+                CheckEqual(actual, expected[i]);
+            }
+            BOOST_CHECK(!reader.Read(actual));
+        }
+    }
+
+    void TestReadCSVColumns()
+    {
+        CMemFile file;
+        MeaTextLogRecord record;
+
+        SetContents(file,
+            "\xEF\xBB\xBF" "extra,angle,tool\n"
+            "ignored,45.0,AngleTool\n"
+            "\n"
+            "x,,PointTool");
+
+        MeaTextLogReader reader(file, MeaCSVFormat);
+
+        BOOST_CHECK(reader.Read(record));
+        BOOST_CHECK(record.tool == _T("AngleTool"));
+        BOOST_CHECK_EQUAL(record.fieldMask, static_cast<UINT>(MeaAngleField));
+        BOOST_CHECK_EQUAL(record.angle, 45.0);
+
+        BOOST_CHECK(reader.Read(record));
+        BOOST_CHECK_EQUAL(reader.GetLineNumber(), 4);
+        BOOST_CHECK(record.tool == _T("PointTool"));
+        BOOST_CHECK_EQUAL(record.fieldMask, 0u);
+
+        BOOST_CHECK(!reader.Read(record));
+    }
+
+    void TestReadJSONExtras()
+    {
+        CMemFile file;
+        MeaTextLogRecord record;
+
+        SetContents(file,
+            "{ \"extra\": [1, {\"a\": \"}\"}], \"tool\" : \"PointTool\", \"desc\": null,\r\n"
+            "{\"tool\":\"\\u00e9\\u20AC\",\"points\":{\"q\":{\"x\":1,\"y\":2},\"v\":{\"y\":3e2}},\"width\":-1.5E1}\n");
+
+        MeaTextLogReader reader(file, MeaJSONLinesFormat);
+
+        // The first line is missing its closing brace.
+        BOOST_CHECK_THROW(reader.Read(record), MeaLogFileException);
+        BOOST_CHECK_EQUAL(reader.GetLineNumber(), 1);
+
+        SetContents(file,
+            "{ \"extra\": [1, {\"a\": \"}\"}], \"tool\" : \"PointTool\", \"desc\": null }\r\n"
+            "{\"tool\":\"\\u00e9\\u20AC\",\"points\":{\"q\":{\"x\":1,\"y\":2},\"v\":{\"y\":3e2}},\"width\":-1.5E1}\n");
+
+        MeaTextLogReader reader2(file, MeaJSONLinesFormat);
+
+        BOOST_CHECK(reader2.Read(record));
+        BOOST_CHECK(record.tool == _T("PointTool"));
+        BOOST_CHECK(record.desc.IsEmpty());
+
+        BOOST_CHECK(reader2.Read(record));
+        BOOST_CHECK(CStringW(record.tool) == CStringW(L"\x00E9\x20AC"));
+        BOOST_CHECK(!record.hasPoint[MeaPositionPoints::Point1]);
+        BOOST_CHECK(record.hasPoint[MeaPositionPoints::PointV]);
+        BOOST_CHECK_EQUAL(record.points[MeaPositionPoints::PointV].x, 0.0);
+        BOOST_CHECK_EQUAL(record.points[MeaPositionPoints::PointV].y, 300.0);
+        BOOST_CHECK_EQUAL(record.fieldMask, static_cast<UINT>(MeaWidthField));
+        BOOST_CHECK_EQUAL(record.width, -15.0);
+
+        BOOST_CHECK(!reader2.Read(record));
+    }
+
+    void TestReadErrors()
+    {
+        const char* badCSV[] = {
+            "date,desc\nx,y\n",                     // No tool column
+            "tool,width\nLineTool,abc\n",           // Invalid number
+            "tool,desc\nLineTool,\"unterminated\n", // Unterminated quote
+            "tool,desc\nLineTool,\"a\"b\n"          // Text after quote
+        };
+        const char* badJSON[] = {
+            "{\"tool\":\"LineTool\"} extra\n",
+            "{\"tool\":\"Line\\qTool\"}\n",
+            "{\"tool\":\"LineTool\",\"width\":1.0.0}\n",
+            "[\"tool\"]\n"
+        };
+
+        for (size_t i = 0; i < sizeof(badCSV) / sizeof(badCSV[0]); i++) {
+            CMemFile file;
+            MeaTextLogRecord record;
+
+            SetContents(file, badCSV[i]);
+            MeaTextLogReader reader(file, MeaCSVFormat);
+            BOOST_CHECK_THROW(while (reader.Read(record)) {}, MeaLogFileException);
+        }
+
+        for (size_t i = 0; i < sizeof(badJSON) / sizeof(badJSON[0]); i++) {
+            CMemFile file;
+            MeaTextLogRecord record;
+
+            SetContents(file, badJSON[i]);
+            MeaTextLogReader reader(file, MeaJSONLinesFormat);
+            BOOST_CHECK_THROW(reader.Read(record), MeaLogFileException);
+        }
+    }
+
+    void TestReadDates()
+    {
+        CMemFile file;
+        MeaTextLogRecord record;
+
+        // A missing date is returned as an empty timestamp.
+        //
+        SetContents(file,
+            "tool,date\n"
+            "LineTool,2011-02-03T04:05:06Z\n"
+            "PointTool,\n"
+            "RectTool,03/02/2011\n");
+
+        MeaTextLogReader reader(file, MeaCSVFormat);
+
+        BOOST_CHECK(reader.Read(record));
+        BOOST_CHECK(record.timestamp == _T("2011-02-03T04:05:06Z"));
+
+        BOOST_CHECK(reader.Read(record));
+        BOOST_CHECK(record.timestamp.IsEmpty());
+
+        BOOST_CHECK_THROW(reader.Read(record), MeaLogFileException);
+        BOOST_CHECK_EQUAL(reader.GetLineNumber(), 4);
+
+        SetContents(file,
+            "{\"tool\":\"LineTool\"}\n"
+            "{\"tool\":\"LineTool\",\"date\":\"2011-02-30T00:00:00Z\"}\n");
+
+        MeaTextLogReader reader2(file, MeaJSONLinesFormat);
+
+        BOOST_CHECK(reader2.Read(record));
+        BOOST_CHECK(record.timestamp.IsEmpty());
+
+        BOOST_CHECK_THROW(reader2.Read(record), MeaLogFileException);
+        BOOST_CHECK_EQUAL(reader2.GetLineNumber(), 2);
+    }
+}
+
+
+test_suite* init_unit_test_suite(int argc, char* argv[])
+{
+    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
+        cerr << "Fatail Error: MFC initialization failed\n";
+        return NULL;
+    }
+
+    test_suite* suite = BOOST_TEST_SUITE("PositionLogText Tests");
+    suite->add(BOOST_TEST_CASE(&TestWriteCSV));
+    suite->add(BOOST_TEST_CASE(&TestWriteJSON));
+    suite->add(BOOST_TEST_CASE(&TestRoundTrip));
+    suite->add(BOOST_TEST_CASE(&TestReadCSVColumns));
+    suite->add(BOOST_TEST_CASE(&TestReadJSONExtras));
+    suite->add(BOOST_TEST_CASE(&TestReadErrors));
+    suite->add(BOOST_TEST_CASE(&TestReadDates));
+    return suite;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Benchmark of the memory used by position points.
+///
+/// The memory used to hold the points of a large log of Line tool
+/// positions, each with two points, is measured using a point map and
+/// using the fixed slot points object:
+///
+/// @code
+///     MeazureBenchmark PositionPoints
+/// @endcode
+
+#include "StdAfx.h"
+#include "Benchmark.h"
+#include <PositionPoints.h>
+#include <iostream>
+#include <vector>
+
+
+using namespace std;
+
+
+namespace
+{
+    FPOINT MakePoint(double x, double y)
+    {
+        FPOINT pt;
+        pt.x = x;
+        pt.y = y;
+        return pt;
+    }
+}
+
+
+int RunPositionPointsBenchmark(int /* argc */, char* /* argv */[])
+{
+    const int kNumPositions = 200000;
+    SIZE_T mapBytes;
+    SIZE_T slotBytes;
+
+    {
+        SIZE_T before = GetPrivateBytes();
+
+        vector<MeaPositionPoints::PointMap> log(kNumPositions);
+        for (int i = 0; i < kNumPositions; i++) {
+            log[i][_T("1")] = MakePoint(i, i);
+            log[i][_T("2")] = MakePoint(i + 10.0, i + 10.0);
+        }
+
+        mapBytes = GetPrivateBytes() - before;
+    }
+
+    {
+        SIZE_T before = GetPrivateBytes();
+
+        vector<MeaPositionPoints> log(kNumPositions);
+        for (int i = 0; i < kNumPositions; i++) {
+            log[i].SetPoint(MeaPositionPoints::Point1, MakePoint(i, i));
+            log[i].SetPoint(MeaPositionPoints::Point2, MakePoint(i + 10.0, i + 10.0));
+        }
+
+        slotBytes = GetPrivateBytes() - before;
+    }
+
+    double mapPerPosition = static_cast<double>(mapBytes) / kNumPositions;
+    double slotPerPosition = static_cast<double>(slotBytes) / kNumPositions;
+
+    cout << "Point map: " << mapPerPosition << " bytes per position (sizeof "
+         << sizeof(MeaPositionPoints::PointMap) << ")\n";
+    cout << "Point slots: " << slotPerPosition << " bytes per position (sizeof "
+         << sizeof(MeaPositionPoints) << ")\n";
+    cout << "Reduction: " << (mapPerPosition - slotPerPosition) << " bytes per position\n";
+
+    return (slotBytes < mapBytes) ? 0 : 1;
+}
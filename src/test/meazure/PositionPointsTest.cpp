@@ -0,0 +1,173 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include <PositionPoints.h>
+#include <iostream>
+#include <boost/test/included/unit_test_framework.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+CWinApp theApp;
+
+
+using namespace std;
+using namespace boost::unit_test;
+using boost::unit_test_framework::test_suite;
+
+
+namespace
+{
+    FPOINT MakePoint(double x, double y)
+    {
+        FPOINT pt;
+        pt.x = x;
+        pt.y = y;
+        return pt;
+    }
+
+    void TestPointIds()
+    {
+        BOOST_CHECK_EQUAL(MeaPositionPoints::GetPointId(_T("1")), MeaPositionPoints::Point1);
+        BOOST_CHECK_EQUAL(MeaPositionPoints::GetPointId(_T("2")), MeaPositionPoints::Point2);
+        BOOST_CHECK_EQUAL(MeaPositionPoints::GetPointId(_T("v")), MeaPositionPoints::PointV);
+        BOOST_CHECK_EQUAL(MeaPositionPoints::GetPointId(_T("")), MeaPositionPoints::kNumPointIds);
+        BOOST_CHECK_EQUAL(MeaPositionPoints::GetPointId(_T("12")), MeaPositionPoints::kNumPointIds);
+        BOOST_CHECK_EQUAL(MeaPositionPoints::GetPointId(_T("V")), MeaPositionPoints::kNumPointIds);
+
+        for (int i = 0; i < MeaPositionPoints::kNumPointIds; i++) {
+            MeaPositionPoints::PointId id = static_cast<MeaPositionPoints::PointId>(i);
+            BOOST_CHECK_EQUAL(MeaPositionPoints::GetPointId(MeaPositionPoints::GetPointName(id)), id);
+        }
+    }
+
+    void TestSetPoints()
+    {
+        MeaPositionPoints points;
+
+        BOOST_CHECK_EQUAL(points.GetCount(), 0);
+        BOOST_CHECK(points.FindPoint(_T("1")) == NULL);
+
+        points.SetPoint(MeaPositionPoints::PointV, MakePoint(5.0, 6.0));
+        points.SetPoint(_T("1"), MakePoint(1.0, 2.0));
+        points.SetPoint(_T("1"), MakePoint(3.0, 4.0));
+
+        BOOST_REQUIRE_EQUAL(points.GetCount(), 2);
+        BOOST_CHECK(points.HasPoint(MeaPositionPoints::Point1));
+        BOOST_CHECK(!points.HasPoint(MeaPositionPoints::Point2));
+        BOOST_CHECK(points.HasPoint(MeaPositionPoints::PointV));
+        BOOST_CHECK_EQUAL(points.GetPoint(MeaPositionPoints::Point1).x, 3.0);
+        BOOST_CHECK_EQUAL(points.GetPoint(MeaPositionPoints::Point1).y, 4.0);
+
+        // Points are in name order.
+        BOOST_CHECK(CString(points.GetNameAt(0)) == _T("1"));
+        BOOST_CHECK_EQUAL(points.GetPointAt(0).x, 3.0);
+        BOOST_CHECK(CString(points.GetNameAt(1)) == _T("v"));
+        BOOST_CHECK_EQUAL(points.GetPointAt(1).y, 6.0);
+
+        const FPOINT* pt = points.FindPoint(_T("v"));
+        BOOST_REQUIRE(pt != NULL);
+        BOOST_CHECK_EQUAL(pt->x, 5.0);
+        BOOST_CHECK(points.FindPoint(_T("2")) == NULL);
+
+        points.Clear();
+        BOOST_CHECK_EQUAL(points.GetCount(), 0);
+        BOOST_CHECK(!points.HasPoint(MeaPositionPoints::PointV));
+    }
+
+    void TestOtherPoints()
+    {
+        MeaPositionPoints points;
+
+        points.SetPoint(_T("z"), MakePoint(9.0, 9.0));
+        points.SetPoint(_T("2"), MakePoint(2.0, 2.0));
+        points.SetPoint(_T("center"), MakePoint(7.0, 8.0));
+        points.SetPoint(_T("z"), MakePoint(10.0, 11.0));
+
+        BOOST_REQUIRE_EQUAL(points.GetCount(), 3);
+        BOOST_CHECK(CString(points.GetNameAt(0)) == _T("2"));
+        BOOST_CHECK(CString(points.GetNameAt(1)) == _T("center"));
+        BOOST_CHECK(CString(points.GetNameAt(2)) == _T("z"));
+        BOOST_CHECK_EQUAL(points.GetPointAt(2).x, 10.0);
+
+        const FPOINT* pt = points.FindPoint(_T("center"));
+        BOOST_REQUIRE(pt != NULL);
+        BOOST_CHECK_EQUAL(pt->y, 8.0);
+        BOOST_CHECK(points.FindPoint(_T("q")) == NULL);
+
+        // Copies are independent.
+        MeaPositionPoints copy(points);
+        points.SetPoint(_T("center"), MakePoint(0.0, 0.0));
+        BOOST_CHECK_EQUAL(copy.FindPoint(_T("center"))->x, 7.0);
+
+        MeaPositionPoints assigned;
+        assigned.SetPoint(_T("other"), MakePoint(1.0, 1.0));
+        assigned = copy;
+        BOOST_CHECK_EQUAL(assigned.GetCount(), 3);
+        BOOST_CHECK(assigned.FindPoint(_T("other")) == NULL);
+
+        assigned = MeaPositionPoints();
+        BOOST_CHECK_EQUAL(assigned.GetCount(), 0);
+    }
+
+    void TestPointMap()
+    {
+        MeaPositionPoints::PointMap map;
+
+        map[_T("v")] = MakePoint(1.0, 1.0);
+        map[_T("2")] = MakePoint(2.0, 2.0);
+        map[_T("a")] = MakePoint(3.0, 3.0);
+
+        MeaPositionPoints points(map);
+        BOOST_REQUIRE_EQUAL(points.GetCount(), 3);
+        BOOST_CHECK(points.HasPoint(MeaPositionPoints::Point2));
+        BOOST_CHECK(points.HasPoint(MeaPositionPoints::PointV));
+
+        MeaPositionPoints::PointMap result;
+        result[_T("old")] = MakePoint(0.0, 0.0);
+        points.GetPointMap(result);
+
+        BOOST_REQUIRE_EQUAL(result.size(), map.size());
+        MeaPositionPoints::PointMap::const_iterator iter;
+        for (iter = map.begin(); iter != map.end(); ++iter) {
+            BOOST_REQUIRE(result.find((*iter).first) != result.end());
+            BOOST_CHECK_EQUAL(result[(*iter).first].x, (*iter).second.x);
+            BOOST_CHECK_EQUAL(result[(*iter).first].y, (*iter).second.y);
+        }
+    }
+}
+
+
+test_suite* init_unit_test_suite(int argc, char* argv[])
+{
+    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
+        cerr << "Fatail Error: MFC initialization failed\n";
+        return NULL;
+    }
+
+    test_suite* suite = BOOST_TEST_SUITE("PositionPoints Tests");
+    suite->add(BOOST_TEST_CASE(&TestPointIds));
+    suite->add(BOOST_TEST_CASE(&TestSetPoints));
+    suite->add(BOOST_TEST_CASE(&TestOtherPoints));
+    suite->add(BOOST_TEST_CASE(&TestPointMap));
+    return suite;
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Benchmark of the collection used for the recorded positions.
+///
+/// Adding, getting and deleting 100,000 positions is timed using the
+/// MeaPositionStore_T collection used by MeaPositionLogMgr and using the
+/// index keyed map that the collection formerly used:
+///
+/// @code
+///     MeazureBenchmark PositionStore
+/// @endcode
+///
+/// The position log manager's positions adjust the manager's desktop
+/// reference counts as they are created and destroyed, so the collection
+/// is instantiated here over a stand-in position object that is heap
+/// allocated in the same manner.
+
+#include "StdAfx.h"
+#include "Benchmark.h"
+#include <PositionStore.h>
+#include <iostream>
+#include <map>
+#include <vector>
+
+
+using namespace std;
+
+
+namespace
+{
+    /// Stand-in for a recorded position.
+    ///
+    class Position
+    {
+    public:
+        explicit Position(int i) : m_id(i), m_toolName(_T("PointTool")), m_timestamp(_T("2011-01-01T00:00:00Z")) {
+            FPOINT pt;
+            pt.x = i * 0.5;
+            pt.y = i * 0.25;
+            m_points.SetPoint(MeaPositionPoints::Point1, pt);
+        }
+
+        int GetId() const { return m_id; }
+        double GetX() const { return m_points.GetPoint(MeaPositionPoints::Point1).x; }
+
+        CString GetToolName() const { return m_toolName; }
+        CString GetTimeStamp() const { return m_timestamp; }
+        const MeaPositionPoints& GetPointSet() const { return m_points; }
+
+    private:
+        int                 m_id;
+        CString             m_toolName;
+        CString             m_timestamp;
+        MeaPositionPoints   m_points;
+    };
+
+
+    /// Positions stored in a map keyed by index, as the position log
+    /// manager formerly stored them.
+    ///
+    class MapStore
+    {
+    public:
+        ~MapStore() { DeleteAll(); }
+
+        unsigned int Size() const { return m_posMap.size(); }
+
+        void Add(Position* position) {
+            int posIndex = Size();
+            m_posMap[posIndex] = position;
+        }
+
+        Position& Get(int posIndex) {
+            return *(*m_posMap.find(posIndex)).second;
+        }
+
+        void Delete(int posIndex) {
+            PositionMap::iterator iter = m_posMap.find(posIndex);
+
+            delete (*iter).second;
+
+            for (iter++; iter != m_posMap.end(); ++iter, posIndex++) {
+                m_posMap[posIndex] = (*iter).second;
+            }
+
+            m_posMap.erase(m_posMap.size() - 1);
+        }
+
+        void DeleteAll() {
+            PositionMap::const_iterator iter;
+
+            for (iter = m_posMap.begin(); iter != m_posMap.end(); ++iter) {
+                delete (*iter).second;
+            }
+            m_posMap.clear();
+        }
+
+    private:
+        typedef map<int, Position*> PositionMap;
+
+        PositionMap m_posMap;
+    };
+
+
+    /// Times adding, getting and deleting positions using the specified
+    /// store.
+    ///
+    /// @param title        [in] Name of the store reported with the times.
+    /// @param store        [in] Empty store to exercise.
+    /// @param ids          [out] Identifiers of the positions remaining
+    ///                     after the deletions, in index order.
+    ///
+    template <class Store>
+    void BenchmarkStore(const char* title, Store& store, vector<int>& ids)
+    {
+        const int kNumPositions = 100000;
+        const int kNumDeletes = 100;
+        double sum = 0.0;
+
+        BenchmarkTimer timer;
+        for (int i = 0; i < kNumPositions; i++) {
+            store.Add(new Position(i));
+        }
+        double addMs = timer.GetElapsedMs();
+
+        timer.Start();
+        for (int i = 0; i < kNumPositions; i++) {
+            sum += store.Get(i).GetX();
+        }
+        double getMs = timer.GetElapsedMs();
+
+        // Deleting near the front of the log moves nearly every position.
+        //
+        timer.Start();
+        for (int i = 0; i < kNumDeletes; i++) {
+            store.Delete(i);
+        }
+        double deleteMs = timer.GetElapsedMs();
+
+        ids.clear();
+        for (unsigned int i = 0; i < store.Size(); i++) {
+            ids.push_back(store.Get(i).GetId());
+        }
+
+        timer.Start();
+        store.DeleteAll();
+        double deleteAllMs = timer.GetElapsedMs();
+
+        cout << title << ": add " << kNumPositions << " in " << addMs << " ms, get in " << getMs
+             << " ms (sum " << sum << "), delete " << kNumDeletes << " in " << deleteMs
+             << " ms, delete all in " << deleteAllMs << " ms\n";
+    }
+}
+
+
+int RunPositionStoreBenchmark(int /* argc */, char* /* argv */[])
+{
+    vector<int> mapIds;
+    vector<int> storeIds;
+
+    {
+        MapStore store;
+        BenchmarkStore("Map", store, mapIds);
+    }
+    {
+        MeaPositionStore_T<Position> store;
+        BenchmarkStore("Position store", store, storeIds);
+    }
+
+    return (!storeIds.empty() && storeIds == mapIds) ? 0 : 1;
+}
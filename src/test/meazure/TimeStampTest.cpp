@@ -47,6 +47,28 @@ namespace
         BOOST_CHECK_EQUAL(0, MeaParseTimeStamp(_T("1970-01-01T00:00:00Z")));
         BOOST_CHECK_EQUAL(34563600, MeaParseTimeStamp(_T("1971-02-05T01:00:00Z")));
     }
+
+    void TestIsTimeStamp()
+    {
+        BOOST_CHECK(MeaIsTimeStamp(_T("1970-01-01T00:00:00Z")));
+        BOOST_CHECK(MeaIsTimeStamp(_T("2011-12-31T23:59:59Z")));
+        BOOST_CHECK(MeaIsTimeStamp(_T("2012-02-29T12:00:00Z")));    // Leap year
+        BOOST_CHECK(MeaIsTimeStamp(_T("2000-02-29T12:00:00Z")));
+
+        BOOST_CHECK(!MeaIsTimeStamp(_T("")));
+        BOOST_CHECK(!MeaIsTimeStamp(_T("yesterday")));
+        BOOST_CHECK(!MeaIsTimeStamp(_T("2011-01-01 00:00:00Z")));
+        BOOST_CHECK(!MeaIsTimeStamp(_T("2011-01-01T00:00:00")));
+        BOOST_CHECK(!MeaIsTimeStamp(_T("2011-1-01T00:00:00Z")));
+        BOOST_CHECK(!MeaIsTimeStamp(_T("2011-01-01T00:00:00Z ")));
+        BOOST_CHECK(!MeaIsTimeStamp(_T("2011-13-01T00:00:00Z")));
+        BOOST_CHECK(!MeaIsTimeStamp(_T("2011-04-31T00:00:00Z")));
+        BOOST_CHECK(!MeaIsTimeStamp(_T("2011-02-29T00:00:00Z")));
+        BOOST_CHECK(!MeaIsTimeStamp(_T("1900-02-29T00:00:00Z")));
+        BOOST_CHECK(!MeaIsTimeStamp(_T("2011-01-01T24:00:00Z")));
+        BOOST_CHECK(!MeaIsTimeStamp(_T("2011-01-01T00:60:00Z")));
+        BOOST_CHECK(!MeaIsTimeStamp(_T("0000-01-01T00:00:00Z")));
+    }
 }
 
 
@@ -60,5 +82,6 @@ test_suite* init_unit_test_suite(int argc, char* argv[])
     test_suite* suite = BOOST_TEST_SUITE("TimeStamp Tests");
     suite->add(BOOST_TEST_CASE(&TestMakeTimeStamp));
     suite->add(BOOST_TEST_CASE(&TestParseTimeStamp));
+    suite->add(BOOST_TEST_CASE(&TestIsTimeStamp));
     return suite;
 }
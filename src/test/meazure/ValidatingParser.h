@@ -0,0 +1,263 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Validating parser and position logs shared by the validator
+/// tests and benchmarks.
+
+#pragma once
+
+#include <exval.h>
+#include <sstream>
+#include <string>
+
+
+/// Internal subset declaring the position log elements, following
+/// PositionLog1.dtd.
+///
+const char* const kPositionLogDTD =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<!DOCTYPE positionLog [\n"
+    "<!ELEMENT positionLog (info?, ((desktops+, positions+) | (positions+, desktops+))+)>\n"
+    "<!ATTLIST positionLog version (1) #REQUIRED>\n"
+    "<!ELEMENT info (title|desc)*>\n"
+    "<!ELEMENT title (#PCDATA)*>\n"
+    "<!ELEMENT desc (#PCDATA)*>\n"
+    "<!ELEMENT desktops (desktop+)>\n"
+    "<!ELEMENT desktop (units,(origin|size)*,screens)>\n"
+    "<!ATTLIST desktop id ID #REQUIRED>\n"
+    "<!ELEMENT units EMPTY>\n"
+    "<!ATTLIST units length (px|pt|tp|in|cm|mm|pc|custom) #REQUIRED angle (deg|rad) \"deg\">\n"
+    "<!ELEMENT origin EMPTY>\n"
+    "<!ATTLIST origin xoffset CDATA #REQUIRED yoffset CDATA #REQUIRED invertY (true|false) \"false\">\n"
+    "<!ELEMENT size EMPTY>\n"
+    "<!ATTLIST size x CDATA #REQUIRED y CDATA #REQUIRED>\n"
+    "<!ELEMENT screens (screen+)>\n"
+    "<!ELEMENT screen ((rect,resolution)|(resolution,rect))>\n"
+    "<!ATTLIST screen desc CDATA #REQUIRED primary (true|false) \"false\">\n"
+    "<!ELEMENT rect EMPTY>\n"
+    "<!ATTLIST rect top CDATA #REQUIRED bottom CDATA #REQUIRED left CDATA #REQUIRED right CDATA #REQUIRED>\n"
+    "<!ELEMENT resolution EMPTY>\n"
+    "<!ATTLIST resolution x CDATA #REQUIRED y CDATA #REQUIRED manual (true|false) \"false\">\n"
+    "<!ELEMENT positions (position*)>\n"
+    "<!ELEMENT position (desc?,points,desc?,properties*,desc?)>\n"
+    "<!ATTLIST position desktopRef IDREF #REQUIRED tool CDATA #REQUIRED date CDATA #REQUIRED>\n"
+    "<!ELEMENT points (point)+>\n"
+    "<!ELEMENT point EMPTY>\n"
+    "<!ATTLIST point name (1|2|v) #REQUIRED x CDATA #REQUIRED y CDATA #REQUIRED>\n"
+    "<!ELEMENT properties (width|height|distance|area|angle)*>\n"
+    "<!ELEMENT width EMPTY>\n"
+    "<!ATTLIST width value CDATA #REQUIRED>\n"
+    "<!ELEMENT height EMPTY>\n"
+    "<!ATTLIST height value CDATA #REQUIRED>\n"
+    "<!ELEMENT distance EMPTY>\n"
+    "<!ATTLIST distance value CDATA #REQUIRED>\n"
+    "<!ELEMENT area EMPTY>\n"
+    "<!ATTLIST area value CDATA #REQUIRED>\n"
+    "<!ELEMENT angle EMPTY>\n"
+    "<!ATTLIST angle value CDATA #REQUIRED>\n"
+    "]>\n";
+
+/// Start of a position log up to the first position.
+///
+const char* const kPositionLogStart =
+    "<positionLog version=\"1\">\n"
+    "    <info><title>Benchmark</title></info>\n"
+    "    <desktops>\n"
+    "        <desktop id=\"desktop1\">\n"
+    "            <units length=\"px\" angle=\"deg\"/>\n"
+    "            <origin xoffset=\"0\" yoffset=\"0\" invertY=\"false\"/>\n"
+    "            <size x=\"1600\" y=\"1200\"/>\n"
+    "            <screens>\n"
+    "                <screen desc=\"Primary\" primary=\"true\">\n"
+    "                    <rect top=\"0\" bottom=\"1200\" left=\"0\" right=\"1600\"/>\n"
+    "                    <resolution x=\"96\" y=\"96\" manual=\"false\"/>\n"
+    "                </screen>\n"
+    "            </screens>\n"
+    "        </desktop>\n"
+    "    </desktops>\n"
+    "    <positions>\n";
+
+/// End of a position log following the last position.
+///
+const char* const kPositionLogEnd =
+    "    </positions>\n"
+    "</positionLog>\n";
+
+
+/// Drives an expat parser and a validator over a document in the same
+/// manner as MeaXMLParser.
+///
+class ValidatingParser : public ev::IValidationHandler
+{
+public:
+    explicit ValidatingParser(bool validate = true) :
+        m_validate(validate), m_haveError(false), m_errorCode(ev::ValidationError::InvalidElementPattern)
+    {
+        m_validator.SetValidationHandler(this);
+
+        m_parser = XML_ParserCreate(NULL);
+        XML_SetUserData(m_parser, this);
+        XML_SetElementHandler(m_parser, StartElementHandler, EndElementHandler);
+        XML_SetCharacterDataHandler(m_parser, CharacterDataHandler);
+        XML_SetStartDoctypeDeclHandler(m_parser, DoctypeDeclHandler);
+        XML_SetElementDeclHandler(m_parser, ElementDeclHandler);
+        XML_SetAttlistDeclHandler(m_parser, AttributeDeclHandler);
+        XML_SetNotationDeclHandler(m_parser, NotationDeclHandler);
+        XML_SetEntityDeclHandler(m_parser, EntityDeclHandler);
+    }
+
+    virtual ~ValidatingParser()
+    {
+        XML_ParserFree(m_parser);
+    }
+
+    bool Parse(const char* buffer, int len, bool isFinal)
+    {
+        return XML_Parse(m_parser, buffer, len, isFinal) != XML_STATUS_ERROR;
+    }
+
+    bool Parse(const std::string& text)
+    {
+        return Parse(text.c_str(), static_cast<int>(text.size()), true);
+    }
+
+    virtual void HandleValidationError(const ev::ValidationError& error)
+    {
+        if (!m_haveError) {
+            m_haveError = true;
+            m_errorCode = error.GetCode();
+        }
+    }
+
+    bool HaveError() const { return m_haveError; }
+    ev::ValidationError::Code GetErrorCode() const { return m_errorCode; }
+    ev::Validator& GetValidator() { return m_validator; }
+
+private:
+    static void StartElementHandler(void *userData, const XML_Char *elementName, const XML_Char **attrs)
+    {
+        ValidatingParser *ps = static_cast<ValidatingParser*>(userData);
+        if (ps->m_validate) {
+            ps->m_validator.StartElement(ps->m_parser, elementName, attrs);
+        }
+    }
+
+    static void EndElementHandler(void *userData, const XML_Char* /*elementName*/)
+    {
+        ValidatingParser *ps = static_cast<ValidatingParser*>(userData);
+        if (ps->m_validate) {
+            ps->m_validator.EndElement(ps->m_parser);
+        }
+    }
+
+    static void CharacterDataHandler(void *userData, const XML_Char *s, int len)
+    {
+        ValidatingParser *ps = static_cast<ValidatingParser*>(userData);
+        if (ps->m_validate) {
+            ps->m_validator.CharacterData(ps->m_parser, s, len);
+        }
+    }
+
+    static void DoctypeDeclHandler(void *userData, const XML_Char* doctypeName,
+                                   const XML_Char* /*sysid*/, const XML_Char* /*pubid*/,
+                                   int /*has_internal_subset*/)
+    {
+        ValidatingParser *ps = static_cast<ValidatingParser*>(userData);
+        if (ps->m_validate) {
+            ps->m_validator.SetDocumentElement(doctypeName);
+        }
+    }
+
+    static void ElementDeclHandler(void *userData, const XML_Char *name, XML_Content *model)
+    {
+        ValidatingParser *ps = static_cast<ValidatingParser*>(userData);
+        if (ps->m_validate) {
+            ps->m_validator.AddElementDecl(name, model);
+        }
+        XML_FreeContentModel(ps->m_parser, model);
+    }
+
+    static void AttributeDeclHandler(void *userData, const XML_Char *elname, const XML_Char *attname,
+                                     const XML_Char *att_type, const XML_Char *dflt, int isrequired)
+    {
+        ValidatingParser *ps = static_cast<ValidatingParser*>(userData);
+        if (ps->m_validate) {
+            ps->m_validator.AddAttributeDecl(elname, attname, att_type, dflt, isrequired);
+        }
+    }
+
+    static void NotationDeclHandler(void *userData, const XML_Char *notationName, const XML_Char* /*base*/,
+                                    const XML_Char* /*systemId*/, const XML_Char* /*publicId*/)
+    {
+        ValidatingParser *ps = static_cast<ValidatingParser*>(userData);
+        if (ps->m_validate) {
+            ps->m_validator.AddNotationDecl(notationName);
+        }
+    }
+
+    static void EntityDeclHandler(void *userData, const XML_Char *entityName, int is_parameter_entity,
+                                  const XML_Char* /*value*/, int /*value_length*/, const XML_Char* /*base*/,
+                                  const XML_Char* /*systemId*/, const XML_Char* /*publicId*/,
+                                  const XML_Char *notationName)
+    {
+        ValidatingParser *ps = static_cast<ValidatingParser*>(userData);
+        if (ps->m_validate && !is_parameter_entity && notationName != NULL) {
+            ps->m_validator.AddEntityDecl(entityName);
+        }
+    }
+
+    XML_Parser                  m_parser;
+    ev::Validator               m_validator;
+    bool                        m_validate;
+    bool                        m_haveError;
+    ev::ValidationError::Code   m_errorCode;
+};
+
+
+/// Returns the XML for a Line tool position.
+///
+inline std::string MakePosition(int i, const char* desktopRef = "desktop1")
+{
+    std::ostringstream pos;
+
+    pos << "        <position desktopRef=\"" << desktopRef << "\" tool=\"LineTool\" date=\"2011-03-05T12:34:56Z\">\n"
+        << "            <points>\n"
+        << "                <point name=\"1\" x=\"" << (i % 1600) << ".5\" y=\"" << (i % 1200) << ".25\"/>\n"
+        << "                <point name=\"2\" x=\"" << ((i + 100) % 1600) << ".5\" y=\"" << ((i + 100) % 1200) << ".25\"/>\n"
+        << "            </points>\n"
+        << "            <properties>\n"
+        << "                <width value=\"101\"/>\n"
+        << "                <height value=\"101\"/>\n"
+        << "                <distance value=\"141.42\"/>\n"
+        << "                <area value=\"10201\"/>\n"
+        << "                <angle value=\"45\"/>\n"
+        << "            </properties>\n"
+        << "        </position>\n";
+
+    return pos.str();
+}
+
+
+/// Returns a position log containing the specified positions.
+///
+inline std::string MakeLog(const std::string& positions)
+{
+    return std::string(kPositionLogDTD) + kPositionLogStart + positions + kPositionLogEnd;
+}
@@ -0,0 +1,734 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Benchmark of the XML parser and DTD validator.
+///
+/// Synthetic documents ranging from 1 KB to 500 MB are parsed in callback
+/// mode and DOM mode, each with and without validation. The throughput,
+/// peak memory and allocations per element of each run are written to a
+/// JSON file so that the results of two builds can be compared:
+///
+/// @code
+///     MeazureBenchmark XMLParser [output.json [maxMB]]
+/// @endcode
+
+#include "StdAfx.h"
+#include "Benchmark.h"
+#include <XMLParser.h>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+using namespace std;
+
+
+//*************************************************************************
+// Allocation counting
+//*************************************************************************
+
+
+namespace
+{
+    long allocationCount = 0;           ///< Allocations made while counting is enabled.
+    bool countAllocations = false;      ///< Enables counting of allocations.
+
+    /// Allocates memory for expat, counting the allocation.
+    ///
+    void* CountingMalloc(size_t size)
+    {
+        if (countAllocations) {
+            allocationCount++;
+        }
+        return malloc(size);
+    }
+
+    /// Reallocates memory for expat, counting the reallocation.
+    ///
+    void* CountingRealloc(void* ptr, size_t size)
+    {
+        if (countAllocations) {
+            allocationCount++;
+        }
+        return realloc(ptr, size);
+    }
+
+    /// Frees memory for expat.
+    ///
+    void CountingFree(void* ptr)
+    {
+        free(ptr);
+    }
+
+    /// Memory functions for expat, which allocates with malloc rather
+    /// than operator new.
+    ///
+    XML_Memory_Handling_Suite countingSuite = { CountingMalloc, CountingRealloc, CountingFree };
+
+    /// Allocates memory for operator new, counting the allocation. As
+    /// required of operator new, the new handler is called until the
+    /// memory is obtained or the handler gives up.
+    ///
+    void* CountingNew(size_t size)
+    {
+        if (countAllocations) {
+            allocationCount++;
+        }
+        for (;;) {
+            void* mem = malloc((size == 0) ? 1 : size);
+            if (mem != NULL) {
+                return mem;
+            }
+            new_handler handler = set_new_handler(NULL);
+            set_new_handler(handler);
+            if (handler == NULL) {
+                throw bad_alloc();
+            }
+            handler();
+        }
+    }
+}
+
+
+// The global allocation functions are replaced so that allocations are
+// counted in release builds as well as debug builds. Allocations made
+// within the MFC DLL, such as CString buffers, do not use these functions
+// and are not counted.
+//
+
+void* operator new(size_t size)
+{
+    return CountingNew(size);
+}
+
+
+void* operator new[](size_t size)
+{
+    return CountingNew(size);
+}
+
+
+void* operator new(size_t size, const nothrow_t&) throw()
+{
+    try {
+        return CountingNew(size);
+    }
+    catch (bad_alloc&) {
+        return NULL;
+    }
+}
+
+
+void* operator new[](size_t size, const nothrow_t&) throw()
+{
+    try {
+        return CountingNew(size);
+    }
+    catch (bad_alloc&) {
+        return NULL;
+    }
+}
+
+
+void operator delete(void* ptr) throw()
+{
+    free(ptr);
+}
+
+
+void operator delete[](void* ptr) throw()
+{
+    free(ptr);
+}
+
+
+void operator delete(void* ptr, const nothrow_t&) throw()
+{
+    free(ptr);
+}
+
+
+void operator delete[](void* ptr, const nothrow_t&) throw()
+{
+    free(ptr);
+}
+
+
+//*************************************************************************
+// Benchmark
+//*************************************************************************
+
+
+namespace
+{
+    const size_t kKB = 1024;
+    const size_t kMB = 1024 * kKB;
+
+    /// Sizes of the documents parsed for each kind of document.
+    ///
+    const size_t kDocumentSizes[] = { kKB, 64 * kKB, kMB, 16 * kMB, 100 * kMB, 500 * kMB };
+
+    /// Largest document for which a DOM is built. Larger DOMs measure the
+    /// virtual memory of the machine rather than the parser.
+    ///
+    const size_t kMaxDOMSize = 16 * kMB;
+
+    /// Minimum number of bytes parsed for each measurement. Small
+    /// documents are parsed repeatedly to reach this amount.
+    ///
+    const size_t kMinParsedBytes = 16 * kMB;
+
+    /// Number of bytes fed to the parser at a time.
+    ///
+    const size_t kChunkSize = 64 * kKB;
+
+    const char* kXMLDecl = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+
+
+    /// A synthetic document. The body of the document is the block
+    /// repeated as many times as needed to reach the requested size.
+    ///
+    struct Document
+    {
+        string name;        ///< Name of the document in the results.
+        string dtd;         ///< Internal subset declaring the document's elements.
+        string start;       ///< Start of the document up to the first block.
+        string block;       ///< Repeated content of the document.
+        string end;         ///< End of the document following the last block.
+    };
+
+
+    /// Makes a document whose elements are nested 64 deep, exercising the
+    /// validator's element stack.
+    ///
+    Document MakeDeepDocument()
+    {
+        const int kDepth = 64;
+        ostringstream dtd, open, close;
+
+        dtd << "<!DOCTYPE deep [\n"
+            << "<!ELEMENT deep (n0)*>\n";
+        for (int i = 0; i < kDepth; i++) {
+            if (i < kDepth - 1) {
+                dtd << "<!ELEMENT n" << i << " (leaf, n" << (i + 1) << "?)>\n";
+            } else {
+                dtd << "<!ELEMENT n" << i << " (leaf)>\n";
+            }
+            open << "<n" << i << "><leaf v=\"" << i << "\"/>";
+        }
+        for (int i = kDepth - 1; i >= 0; i--) {
+            close << "</n" << i << ">";
+        }
+        dtd << "<!ELEMENT leaf EMPTY>\n"
+            << "<!ATTLIST leaf v CDATA #REQUIRED>\n"
+            << "]>\n";
+
+        Document doc;
+        doc.name = "deepNesting";
+        doc.dtd = dtd.str();
+        doc.start = "<deep>\n";
+        doc.block = open.str() + close.str() + "\n";
+        doc.end = "</deep>\n";
+        return doc;
+    }
+
+    /// Makes a document whose root element is a repeated choice among 200
+    /// elements, exercising content models with wide transition tables.
+    ///
+    Document MakeWideDocument()
+    {
+        const int kWidth = 200;
+        ostringstream dtd, block;
+
+        dtd << "<!DOCTYPE wide [\n"
+            << "<!ELEMENT wide (";
+        for (int i = 0; i < kWidth; i++) {
+            dtd << ((i == 0) ? "c" : "|c") << i;
+        }
+        dtd << ")*>\n";
+        for (int i = 0; i < kWidth; i++) {
+            dtd << "<!ELEMENT c" << i << " EMPTY>\n"
+                << "<!ATTLIST c" << i << " v CDATA #REQUIRED>\n";
+
+            int c = (i * 7) % kWidth;
+            block << "<c" << c << " v=\"" << i << "\"/>\n";
+        }
+        dtd << "]>\n";
+
+        Document doc;
+        doc.name = "wideChoice";
+        doc.dtd = dtd.str();
+        doc.start = "<wide>\n";
+        doc.block = block.str();
+        doc.end = "</wide>\n";
+        return doc;
+    }
+
+    /// Makes a document of groups whose content models use the '*', '+'
+    /// and '?' repetition operators.
+    ///
+    Document MakeRepetitionDocument()
+    {
+        Document doc;
+        doc.name = "repetition";
+        doc.dtd =
+            "<!DOCTYPE repetition [\n"
+            "<!ELEMENT repetition (group)*>\n"
+            "<!ELEMENT group (a+, (b, c?)*, d)>\n"
+            "<!ELEMENT a EMPTY>\n"
+            "<!ATTLIST a x CDATA #REQUIRED>\n"
+            "<!ELEMENT b EMPTY>\n"
+            "<!ATTLIST b x CDATA #REQUIRED>\n"
+            "<!ELEMENT c EMPTY>\n"
+            "<!ATTLIST c x CDATA #REQUIRED>\n"
+            "<!ELEMENT d EMPTY>\n"
+            "]>\n";
+        doc.start = "<repetition>\n";
+        doc.block =
+            "<group><a x=\"1\"/><a x=\"2\"/><a x=\"3\"/>"
+            "<b x=\"1\"/><c x=\"1\"/><b x=\"2\"/><b x=\"3\"/><c x=\"3\"/><d/></group>\n";
+        doc.end = "</repetition>\n";
+        return doc;
+    }
+
+    /// Makes a position log following PositionLog1.dtd.
+    ///
+    Document MakePositionLogDocument()
+    {
+        Document doc;
+        doc.name = "positionLog";
+        doc.dtd =
+            "<!DOCTYPE positionLog [\n"
+            "<!ELEMENT positionLog (info?, ((desktops+, positions+) | (positions+, desktops+))+)>\n"
+            "<!ATTLIST positionLog version (1) #REQUIRED>\n"
+            "<!ELEMENT info (title|desc)*>\n"
+            "<!ELEMENT title (#PCDATA)*>\n"
+            "<!ELEMENT desc (#PCDATA)*>\n"
+            "<!ELEMENT desktops (desktop+)>\n"
+            "<!ELEMENT desktop (units,(origin|size)*,screens)>\n"
+            "<!ATTLIST desktop id ID #REQUIRED>\n"
+            "<!ELEMENT units EMPTY>\n"
+            "<!ATTLIST units length (px|pt|tp|in|cm|mm|pc|custom) #REQUIRED angle (deg|rad) \"deg\">\n"
+            "<!ELEMENT origin EMPTY>\n"
+            "<!ATTLIST origin xoffset CDATA #REQUIRED yoffset CDATA #REQUIRED invertY (true|false) \"false\">\n"
+            "<!ELEMENT size EMPTY>\n"
+            "<!ATTLIST size x CDATA #REQUIRED y CDATA #REQUIRED>\n"
+            "<!ELEMENT screens (screen+)>\n"
+            "<!ELEMENT screen ((rect,resolution)|(resolution,rect))>\n"
+            "<!ATTLIST screen desc CDATA #REQUIRED primary (true|false) \"false\">\n"
+            "<!ELEMENT rect EMPTY>\n"
+            "<!ATTLIST rect top CDATA #REQUIRED bottom CDATA #REQUIRED left CDATA #REQUIRED right CDATA #REQUIRED>\n"
+            "<!ELEMENT resolution EMPTY>\n"
+            "<!ATTLIST resolution x CDATA #REQUIRED y CDATA #REQUIRED manual (true|false) \"false\">\n"
+            "<!ELEMENT positions (position*)>\n"
+            "<!ELEMENT position (desc?,points,desc?,properties*,desc?)>\n"
+            "<!ATTLIST position desktopRef IDREF #REQUIRED tool CDATA #REQUIRED date CDATA #REQUIRED>\n"
+            "<!ELEMENT points (point)+>\n"
+            "<!ELEMENT point EMPTY>\n"
+            "<!ATTLIST point name (1|2|v) #REQUIRED x CDATA #REQUIRED y CDATA #REQUIRED>\n"
+            "<!ELEMENT properties (width|height|distance|area|angle)*>\n"
+            "<!ELEMENT width EMPTY>\n"
+            "<!ATTLIST width value CDATA #REQUIRED>\n"
+            "<!ELEMENT height EMPTY>\n"
+            "<!ATTLIST height value CDATA #REQUIRED>\n"
+            "<!ELEMENT distance EMPTY>\n"
+            "<!ATTLIST distance value CDATA #REQUIRED>\n"
+            "<!ELEMENT area EMPTY>\n"
+            "<!ATTLIST area value CDATA #REQUIRED>\n"
+            "<!ELEMENT angle EMPTY>\n"
+            "<!ATTLIST angle value CDATA #REQUIRED>\n"
+            "]>\n";
+        doc.start =
+            "<positionLog version=\"1\">\n"
+            "    <info><title>Benchmark</title><desc>Synthetic position log</desc></info>\n"
+            "    <desktops>\n"
+            "        <desktop id=\"desktop1\">\n"
+            "            <units length=\"px\" angle=\"deg\"/>\n"
+            "            <origin xoffset=\"0\" yoffset=\"0\" invertY=\"false\"/>\n"
+            "            <size x=\"1600\" y=\"1200\"/>\n"
+            "            <screens>\n"
+            "                <screen desc=\"Primary\" primary=\"true\">\n"
+            "                    <rect top=\"0\" bottom=\"1200\" left=\"0\" right=\"1600\"/>\n"
+            "                    <resolution x=\"96\" y=\"96\" manual=\"false\"/>\n"
+            "                </screen>\n"
+            "            </screens>\n"
+            "        </desktop>\n"
+            "    </desktops>\n"
+            "    <positions>\n";
+
+        ostringstream block;
+        for (int i = 0; i < 100; i++) {
+            block << "        <position desktopRef=\"desktop1\" tool=\"LineTool\" date=\"2011-03-05T12:34:56Z\">\n"
+                  << "            <points>\n"
+                  << "                <point name=\"1\" x=\"" << (i * 13 % 1600) << ".5\" y=\"" << (i * 7 % 1200) << ".25\"/>\n"
+                  << "                <point name=\"2\" x=\"" << (i * 17 % 1600) << ".5\" y=\"" << (i * 11 % 1200) << ".25\"/>\n"
+                  << "            </points>\n"
+                  << "            <properties>\n"
+                  << "                <width value=\"101\"/>\n"
+                  << "                <height value=\"101\"/>\n"
+                  << "                <distance value=\"141.42\"/>\n"
+                  << "                <area value=\"10201\"/>\n"
+                  << "                <angle value=\"45\"/>\n"
+                  << "            </properties>\n"
+                  << "        </position>\n";
+        }
+        doc.block = block.str();
+        doc.end =
+            "    </positions>\n"
+            "</positionLog>\n";
+        return doc;
+    }
+
+    /// Makes a profile in the format written by MeaFileProfile. Profiles
+    /// have no DTD of their own, so the internal subset declares the
+    /// settings written by the application.
+    ///
+    Document MakeProfileDocument()
+    {
+        static const char* kSettings[] = {
+            "RulerEnabled", "RulerOrientation", "RulerColor", "CrossHairColor",
+            "CrossHairOpacity", "LineColor", "UnitsId", "AngleUnitsId",
+            "ScreenGrid", "GridSpacingH", "GridSpacingV", "GridLinkSpacing",
+            "MagEnabled", "MagZoom", "MagShowGrid", "MagRunState",
+            "ToolbarVisible", "StatusBarVisible", "WindowX", "WindowY",
+            "WindowWidth", "WindowHeight", "CurrentRadioTool", "PrecisionPixel"
+        };
+        const int kNumSettings = sizeof(kSettings) / sizeof(kSettings[0]);
+
+        ostringstream dtd, block;
+
+        dtd << "<!DOCTYPE profile [\n"
+            << "<!ELEMENT profile (info?, data)>\n"
+            << "<!ATTLIST profile version CDATA #REQUIRED>\n"
+            << "<!ELEMENT info (title|created|generator|machine)*>\n"
+            << "<!ELEMENT title (#PCDATA)*>\n"
+            << "<!ELEMENT created EMPTY>\n"
+            << "<!ATTLIST created date CDATA #REQUIRED>\n"
+            << "<!ELEMENT generator EMPTY>\n"
+            << "<!ATTLIST generator name CDATA #REQUIRED version CDATA #REQUIRED build CDATA #REQUIRED>\n"
+            << "<!ELEMENT machine EMPTY>\n"
+            << "<!ATTLIST machine name CDATA #REQUIRED>\n"
+            << "<!ELEMENT data (";
+        for (int i = 0; i < kNumSettings; i++) {
+            dtd << ((i == 0) ? "" : "|") << kSettings[i];
+        }
+        dtd << ")*>\n";
+        for (int i = 0; i < kNumSettings; i++) {
+            dtd << "<!ELEMENT " << kSettings[i] << " EMPTY>\n"
+                << "<!ATTLIST " << kSettings[i] << " value CDATA #REQUIRED>\n";
+            block << "        <" << kSettings[i] << " value=\"" << (i * 37) << "\"/>\n";
+        }
+        dtd << "]>\n";
+
+        Document doc;
+        doc.name = "profile";
+        doc.dtd = dtd.str();
+        doc.start =
+            "<profile version=\"1\">\n"
+            "    <info>\n"
+            "        <title>Meazure Profile File</title>\n"
+            "        <created date=\"2011-03-05T12:34:56Z\"/>\n"
+            "        <generator name=\"Meazure\" version=\"2.0\" build=\"1\"/>\n"
+            "        <machine name=\"benchmark\"/>\n"
+            "    </info>\n"
+            "    <data>\n";
+        doc.block = block.str();
+        doc.end =
+            "    </data>\n"
+            "</profile>\n";
+        return doc;
+    }
+
+
+    /// Counts the elements reported by the parser and the errors it
+    /// reports. The errors are counted rather than displayed.
+    ///
+    class CountingHandler : public MeaXMLParserHandler
+    {
+    public:
+        CountingHandler() : m_elementCount(0), m_errorCount(0) {}
+
+        virtual void StartElementHandler(const MeaXMLStringView& /* container */,
+                                         const MeaXMLStringView& /* elementName */,
+                                         const MeaXMLAttributes& /* attrs */) {
+            m_elementCount++;
+        }
+
+        virtual void EndElementHandler(const MeaXMLStringView& /* container */,
+                                       const MeaXMLStringView& /* elementName */) {
+        }
+
+        virtual void CharacterDataHandler(const MeaXMLStringView& /* container */,
+                                          const MeaXMLStringView& /* data */) {
+        }
+
+        virtual void ReportError(const CString& /* title */, const CString& msg) {
+            if (m_errorCount++ == 0) {
+                cerr << "Error: " << static_cast<LPCSTR>(CStringA(msg)) << '\n';
+            }
+        }
+
+        size_t  m_elementCount;
+        int     m_errorCount;
+    };
+
+
+    /// Results of parsing a document in one mode.
+    ///
+    struct Result
+    {
+        string  document;       ///< Name of the document.
+        string  mode;           ///< "callback" or "dom".
+        bool    validate;       ///< Was the document validated.
+        size_t  bytes;          ///< Size of the document.
+        int     iterations;     ///< Number of times the document was parsed.
+        bool    skipped;        ///< Was the measurement skipped.
+        bool    failed;         ///< Did parsing fail.
+        size_t  elements;       ///< Number of elements in the document.
+        double  ms;             ///< Time to parse the document once.
+        SIZE_T  peakBytes;      ///< Peak private bytes while parsing, above the starting level.
+        long    allocations;    ///< Heap allocations per parse.
+    };
+
+
+    /// Feeds a piece of a document to the parser and records the peak
+    /// memory use.
+    ///
+    void Feed(MeaXMLParser& parser, const string& data, bool isFinal, SIZE_T& peak)
+    {
+        int len = static_cast<int>(data.size());
+        void* buf = parser.GetBuffer(len);
+        memcpy(buf, data.data(), len);
+        parser.ParseBuffer(len, isFinal);
+
+        SIZE_T bytes = GetPrivateBytes();
+        if (bytes > peak) {
+            peak = bytes;
+        }
+    }
+
+    /// Parses a document of the specified size once. The body of the
+    /// document is fed to the parser a chunk of blocks at a time, so the
+    /// whole document is never held in memory.
+    ///
+    /// @return false if a parsing or validation error occurred.
+    ///
+    bool ParseDocument(const Document& doc, const string& chunk, size_t blocksPerChunk, size_t numBlocks,
+                       bool buildDOM, bool validate, CountingHandler& handler, SIZE_T& peak)
+    {
+        MeaXMLParser parser(&handler, buildDOM, &countingSuite);
+
+        try {
+            string head = string(kXMLDecl) + (validate ? doc.dtd : string()) + doc.start;
+            Feed(parser, head, false, peak);
+
+            size_t remaining = numBlocks;
+            for (; remaining >= blocksPerChunk; remaining -= blocksPerChunk) {
+                Feed(parser, chunk, false, peak);
+            }
+
+            string tail;
+            for (; remaining > 0; remaining--) {
+                tail += doc.block;
+            }
+            tail += doc.end;
+            Feed(parser, tail, true, peak);
+        }
+        catch (MeaXMLParserException&) {
+            return false;
+        }
+
+        return handler.m_errorCount == 0;
+    }
+
+    /// Measures parsing a document of the specified size in one mode.
+    ///
+    Result Measure(const Document& doc, size_t size, bool buildDOM, bool validate)
+    {
+        Result result;
+
+        result.document = doc.name;
+        result.mode = buildDOM ? "dom" : "callback";
+        result.validate = validate;
+        result.iterations = 0;
+        result.skipped = buildDOM && size > kMaxDOMSize;
+        result.failed = false;
+        result.elements = 0;
+        result.ms = 0.0;
+        result.peakBytes = 0;
+        result.allocations = 0;
+
+        size_t fixedSize = strlen(kXMLDecl) + (validate ? doc.dtd.size() : 0) + doc.start.size() + doc.end.size();
+        size_t numBlocks = (size > fixedSize) ? (size - fixedSize) / doc.block.size() : 0;
+        if (numBlocks == 0) {
+            numBlocks = 1;
+        }
+        result.bytes = fixedSize + numBlocks * doc.block.size();
+
+        if (result.skipped) {
+            return result;
+        }
+
+        size_t blocksPerChunk = kChunkSize / doc.block.size();
+        if (blocksPerChunk == 0) {
+            blocksPerChunk = 1;
+        }
+        string chunk;
+        for (size_t i = 0; i < blocksPerChunk; i++) {
+            chunk += doc.block;
+        }
+
+        result.iterations = static_cast<int>(kMinParsedBytes / result.bytes);
+        if (result.iterations == 0) {
+            result.iterations = 1;
+        }
+
+        SIZE_T base = GetPrivateBytes();
+        SIZE_T peak = base;
+
+        // Allocations are counted in a pass of their own so that counting
+        // does not affect the timing.
+        //
+        {
+            CountingHandler handler;
+
+            allocationCount = 0;
+            countAllocations = true;
+            result.failed = !ParseDocument(doc, chunk, blocksPerChunk, numBlocks, buildDOM, validate,
+                                           handler, peak);
+            countAllocations = false;
+
+            result.allocations = allocationCount;
+            result.elements = handler.m_elementCount;
+        }
+
+        BenchmarkTimer timer;
+        for (int i = 0; i < result.iterations && !result.failed; i++) {
+            CountingHandler handler;
+            result.failed = !ParseDocument(doc, chunk, blocksPerChunk, numBlocks, buildDOM, validate,
+                                           handler, peak);
+        }
+
+        result.ms = timer.GetElapsedMs() / result.iterations;
+        result.peakBytes = peak - base;
+        return result;
+    }
+
+
+    /// Writes the results as a JSON document.
+    ///
+    void WriteJSON(ostream& out, const vector<Result>& results)
+    {
+        out << "{\n"
+            << "    \"benchmark\": \"XMLParser\",\n"
+#ifdef _DEBUG
+            << "    \"build\": \"debug\",\n"
+#else
+            << "    \"build\": \"release\",\n"
+#endif
+            << "    \"results\": [";
+
+        for (vector<Result>::const_iterator iter = results.begin(); iter != results.end(); ++iter) {
+            const Result& r = *iter;
+            double mbytes = static_cast<double>(r.bytes) / kMB;
+            bool measured = !r.skipped && !r.failed;
+
+            out << ((iter == results.begin()) ? "\n" : ",\n")
+                << "        {"
+                << "\"document\": \"" << r.document << "\", "
+                << "\"mode\": \"" << r.mode << "\", "
+                << "\"validate\": " << (r.validate ? "true" : "false") << ", "
+                << "\"bytes\": " << r.bytes << ", "
+                << "\"status\": \"" << (r.skipped ? "skipped" : (r.failed ? "failed" : "ok")) << "\"";
+
+            if (measured) {
+                out << ", \"iterations\": " << r.iterations
+                    << ", \"elements\": " << r.elements
+                    << ", \"ms\": " << r.ms
+                    << ", \"mbPerSec\": " << ((r.ms > 0.0) ? (mbytes * 1000.0 / r.ms) : 0.0)
+                    << ", \"nsPerElement\": " << ((r.elements > 0) ? (r.ms * 1000000.0 / r.elements) : 0.0)
+                    << ", \"peakPrivateBytes\": " << r.peakBytes
+                    << ", \"allocations\": " << r.allocations
+                    << ", \"allocationsPerElement\": "
+                    << ((r.elements > 0) ? (static_cast<double>(r.allocations) / r.elements) : 0.0);
+            }
+            out << "}";
+        }
+
+        out << "\n    ]\n"
+            << "}\n";
+    }
+}
+
+
+int RunXMLParserBenchmark(int argc, char* argv[])
+{
+    const char* outputPath = (argc > 0) ? argv[0] : "XMLParserBenchmark.json";
+    size_t maxSize = (argc > 1) ? static_cast<size_t>(atoi(argv[1])) * kMB : 500 * kMB;
+
+    vector<Document> documents;
+    documents.push_back(MakeDeepDocument());
+    documents.push_back(MakeWideDocument());
+    documents.push_back(MakeRepetitionDocument());
+    documents.push_back(MakePositionLogDocument());
+    documents.push_back(MakeProfileDocument());
+
+    vector<Result> results;
+    int numFailed = 0;
+
+    for (vector<Document>::const_iterator doc = documents.begin(); doc != documents.end(); ++doc) {
+        for (size_t i = 0; i < sizeof(kDocumentSizes) / sizeof(kDocumentSizes[0]); i++) {
+            if (kDocumentSizes[i] > maxSize) {
+                continue;
+            }
+            for (int buildDOM = 0; buildDOM < 2; buildDOM++) {
+                for (int validate = 0; validate < 2; validate++) {
+                    Result r = Measure(*doc, kDocumentSizes[i], buildDOM != 0, validate != 0);
+
+                    cout << r.document << ' ' << r.bytes << " bytes " << r.mode
+                         << (r.validate ? " validated: " : ": ");
+                    if (r.skipped) {
+                        cout << "skipped\n";
+                    } else if (r.failed) {
+                        cout << "FAILED\n";
+                        numFailed++;
+                    } else {
+                        cout << r.ms << " ms (" << (static_cast<double>(r.bytes) / kMB * 1000.0 / r.ms)
+                             << " MB/s)\n";
+                    }
+                    results.push_back(r);
+                }
+            }
+        }
+    }
+
+    ofstream out(outputPath);
+    if (!out) {
+        cerr << "Error: could not open " << outputPath << '\n';
+        return 1;
+    }
+    WriteJSON(out, results);
+
+    return (numFailed == 0) ? 0 : 1;
+}
@@ -0,0 +1,390 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include <XMLParser.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <boost/test/included/unit_test_framework.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+CWinApp theApp;
+
+
+using namespace std;
+using namespace boost::unit_test;
+using boost::unit_test_framework::test_suite;
+
+
+namespace
+{
+    /// Records the parsing events as "container/element" strings and
+    /// keeps a copy of the attributes of each element.
+    ///
+    class RecordingHandler : public MeaXMLParserHandler
+    {
+    public:
+        RecordingHandler() : m_errorCount(0) {}
+
+        virtual void StartElementHandler(const MeaXMLStringView& container,
+                                         const MeaXMLStringView& elementName,
+                                         const MeaXMLAttributes& attrs) {
+            m_starts.push_back(container.ToString() + _T("/") + elementName.ToString());
+            m_attributes.push_back(attrs);
+        }
+
+        virtual void EndElementHandler(const MeaXMLStringView& container,
+                                       const MeaXMLStringView& elementName) {
+            m_ends.push_back(container.ToString() + _T("/") + elementName.ToString());
+        }
+
+        virtual void ReportError(const CString& /* title */, const CString& /* msg */) {
+            m_errorCount++;
+        }
+
+        vector<CString>             m_starts;
+        vector<CString>             m_ends;
+        vector<MeaXMLAttributes>    m_attributes;
+        int                         m_errorCount;
+    };
+
+    void Parse(MeaXMLParser& parser, const string& doc)
+    {
+        int len = static_cast<int>(doc.size());
+        void* buf = parser.GetBuffer(len);
+        memcpy(buf, doc.data(), len);
+        parser.ParseBuffer(len, true);
+    }
+
+    bool IsAligned(const void* mem)
+    {
+        return (reinterpret_cast<UINT_PTR>(mem) % sizeof(double)) == 0;
+    }
+
+
+    void TestArena()
+    {
+        MeaXMLArena arena(1024);
+        BOOST_CHECK_EQUAL(arena.GetReservedSize(), 0U);
+
+        // Small allocations are rounded up and handed out sequentially.
+        //
+        char* first = static_cast<char*>(arena.Allocate(3));
+        char* second = static_cast<char*>(arena.Allocate(5));
+        BOOST_CHECK(IsAligned(first));
+        BOOST_CHECK(IsAligned(second));
+        BOOST_CHECK(second == first + 8);
+        BOOST_CHECK_EQUAL(arena.GetReservedSize(), 1024U);
+
+        // A large allocation gets a block of its own and does not
+        // abandon the rest of the current block.
+        //
+        void* large = arena.Allocate(600);
+        BOOST_CHECK(IsAligned(large));
+        BOOST_CHECK_EQUAL(arena.GetReservedSize(), 1024U + 600U);
+
+        char* third = static_cast<char*>(arena.Allocate(8));
+        BOOST_CHECK(third == second + 8);
+
+        // Filling the current block starts a new one.
+        //
+        arena.Allocate(250);
+        arena.Allocate(250);
+        arena.Allocate(250);
+        BOOST_CHECK_EQUAL(arena.GetReservedSize(), 1024U + 600U);
+        char* next = static_cast<char*>(arena.Allocate(250));
+        BOOST_CHECK(IsAligned(next));
+        BOOST_CHECK_EQUAL(arena.GetReservedSize(), 2U * 1024U + 600U);
+
+        LPCTSTR str = arena.CopyString(_T("hello"), 3);
+        BOOST_CHECK(_tcscmp(str, _T("hel")) == 0);
+
+        arena.Clear();
+        BOOST_CHECK_EQUAL(arena.GetReservedSize(), 0U);
+    }
+
+    void TestStringView()
+    {
+        MeaXMLStringView empty;
+        BOOST_CHECK(empty.IsEmpty());
+        BOOST_CHECK(empty == _T(""));
+        BOOST_CHECK(empty != _T("a"));
+
+        // The view need not be NUL terminated.
+        //
+        MeaXMLStringView ascii("abcdef", 2);
+        BOOST_CHECK(ascii == _T("ab"));
+        BOOST_CHECK(ascii != _T("a"));
+        BOOST_CHECK(ascii != _T("abc"));
+        BOOST_CHECK(ascii != _T("ax"));
+
+        // Non-ASCII strings are compared in the ACP.
+        //
+        CString cafe(MeaXMLParser::FromUTF8("caf\xC3\xA9"));
+        MeaXMLStringView utf8("caf\xC3\xA9xyz", 5);
+        BOOST_CHECK(utf8 == cafe);
+        BOOST_CHECK(utf8 != _T("cafe"));
+        BOOST_CHECK(utf8 != _T("caf"));
+        BOOST_CHECK(MeaXMLStringView("cafe", 4) != cafe);
+        BOOST_CHECK(MeaXMLStringView("caf\xC3\xA9", 5).ToString() == cafe);
+    }
+
+    void TestFromUTF8()
+    {
+        BOOST_CHECK(MeaXMLParser::FromUTF8("") == _T(""));
+        BOOST_CHECK(MeaXMLParser::FromUTF8("abc", 2) == _T("ab"));
+
+        // A string longer than the conversion scratch buffer is converted
+        // in a buffer of its own.
+        //
+        const int kNumChars = 1500;
+        CString eAcute(MeaXMLParser::FromUTF8("\xC3\xA9"));
+        string utf8;
+        CString expected;
+        for (int i = 0; i < kNumChars; i++) {
+            utf8 += "\xC3\xA9";
+            expected += eAcute;
+        }
+
+        CString str(MeaXMLParser::FromUTF8(utf8.c_str()));
+        BOOST_CHECK_EQUAL(str.GetLength(), expected.GetLength());
+        BOOST_CHECK(str == expected);
+        BOOST_CHECK(MeaXMLParser::FromUTF8(utf8.c_str(), 4) == eAcute + eAcute);
+    }
+
+    void TestElementStack()
+    {
+        const string doc = "<outer><in><x/></in><longer><y/></longer></outer>";
+        RecordingHandler handler;
+        MeaXMLParser parser(&handler);
+
+        Parse(parser, doc);
+
+        BOOST_REQUIRE_EQUAL(handler.m_starts.size(), 5U);
+        BOOST_CHECK(handler.m_starts[0] == _T("/outer"));
+        BOOST_CHECK(handler.m_starts[1] == _T("outer/in"));
+        BOOST_CHECK(handler.m_starts[2] == _T("in/x"));
+        BOOST_CHECK(handler.m_starts[3] == _T("outer/longer"));
+        BOOST_CHECK(handler.m_starts[4] == _T("longer/y"));
+
+        BOOST_REQUIRE_EQUAL(handler.m_ends.size(), 5U);
+        BOOST_CHECK(handler.m_ends[0] == _T("in/x"));
+        BOOST_CHECK(handler.m_ends[1] == _T("outer/in"));
+        BOOST_CHECK(handler.m_ends[2] == _T("longer/y"));
+        BOOST_CHECK(handler.m_ends[3] == _T("outer/longer"));
+        BOOST_CHECK(handler.m_ends[4] == _T("/outer"));
+        BOOST_CHECK_EQUAL(handler.m_errorCount, 0);
+    }
+
+    void TestAttributes()
+    {
+        // The copies made by the handler must outlive the parser's
+        // strings. The second element has more attributes than are
+        // held inline.
+        //
+        string doc = "<a><few p=\"12.75\" q=\"true\" \xC3\xA9=\"accent\"/><many";
+        for (int i = 0; i < 10; i++) {
+            char attr[32];
+            sprintf_s(attr, sizeof(attr), " a%d=\"%d\"", i, i * 10);
+            doc += attr;
+        }
+        doc += "/></a>";
+
+        RecordingHandler handler;
+        {
+            MeaXMLParser parser(&handler);
+            Parse(parser, doc);
+        }
+        BOOST_REQUIRE_EQUAL(handler.m_attributes.size(), 3U);
+
+        const MeaXMLAttributes& few = handler.m_attributes[1];
+        const MeaXMLAttributes& many = handler.m_attributes[2];
+        CString strValue;
+        int intValue;
+        double dblValue;
+        bool boolValue;
+        bool isDefault;
+
+        // Integer and double values are cached separately.
+        //
+        BOOST_CHECK(few.GetValueInt(_T("p"), intValue, isDefault));
+        BOOST_CHECK_EQUAL(intValue, 12);
+        BOOST_CHECK(!isDefault);
+        BOOST_CHECK(few.GetValueDbl(_T("p"), dblValue, isDefault));
+        BOOST_CHECK_EQUAL(dblValue, 12.75);
+        BOOST_CHECK(few.GetValueInt(_T("p"), intValue, isDefault));
+        BOOST_CHECK_EQUAL(intValue, 12);
+        BOOST_CHECK(few.GetValueDbl(_T("p"), dblValue, isDefault));
+        BOOST_CHECK_EQUAL(dblValue, 12.75);
+        BOOST_CHECK(few.GetValueBool(_T("q"), boolValue, isDefault));
+        BOOST_CHECK(boolValue);
+        BOOST_CHECK(!few.GetValueInt(_T("r"), intValue, isDefault));
+
+        BOOST_CHECK(few.GetValueStr(MeaXMLParser::FromUTF8("\xC3\xA9"), strValue, isDefault));
+        BOOST_CHECK(strValue == _T("accent"));
+
+        for (int i = 0; i < 10; i++) {
+            CString name;
+            name.Format(_T("a%d"), i);
+            BOOST_CHECK(many.GetValueInt(name, intValue, isDefault));
+            BOOST_CHECK_EQUAL(intValue, i * 10);
+        }
+
+        // Copies between inline and overflow storage.
+        //
+        MeaXMLAttributes copy(many);
+        BOOST_CHECK(copy.GetValueInt(_T("a9"), intValue, isDefault));
+        BOOST_CHECK_EQUAL(intValue, 90);
+
+        copy = copy;
+        BOOST_CHECK(copy.GetValueInt(_T("a0"), intValue, isDefault));
+        BOOST_CHECK_EQUAL(intValue, 0);
+        BOOST_CHECK(copy.GetValueInt(_T("a9"), intValue, isDefault));
+        BOOST_CHECK_EQUAL(intValue, 90);
+
+        copy = few;
+        BOOST_CHECK(!copy.GetValueInt(_T("a9"), intValue, isDefault));
+        BOOST_CHECK(copy.GetValueDbl(_T("p"), dblValue, isDefault));
+        BOOST_CHECK_EQUAL(dblValue, 12.75);
+
+        copy = many;
+        BOOST_CHECK(!copy.GetValueInt(_T("p"), intValue, isDefault));
+        BOOST_CHECK(copy.GetValueInt(_T("a5"), intValue, isDefault));
+        BOOST_CHECK_EQUAL(intValue, 50);
+
+        MeaXMLAttributes empty;
+        copy = empty;
+        BOOST_CHECK(!copy.GetValueInt(_T("a5"), intValue, isDefault));
+    }
+
+    void TestDefaultAttributes()
+    {
+        const string doc =
+            "<!DOCTYPE a ["
+            "<!ELEMENT a (b)>"
+            "<!ELEMENT b EMPTY>"
+            "<!ATTLIST b x CDATA #IMPLIED y CDATA #IMPLIED z CDATA \"dflt\">"
+            "]>"
+            "<a><b x=\"1\" y=\"2\"/></a>";
+        RecordingHandler handler;
+        MeaXMLParser parser(&handler, true);
+
+        Parse(parser, doc);
+        BOOST_CHECK_EQUAL(handler.m_errorCount, 0);
+        BOOST_REQUIRE_EQUAL(handler.m_attributes.size(), 2U);
+
+        const MeaXMLAttributes& attrs = handler.m_attributes[1];
+        CString value;
+        bool isDefault;
+
+        BOOST_CHECK(attrs.GetValueStr(_T("x"), value, isDefault));
+        BOOST_CHECK(!isDefault);
+        BOOST_CHECK(attrs.GetValueStr(_T("y"), value, isDefault));
+        BOOST_CHECK(!isDefault);
+        BOOST_CHECK(attrs.GetValueStr(_T("z"), value, isDefault));
+        BOOST_CHECK(value == _T("dflt"));
+        BOOST_CHECK(isDefault);
+
+        const MeaXMLNode* b = parser.GetDOM()->GetFirstChild();
+        LPCTSTR nodeValue;
+        BOOST_REQUIRE(b != NULL);
+        BOOST_CHECK(b->GetAttributeValue(_T("y"), nodeValue, isDefault));
+        BOOST_CHECK(!isDefault);
+        BOOST_CHECK(b->GetAttributeValue(_T("z"), nodeValue, isDefault));
+        BOOST_CHECK(isDefault);
+    }
+
+    void TestDOM()
+    {
+        const string doc = "<root x=\"1\"><first/><second y=\"2\" z=\"3\"><inner/></second><third/></root>";
+        RecordingHandler handler;
+        MeaXMLParser parser(&handler, true);
+
+        Parse(parser, doc);
+
+        const MeaXMLNode* root = parser.GetDOM();
+        BOOST_REQUIRE(root != NULL);
+        BOOST_CHECK_EQUAL(root->GetType(), MeaXMLNode::Element);
+        BOOST_CHECK(_tcscmp(root->GetData(), _T("root")) == 0);
+        BOOST_CHECK_EQUAL(root->GetDataLength(), 4);
+        BOOST_CHECK(root->GetParent() == NULL);
+        BOOST_CHECK(root->GetNextSibling() == NULL);
+
+        LPCTSTR value;
+        bool isDefault;
+        BOOST_CHECK_EQUAL(root->GetAttributeCount(), 1);
+        BOOST_CHECK(root->GetAttributeValue(_T("x"), value, isDefault));
+        BOOST_CHECK(_tcscmp(value, _T("1")) == 0);
+        BOOST_CHECK(!isDefault);
+        BOOST_CHECK(!root->GetAttributeValue(_T("y"), value, isDefault));
+
+        // The children are linked in document order.
+        //
+        const MeaXMLNode* first = root->GetFirstChild();
+        BOOST_REQUIRE(first != NULL);
+        BOOST_CHECK(_tcscmp(first->GetData(), _T("first")) == 0);
+        BOOST_CHECK(first->GetParent() == root);
+        BOOST_CHECK(first->GetFirstChild() == NULL);
+
+        const MeaXMLNode* second = first->GetNextSibling();
+        BOOST_REQUIRE(second != NULL);
+        BOOST_CHECK(_tcscmp(second->GetData(), _T("second")) == 0);
+        BOOST_CHECK(second->GetParent() == root);
+        BOOST_CHECK_EQUAL(second->GetAttributeCount(), 2);
+        BOOST_CHECK(_tcscmp(second->GetAttribute(1).name, _T("z")) == 0);
+        BOOST_CHECK(second->GetAttributeValue(_T("y"), value, isDefault));
+        BOOST_CHECK(_tcscmp(value, _T("2")) == 0);
+
+        const MeaXMLNode* inner = second->GetFirstChild();
+        BOOST_REQUIRE(inner != NULL);
+        BOOST_CHECK(_tcscmp(inner->GetData(), _T("inner")) == 0);
+        BOOST_CHECK(inner->GetParent() == second);
+        BOOST_CHECK(inner->GetNextSibling() == NULL);
+
+        const MeaXMLNode* third = second->GetNextSibling();
+        BOOST_REQUIRE(third != NULL);
+        BOOST_CHECK(_tcscmp(third->GetData(), _T("third")) == 0);
+        BOOST_CHECK(third->GetParent() == root);
+        BOOST_CHECK(third->GetNextSibling() == NULL);
+    }
+}
+
+
+test_suite* init_unit_test_suite(int argc, char* argv[])
+{
+    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
+        cerr << "Fatail Error: MFC initialization failed\n";
+        return NULL;
+    }
+
+    test_suite* suite = BOOST_TEST_SUITE("XMLParser Tests");
+    suite->add(BOOST_TEST_CASE(&TestArena));
+    suite->add(BOOST_TEST_CASE(&TestStringView));
+    suite->add(BOOST_TEST_CASE(&TestFromUTF8));
+    suite->add(BOOST_TEST_CASE(&TestElementStack));
+    suite->add(BOOST_TEST_CASE(&TestAttributes));
+    suite->add(BOOST_TEST_CASE(&TestDefaultAttributes));
+    suite->add(BOOST_TEST_CASE(&TestDOM));
+    return suite;
+}
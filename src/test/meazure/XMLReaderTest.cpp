@@ -0,0 +1,195 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ * 
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include <XMLReader.h>
+#include <string>
+#include <iostream>
+#include <boost/test/included/unit_test_framework.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+CWinApp theApp;
+
+
+using namespace std;
+using namespace boost::unit_test;
+using boost::unit_test_framework::test_suite;
+
+
+namespace
+{
+    /// Records the errors reported by the reader instead of displaying them.
+    ///
+    class ErrorHandler : public MeaXMLParserHandler
+    {
+    public:
+        ErrorHandler() : m_errorCount(0) {}
+
+        virtual void ReportError(const CString& /* title */, const CString& /* msg */) {
+            m_errorCount++;
+        }
+
+        int m_errorCount;
+    };
+
+    void Open(CMemFile& file, const std::string& doc)
+    {
+        file.Write(doc.data(), static_cast<UINT>(doc.size()));
+        file.SeekToBegin();
+    }
+
+    void TestEvents()
+    {
+        const std::string doc = "<a x=\"1\"><b y=\"2.5\"/><c>text &amp; more</c></a>";
+        ErrorHandler handler;
+        MeaXMLReader reader(doc.data(), doc.size(), &handler);
+        int intValue;
+        double dblValue;
+        bool isDefault;
+
+        BOOST_CHECK_EQUAL(reader.Next(), MeaXMLReader::StartElement);
+        BOOST_CHECK(reader.GetName() == _T("a"));
+        BOOST_CHECK_EQUAL(reader.GetDepth(), 1);
+        BOOST_CHECK(reader.GetAttributes().GetValueInt(_T("x"), intValue, isDefault));
+        BOOST_CHECK_EQUAL(intValue, 1);
+
+        BOOST_CHECK_EQUAL(reader.Next(), MeaXMLReader::StartElement);
+        BOOST_CHECK(reader.GetName() == _T("b"));
+        BOOST_CHECK_EQUAL(reader.GetDepth(), 2);
+        BOOST_CHECK(reader.GetAttributes().GetValueDbl(_T("y"), dblValue, isDefault));
+        BOOST_CHECK_EQUAL(dblValue, 2.5);
+        BOOST_CHECK(!reader.GetAttributes().GetValueInt(_T("x"), intValue, isDefault));
+
+        BOOST_CHECK_EQUAL(reader.Next(), MeaXMLReader::EndElement);
+        BOOST_CHECK(reader.GetName() == _T("b"));
+        BOOST_CHECK_EQUAL(reader.GetDepth(), 1);
+
+        BOOST_CHECK_EQUAL(reader.Next(), MeaXMLReader::StartElement);
+        BOOST_CHECK(reader.GetName() == _T("c"));
+
+        // The entity reference splits the character data, which is
+        // reported as a single event.
+        //
+        BOOST_CHECK_EQUAL(reader.Next(), MeaXMLReader::Text);
+        BOOST_CHECK(reader.GetText().ToString() == _T("text & more"));
+
+        BOOST_CHECK_EQUAL(reader.Next(), MeaXMLReader::EndElement);
+        BOOST_CHECK(reader.GetName() == _T("c"));
+        BOOST_CHECK_EQUAL(reader.Next(), MeaXMLReader::EndElement);
+        BOOST_CHECK(reader.GetName() == _T("a"));
+        BOOST_CHECK_EQUAL(reader.GetDepth(), 0);
+
+        BOOST_CHECK_EQUAL(reader.Next(), MeaXMLReader::EndDocument);
+        BOOST_CHECK_EQUAL(reader.Next(), MeaXMLReader::EndDocument);
+        BOOST_CHECK_EQUAL(handler.m_errorCount, 0);
+    }
+
+    void TestSkip()
+    {
+        const std::string doc = "<a><skip><x/><y>t</y><skip/></skip><after/></a>";
+        MeaXMLReader reader(doc.data(), doc.size());
+
+        BOOST_CHECK_EQUAL(reader.Next(), MeaXMLReader::StartElement);
+        BOOST_CHECK_EQUAL(reader.Next(), MeaXMLReader::StartElement);
+        BOOST_CHECK(reader.GetName() == _T("skip"));
+
+        reader.Skip();
+        BOOST_CHECK_EQUAL(reader.GetEvent(), MeaXMLReader::EndElement);
+        BOOST_CHECK(reader.GetName() == _T("skip"));
+        BOOST_CHECK_EQUAL(reader.GetDepth(), 1);
+
+        BOOST_CHECK_EQUAL(reader.Next(), MeaXMLReader::StartElement);
+        BOOST_CHECK(reader.GetName() == _T("after"));
+    }
+
+    void TestChunks()
+    {
+        // A document spanning several chunks, read from a file.
+        //
+        const int kNumPoints = 20000;
+        std::string doc = "<points>";
+        for (int i = 0; i < kNumPoints; i++) {
+            char point[64];
+            sprintf_s(point, sizeof(point), "<point x=\"%d\" y=\"%d\"/>", i, -i);
+            doc += point;
+        }
+        doc += "</points>";
+        BOOST_CHECK(doc.size() > 4 * MeaXMLReader::kChunkSize);
+
+        CMemFile file;
+        Open(file, doc);
+        MeaXMLReader reader(file);
+        int count = 0;
+        int sum = 0;
+
+        while (reader.Next() != MeaXMLReader::EndDocument) {
+            if (reader.GetEvent() == MeaXMLReader::StartElement && reader.GetName() == _T("point")) {
+                int x, y;
+                bool isDefault;
+
+                reader.GetAttributes().GetValueInt(_T("x"), x, isDefault);
+                reader.GetAttributes().GetValueInt(_T("y"), y, isDefault);
+                BOOST_CHECK_EQUAL(x, -y);
+                sum += x;
+                count++;
+            }
+        }
+
+        BOOST_CHECK_EQUAL(count, kNumPoints);
+        BOOST_CHECK_EQUAL(sum, kNumPoints * (kNumPoints - 1) / 2);
+    }
+
+    void TestError()
+    {
+        const std::string doc = "<a><b></a>";
+        ErrorHandler handler;
+        MeaXMLReader reader(doc.data(), doc.size(), &handler);
+        bool thrown = false;
+
+        try {
+            while (reader.Next() != MeaXMLReader::EndDocument) {
+            }
+        } catch (MeaXMLParserException&) {
+            thrown = true;
+        }
+
+        BOOST_CHECK(thrown);
+        BOOST_CHECK_EQUAL(handler.m_errorCount, 1);
+    }
+}
+
+
+test_suite* init_unit_test_suite(int argc, char* argv[])
+{
+    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
+        cerr << "Fatail Error: MFC initialization failed\n";
+        return NULL;
+    }
+    
+    test_suite* suite = BOOST_TEST_SUITE("XMLReader Tests");
+    suite->add(BOOST_TEST_CASE(&TestEvents));
+    suite->add(BOOST_TEST_CASE(&TestSkip));
+    suite->add(BOOST_TEST_CASE(&TestChunks));
+    suite->add(BOOST_TEST_CASE(&TestError));
+    return suite;
+}
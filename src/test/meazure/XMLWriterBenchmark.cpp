@@ -0,0 +1,151 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ *
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file
+/// @brief Benchmark of the XML writer.
+///
+/// Text with varying amounts of markup is escaped, and a position log of
+/// 100,000 positions is written to memory:
+///
+/// @code
+///     MeazureBenchmark XMLWriter
+/// @endcode
+
+#include "StdAfx.h"
+#include "Benchmark.h"
+#include <XMLWriter.h>
+#include <iostream>
+
+
+using namespace std;
+
+
+namespace
+{
+    /// Writes the text repeatedly as character data and reports the
+    /// throughput.
+    ///
+    /// @return false if nothing was written.
+    ///
+    bool BenchmarkText(const char* title, const CString& text)
+    {
+        const int kNumStrings = 100000;
+        CMemFile file(4 * 1024 * 1024);
+
+        BenchmarkTimer timer;
+        {
+            MeaXMLWriter writer(file);
+
+            writer.StartElement(_T("desc"));
+            for (int i = 0; i < kNumStrings; i++) {
+                writer.Text(text);
+            }
+            writer.EndElement();
+        }
+        double ms = timer.GetElapsedMs();
+        double mb = static_cast<double>(kNumStrings) * text.GetLength() / (1024.0 * 1024.0);
+
+        cout << "escape " << title << ": " << mb << " MB of text in " << ms
+             << " ms, " << (mb * 1000.0 / ms) << " MB/s\n";
+
+        return file.GetLength() > 0;
+    }
+
+    /// Escapes text with varying amounts of markup.
+    ///
+    /// @return false if nothing was written.
+    ///
+    bool BenchmarkEscape()
+    {
+        // Typical position descriptions contain little or no markup.
+        //
+        bool ok = BenchmarkText("plain", _T("Distance between the left edge of the toolbar and the first button, ")
+                                         _T("measured at 100% zoom on the primary screen."));
+        ok = BenchmarkText("realistic", _T("Width of the \"Save & Close\" button <primary screen>, ")
+                                        _T("measured from the toolbar's left edge at 100% zoom.")) && ok;
+
+        // Every character needs an entity reference or a conversion.
+        //
+        ok = BenchmarkText("all markup", _T("<<>>&&\"\"''<>&\"'<<>>&&\"\"''<>&\"'<<>>&&\"\"''<>&\"'<<>>&&\"\"''<>&\"'")) && ok;
+        ok = BenchmarkText("non-ASCII", CString(L"\x00E9\x00E8\x00EA\x00EB\x00E0\x00E2\x00E4\x00F4\x00F6\x00FB")
+                                        + CString(L"\x00FC\x00E7\x00EF\x00EE\x00E9\x00E8\x00EA\x00EB\x00E0\x00E2")) && ok;
+        return ok;
+    }
+
+    /// Writes a position log and reports the throughput.
+    ///
+    /// @return false if nothing was written.
+    ///
+    bool BenchmarkPositionLog()
+    {
+        const int kNumPositions = 100000;
+        CMemFile file(4 * 1024 * 1024);
+
+        BenchmarkTimer timer;
+        {
+            MeaXMLWriter writer(file);
+
+            writer.Declaration();
+            writer.StartElement(_T("positionLog"));
+            writer.Attribute(_T("version"), 1);
+            writer.StartElement(_T("positions"));
+            for (int i = 0; i < kNumPositions; i++) {
+                writer.StartElement(_T("position"));
+                writer.Attribute(_T("desktopRef"), _T("00000000-0000-0000-0000-000000000000"));
+                writer.Attribute(_T("tool"), _T("LineTool"));
+                writer.Attribute(_T("date"), _T("2011-01-01T00:00:00Z"));
+                    writer.StartElement(_T("points"));
+                    writer.StartElement(_T("point"));
+                    writer.Attribute(_T("name"), _T("1"));
+                    writer.Attribute(_T("x"), i * 0.5);
+                    writer.Attribute(_T("y"), i * 0.25);
+                    writer.EndElement();
+                    writer.StartElement(_T("point"));
+                    writer.Attribute(_T("name"), _T("2"));
+                    writer.Attribute(_T("x"), i * 1.5);
+                    writer.Attribute(_T("y"), i * 1.25);
+                    writer.EndElement();
+                    writer.EndElement();
+                    writer.StartElement(_T("properties"));
+                    writer.StartElement(_T("distance"));
+                    writer.Attribute(_T("value"), i * 3.0);
+                    writer.EndElement();
+                    writer.EndElement();
+                writer.EndElement();
+            }
+            writer.EndElement();
+            writer.EndElement();
+        }
+        double ms = timer.GetElapsedMs();
+        double mb = static_cast<double>(file.GetLength()) / (1024.0 * 1024.0);
+
+        cout << "write " << kNumPositions << " positions (" << mb << " MB) in " << ms
+             << " ms, " << (mb * 1000.0 / ms) << " MB/s\n";
+
+        return file.GetLength() > 0;
+    }
+}
+
+
+int RunXMLWriterBenchmark(int /* argc */, char* /* argv */[])
+{
+    bool ok = BenchmarkEscape();
+    ok = BenchmarkPositionLog() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2011 C Thing Software
+ *
+ * This file is part of Meazure.
+ * 
+ * Meazure is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Meazure is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Meazure.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StdAfx.h"
+#include <XMLWriter.h>
+#include <string>
+#include <iostream>
+#include <boost/test/included/unit_test_framework.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+CWinApp theApp;
+
+
+using namespace std;
+using namespace boost::unit_test;
+using boost::unit_test_framework::test_suite;
+
+
+namespace
+{
+    std::string GetContents(CMemFile& file)
+    {
+        std::string contents(static_cast<size_t>(file.GetLength()), '\0');
+
+        file.SeekToBegin();
+        if (!contents.empty()) {
+            file.Read(&contents[0], static_cast<UINT>(contents.size()));
+        }
+        return contents;
+    }
+
+    void TestDeclaration()
+    {
+        CMemFile file;
+        {
+            MeaXMLWriter writer(file);
+            writer.Declaration(true);
+            writer.Doctype(_T("positionLog"), _T("http://www.cthing.com/dtd/PositionLog1.dtd"));
+        }
+        BOOST_CHECK_EQUAL(GetContents(file),
+            "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+            "<!DOCTYPE positionLog SYSTEM \"http://www.cthing.com/dtd/PositionLog1.dtd\">\n");
+    }
+
+    void TestElements()
+    {
+        CMemFile file;
+        {
+            MeaXMLWriter writer(file);
+            writer.StartElement(_T("info"));
+                writer.StartElement(_T("title"));
+                writer.Text(_T("My Title"));
+                writer.EndElement();
+                writer.StartElement(_T("points"));
+                    writer.StartElement(_T("point"));
+                    writer.Attribute(_T("name"), _T("1"));
+                    writer.EndElement();
+                writer.EndElement();
+                writer.StartElement(_T("empty"));
+                writer.EndElement();
+            writer.EndElement();
+        }
+        BOOST_CHECK_EQUAL(GetContents(file),
+            "<info>\n"
+            "    <title>My Title</title>\n"
+            "    <points>\n"
+            "        <point name=\"1\"/>\n"
+            "    </points>\n"
+            "    <empty/>\n"
+            "</info>\n");
+    }
+
+    void TestAttributes()
+    {
+        CMemFile file;
+        {
+            MeaXMLWriter writer(file);
+            writer.StartElement(_T("a"));
+            writer.Attribute(_T("s"), _T("str"));
+            writer.Attribute(_T("i"), -42);
+            writer.Attribute(_T("d1"), 1.5);
+            writer.Attribute(_T("d2"), 10.0);
+            writer.Attribute(_T("d3"), -0.25);
+            writer.Attribute(_T("t"), true);
+            writer.Attribute(_T("f"), false);
+            writer.EndElement();
+        }
+        BOOST_CHECK_EQUAL(GetContents(file),
+            "<a s=\"str\" i=\"-42\" d1=\"1.5\" d2=\"10.0\" d3=\"-0.25\" t=\"true\" f=\"false\"/>\n");
+    }
+
+    void TestEscape()
+    {
+        CMemFile file;
+        {
+            MeaXMLWriter writer(file);
+            writer.StartElement(_T("a"));
+            writer.Attribute(_T("v"), _T("<\"'&'\">"));
+            writer.Text(_T("x < y & y > z"));
+            writer.EndElement();
+        }
+        BOOST_CHECK_EQUAL(GetContents(file),
+            "<a v=\"&lt;&quot;&apos;&amp;&apos;&quot;&gt;\">x &lt; y &amp; y &gt; z</a>\n");
+    }
+
+    void TestEscapeLong()
+    {
+        // Place a markup character at each position of a string longer
+        // than the 16 characters examined at once.
+        //
+        for (int pos = 0; pos < 40; pos++) {
+            CString text(_T('a'), 40);
+            text.SetAt(pos, _T('&'));
+
+            std::string expected(40, 'a');
+            expected.replace(pos, 1, "&amp;");
+
+            CMemFile file;
+            {
+                MeaXMLWriter writer(file);
+                writer.StartElement(_T("a"));
+                writer.Text(text);
+                writer.EndElement();
+            }
+            BOOST_CHECK_EQUAL(GetContents(file), "<a>" + expected + "</a>\n");
+        }
+    }
+
+    void TestUTF8()
+    {
+        CMemFile file;
+        {
+            MeaXMLWriter writer(file);
+            writer.StartElement(_T("a"));
+            writer.Text(CString(L"\x00E9\x20AC"));
+            writer.EndElement();
+        }
+        BOOST_CHECK_EQUAL(GetContents(file), "<a>\xC3\xA9\xE2\x82\xAC</a>\n");
+    }
+
+    void TestBuffering()
+    {
+        CMemFile file;
+        MeaXMLWriter writer(file, 16);
+
+        writer.StartElement(_T("elementWithALongName"));
+        writer.Attribute(_T("attributeWithALongName"), _T("a value longer than the buffer"));
+        writer.EndElement();
+
+        BOOST_CHECK(writer.GetBytesWritten() > 16);
+        BOOST_CHECK(file.GetLength() > 0);
+
+        writer.Flush();
+        BOOST_CHECK_EQUAL(GetContents(file),
+            "<elementWithALongName attributeWithALongName=\"a value longer than the buffer\"/>\n");
+        BOOST_CHECK_EQUAL(writer.GetBytesWritten(), file.GetLength());
+    }
+}
+
+
+test_suite* init_unit_test_suite(int argc, char* argv[])
+{
+    if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0)) {
+        cerr << "Fatail Error: MFC initialization failed\n";
+        return NULL;
+    }
+    
+    test_suite* suite = BOOST_TEST_SUITE("XMLWriter Tests");
+    suite->add(BOOST_TEST_CASE(&TestDeclaration));
+    suite->add(BOOST_TEST_CASE(&TestElements));
+    suite->add(BOOST_TEST_CASE(&TestAttributes));
+    suite->add(BOOST_TEST_CASE(&TestEscape));
+    suite->add(BOOST_TEST_CASE(&TestEscapeLong));
+    suite->add(BOOST_TEST_CASE(&TestUTF8));
+    suite->add(BOOST_TEST_CASE(&TestBuffering));
+    return suite;
+}